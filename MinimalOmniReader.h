@@ -1,14 +1,72 @@
 #pragma once
 
+#include <stddef.h>
+#include <stdint.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
 	typedef void (*OmniDataCallback)(float ringAngle, int gamePadX, int gamePadY);
 
+	// Extended fields present in an OmniSample (OmniSample::flags)
+	enum OmniSampleFlags {
+		OmniSample_DeviceTimestamp = 1,
+		OmniSample_StepCount = 2,
+		OmniSample_RingDelta = 4,
+		OmniSample_GunButtonData = 8,
+		OmniSample_StepTrigger = 16
+	};
+
+	// One treadmill sample for OmniReader_Poll (matches OmniBridge/OmniSampleRing.cs)
+	typedef struct OmniSample {
+		uint64_t sequence;          // 1-based, increases by one per sample
+		int64_t timestampUs;        // QPC microseconds when the master received the packet
+		uint32_t deviceTimestamp;   // treadmill timestamp
+		uint32_t stepCount;
+		float ringAngle;
+		int32_t gamePadX;
+		int32_t gamePadY;
+		uint8_t ringDelta;
+		uint8_t gunButtonData;
+		uint8_t stepTrigger;
+		uint8_t flags;              // OmniSampleFlags
+	} OmniSample;
+
+	// Pods in an OmniPodSample (OmniPodSample::flags)
+	enum OmniPodFlags {
+		OmniPod_Pod1 = 1,           // left foot
+		OmniPod_Pod2 = 2,           // right foot
+		OmniPod_DeviceTimestamp = 4
+	};
+
+	// Pod orientations from one raw data packet for OmniReader_PollPods
+	// (matches OmniBridge/OmniPodRing.cs)
+	typedef struct OmniPodSample {
+		uint64_t sequence;          // 1-based, increases by one per sample
+		int64_t timestampUs;        // QPC microseconds when the packet was received
+		uint32_t deviceTimestamp;   // treadmill timestamp
+		uint8_t flags;              // OmniPodFlags
+		uint8_t reserved[3];
+		float pod1[4];              // W, X, Y, Z
+		float pod2[4];
+	} OmniPodSample;
+
 	void* OmniReader_Create();
 	bool OmniReader_Initialize(void* handle, const char* comPort, int omniMode, int baudRate);
 	void OmniReader_RegisterCallback(void* handle, OmniDataCallback callback);
+	// Copies all samples newer than *sequence (start with 0), oldest first, and
+	// advances *sequence. Call on your own thread - no callback, no locking needed.
+	size_t OmniReader_Poll(void* handle, OmniSample* samples, size_t maxSamples, uint64_t* sequence);
+	// Streams pod quaternions from the next Initialize on. False while running
+	// as a shared memory consumer, which does not receive pod data.
+	bool OmniReader_EnablePods(void* handle, bool enable);
+	// OmniReader_Poll for pod orientations
+	size_t OmniReader_PollPods(void* handle, OmniPodSample* samples, size_t maxSamples, uint64_t* sequence);
+	// Sends the samples as UDP datagrams to address:port at rateHz, format as
+	// TreadmillBroadcastFormat (0 off, 1 binary, 2 OSC - see TreadmillBroadcast.h).
+	// Keeps running across Disconnect/Initialize until set to off or Destroy.
+	bool OmniReader_ConfigureBroadcast(void* handle, const char* address, int port, int rateHz, int format);
 	void OmniReader_Disconnect(void* handle);
 	void OmniReader_Destroy(void* handle);
 
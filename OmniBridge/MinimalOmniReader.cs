@@ -1,3 +1,4 @@
+using System.Diagnostics;
 using System.Runtime.InteropServices;
 using OmniCommon;
 using OmniCommon.Messages;
@@ -8,6 +9,11 @@ public class MinimalOmniReader
     private OmniMotionDataHandler? _handler;
     private nint _callbackPtr;
     private TreadmillSharedMemory? _sharedMemory;
+    private readonly OmniSampleRing _samples = new();
+    private readonly OmniPodRing _pods = new();
+    private bool _podsEnabled;
+    private TreadmillBroadcaster? _broadcaster;
+    private readonly object _broadcastLock = new();
     private bool _isMaster;
     private bool _isConsumer;
     private Thread? _consumerThread;
@@ -23,6 +29,7 @@ public class MinimalOmniReader
     private int _baudRate = 115200;
     private int _omniMode = 0;
     private const int StaleDataThresholdMs = 1000;
+    private const int FailoverConfigurationDelayMs = 10;
 
     [UnmanagedCallersOnly(EntryPoint = "OmniReader_Create")]
     public static nint Create()
@@ -118,27 +125,46 @@ public class MinimalOmniReader
     /// <summary>
     /// Initialize direct COM port mode (master mode).
     /// </summary>
-    private bool InitializeDirectMode(string comPort, int omniMode, int baudRate)
+    private bool InitializeDirectMode(string comPort, int omniMode, int baudRate, int configurationDelayMs = 100)
     {
         try
         {
             Logger.Debug($"InitializeDirectMode: Opening {comPort}...");
-            _handler = new OmniMotionDataHandler(comPort, baudRate, 100, (OmniMode)omniMode);
+            _handler = new OmniMotionDataHandler(comPort, baudRate, configurationDelayMs, (OmniMode)omniMode);
 
             var selection = new MotionDataSelection
             {
                 RingAngle = true,
                 GamePadData = true,
-                Timestamp = false,
-                StepCount = false,
-                RingDelta = false,
+                // Extended fields for OmniReader_Poll
+                Timestamp = true,
+                StepCount = true,
+                RingDelta = true,
                 GunButtonData = false,
-                StepTrigger = false
+                StepTrigger = true
             };
 
-            if (!_handler.Connect(selection, (OmniMode)omniMode))
+            // Pod quaternions only - accelerometer and gyroscope would triple the raw stream
+            RawDataSelection? rawSelection = null;
+            if (_podsEnabled)
+            {
+                rawSelection = new RawDataSelection
+                {
+                    Count = 2,
+                    Timestamp = true,
+                    Pods = new List<RawPodDataMode>
+                    {
+                        new RawPodDataMode { Quaternions = true },
+                        new RawPodDataMode { Quaternions = true }
+                    }
+                };
+            }
+
+            if (!_handler.Connect(selection, (OmniMode)omniMode, rawSelection))
             {
                 Logger.Error("InitializeDirectMode: Connect FAILED");
+                _handler.Dispose();
+                _handler = null;
                 return false;
             }
 
@@ -152,6 +178,8 @@ public class MinimalOmniReader
             TryInitializeSharedMemoryAsMaster();
 
             _handler.MotionDataReceived += OnMotionDataReceived;
+            if (_podsEnabled)
+                _handler.PodDataReceived += OnPodDataReceived;
             
             Logger.Info($"Master mode active - connected to {comPort}");
             return true;
@@ -159,6 +187,9 @@ public class MinimalOmniReader
         catch (Exception ex)
         {
             Logger.Error("InitializeDirectMode failed", ex);
+            // Failover retries land here repeatedly - don't leak the port handle
+            _handler?.Dispose();
+            _handler = null;
             return false;
         }
     }
@@ -221,20 +252,59 @@ public class MinimalOmniReader
         _lastX = rawX;
         _lastY = rawY;
         
+        var sample = CreateSample(data);
+        
         // Write to shared memory (if available)
         try
         {
-            _sharedMemory?.WriteData(_lastX, _lastY, data.RingAngle, data.GamePad_X, data.GamePad_Y);
+            _sharedMemory?.WriteData(_lastX, _lastY, in sample);
         }
         catch
         {
             // Shared memory write failed - non-critical, continue
         }
         
+        _samples.Add(sample);
+        
         // Invoke callback
         InvokeCallback(data.RingAngle, data.GamePad_X, data.GamePad_Y);
     }
 
+    /// <summary>
+    /// Handle incoming pod orientations from COM port (master mode).
+    /// </summary>
+    private void OnPodDataReceived(object? sender, OmniPodSample sample)
+    {
+        _pods.Add(in sample);
+    }
+
+    /// <summary>
+    /// Build the OmniReader_Poll sample for a motion data packet.
+    /// </summary>
+    private static OmniSample CreateSample(OmniMotionData data)
+    {
+        var flags = OmniSampleFlags.None;
+        if (data.EnableTimestamp) flags |= OmniSampleFlags.DeviceTimestamp;
+        if (data.EnableStepCount) flags |= OmniSampleFlags.StepCount;
+        if (data.EnableRingDelta) flags |= OmniSampleFlags.RingDelta;
+        if (data.EnableGunButtonData) flags |= OmniSampleFlags.GunButtonData;
+        if (data.EnableStepTrigger) flags |= OmniSampleFlags.StepTrigger;
+        
+        return new OmniSample
+        {
+            TimestampUs = TreadmillSharedMemory.NowMicroseconds(),
+            DeviceTimestamp = data.Timestamp,
+            StepCount = data.StepCount,
+            RingAngle = data.RingAngle,
+            GamePadX = data.GamePad_X,
+            GamePadY = data.GamePad_Y,
+            RingDelta = data.RingDelta,
+            GunButtonData = data.GunButtonData,
+            StepTrigger = data.StepTrigger,
+            Flags = flags
+        };
+    }
+
     /// <summary>
     /// Consumer loop - reads from shared memory and monitors master health.
     /// </summary>
@@ -244,6 +314,10 @@ public class MinimalOmniReader
         const int StaleCountThreshold = 10;
         int loopCount = 0;
         
+        // Start at the newest history sample; ReadHistory clamps the cursor to the head
+        long historyCursor = long.MaxValue;
+        var historyBuffer = new TreadmillSharedMemory.HistorySample[TreadmillSharedMemory.HistoryCapacity];
+        
         Logger.Debug("ConsumerLoop: Started");
         
         while (_running && _sharedMemory != null)
@@ -251,6 +325,19 @@ public class MinimalOmniReader
             try
             {
                 loopCount++;
+                
+                // Lease watch - a dead master is noticed within LeaseDurationMs
+                if (_sharedMemory.IsLeaseExpired(out long expiredForMs))
+                {
+                    if (TryFailoverToMaster(expiredForMs))
+                    {
+                        return; // Exit consumer loop - we are the master now
+                    }
+                    
+                    if (_sharedMemory == null)
+                        break;
+                }
+                
                 bool dataFresh = _sharedMemory.IsDataFresh(StaleDataThresholdMs);
                 
                 if (_sharedMemory.ReadData(out _, out _, out float yaw, out int rawX, out int rawY))
@@ -264,7 +351,41 @@ public class MinimalOmniReader
                     if (dataFresh)
                     {
                         staleCount = 0;
-                        InvokeCallback(yaw, rawX, rawY);
+                        
+                        if (_sharedMemory.HasHistory)
+                        {
+                            // Deliver every sample since the last poll in order, not just the latest
+                            int count = _sharedMemory.ReadHistory(ref historyCursor, historyBuffer);
+                            for (int i = 0; i < count; i++)
+                            {
+                                ref var h = ref historyBuffer[i];
+                                _samples.Add(new OmniSample
+                                {
+                                    TimestampUs = h.TimestampUs,
+                                    DeviceTimestamp = h.DeviceTimestamp,
+                                    StepCount = h.StepCount,
+                                    RingAngle = h.Yaw,
+                                    GamePadX = h.RawX,
+                                    GamePadY = h.RawY,
+                                    RingDelta = h.RingDelta,
+                                    GunButtonData = h.GunButtonData,
+                                    StepTrigger = h.StepTrigger,
+                                    Flags = h.Flags
+                                });
+                                InvokeCallback(h.Yaw, h.RawX, h.RawY);
+                            }
+                        }
+                        else
+                        {
+                            _samples.Add(new OmniSample
+                            {
+                                TimestampUs = TreadmillSharedMemory.NowMicroseconds(),
+                                RingAngle = yaw,
+                                GamePadX = rawX,
+                                GamePadY = rawY
+                            });
+                            InvokeCallback(yaw, rawX, rawY);
+                        }
                     }
                     else
                     {
@@ -273,8 +394,8 @@ public class MinimalOmniReader
                         
                         if (staleCount >= StaleCountThreshold)
                         {
-                            // Master appears dead - try failover
-                            if (TryFailoverToMaster())
+                            // Master appears dead (pre-lease master) - try failover
+                            if (TryFailoverToMaster(0))
                             {
                                 return; // Exit consumer loop
                             }
@@ -286,7 +407,7 @@ public class MinimalOmniReader
             catch
             {
                 // Error reading shared memory - try failover
-                if (TryFailoverToMaster())
+                if (TryFailoverToMaster(0))
                 {
                     return;
                 }
@@ -298,26 +419,75 @@ public class MinimalOmniReader
 
     /// <summary>
     /// Attempt to take over as master when previous master dies.
+    /// leaseExpiredForMs: how long the master lease has been expired (0 = unknown).
+    /// A master whose process is still alive is only replaced once its lease has
+    /// been expired for longer than StaleDataThresholdMs.
     /// </summary>
-    private bool TryFailoverToMaster()
+    private bool TryFailoverToMaster(long leaseExpiredForMs)
     {
+        var stopwatch = Stopwatch.StartNew();
+        Mutex? election = null;
+        
         try
         {
-            if (TreadmillSharedMemory.IsMasterRunning())
-                return false; // Master is still alive
+            // Only one consumer may reopen the COM port
+            election = TreadmillSharedMemory.TryEnterElection();
+            if (election == null)
+                return false; // Another consumer is taking over
+            
+            // Checked under the election: a previous winner already holds a fresh lease,
+            // or the old master is merely stalled
+            if (leaseExpiredForMs < StaleDataThresholdMs && TreadmillSharedMemory.IsMasterRunning())
+                return false;
+            
+            Logger.Info($"Master lost (lease expired {Math.Min(leaseExpiredForMs, StaleDataThresholdMs)}+ ms) - taking over {_comPort}");
             
             // Clean up consumer state
             _sharedMemory?.Dispose();
             _sharedMemory = null;
             _isConsumer = false;
             
-            // Try to become master
-            return InitializeDirectMode(_comPort, _omniMode, _baudRate);
+            // Try to become master (short configuration delays - the pod is already streaming)
+            if (InitializeDirectMode(_comPort, _omniMode, _baudRate, FailoverConfigurationDelayMs))
+            {
+                Logger.Info($"Failover complete in {stopwatch.ElapsedMilliseconds} ms");
+                return true;
+            }
+            
+            // Port still held by someone else - keep reading as consumer
+            Logger.Debug("TryFailoverToMaster: Takeover failed, reconnecting as consumer");
+            ReconnectAsConsumer();
+            return false;
         }
-        catch
+        catch (Exception ex)
         {
+            Logger.Debug($"TryFailoverToMaster: Exception - {ex.Message}");
+            if (_sharedMemory == null && !_isMaster)
+                ReconnectAsConsumer();
             return false;
         }
+        finally
+        {
+            election?.ReleaseMutex();
+            election?.Dispose();
+        }
+    }
+
+    /// <summary>
+    /// Reattach to shared memory after a failed takeover.
+    /// </summary>
+    private void ReconnectAsConsumer()
+    {
+        var sharedMemory = new TreadmillSharedMemory();
+        if (sharedMemory.InitializeAsConsumer())
+        {
+            _sharedMemory = sharedMemory;
+            _isConsumer = true;
+        }
+        else
+        {
+            sharedMemory.Dispose();
+        }
     }
 
     /// <summary>
@@ -366,6 +536,119 @@ public class MinimalOmniReader
         reader._callbackPtr = callbackPtr;
     }
 
+    /// <summary>
+    /// Batch pull alternative to the callback: copies every sample newer than
+    /// *sequence (0 = from the oldest available) into the caller's array, oldest
+    /// first, and advances *sequence. Returns the number of samples copied.
+    /// </summary>
+    [UnmanagedCallersOnly(EntryPoint = "OmniReader_Poll")]
+    public static unsafe nuint Poll(nint handle, OmniSample* samples, nuint maxSamples, ulong* sequence)
+    {
+        if (handle == 0 || samples == null || sequence == null || maxSamples == 0)
+            return 0;
+        
+        try
+        {
+            var reader = GetReader(handle);
+            ulong cursor = *sequence;
+            int count = reader._samples.CopySince(ref cursor, samples, (int)Math.Min(maxSamples, (nuint)int.MaxValue));
+            *sequence = cursor;
+            return (nuint)count;
+        }
+        catch (Exception ex)
+        {
+            Logger.Debug($"Poll exception: {ex.Message}");
+            return 0;
+        }
+    }
+
+    /// <summary>
+    /// Request pod orientation streaming (raw data, quaternions only) from the
+    /// next Initialize on. Only a master reads the pods - shared memory does not
+    /// carry them - so the return value is false while running as consumer.
+    /// </summary>
+    [UnmanagedCallersOnly(EntryPoint = "OmniReader_EnablePods")]
+    public static bool EnablePods(nint handle, bool enable)
+    {
+        if (handle == 0)
+            return false;
+        
+        var reader = GetReader(handle);
+        reader._podsEnabled = enable;
+        Logger.Info($"EnablePods: {enable}");
+        return !reader._isConsumer;
+    }
+
+    /// <summary>
+    /// OmniReader_Poll for pod orientations: copies every pod sample newer than
+    /// *sequence into the caller's array, oldest first, and advances *sequence.
+    /// </summary>
+    [UnmanagedCallersOnly(EntryPoint = "OmniReader_PollPods")]
+    public static unsafe nuint PollPods(nint handle, OmniPodSample* samples, nuint maxSamples, ulong* sequence)
+    {
+        if (handle == 0 || samples == null || sequence == null || maxSamples == 0)
+            return 0;
+        
+        try
+        {
+            var reader = GetReader(handle);
+            ulong cursor = *sequence;
+            int count = reader._pods.CopySince(ref cursor, samples, (int)Math.Min(maxSamples, (nuint)int.MaxValue));
+            *sequence = cursor;
+            return (nuint)count;
+        }
+        catch (Exception ex)
+        {
+            Logger.Debug($"PollPods exception: {ex.Message}");
+            return 0;
+        }
+    }
+
+    /// <summary>
+    /// Send the samples as UDP datagrams to address:port (IPv4 or IPv6, loopback,
+    /// LAN or a .255 broadcast address), batched at rateHz. format: 0 off,
+    /// 1 binary, 2 OSC (TreadmillBroadcast.h). Keeps running across Disconnect
+    /// and Initialize; calling again with the same settings changes nothing.
+    /// </summary>
+    [UnmanagedCallersOnly(EntryPoint = "OmniReader_ConfigureBroadcast")]
+    public static bool ConfigureBroadcast(nint handle, nint addressPtr, int port, int rateHz, int format)
+    {
+        if (handle == 0)
+            return false;
+        
+        try
+        {
+            var reader = GetReader(handle);
+            var broadcastFormat = (TreadmillBroadcastFormat)format;
+            string address = Marshal.PtrToStringAnsi(addressPtr) ?? "127.0.0.1";
+            
+            lock (reader._broadcastLock)
+            {
+                var current = reader._broadcaster;
+                if (current != null && current.Format == broadcastFormat && current.Address == address &&
+                    current.Port == port && current.RateHz == Math.Clamp(rateHz, 1, 1000))
+                    return true;
+                
+                current?.Dispose();
+                reader._broadcaster = null;
+                if (broadcastFormat == TreadmillBroadcastFormat.Off)
+                    return true;
+                if (!Enum.IsDefined(broadcastFormat) || port <= 0 || port > 65535)
+                    return false;
+                
+                var broadcaster = new TreadmillBroadcaster(reader._samples, address, port, rateHz, broadcastFormat);
+                broadcaster.Start();
+                reader._broadcaster = broadcaster;
+                return true;
+            }
+        }
+        catch (Exception ex)
+        {
+            Logger.Error("ConfigureBroadcast failed", ex);
+            return false;
+        }
+    }
+
     [UnmanagedCallersOnly(EntryPoint = "OmniReader_Disconnect")]
     public static void Disconnect(nint handle)
     {
@@ -375,6 +658,13 @@ public class MinimalOmniReader
         reader._handler?.Disconnect();
         reader._handler?.Dispose();
         reader._sharedMemory?.Dispose();
+        
+        // The driver re-initializes the same reader after a lost link
+        reader._handler = null;
+        reader._sharedMemory = null;
+        reader._consumerThread = null;
+        reader._isMaster = false;
+        reader._isConsumer = false;
     }
 
     [UnmanagedCallersOnly(EntryPoint = "OmniReader_Destroy")]
@@ -388,6 +678,11 @@ public class MinimalOmniReader
             reader._consumerThread?.Join(1000);
             reader._handler?.Dispose();
             reader._sharedMemory?.Dispose();
+            lock (reader._broadcastLock)
+            {
+                reader._broadcaster?.Dispose();
+                reader._broadcaster = null;
+            }
             gcHandle.Free();
         }
     }
@@ -17,12 +17,19 @@ public class OmniMotionDataHandler : IDisposable
     private int _crcErrorCount = 0;
     private int _packetCount = 0;
     private int _bytesReadTotal = 0;
+    private OmniPodSample _podSample;   // reused for every raw data packet
 
     /// <summary>
     /// Event is raised when motion data is received
     /// </summary>
     public event EventHandler<OmniMotionData>? MotionDataReceived;
 
+    /// <summary>
+    /// Event is raised when pod orientations are received (raw data streaming,
+    /// see ConfigureRawData). The sample is a struct - no allocation per packet.
+    /// </summary>
+    public event EventHandler<OmniPodSample>? PodDataReceived;
+
     /// <summary>
     /// Event is raised when raw hex data is received
     /// </summary>
@@ -78,7 +85,8 @@ public class OmniMotionDataHandler : IDisposable
     /// </summary>
     /// <param name="selection">The Motion Data Selection - null for AllOn()</param>
     /// <param name="omniMode">The OmniMode - null for standard</param>
-    public bool Connect(MotionDataSelection? selection = null, OmniMode? omniMode = null)
+    /// <param name="rawSelection">Pod raw data to stream as well - null for none</param>
+    public bool Connect(MotionDataSelection? selection = null, OmniMode? omniMode = null, RawDataSelection? rawSelection = null)
     {
         try
         {
@@ -124,6 +132,12 @@ public class OmniMotionDataHandler : IDisposable
 
             Thread.Sleep(_configurationDelayMs); // Wait for hardware response
 
+            if (rawSelection != null)
+            {
+                ConfigureRawData(rawSelection);
+                Thread.Sleep(_configurationDelayMs);
+            }
+
             // Start reader thread
             _isRunning = true;
             _readerThread.Start();
@@ -188,6 +202,22 @@ public class OmniMotionDataHandler : IDisposable
         Logger.Debug($"Motion Data config: Timestamp={selection.Timestamp}, StepCount={selection.StepCount}, RingAngle={selection.RingAngle}, GamePadData={selection.GamePadData}");
     }
 
+    /// <summary>
+    /// Configures which pod raw data (quaternions, accelerometer, gyroscope) should be streamed
+    /// </summary>
+    public void ConfigureRawData(RawDataSelection selection)
+    {
+        if (!_port.IsOpen)
+        {
+            throw new InvalidOperationException("Port is not open!");
+        }
+
+        var message = new OmniSetRawDataMessage(selection);
+        SendMessage(message);
+
+        Logger.Debug($"Raw Data config: {selection}");
+    }
+
     /// <summary>
     /// Creates a custom Motion Data Selection
     /// </summary>
@@ -338,6 +368,27 @@ public class OmniMotionDataHandler : IDisposable
             
             OnMotionDataReceived(motionData);
         }
+        else if (msg.MsgType == MessageType.OmniRawDataMessage)
+        {
+            // Decoded in place - PodRawData would allocate arrays per packet
+            _podSample.TimestampUs = TreadmillSharedMemory.NowMicroseconds();
+            if (OmniPodDecoder.TryDecodeRaw(msg.Payload, ref _podSample))
+            {
+                PodDataReceived?.Invoke(this, _podSample);
+            }
+        }
+        else if (msg.MsgType == MessageType.OmniMotionAndRawDataMessage)
+        {
+            // Sent instead of motion packets while raw streaming is on - ring
+            // angle and gamepad must keep flowing or the link looks stalled
+            OnMotionDataReceived(new OmniMotionAndRawDataMessage(msg).GetMotionData());
+            
+            _podSample.TimestampUs = TreadmillSharedMemory.NowMicroseconds();
+            if (OmniPodDecoder.TryDecodeCombined(msg.Payload, ref _podSample))
+            {
+                PodDataReceived?.Invoke(this, _podSample);
+            }
+        }
         else
         {
             Logger.Debug($"ProcessMessage: Unexpected message type {msg.MsgType}");
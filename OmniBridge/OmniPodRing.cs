@@ -0,0 +1,180 @@
+using System.Runtime.InteropServices;
+
+namespace OmniBridge;
+
+/// <summary>
+/// Which pods an OmniPodSample carries an orientation for
+/// </summary>
+[Flags]
+public enum OmniPodFlags : byte
+{
+    None = 0,
+    Pod1 = 1,               // left foot
+    Pod2 = 2,               // right foot
+    DeviceTimestamp = 4
+}
+
+/// <summary>
+/// Pod orientations from one raw data packet as delivered by OmniReader_PollPods.
+/// Layout must match OmniPodSample in MinimalOmniReader.h (56 bytes).
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct OmniPodSample
+{
+    public ulong Sequence;          // 1-based, assigned by OmniPodRing
+    public long TimestampUs;        // QPC microseconds when the packet was received
+    public uint DeviceTimestamp;    // Treadmill timestamp
+    public OmniPodFlags Flags;
+    public byte Reserved0, Reserved1, Reserved2;
+    public float Pod1W, Pod1X, Pod1Y, Pod1Z;
+    public float Pod2W, Pod2X, Pod2Y, Pod2Z;
+}
+
+/// <summary>
+/// Decodes pod quaternions straight from a raw data payload. OmniRawDataMessage
+/// and PodRawData allocate lists and arrays per packet; this reads the same
+/// layout into an OmniPodSample and allocates nothing.
+/// </summary>
+public static class OmniPodDecoder
+{
+    private const float QuaternionScale = 1f / 16384f;
+
+    // Combined motion + raw packets: fixed offsets (OmniMotionAndRawDataMessage)
+    private const int CombinedPod1Offset = 16;
+    private const int CombinedPod2Offset = 36;
+
+    /// <summary>
+    /// OmniRawDataMessage payload: count and timestamp flag, one mode nibble per
+    /// pod, optional timestamp, then per pod Q(8) A(6) G(6) F(2) as enabled.
+    /// </summary>
+    public static bool TryDecodeRaw(byte[] payload, ref OmniPodSample sample)
+    {
+        if (payload == null || payload.Length < 1)
+            return false;
+
+        int count = payload[0] >> 4 & 15;
+        bool timestamp = (payload[0] & 1) == 1;
+        int index = 1 + (count + 1) / 2;
+        sample.Flags = OmniPodFlags.None;
+
+        if (timestamp)
+        {
+            if (payload.Length < index + 4)
+                return false;
+            sample.DeviceTimestamp = (uint)(payload[index] | payload[index + 1] << 8 | payload[index + 2] << 16 | payload[index + 3] << 24);
+            sample.Flags |= OmniPodFlags.DeviceTimestamp;
+            index += 4;
+        }
+
+        for (int pod = 0; pod < count && pod < 2; pod++)
+        {
+            if (payload.Length <= 1 + pod / 2)
+                return false;
+            int mode = (pod % 2 == 0 ? payload[1 + pod / 2] >> 4 : payload[1 + pod / 2]) & 15;
+
+            if ((mode & 2) != 0)
+            {
+                if (payload.Length < index + 8)
+                    return false;
+                if (pod == 0)
+                {
+                    ReadQuaternion(payload, index, out sample.Pod1W, out sample.Pod1X, out sample.Pod1Y, out sample.Pod1Z);
+                    sample.Flags |= OmniPodFlags.Pod1;
+                }
+                else
+                {
+                    ReadQuaternion(payload, index, out sample.Pod2W, out sample.Pod2X, out sample.Pod2Y, out sample.Pod2Z);
+                    sample.Flags |= OmniPodFlags.Pod2;
+                }
+                index += 8;
+            }
+            if ((mode & 4) != 0) index += 6;    // accelerometer
+            if ((mode & 8) != 0) index += 6;    // gyroscope
+            if ((mode & 1) != 0) index += 2;    // frame number
+        }
+
+        return (sample.Flags & (OmniPodFlags.Pod1 | OmniPodFlags.Pod2)) != 0;
+    }
+
+    /// <summary>
+    /// OmniMotionAndRawDataMessage payload: motion fields, then both pods at fixed offsets
+    /// </summary>
+    public static bool TryDecodeCombined(byte[] payload, ref OmniPodSample sample)
+    {
+        if (payload == null || payload.Length < CombinedPod2Offset + 8)
+            return false;
+
+        sample.DeviceTimestamp = (uint)(payload[0] | payload[1] << 8 | payload[2] << 16 | payload[3] << 24);
+        ReadQuaternion(payload, CombinedPod1Offset, out sample.Pod1W, out sample.Pod1X, out sample.Pod1Y, out sample.Pod1Z);
+        ReadQuaternion(payload, CombinedPod2Offset, out sample.Pod2W, out sample.Pod2X, out sample.Pod2Y, out sample.Pod2Z);
+        sample.Flags = OmniPodFlags.Pod1 | OmniPodFlags.Pod2 | OmniPodFlags.DeviceTimestamp;
+        return true;
+    }
+
+    // W, X, Y, Z as signed Q14, little endian
+    private static void ReadQuaternion(byte[] data, int index, out float w, out float x, out float y, out float z)
+    {
+        w = (short)(data[index] | data[index + 1] << 8) * QuaternionScale;
+        x = (short)(data[index + 2] | data[index + 3] << 8) * QuaternionScale;
+        y = (short)(data[index + 4] | data[index + 5] << 8) * QuaternionScale;
+        z = (short)(data[index + 6] | data[index + 7] << 8) * QuaternionScale;
+    }
+}
+
+/// <summary>
+/// In-process history of the last Capacity pod samples for OmniReader_PollPods,
+/// the pod counterpart of OmniSampleRing.
+/// </summary>
+public class OmniPodRing
+{
+    public const int Capacity = 128;
+
+    private readonly OmniPodSample[] _samples = new OmniPodSample[Capacity];
+    private readonly object _lockObject = new();
+    private ulong _lastSequence;
+
+    /// <summary>
+    /// Append a sample and assign its sequence number
+    /// </summary>
+    public void Add(in OmniPodSample sample)
+    {
+        lock (_lockObject)
+        {
+            ulong sequence = ++_lastSequence;
+            ref OmniPodSample slot = ref _samples[sequence % Capacity];
+            slot = sample;
+            slot.Sequence = sequence;
+        }
+    }
+
+    /// <summary>
+    /// Copy samples newer than sequence into output, oldest first, and advance
+    /// sequence to the last one copied. Returns the number of samples copied.
+    /// </summary>
+    public unsafe int CopySince(ref ulong sequence, OmniPodSample* output, int maxSamples)
+    {
+        lock (_lockObject)
+        {
+            if (_lastSequence == 0 || maxSamples <= 0)
+                return 0;
+
+            // A cursor from the future belongs to an older reader instance - start over
+            if (sequence > _lastSequence)
+                sequence = 0;
+
+            ulong oldest = _lastSequence >= Capacity ? _lastSequence - Capacity + 1 : 1;
+            ulong first = Math.Max(sequence + 1, oldest);
+            int count = 0;
+
+            for (ulong s = first; s <= _lastSequence && count < maxSamples; s++)
+            {
+                output[count++] = _samples[s % Capacity];
+            }
+
+            if (count > 0)
+                sequence = output[count - 1].Sequence;
+
+            return count;
+        }
+    }
+}
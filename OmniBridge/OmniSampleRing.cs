@@ -0,0 +1,105 @@
+using System.Runtime.InteropServices;
+
+namespace OmniBridge;
+
+/// <summary>
+/// Which of the extended OmniSample fields carry data from the treadmill
+/// </summary>
+[Flags]
+public enum OmniSampleFlags : byte
+{
+    None = 0,
+    DeviceTimestamp = 1,
+    StepCount = 2,
+    RingDelta = 4,
+    GunButtonData = 8,
+    StepTrigger = 16
+}
+
+/// <summary>
+/// One treadmill sample as delivered by OmniReader_Poll.
+/// Layout must match OmniSample in MinimalOmniReader.h (40 bytes).
+/// </summary>
+[StructLayout(LayoutKind.Sequential)]
+public struct OmniSample
+{
+    public ulong Sequence;          // 1-based, assigned by OmniSampleRing
+    public long TimestampUs;        // QPC microseconds when the master received the packet
+    public uint DeviceTimestamp;    // Treadmill timestamp
+    public uint StepCount;
+    public float RingAngle;
+    public int GamePadX;
+    public int GamePadY;
+    public byte RingDelta;
+    public byte GunButtonData;
+    public byte StepTrigger;
+    public OmniSampleFlags Flags;
+}
+
+/// <summary>
+/// In-process history of the last Capacity samples for OmniReader_Poll.
+///
+/// Written by the COM reader thread (master) or the consumer thread, read by
+/// host threads. The lock is held only for array copies, so polling never
+/// waits on serial I/O.
+/// </summary>
+public class OmniSampleRing
+{
+    public const int Capacity = 256;
+
+    private readonly OmniSample[] _samples = new OmniSample[Capacity];
+    private readonly object _lockObject = new();
+    private ulong _lastSequence;
+
+    /// <summary>
+    /// Sequence number of the newest sample, 0 while empty
+    /// </summary>
+    public ulong LastSequence
+    {
+        get { lock (_lockObject) return _lastSequence; }
+    }
+
+    /// <summary>
+    /// Append a sample and assign its sequence number
+    /// </summary>
+    public void Add(OmniSample sample)
+    {
+        lock (_lockObject)
+        {
+            sample.Sequence = ++_lastSequence;
+            _samples[sample.Sequence % Capacity] = sample;
+        }
+    }
+
+    /// <summary>
+    /// Copy samples newer than sequence into output, oldest first, and advance
+    /// sequence to the last one copied. Samples that already fell out of the ring
+    /// are skipped. Returns the number of samples copied.
+    /// </summary>
+    public unsafe int CopySince(ref ulong sequence, OmniSample* output, int maxSamples)
+    {
+        lock (_lockObject)
+        {
+            if (_lastSequence == 0 || maxSamples <= 0)
+                return 0;
+
+            // A cursor from the future belongs to an older reader instance - start over
+            if (sequence > _lastSequence)
+                sequence = 0;
+
+            ulong oldest = _lastSequence >= Capacity ? _lastSequence - Capacity + 1 : 1;
+            ulong first = Math.Max(sequence + 1, oldest);
+            int count = 0;
+
+            for (ulong s = first; s <= _lastSequence && count < maxSamples; s++)
+            {
+                output[count++] = _samples[s % Capacity];
+            }
+
+            if (count > 0)
+                sequence = output[count - 1].Sequence;
+
+            return count;
+        }
+    }
+}
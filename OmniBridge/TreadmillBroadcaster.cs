@@ -0,0 +1,245 @@
+using System.Buffers.Binary;
+using System.Diagnostics;
+using System.Net;
+using System.Net.Sockets;
+using System.Text;
+
+namespace OmniBridge;
+
+/// <summary>
+/// Datagram layout for OmniReader_ConfigureBroadcast
+/// </summary>
+public enum TreadmillBroadcastFormat
+{
+    Off = 0,
+    Binary = 1,
+    Osc = 2
+}
+
+/// <summary>
+/// Sends the reader's samples as UDP datagrams for processes that do not load
+/// OmniBridge: at RateHz, everything added to the OmniSampleRing since the last
+/// send, in as few datagrams as fit an Ethernet frame. Layouts are documented
+/// in TreadmillBroadcast.h and must match it.
+///
+/// Runs on its own thread and pulls with OmniSampleRing.CopySince, so the COM
+/// reader never waits on the network. Buffers are allocated once.
+/// </summary>
+public sealed class TreadmillBroadcaster : IDisposable
+{
+    public const int MaxDatagram = 1472;
+    public const ushort Version = 1;
+    private const uint Magic = 0x42544D4F;              // "OMTB"
+    private const int HeaderSize = 32;
+    private const int SampleSize = 32;
+    private const int BinarySamplesPerDatagram = (MaxDatagram - HeaderSize) / SampleSize;
+    private const int OscHeaderSize = 16 + 4 + 28;      // bundle tag + time tag, /omni/datagram
+    private const int OscSampleSize = 4 + 48;           // size prefix + /omni/sample
+    private const int OscSamplesPerDatagram = (MaxDatagram - OscHeaderSize) / OscSampleSize;
+    private const long IdleDatagramIntervalUs = 1_000_000;
+
+    private static readonly byte[] OscBundleTag = Encoding.ASCII.GetBytes("#bundle\0");
+    private static readonly byte[] OscDatagramAddress = Encoding.ASCII.GetBytes("/omni/datagram\0\0,ii\0");
+    private static readonly byte[] OscSampleAddress = Encoding.ASCII.GetBytes("/omni/sample\0\0\0\0,ifiiii\0");
+
+    private readonly OmniSampleRing _ring;
+    private readonly OmniSample[] _pending = new OmniSample[OmniSampleRing.Capacity];
+    private readonly byte[] _datagram = new byte[MaxDatagram];
+    private readonly Socket _socket;
+    private readonly EndPoint _target;
+    private readonly Thread _thread;
+    private volatile bool _running;
+    private ulong _cursor;
+    private uint _datagramSequence;
+    private uint _skippedSamples;
+    private long _lastSendUs;
+    private long _sendErrors;
+
+    public string Address { get; }
+    public int Port { get; }
+    public int RateHz { get; }
+    public TreadmillBroadcastFormat Format { get; }
+
+    public TreadmillBroadcaster(OmniSampleRing ring, string address, int port, int rateHz, TreadmillBroadcastFormat format)
+    {
+        if (format == TreadmillBroadcastFormat.Off)
+            throw new ArgumentException("Broadcast format is off", nameof(format));
+
+        _ring = ring;
+        Address = address;
+        Port = port;
+        RateHz = Math.Clamp(rateHz, 1, 1000);
+        Format = format;
+
+        IPAddress ip = IPAddress.Parse(address);
+        _target = new IPEndPoint(ip, port);
+        _socket = new Socket(ip.AddressFamily, SocketType.Dgram, ProtocolType.Udp);
+        _socket.Blocking = false;       // a full send buffer drops the datagram instead of stalling
+        if (ip.AddressFamily == AddressFamily.InterNetwork && ip.GetAddressBytes()[3] == 255)
+            _socket.EnableBroadcast = true;
+
+        _thread = new Thread(SendLoop)
+        {
+            IsBackground = true,
+            Name = "OmniBridge_Broadcast"
+        };
+    }
+
+    public void Start()
+    {
+        // Only what arrives from now on - receivers want live data, not the ring's history
+        _cursor = _ring.LastSequence;
+        _running = true;
+        _thread.Start();
+        Logger.Info($"Broadcast: {Format} to {Address}:{Port} at {RateHz} Hz");
+    }
+
+    public void Dispose()
+    {
+        _running = false;
+        if (_thread.IsAlive)
+            _thread.Join(1000);
+        _socket.Dispose();
+        Logger.Info($"Broadcast stopped: {_datagramSequence} datagrams, {_skippedSamples} samples skipped, {_sendErrors} send errors");
+    }
+
+    private void SendLoop()
+    {
+        long intervalUs = 1_000_000 / RateHz;
+        long nextUs = TreadmillSharedMemory.NowMicroseconds();
+
+        while (_running)
+        {
+            nextUs += intervalUs;
+            long waitUs = nextUs - TreadmillSharedMemory.NowMicroseconds();
+            if (waitUs > 0)
+                Thread.Sleep((int)((waitUs + 999) / 1000));
+            else if (waitUs < -intervalUs)
+                nextUs = TreadmillSharedMemory.NowMicroseconds();      // fell behind - don't burst
+
+            try
+            {
+                SendPending();
+            }
+            catch (Exception ex)
+            {
+                Logger.Debug($"Broadcast exception: {ex.Message}");
+            }
+        }
+    }
+
+    private unsafe void SendPending()
+    {
+        ulong before = _cursor;
+        int count;
+        fixed (OmniSample* pending = _pending)
+        {
+            count = _ring.CopySince(ref _cursor, pending, _pending.Length);
+        }
+
+        // CopySince skips what already fell out of the ring; a restarted reader starts over
+        if (count > 0 && _pending[0].Sequence > before + 1 && _cursor > before)
+            _skippedSamples += (uint)(_pending[0].Sequence - before - 1);
+
+        long nowUs = TreadmillSharedMemory.NowMicroseconds();
+        if (count == 0)
+        {
+            // An empty datagram now and then tells receivers the sender is alive
+            if (nowUs - _lastSendUs >= IdleDatagramIntervalUs)
+                Send(0, 0);
+            return;
+        }
+
+        int perDatagram = Format == TreadmillBroadcastFormat.Osc ? OscSamplesPerDatagram : BinarySamplesPerDatagram;
+        for (int first = 0; first < count; first += perDatagram)
+        {
+            Send(first, Math.Min(perDatagram, count - first));
+        }
+    }
+
+    private void Send(int first, int count)
+    {
+        _datagramSequence++;
+        _lastSendUs = TreadmillSharedMemory.NowMicroseconds();
+        int length = Format == TreadmillBroadcastFormat.Osc
+            ? WriteOsc(_datagram, first, count)
+            : WriteBinary(_datagram, first, count, _lastSendUs);
+
+        try
+        {
+            _socket.SendTo(_datagram, 0, length, SocketFlags.None, _target);
+        }
+        catch (SocketException ex)
+        {
+            // No listener (ICMP port unreachable) or buffer full - loss the sequence numbers show
+            if (_sendErrors++ == 0)
+                Logger.Debug($"Broadcast send failed: {ex.SocketErrorCode}");
+        }
+    }
+
+    private int WriteBinary(byte[] buffer, int first, int count, long sendTimeUs)
+    {
+        Span<byte> span = buffer;
+        BinaryPrimitives.WriteUInt32LittleEndian(span, Magic);
+        BinaryPrimitives.WriteUInt16LittleEndian(span[4..], Version);
+        BinaryPrimitives.WriteUInt16LittleEndian(span[6..], HeaderSize);
+        BinaryPrimitives.WriteUInt32LittleEndian(span[8..], _datagramSequence);
+        BinaryPrimitives.WriteUInt16LittleEndian(span[12..], (ushort)count);
+        BinaryPrimitives.WriteUInt16LittleEndian(span[14..], SampleSize);
+        BinaryPrimitives.WriteInt64LittleEndian(span[16..], sendTimeUs);
+        BinaryPrimitives.WriteUInt32LittleEndian(span[24..], _skippedSamples);
+        BinaryPrimitives.WriteUInt32LittleEndian(span[28..], 0);
+
+        for (int i = 0; i < count; i++)
+        {
+            ref OmniSample s = ref _pending[first + i];
+            Span<byte> sample = span.Slice(HeaderSize + i * SampleSize, SampleSize);
+            BinaryPrimitives.WriteUInt64LittleEndian(sample, s.Sequence);
+            BinaryPrimitives.WriteInt64LittleEndian(sample[8..], s.TimestampUs);
+            BinaryPrimitives.WriteSingleLittleEndian(sample[16..], s.RingAngle);
+            BinaryPrimitives.WriteUInt32LittleEndian(sample[20..], s.StepCount);
+            sample[24] = (byte)Math.Clamp(s.GamePadX, 0, 255);
+            sample[25] = (byte)Math.Clamp(s.GamePadY, 0, 255);
+            sample[26] = s.RingDelta;
+            sample[27] = s.GunButtonData;
+            sample[28] = s.StepTrigger;
+            sample[29] = (byte)s.Flags;
+            BinaryPrimitives.WriteUInt16LittleEndian(sample[30..], 0);
+        }
+
+        return HeaderSize + count * SampleSize;
+    }
+
+    // OSC is big endian; one bundle, "immediately" time tag
+    private int WriteOsc(byte[] buffer, int first, int count)
+    {
+        Span<byte> span = buffer;
+        OscBundleTag.CopyTo(span);
+        BinaryPrimitives.WriteUInt64BigEndian(span[8..], 1);
+
+        int offset = 16;
+        BinaryPrimitives.WriteInt32BigEndian(span[offset..], OscDatagramAddress.Length + 8);
+        OscDatagramAddress.CopyTo(span[(offset + 4)..]);
+        offset += 4 + OscDatagramAddress.Length;
+        BinaryPrimitives.WriteInt32BigEndian(span[offset..], unchecked((int)_datagramSequence));
+        BinaryPrimitives.WriteInt32BigEndian(span[(offset + 4)..], count);
+        offset += 8;
+
+        for (int i = 0; i < count; i++)
+        {
+            ref OmniSample s = ref _pending[first + i];
+            BinaryPrimitives.WriteInt32BigEndian(span[offset..], OscSampleAddress.Length + 24);
+            OscSampleAddress.CopyTo(span[(offset + 4)..]);
+            offset += 4 + OscSampleAddress.Length;
+            BinaryPrimitives.WriteInt32BigEndian(span[offset..], unchecked((int)s.Sequence));
+            BinaryPrimitives.WriteSingleBigEndian(span[(offset + 4)..], s.RingAngle);
+            BinaryPrimitives.WriteInt32BigEndian(span[(offset + 8)..], s.GamePadX);
+            BinaryPrimitives.WriteInt32BigEndian(span[(offset + 12)..], s.GamePadY);
+            BinaryPrimitives.WriteInt32BigEndian(span[(offset + 16)..], unchecked((int)s.StepCount));
+            BinaryPrimitives.WriteInt32BigEndian(span[(offset + 20)..], s.StepTrigger);
+            offset += 24;
+        }
+
+        return offset;
+    }
+}
@@ -12,6 +12,18 @@ namespace OmniBridge;
 /// - Master opens COM port and writes to shared memory
 /// - Subsequent processes become CONSUMERS and read from shared memory
 /// - When master exits, next process to initialize can become master
+///
+/// Failover:
+/// - Master renews a short lease (Heartbeat/LeaseExpiry) from a dedicated thread
+/// - Consumers watch the lease; once it expires they run an election on a named
+///   mutex and the single winner reopens the COM port as the new master
+///
+/// Sample history (v3):
+/// - Behind the header, the master publishes a ring of the last HistoryCapacity
+///   samples, each stamped with the QPC clock in microseconds
+/// - Every slot is guarded by its own sequence counter (odd = being written),
+///   so readers in other processes never take a lock
+/// - HistoryHead counts all samples ever written; sample n lives in slot n % HistoryCapacity
 /// </summary>
 public class TreadmillSharedMemory : IDisposable
 {
@@ -19,8 +31,25 @@ public class TreadmillSharedMemory : IDisposable
     // This means shared memory only works within the same user session
     private const string SharedMemoryName = "Local\\OmniTreadmillData";
     private const string MutexName = "Local\\OmniTreadmillMutex";
+    private const string ElectionMutexName = "Local\\OmniTreadmillElection";
     private const uint Magic = 0x4F4D4E49; // 'OMNI'
-    private const uint Version = 1;
+    private const uint Version = 3;
+
+    // Lease timing (Environment.TickCount64 is system uptime, identical in all processes)
+    public const int LeaseDurationMs = 25;
+    private const int HeartbeatIntervalMs = 5;
+
+    // Sample history layout (mirrored in TreadmillSampleHistory.h)
+    public const int HistoryOffset = 128;
+    public const int HistoryCapacity = 64;
+    public const int HistorySlotSize = 48;
+    private const int SharedMemorySize = HistoryOffset + HistoryCapacity * HistorySlotSize;
+
+    [DllImport("winmm.dll")]
+    private static extern uint timeBeginPeriod(uint period);
+
+    [DllImport("winmm.dll")]
+    private static extern uint timeEndPeriod(uint period);
 
     // Use a simple struct without managed types for blittable compatibility
     [StructLayout(LayoutKind.Sequential, Pack = 1)]
@@ -37,24 +66,77 @@ public class TreadmillSharedMemory : IDisposable
         public long LastUpdate;
         public long UpdateCount;
         public uint MasterPid;
+        // Lease (v2): master renews both every HeartbeatIntervalMs, 0 = released
+        public long Heartbeat;
+        public long LeaseExpiry;
+        // Sample history (v3): number of samples written so far
+        public long HistoryHead;
         // Reserved space as individual fields (no managed array)
-        public long Reserved1;
-        public long Reserved2;
-        public long Reserved3;
         public long Reserved4;
     }
+
+    /// <summary>
+    /// One slot of the sample history ring. Seq is 2n+1 while sample n is being
+    /// written and 2n+2 once it is complete.
+    /// </summary>
+    [StructLayout(LayoutKind.Sequential, Pack = 1)]
+    public struct HistorySample
+    {
+        public long Seq;
+        public long TimestampUs;
+        public float X;
+        public float Y;
+        public float Yaw;
+        public int RawX;
+        public int RawY;
+        // Extended fields, see OmniSample
+        public uint StepCount;
+        public uint DeviceTimestamp;
+        public byte RingDelta;
+        public byte GunButtonData;
+        public byte StepTrigger;
+        public OmniSampleFlags Flags;
+    }
     
     private static readonly int SharedDataSize = Marshal.SizeOf<SharedData>();
+    private static readonly int OffsetX = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.X));
+    private static readonly int OffsetY = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.Y));
+    private static readonly int OffsetYaw = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.Yaw));
+    private static readonly int OffsetRawX = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.RawX));
+    private static readonly int OffsetRawY = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.RawY));
+    private static readonly int OffsetConnected = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.Connected));
+    private static readonly int OffsetLastUpdate = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.LastUpdate));
+    private static readonly int OffsetUpdateCount = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.UpdateCount));
+    private static readonly int OffsetMasterPid = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.MasterPid));
+    private static readonly int OffsetHeartbeat = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.Heartbeat));
+    private static readonly int OffsetLeaseExpiry = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.LeaseExpiry));
+    private static readonly int OffsetHistoryHead = (int)Marshal.OffsetOf<SharedData>(nameof(SharedData.HistoryHead));
 
     private MemoryMappedFile? _mappedFile;
     private MemoryMappedViewAccessor? _accessor;
     private Mutex? _mutex;
+    private Thread? _heartbeatThread;
+    private volatile bool _heartbeatRunning;
+    private bool _highResolutionTimer;
+    private bool _hasHistory;
     private bool _isMaster;
     private bool _disposed;
 
 
     public bool IsMaster => _isMaster;
     public bool IsConnected => _accessor != null;
+    public bool HasHistory => _hasHistory;
+
+    /// <summary>
+    /// Current time on the history clock: QueryPerformanceCounter in microseconds,
+    /// the same clock std::chrono::steady_clock uses on MSVC.
+    /// </summary>
+    public static long NowMicroseconds()
+    {
+        long ticks = Stopwatch.GetTimestamp();
+        long frequency = Stopwatch.Frequency;
+        return ticks / frequency * 1_000_000 + ticks % frequency * 1_000_000 / frequency;
+    }
 
     /// <summary>
     /// Check if a master process is already running
@@ -72,6 +154,13 @@ public class TreadmillSharedMemory : IDisposable
             if (data.Magic != Magic)
                 return false;
             
+            // A valid lease proves the master is alive without a process lookup
+            if (data.Version >= 2 && data.LeaseExpiry > Environment.TickCount64)
+                return true;
+            
+            if (data.MasterPid == 0)
+                return false;
+            
             // Check if master process is still alive
             try
             {
@@ -101,14 +190,21 @@ public class TreadmillSharedMemory : IDisposable
             Logger.Debug($"InitializeAsMaster: Creating mutex '{MutexName}'...");
             _mutex = new Mutex(false, MutexName);
             
-            Logger.Debug($"InitializeAsMaster: Creating shared memory '{SharedMemoryName}' (size={SharedDataSize})...");
+            Logger.Debug($"InitializeAsMaster: Creating shared memory '{SharedMemoryName}' (size={SharedMemorySize})...");
             _mappedFile = MemoryMappedFile.CreateOrOpen(
                 SharedMemoryName,
-                SharedDataSize,
+                SharedMemorySize,
                 MemoryMappedFileAccess.ReadWrite);
             
             Logger.Debug("InitializeAsMaster: Creating view accessor...");
-            _accessor = _mappedFile.CreateViewAccessor(0, SharedDataSize, MemoryMappedFileAccess.ReadWrite);
+            _accessor = _mappedFile.CreateViewAccessor(0, SharedMemorySize, MemoryMappedFileAccess.ReadWrite);
+            
+            // After a failover, continue the previous master's history so consumer cursors stay valid
+            long historyHead = 0;
+            if (_accessor.ReadUInt32(0) == Magic && _accessor.ReadUInt32(4) >= 3)
+            {
+                historyHead = _accessor.ReadInt64(OffsetHistoryHead);
+            }
             
             // Initialize shared data
             var pid = (uint)Process.GetCurrentProcess().Id;
@@ -125,15 +221,19 @@ public class TreadmillSharedMemory : IDisposable
                 LastUpdate = 0,
                 UpdateCount = 0,
                 MasterPid = pid,
-                Reserved1 = 0,
-                Reserved2 = 0,
-                Reserved3 = 0,
+                Heartbeat = Environment.TickCount64,
+                LeaseExpiry = Environment.TickCount64 + LeaseDurationMs,
+                HistoryHead = historyHead,
                 Reserved4 = 0
             };
             
             Logger.Debug($"InitializeAsMaster: Writing initial data (PID={pid})...");
             _accessor.Write(0, ref data);
             _isMaster = true;
+            _hasHistory = true;
+            
+            BeginHighResolutionTimer();
+            StartHeartbeat();
             
             Logger.Info($"Shared memory master ready (PID {pid})");
             return true;
@@ -154,7 +254,8 @@ public class TreadmillSharedMemory : IDisposable
         {
             Logger.Debug("InitializeAsConsumer: Opening existing shared memory...");
             _mappedFile = MemoryMappedFile.OpenExisting(SharedMemoryName, MemoryMappedFileRights.Read);
-            _accessor = _mappedFile.CreateViewAccessor(0, SharedDataSize, MemoryMappedFileAccess.Read);
+            // Map the whole section - masters before v3 created it without the history ring
+            _accessor = _mappedFile.CreateViewAccessor(0, 0, MemoryMappedFileAccess.Read);
             
             SharedData data;
             _accessor.Read(0, out data);
@@ -166,6 +267,8 @@ public class TreadmillSharedMemory : IDisposable
             }
             
             _isMaster = false;
+            _hasHistory = data.Version >= 3 && _accessor.Capacity >= SharedMemorySize;
+            BeginHighResolutionTimer();
             Logger.Info($"Shared memory consumer connected (master PID {data.MasterPid})");
             return true;
         }
@@ -177,26 +280,105 @@ public class TreadmillSharedMemory : IDisposable
     }
 
     /// <summary>
-    /// Write treadmill data (master only)
+    /// Write treadmill data (master only). x/y are the processed stick values,
+    /// everything else comes from the sample.
     /// </summary>
-    public void WriteData(float x, float y, float yaw, int rawX, int rawY)
+    public void WriteData(float x, float y, in OmniSample sample)
     {
         if (!_isMaster || _accessor == null)
             return;
         
-        SharedData data;
-        _accessor.Read(0, out data);
+        // Field-wise writes: the heartbeat thread owns the lease fields concurrently
+        _accessor.Write(OffsetX, x);
+        _accessor.Write(OffsetY, y);
+        _accessor.Write(OffsetYaw, sample.RingAngle);
+        _accessor.Write(OffsetRawX, sample.GamePadX);
+        _accessor.Write(OffsetRawY, sample.GamePadY);
+        _accessor.Write(OffsetConnected, 1u);
+        _accessor.Write(OffsetLastUpdate, DateTimeOffset.UtcNow.ToUnixTimeMilliseconds());
+        WriteHistorySample(x, y, in sample);
+        
+        // Last, like TreadmillSharedRegion::Publish: a consumer woken by the count
+        // must already find the new sample in the history
+        Interlocked.MemoryBarrier();
+        _accessor.Write(OffsetUpdateCount, _accessor.ReadInt64(OffsetUpdateCount) + 1);
+    }
+
+    /// <summary>
+    /// Append one sample to the history ring (master only, single writer).
+    /// </summary>
+    private void WriteHistorySample(float x, float y, in OmniSample source)
+    {
+        var accessor = _accessor!;
+        long index = accessor.ReadInt64(OffsetHistoryHead);
+        long slot = HistoryOffset + (index % HistoryCapacity) * HistorySlotSize;
         
-        data.X = x;
-        data.Y = y;
-        data.Yaw = yaw;
-        data.RawX = rawX;
-        data.RawY = rawY;
-        data.Connected = 1;
-        data.LastUpdate = DateTimeOffset.UtcNow.ToUnixTimeMilliseconds();
-        data.UpdateCount++;
+        var sample = new HistorySample
+        {
+            Seq = 2 * index + 1,
+            TimestampUs = source.TimestampUs,
+            X = x,
+            Y = y,
+            Yaw = source.RingAngle,
+            RawX = source.GamePadX,
+            RawY = source.GamePadY,
+            StepCount = source.StepCount,
+            DeviceTimestamp = source.DeviceTimestamp,
+            RingDelta = source.RingDelta,
+            GunButtonData = source.GunButtonData,
+            StepTrigger = source.StepTrigger,
+            Flags = source.Flags
+        };
         
-        _accessor.Write(0, ref data);
+        // Odd sequence first, so a reader racing this write discards the slot
+        accessor.Write(slot, sample.Seq);
+        Interlocked.MemoryBarrier();
+        accessor.Write(slot, ref sample);
+        Interlocked.MemoryBarrier();
+        accessor.Write(slot, 2 * index + 2);
+        Interlocked.MemoryBarrier();
+        accessor.Write(OffsetHistoryHead, index + 1);
+    }
+
+    /// <summary>
+    /// Copy all complete history samples from nextIndex onwards into buffer, oldest first,
+    /// and advance nextIndex past them. Samples that were already overwritten are skipped.
+    /// Returns the number of samples copied.
+    /// </summary>
+    public int ReadHistory(ref long nextIndex, HistorySample[] buffer)
+    {
+        if (_accessor == null || !_hasHistory)
+            return 0;
+        
+        long head = _accessor.ReadInt64(OffsetHistoryHead);
+        if (nextIndex > head)
+            nextIndex = head; // Writer restarted with a shorter history
+        
+        // Only the newest HistoryCapacity (and buffer.Length) samples are still available
+        long first = Math.Max(nextIndex, head - Math.Min(HistoryCapacity - 1, buffer.Length));
+        int count = 0;
+        
+        for (long index = first; index < head; index++)
+        {
+            long slot = HistoryOffset + (index % HistoryCapacity) * HistorySlotSize;
+            long expectedSeq = 2 * index + 2;
+            
+            if (_accessor.ReadInt64(slot) != expectedSeq)
+                continue;
+            
+            Interlocked.MemoryBarrier();
+            _accessor.Read(slot, out HistorySample sample);
+            Interlocked.MemoryBarrier();
+            
+            // Overwritten while copying
+            if (sample.Seq != expectedSeq || _accessor.ReadInt64(slot) != expectedSeq)
+                continue;
+            
+            buffer[count++] = sample;
+        }
+        
+        nextIndex = head;
+        return count;
     }
 
     /// <summary>
@@ -237,18 +419,132 @@ public class TreadmillSharedMemory : IDisposable
     }
 
     /// <summary>
-    /// Mark as disconnected (master only)
+    /// Check whether the master's lease has run out. expiredForMs tells how long ago.
+    /// Version 1 masters have no lease and are never reported as expired here.
+    /// </summary>
+    public bool IsLeaseExpired(out long expiredForMs)
+    {
+        expiredForMs = 0;
+        
+        if (_accessor == null)
+            return false;
+        
+        if (_accessor.ReadUInt32(0) != Magic || _accessor.ReadUInt32(4) < 2)
+            return false;
+        
+        // LeaseExpiry straddles a cache line (bytes 60-67): read until two reads agree
+        long expiry = _accessor.ReadInt64(OffsetLeaseExpiry);
+        for (long again; (again = _accessor.ReadInt64(OffsetLeaseExpiry)) != expiry;)
+            expiry = again;
+        long now = Environment.TickCount64;
+        if (now < expiry)
+            return false;
+        
+        expiredForMs = expiry == 0 ? long.MaxValue : now - expiry;
+        return true;
+    }
+
+    /// <summary>
+    /// Enter the takeover election. Only one process at a time may try to become
+    /// the new master; the caller must ReleaseMutex() and dispose the returned mutex
+    /// on the same thread.
+    /// </summary>
+    public static Mutex? TryEnterElection()
+    {
+        var election = new Mutex(false, ElectionMutexName);
+        try
+        {
+            if (election.WaitOne(0))
+                return election;
+        }
+        catch (AbandonedMutexException)
+        {
+            // Previous holder died mid-takeover - we own it now
+            return election;
+        }
+        
+        election.Dispose();
+        return null;
+    }
+
+    /// <summary>
+    /// Raise the system timer resolution to 1 ms while attached, so that short
+    /// sleeps in the heartbeat and consumer loops are not rounded up to 15.6 ms.
+    /// </summary>
+    private void BeginHighResolutionTimer()
+    {
+        try { _highResolutionTimer = timeBeginPeriod(1) == 0; } catch { }
+    }
+
+    private void EndHighResolutionTimer()
+    {
+        if (!_highResolutionTimer)
+            return;
+        
+        try { timeEndPeriod(1); } catch { }
+        _highResolutionTimer = false;
+    }
+
+    private void StartHeartbeat()
+    {
+        _heartbeatRunning = true;
+        _heartbeatThread = new Thread(HeartbeatLoop)
+        {
+            IsBackground = true,
+            Priority = ThreadPriority.AboveNormal,
+            Name = "OmniBridge_Heartbeat"
+        };
+        _heartbeatThread.Start();
+    }
+
+    private void StopHeartbeat()
+    {
+        _heartbeatRunning = false;
+        _heartbeatThread?.Join(100);
+        _heartbeatThread = null;
+    }
+
+    /// <summary>
+    /// Renew the master lease independently of motion data, so an idle treadmill
+    /// does not look like a dead master.
+    /// </summary>
+    private void HeartbeatLoop()
+    {
+        try
+        {
+            while (_heartbeatRunning)
+            {
+                var accessor = _accessor;
+                if (accessor == null)
+                    break;
+                
+                long now = Environment.TickCount64;
+                accessor.Write(OffsetHeartbeat, now);
+                accessor.Write(OffsetLeaseExpiry, now + LeaseDurationMs);
+                
+                Thread.Sleep(HeartbeatIntervalMs);
+            }
+        }
+        catch (Exception ex)
+        {
+            Logger.Debug($"HeartbeatLoop: Exception - {ex.Message}");
+        }
+    }
+
+    /// <summary>
+    /// Mark as disconnected (master only). Releases the lease so consumers
+    /// can take over immediately instead of waiting for it to expire.
     /// </summary>
     public void SetDisconnected()
     {
         if (!_isMaster || _accessor == null)
             return;
         
-        SharedData data;
-        _accessor.Read(0, out data);
-        data.Connected = 0;
-        data.MasterPid = 0;
-        _accessor.Write(0, ref data);
+        StopHeartbeat();
+        
+        _accessor.Write(OffsetConnected, 0u);
+        _accessor.Write(OffsetMasterPid, 0u);
+        _accessor.Write(OffsetLeaseExpiry, 0L);
     }
 
     public void Dispose()
@@ -261,6 +557,8 @@ public class TreadmillSharedMemory : IDisposable
             SetDisconnected();
         }
         
+        EndHighResolutionTimer();
+        
         _accessor?.Dispose();
         _mappedFile?.Dispose();
         _mutex?.Dispose();
@@ -0,0 +1,135 @@
+#pragma once
+
+// ============================================================================
+// TreadmillBroadcast - UDP datagrams OmniBridge sends for external consumers
+// ============================================================================
+// With broadcast_format set, OmniBridge sends every broadcast_rate_hz one
+// datagram with all samples since the previous one to broadcast_address:
+// broadcast_port (OmniReader_ConfigureBroadcast, OmniBridge/TreadmillBroadcaster.cs).
+// Overlays, fitness trackers and non-VR games read it without loading
+// OmniBridge or mapping the shared memory.
+//
+// Binary (version 1, little endian):
+//
+//   header  32 bytes  magic "OMTB", version, header size, datagram sequence,
+//                     sample count, sample size, send time, skipped samples
+//   sample  32 bytes  each, oldest first
+//
+// Readers skip headerSize bytes and step by sampleSize, so later versions can
+// append fields without breaking them. Datagram sequence numbers increase by
+// one per datagram, sample sequence numbers are the OmniReader_Poll ones - a
+// gap in either is loss.
+//
+// OSC: one bundle per datagram with /omni/datagram ,ii (datagram sequence,
+// sample count) and one /omni/sample ,ifiiii per sample (sequence, ring
+// angle, gamepad X, gamepad Y, step count, step trigger).
+//
+// Both layouts must match TreadmillBroadcaster.cs. TreadmillBroadcastCli is
+// the loopback receiver.
+// ============================================================================
+
+#include <cstdint>
+#include <cstring>
+
+enum class TreadmillBroadcastFormat : int {
+    Off = 0,
+    Binary = 1,
+    Osc = 2
+};
+
+struct TreadmillBroadcastHeader {
+    uint32_t magic;             // TreadmillBroadcastMagic
+    uint16_t version;
+    uint16_t headerSize;        // offset of the first sample
+    uint32_t sequence;          // 1-based, one per datagram
+    uint16_t sampleCount;
+    uint16_t sampleSize;        // stride between samples
+    int64_t sendTimeUs;         // QPC microseconds when the datagram was sent
+    uint32_t skippedSamples;    // samples that fell out of the ring unsent, total
+    uint32_t reserved;
+};
+
+struct TreadmillBroadcastSample {
+    uint64_t sequence;          // OmniSample::sequence
+    int64_t timestampUs;        // QPC microseconds when the master received the packet
+    float ringAngle;
+    uint32_t stepCount;
+    uint8_t gamePadX;           // 0..255, 127 centered
+    uint8_t gamePadY;
+    uint8_t ringDelta;
+    uint8_t gunButtonData;
+    uint8_t stepTrigger;
+    uint8_t flags;              // OmniSampleFlags
+    uint16_t reserved;
+};
+
+static_assert(sizeof(TreadmillBroadcastHeader) == 32, "must match TreadmillBroadcaster.cs");
+static_assert(sizeof(TreadmillBroadcastSample) == 32, "must match TreadmillBroadcaster.cs");
+
+constexpr uint32_t TreadmillBroadcastMagic = 0x42544D4F;   // "OMTB"
+constexpr uint16_t TreadmillBroadcastVersion = 1;
+constexpr int TreadmillBroadcastDefaultPort = 9870;
+constexpr size_t TreadmillBroadcastMaxDatagram = 1472;     // one Ethernet frame
+
+// Validate a binary datagram. On success header holds the header and samples
+// points at the first sample; read them with TreadmillBroadcastReadSample.
+inline bool TreadmillBroadcastParse(const uint8_t* data, size_t length, TreadmillBroadcastHeader& header, const uint8_t*& samples) {
+    if (length < sizeof(TreadmillBroadcastHeader)) return false;
+    memcpy(&header, data, sizeof(header));
+    if (header.magic != TreadmillBroadcastMagic || header.version < 1) return false;
+    if (header.headerSize < sizeof(TreadmillBroadcastHeader) || header.sampleSize < sizeof(TreadmillBroadcastSample)) return false;
+    if (header.headerSize + static_cast<size_t>(header.sampleCount) * header.sampleSize > length) return false;
+    samples = data + header.headerSize;
+    return true;
+}
+
+inline TreadmillBroadcastSample TreadmillBroadcastReadSample(const uint8_t* samples, const TreadmillBroadcastHeader& header, size_t index) {
+    TreadmillBroadcastSample sample;
+    memcpy(&sample, samples + index * header.sampleSize, sizeof(sample));
+    return sample;
+}
+
+// Minimal OSC reader for the bundles above: walks the elements and calls
+// onMessage(address, typeTags, args, argsLength) for each message.
+namespace TreadmillOsc {
+
+inline size_t Padded(size_t length) { return (length + 4) & ~static_cast<size_t>(3); }
+
+inline int32_t ReadInt(const uint8_t* p) {
+    return static_cast<int32_t>(static_cast<uint32_t>(p[0]) << 24 | static_cast<uint32_t>(p[1]) << 16 |
+        static_cast<uint32_t>(p[2]) << 8 | static_cast<uint32_t>(p[3]));
+}
+
+inline float ReadFloat(const uint8_t* p) {
+    int32_t bits = ReadInt(p);
+    float value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template <typename OnMessage>
+bool ParseBundle(const uint8_t* data, size_t length, OnMessage&& onMessage) {
+    static const char BundleTag[8] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0' };
+    if (length < 16 || memcmp(data, BundleTag, 8) != 0) return false;
+
+    size_t offset = 16;     // tag + time tag
+    while (offset + 4 <= length) {
+        size_t size = static_cast<size_t>(ReadInt(data + offset));
+        offset += 4;
+        if (size > length - offset) return false;
+
+        const char* address = reinterpret_cast<const char*>(data + offset);
+        size_t addressLength = strnlen(address, size);
+        size_t tagsOffset = Padded(addressLength);
+        if (tagsOffset >= size || data[offset + tagsOffset] != ',') return false;
+        const char* tags = reinterpret_cast<const char*>(data + offset + tagsOffset);
+        size_t argsOffset = tagsOffset + Padded(strnlen(tags, size - tagsOffset));
+        if (argsOffset > size) return false;
+
+        onMessage(address, tags + 1, data + offset + argsOffset, size - argsOffset);
+        offset += size;
+    }
+    return offset == length;
+}
+
+}
@@ -0,0 +1,229 @@
+// ============================================================================
+// TreadmillBroadcast - loopback receiver for the OmniBridge UDP broadcast
+// ============================================================================
+// Listens for the datagrams OmniBridge sends with broadcast_format set
+// (TreadmillBroadcast.h), binary or OSC, and reports once per interval:
+//
+//   datagrams, samples    received in the interval
+//   lost                  datagram and sample sequence gaps
+//   skipped               samples the sender dropped before sending
+//   age                   packet received by OmniBridge -> datagram received
+//   transit               datagram sent -> received (binary only)
+//
+//   TreadmillBroadcast.exe [--port <n>] [--bind <address>] [--interval <ms>]
+//                          [--seconds <n>]
+//
+// Both latencies use the QPC clock OmniBridge stamps samples with, so they are
+// only meaningful on the same machine. With --seconds the tool exits after n
+// seconds: 0 if datagrams arrived without loss, 1 on loss, 2 if none arrived.
+// ============================================================================
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using SocketHandle = SOCKET;
+static void CloseSocket(SocketHandle s) { closesocket(s); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+using SocketHandle = int;
+constexpr SocketHandle INVALID_SOCKET = -1;
+static void CloseSocket(SocketHandle s) { close(s); }
+#endif
+
+// After winsock2.h - TreadmillSharedRegion pulls in windows.h
+#include "../TreadmillBroadcast.h"
+#include "../TreadmillLatencyStats.h"
+#include "../TreadmillSampleHistory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct ReceiverStats {
+    uint64_t datagrams = 0;
+    uint64_t samples = 0;
+    uint64_t lostDatagrams = 0;
+    uint64_t lostSamples = 0;
+    uint64_t malformed = 0;
+    uint32_t skippedSamples = 0;    // sender's running total
+    uint32_t lastDatagram = 0;
+    uint64_t lastSample = 0;
+    TreadmillLatencyStats age;
+    TreadmillLatencyStats transit;
+
+    void OnDatagram(uint32_t sequence) {
+        // A sequence that goes backwards is a restarted sender, not loss
+        if (lastDatagram != 0 && sequence > lastDatagram) lostDatagrams += sequence - lastDatagram - 1;
+        lastDatagram = sequence;
+        datagrams++;
+    }
+
+    void OnSample(uint64_t sequence) {
+        if (lastSample != 0 && sequence > lastSample) lostSamples += sequence - lastSample - 1;
+        lastSample = sequence;
+        samples++;
+    }
+};
+
+static void ReceiveBinary(ReceiverStats& stats, const uint8_t* data, size_t length, int64_t nowUs) {
+    TreadmillBroadcastHeader header;
+    const uint8_t* samples = nullptr;
+    if (!TreadmillBroadcastParse(data, length, header, samples)) {
+        stats.malformed++;
+        return;
+    }
+
+    stats.OnDatagram(header.sequence);
+    stats.skippedSamples = header.skippedSamples;
+    stats.transit.Record(nowUs - header.sendTimeUs);
+    for (size_t i = 0; i < header.sampleCount; i++) {
+        TreadmillBroadcastSample sample = TreadmillBroadcastReadSample(samples, header, i);
+        stats.OnSample(sample.sequence);
+        stats.age.Record(nowUs - sample.timestampUs);
+    }
+}
+
+static void ReceiveOsc(ReceiverStats& stats, const uint8_t* data, size_t length) {
+    bool ok = TreadmillOsc::ParseBundle(data, length, [&](const char* address, const char* tags, const uint8_t* args, size_t argsLength) {
+        if (strcmp(address, "/omni/datagram") == 0 && strncmp(tags, "ii", 2) == 0 && argsLength >= 8) {
+            stats.OnDatagram(static_cast<uint32_t>(TreadmillOsc::ReadInt(args)));
+        } else if (strcmp(address, "/omni/sample") == 0 && argsLength >= 4) {
+            // OSC carries the low 32 bits of the sample sequence
+            uint32_t sequence = static_cast<uint32_t>(TreadmillOsc::ReadInt(args));
+            uint64_t full = (stats.lastSample & ~0xFFFFFFFFull) | sequence;
+            if (stats.lastSample != 0 && full < stats.lastSample && stats.lastSample - full > 0x80000000ull) full += 0x100000000ull;
+            stats.OnSample(full);
+        }
+    });
+    if (!ok) stats.malformed++;
+}
+
+static void PrintLatency(const char* name, const TreadmillLatencyStats& latency) {
+    TreadmillLatencyStats::Summary s = latency.GetSummary();
+    if (s.count == 0) {
+        printf("  %-8s -\n", name);
+        return;
+    }
+    printf("  %-8s p50 %7.2f ms  p99 %7.2f ms  max %7.2f ms\n", name, s.p50Us / 1000.0, s.p99Us / 1000.0, s.maxUs / 1000.0);
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillBroadcast [--port <n>] [--bind <address>] [--interval <ms>] [--seconds <n>]\n");
+}
+
+int main(int argc, char** argv) {
+    int port = TreadmillBroadcastDefaultPort;
+    const char* bindAddress = "0.0.0.0";
+    int intervalMs = 1000;
+    int seconds = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bind") == 0 && i + 1 < argc) {
+            bindAddress = argv[++i];
+        } else if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            intervalMs = std::max(100, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::max(1, atoi(argv[++i]));
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    WSADATA wsa;
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) {
+        fprintf(stderr, "WSAStartup failed\n");
+        return 2;
+    }
+#endif
+
+    sockaddr_in local{};
+    local.sin_family = AF_INET;
+    local.sin_port = htons(static_cast<uint16_t>(port));
+    SocketHandle s = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (s == INVALID_SOCKET || inet_pton(AF_INET, bindAddress, &local.sin_addr) != 1 ||
+        bind(s, reinterpret_cast<sockaddr*>(&local), sizeof(local)) != 0) {
+        fprintf(stderr, "Cannot listen on %s:%d\n", bindAddress, port);
+        return 2;
+    }
+
+    // Wake up regularly to print, even when nothing arrives
+#ifdef _WIN32
+    DWORD timeoutMs = 100;
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeoutMs), sizeof(timeoutMs));
+#else
+    timeval timeout{ 0, 100000 };
+    setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+#endif
+
+    printf("Listening on %s:%d\n", bindAddress, port);
+    fflush(stdout);
+
+    ReceiverStats total;
+    ReceiverStats interval;
+    uint8_t buffer[65536];
+    int64_t startUs = TreadmillSampleHistory::NowUs();
+    int64_t nextPrintUs = startUs + intervalMs * 1000LL;
+
+    for (;;) {
+        int received = static_cast<int>(recv(s, reinterpret_cast<char*>(buffer), sizeof(buffer), 0));
+        int64_t nowUs = TreadmillSampleHistory::NowUs();
+
+        if (received > 0) {
+            static const uint8_t BundleTag[4] = { '#', 'b', 'u', 'n' };
+            bool osc = received >= 4 && memcmp(buffer, BundleTag, 4) == 0;
+            for (ReceiverStats* stats : { &total, &interval }) {
+                if (osc) {
+                    ReceiveOsc(*stats, buffer, static_cast<size_t>(received));
+                } else {
+                    ReceiveBinary(*stats, buffer, static_cast<size_t>(received), nowUs);
+                }
+            }
+        }
+
+        if (nowUs >= nextPrintUs) {
+            nextPrintUs += intervalMs * 1000LL;
+            printf("datagrams %llu  samples %llu  lost %llu/%llu  skipped %u  malformed %llu\n",
+                static_cast<unsigned long long>(interval.datagrams), static_cast<unsigned long long>(interval.samples),
+                static_cast<unsigned long long>(interval.lostDatagrams), static_cast<unsigned long long>(interval.lostSamples),
+                total.skippedSamples, static_cast<unsigned long long>(interval.malformed));
+            PrintLatency("age", interval.age);
+            PrintLatency("transit", interval.transit);
+            fflush(stdout);
+
+            // Carry the sequence cursors over, restart the counters
+            uint32_t lastDatagram = interval.lastDatagram;
+            uint64_t lastSample = interval.lastSample;
+            interval.datagrams = interval.samples = interval.lostDatagrams = interval.lostSamples = interval.malformed = 0;
+            interval.lastDatagram = lastDatagram;
+            interval.lastSample = lastSample;
+            interval.age.Reset();
+            interval.transit.Reset();
+        }
+
+        if (seconds > 0 && nowUs - startUs >= seconds * 1000000LL) break;
+    }
+
+    CloseSocket(s);
+#ifdef _WIN32
+    WSACleanup();
+#endif
+
+    printf("total: datagrams %llu  samples %llu  lost %llu/%llu  malformed %llu\n",
+        static_cast<unsigned long long>(total.datagrams), static_cast<unsigned long long>(total.samples),
+        static_cast<unsigned long long>(total.lostDatagrams), static_cast<unsigned long long>(total.lostSamples),
+        static_cast<unsigned long long>(total.malformed));
+    PrintLatency("age", total.age);
+    PrintLatency("transit", total.transit);
+
+    if (total.datagrams == 0) return 2;
+    return total.lostDatagrams + total.lostSamples + total.malformed > 0 ? 1 : 0;
+}
@@ -0,0 +1,373 @@
+#pragma once
+
+// ============================================================================
+// TreadmillCalibration - learn game behaviour from HMD displacement
+// ============================================================================
+// When a game moves the player, the HMD moves through the play space by the
+// game's response to our joystick. Comparing that displacement with what we
+// sent over a short window tells us
+//   - the game's speed per joystick unit (TreadmillSpeedCalibrator)
+//   - the yaw offset between ring angle and game world (TreadmillYawOffsetEstimator)
+//
+// TreadmillMotionWindow turns per-frame HMD positions and joystick output
+// into such windows. All classes are cheap and meant to run on the frame
+// thread outside g_state.mtx.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <mutex>
+
+// One window of play-space movement against the joystick output sent meanwhile
+struct TreadmillMotionObservation {
+    double seconds = 0.0;
+    float actualX = 0.0f;       // HMD displacement, metres
+    float actualZ = 0.0f;
+    float commandX = 0.0f;      // mean joystick direction in world space (unit-less)
+    float commandZ = 0.0f;
+    float intendedX = 0.0f;     // mean joystick direction turned by the HMD heading
+    float intendedZ = 0.0f;
+    float stick = 0.0f;         // mean joystick magnitude sent to the game [0, 1]
+    bool saturated = false;     // output was clamped at some point
+};
+
+class TreadmillMotionWindow {
+public:
+    static constexpr int64_t WindowUs = 500000;
+    static constexpr int64_t MaxFrameGapUs = 100000;   // longer gaps discard the window
+
+    // Feed one frame. Returns true and fills obs when a window completes.
+    bool AddFrame(int64_t timeUs, float hmdX, float hmdZ,
+                  float commandX, float commandZ, float intendedX, float intendedZ,
+                  float stick, bool saturated, TreadmillMotionObservation& obs) {
+        if (!m_started || timeUs - m_lastTimeUs > MaxFrameGapUs || timeUs < m_lastTimeUs) {
+            Start(timeUs, hmdX, hmdZ);
+            return false;
+        }
+
+        // Weight by frame time so uneven frame pacing does not bias the mean
+        double dt = (timeUs - m_lastTimeUs) * 1e-6;
+        m_lastTimeUs = timeUs;
+        m_commandX += commandX * dt;
+        m_commandZ += commandZ * dt;
+        m_intendedX += intendedX * dt;
+        m_intendedZ += intendedZ * dt;
+        m_stick += stick * dt;
+        m_saturated = m_saturated || saturated;
+
+        if (timeUs - m_startTimeUs < WindowUs) return false;
+
+        double seconds = (timeUs - m_startTimeUs) * 1e-6;
+        obs.seconds = seconds;
+        obs.actualX = hmdX - m_startX;
+        obs.actualZ = hmdZ - m_startZ;
+        obs.commandX = static_cast<float>(m_commandX / seconds);
+        obs.commandZ = static_cast<float>(m_commandZ / seconds);
+        obs.intendedX = static_cast<float>(m_intendedX / seconds);
+        obs.intendedZ = static_cast<float>(m_intendedZ / seconds);
+        obs.stick = static_cast<float>(m_stick / seconds);
+        obs.saturated = m_saturated;
+
+        Start(timeUs, hmdX, hmdZ);
+        return true;
+    }
+
+    void Reset() { m_started = false; }
+
+private:
+    bool m_started = false;
+    int64_t m_startTimeUs = 0;
+    int64_t m_lastTimeUs = 0;
+    float m_startX = 0.0f;
+    float m_startZ = 0.0f;
+    double m_commandX = 0.0;
+    double m_commandZ = 0.0;
+    double m_intendedX = 0.0;
+    double m_intendedZ = 0.0;
+    double m_stick = 0.0;
+    bool m_saturated = false;
+
+    void Start(int64_t timeUs, float hmdX, float hmdZ) {
+        m_started = true;
+        m_startTimeUs = timeUs;
+        m_lastTimeUs = timeUs;
+        m_startX = hmdX;
+        m_startZ = hmdZ;
+        m_commandX = m_commandZ = m_intendedX = m_intendedZ = m_stick = 0.0;
+        m_saturated = false;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// TreadmillSpeedCalibrator - game speed per joystick unit
+// ----------------------------------------------------------------------------
+// Scalar recursive least squares with forgetting on
+//     actual speed (m/s) = gain * joystick magnitude
+// Windows where the joystick saturated, barely moved, or whose residual is
+// far outside the running residual spread (teleports, vehicles, cutscenes)
+// are rejected.
+class TreadmillSpeedCalibrator {
+public:
+    static constexpr double Forgetting = 0.995;     // ~200 windows memory
+    static constexpr float MinStick = 0.15f;
+    static constexpr double OutlierSigma = 3.0;
+    static constexpr uint64_t MinAccepted = 20;     // before a factor is suggested
+    static constexpr int MaxConsecutiveRejects = 10; // then the game changed - relearn
+
+    struct Stats {
+        uint64_t accepted = 0;
+        uint64_t rejected = 0;
+        double gain = 0.0;          // game m/s per joystick unit
+        double residualStd = 0.0;   // m/s
+        bool converged = false;
+    };
+
+    // Returns true if the window was used
+    bool Add(const TreadmillMotionObservation& obs) {
+        if (obs.saturated || obs.stick < MinStick || obs.seconds <= 0.0) return false;
+
+        double u = obs.stick;
+        double y = std::sqrt(obs.actualX * obs.actualX + obs.actualZ * obs.actualZ) / obs.seconds;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        double residual = y - m_gain * u;
+
+        // Gate once the spread is known; the first windows only seed it
+        if (m_accepted >= MinAccepted / 2 &&
+            std::fabs(residual) > OutlierSigma * std::sqrt(m_residualVar) + 0.05) {
+            m_rejected++;
+            if (++m_consecutiveRejects < MaxConsecutiveRejects) return false;
+            // Persistent disagreement is a new game speed, not an outlier
+            m_p = InitialP;
+            m_residualVar = residual * residual;
+        }
+        m_consecutiveRejects = 0;
+
+        double k = m_p * u / (Forgetting + u * m_p * u);
+        m_gain += k * residual;
+        m_p = (m_p - k * u * m_p) / Forgetting;
+
+        double r = y - m_gain * u;
+        m_residualVar += (m_accepted == 0 ? 1.0 : 0.05) * (r * r - m_residualVar);
+        m_accepted++;
+        return true;
+    }
+
+    // speed_factor that makes a treadmill stick of 1.0 (before speed_factor)
+    // move the player at targetSpeed m/s. 0 until converged.
+    float SuggestSpeedFactor(float targetSpeed) const {
+        Stats s = GetStats();
+        if (!s.converged || s.gain <= 0.01) return 0.0f;
+        return std::clamp(static_cast<float>(targetSpeed / s.gain), 0.1f, 10.0f);
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats s;
+        s.accepted = m_accepted;
+        s.rejected = m_rejected;
+        s.gain = m_gain;
+        s.residualStd = std::sqrt(m_residualVar);
+        s.converged = m_accepted >= MinAccepted && m_gain > 0.0;
+        return s;
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_gain = 0.0;
+        m_p = InitialP;
+        m_residualVar = 0.0;
+        m_accepted = 0;
+        m_rejected = 0;
+        m_consecutiveRejects = 0;
+    }
+
+private:
+    static constexpr double InitialP = 100.0;
+
+    mutable std::mutex m_mutex;
+    double m_gain = 0.0;
+    double m_p = InitialP;
+    double m_residualVar = 0.0;
+    uint64_t m_accepted = 0;
+    uint64_t m_rejected = 0;
+    int m_consecutiveRejects = 0;
+};
+
+// ----------------------------------------------------------------------------
+// TreadmillYawOffsetEstimator - ring zero vs. game world forward
+// ----------------------------------------------------------------------------
+// Each window gives the signed angle from the direction the player actually
+// moved to the direction they meant to go: the joystick direction turned by
+// the HMD's heading. Windows are averaged in batches of BatchWindows as a
+// circular mean (unit vectors), so 359° and 1° average to 0°. Within a batch,
+// windows far from its mean (strafing by the game, knock-back, teleports) are
+// gated, and a batch whose windows scatter is dropped.
+//
+// The offset is applied through the controller pose the game steers by, so
+// it turns the very motion it is estimated from. The estimator models that
+// loop: after each step the caller applies, the next batch shows how much of
+// the step came back as a smaller residual. That ratio, the loop gain, is
+// 1 when the offset turns the motion one to one, 0 when the game ignores it
+// and negative when the game turns the other way. Steps are
+// Gain * residual / loop gain. Once enough steps have been taken to know, a
+// loop gain near 0 means the residual does not shrink: Add returns Stop and
+// the caller goes back to the raw ring angle.
+class TreadmillYawOffsetEstimator {
+public:
+    static constexpr float MinStick = 0.2f;
+    static constexpr float MinDistance = 0.1f;       // metres per window
+    static constexpr int BatchWindows = 10;          // ~5 s of walking per decision
+    static constexpr int GateAfterWindows = 4;
+    static constexpr double GateDegrees = 30.0;
+    static constexpr int MaxConsecutiveRejects = 5;
+    static constexpr double MinConcentration = 0.8;  // resultant length to use a batch
+    static constexpr double SettledDeg = 3.0;        // residual left as noise
+    static constexpr double Gain = 0.5;              // fraction of the residual corrected per batch
+    static constexpr double MinProbeDeg = 5.0;       // smallest step while the loop gain is unknown
+    static constexpr double MaxStepDeg = 45.0;
+    static constexpr double MinLoopGain = 0.3;
+    static constexpr double LoopGainEvidenceDeg = 20.0;  // RMS of the steps taken before judging
+    static constexpr double MaxTotalStepDeg = 180.0; // more correction than any real offset needs
+
+    enum class Decision {
+        None,       // no batch completed
+        Hold,       // batch done, nothing to change
+        Step,       // add stepDeg to the applied offset
+        Stop        // the offset does not steer the motion - drop it
+    };
+
+    struct Stats {
+        uint64_t accepted = 0;
+        uint64_t rejected = 0;
+        uint64_t batches = 0;
+        double residualDeg = 0.0;   // last batch, still to add to the applied offset
+        double concentration = 0.0; // last batch, 0 = scattered, 1 = all windows agree
+        double loopGain = 1.0;      // residual change per degree of step, 1 until measured
+        double totalStepDeg = 0.0;  // sum of steps since the last Reset
+        bool settled = false;       // last batch within SettledDeg
+    };
+
+    Decision Add(const TreadmillMotionObservation& obs, double& stepDeg) {
+        stepDeg = 0.0;
+        float distance = std::sqrt(obs.actualX * obs.actualX + obs.actualZ * obs.actualZ);
+        float intended = std::sqrt(obs.intendedX * obs.intendedX + obs.intendedZ * obs.intendedZ);
+        if (obs.stick < MinStick || distance < MinDistance || intended < 0.01f) return Decision::None;
+
+        // Signed angle from actual to intended direction: what the offset still has to turn
+        double cross = obs.actualX * obs.intendedZ - obs.actualZ * obs.intendedX;
+        double dot = obs.actualX * obs.intendedX + obs.actualZ * obs.intendedZ;
+        double angle = std::atan2(cross, dot);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_batchCount >= GateAfterWindows) {
+            double diff = std::remainder(angle - std::atan2(m_sin, m_cos), 2.0 * Pi);
+            if (std::fabs(diff) > GateDegrees * Pi / 180.0) {
+                m_rejected++;
+                if (++m_consecutiveRejects < MaxConsecutiveRejects) return Decision::None;
+                // The world turned (recenter, new level) - this batch starts over from here
+                m_cos = m_sin = 0.0;
+                m_batchCount = 0;
+            }
+        }
+        m_consecutiveRejects = 0;
+        m_cos += std::cos(angle);
+        m_sin += std::sin(angle);
+        m_accepted++;
+        if (++m_batchCount < BatchWindows) return Decision::None;
+
+        double concentration = std::sqrt(m_cos * m_cos + m_sin * m_sin) / m_batchCount;
+        double residual = std::atan2(m_sin, m_cos) * 180.0 / Pi;
+        m_cos = m_sin = 0.0;
+        m_batchCount = 0;
+        m_concentration = concentration;
+        if (concentration < MinConcentration) return Decision::Hold;   // the pending step waits for a clean batch
+
+        // How much of the previous step came back as a smaller residual
+        if (m_hasResidual && std::fabs(m_pendingStep) >= 1.0) {
+            double change = std::remainder(m_residual - residual, 360.0);
+            m_stepChange += m_pendingStep * change;
+            m_stepSquared += m_pendingStep * m_pendingStep;
+        }
+        m_pendingStep = 0.0;
+        m_residual = residual;
+        m_hasResidual = true;
+        m_batches++;
+
+        bool gainKnown = m_stepSquared >= LoopGainEvidenceDeg * LoopGainEvidenceDeg;
+        double loopGain = LoopGain();
+        if (gainKnown && std::fabs(loopGain) < MinLoopGain) return Decision::Stop;
+        if (std::fabs(residual) <= SettledDeg) return Decision::Hold;
+
+        double step;
+        if (std::fabs(loopGain) >= MinLoopGain) {
+            step = Gain * residual / loopGain;
+        } else {
+            // Not enough evidence yet - keep probing as if the offset turned the motion one to one
+            step = Gain * residual;
+        }
+        if (!gainKnown && std::fabs(step) < MinProbeDeg) step = std::copysign(MinProbeDeg, step);
+        step = std::clamp(step, -MaxStepDeg, MaxStepDeg);
+        if (std::fabs(m_totalStep + step) > MaxTotalStepDeg) return Decision::Stop;
+
+        m_pendingStep = step;
+        m_totalStep += step;
+        stepDeg = step;
+        return Decision::Step;
+    }
+
+    Stats GetStats() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Stats s;
+        s.accepted = m_accepted;
+        s.rejected = m_rejected;
+        s.batches = m_batches;
+        s.residualDeg = m_residual;
+        s.concentration = m_concentration;
+        s.loopGain = LoopGain();
+        s.totalStepDeg = m_totalStep;
+        s.settled = m_hasResidual && std::fabs(m_residual) <= SettledDeg;
+        return s;
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_cos = m_sin = 0.0;
+        m_batchCount = 0;
+        m_consecutiveRejects = 0;
+        m_concentration = 0.0;
+        m_hasResidual = false;
+        m_residual = 0.0;
+        m_pendingStep = 0.0;
+        m_stepChange = m_stepSquared = 0.0;
+        m_totalStep = 0.0;
+        m_accepted = 0;
+        m_rejected = 0;
+        m_batches = 0;
+    }
+
+private:
+    static constexpr double Pi = 3.14159265358979323846;
+
+    // Least squares through the origin: residual change = loop gain * step
+    double LoopGain() const {
+        return m_stepSquared > 0.0 ? m_stepChange / m_stepSquared : 1.0;
+    }
+
+    mutable std::mutex m_mutex;
+    double m_cos = 0.0;         // current batch
+    double m_sin = 0.0;
+    int m_batchCount = 0;
+    int m_consecutiveRejects = 0;
+    double m_concentration = 0.0;
+    bool m_hasResidual = false;
+    double m_residual = 0.0;    // last clean batch
+    double m_pendingStep = 0.0; // applied after it, not yet measured
+    double m_stepChange = 0.0;
+    double m_stepSquared = 0.0;
+    double m_totalStep = 0.0;
+    uint64_t m_accepted = 0;
+    uint64_t m_rejected = 0;
+    uint64_t m_batches = 0;
+};
@@ -0,0 +1,172 @@
+#pragma once
+
+// ============================================================================
+// TreadmillCallProfile - per-call cost of the driver hot paths
+// ============================================================================
+// Records nanoseconds per call of the sample and frame paths (OnOmniData,
+// UpdateInputs, both GetPose) and the wait for g_state.mtx, so changes to
+// those paths can be compared on the user's machine with DebugRequest
+// "profile". Disabled by default; while disabled a timer costs one relaxed
+// atomic load.
+//
+// SetBaseline() keeps the current summary; ToJson() then also reports the
+// p50 change against it, e.g. before/after switching filter or debug logging.
+// ============================================================================
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TreadmillCallProfile {
+public:
+    static constexpr size_t Window = 4096;
+
+    struct Summary {
+        uint64_t count = 0;     // calls recorded since the last Reset
+        int64_t meanNs = 0;
+        int64_t p50Ns = 0;      // percentiles over the last Window calls
+        int64_t p99Ns = 0;
+        int64_t maxNs = 0;      // max since the last Reset
+    };
+
+    // One switch for all profiles
+    static void SetEnabled(bool enabled) { s_enabled.store(enabled, std::memory_order_relaxed); }
+    static bool IsEnabled() { return s_enabled.load(std::memory_order_relaxed); }
+
+    static int64_t NowNs() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    void Record(int64_t ns) {
+        if (ns < 0) ns = 0;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_values.size() < Window) {
+            m_values.push_back(ns);
+        } else {
+            m_values[m_count % Window] = ns;
+        }
+        m_count++;
+        m_total += ns;
+        m_max = std::max(m_max, ns);
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_values.clear();
+        m_count = 0;
+        m_total = 0;
+        m_max = 0;
+    }
+
+    Summary GetSummary() const {
+        std::vector<int64_t> sorted;
+        Summary s;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sorted = m_values;
+            s.count = m_count;
+            s.meanNs = m_count > 0 ? m_total / static_cast<int64_t>(m_count) : 0;
+            s.maxNs = m_max;
+        }
+        if (sorted.empty()) return s;
+
+        std::sort(sorted.begin(), sorted.end());
+        s.p50Ns = sorted[(sorted.size() - 1) * 50 / 100];
+        s.p99Ns = sorted[(sorted.size() - 1) * 99 / 100];
+        return s;
+    }
+
+    void SetBaseline() {
+        Summary s = GetSummary();
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_baseline = s;
+        m_hasBaseline = s.count > 0;
+    }
+
+    // Baseline from an earlier run, e.g. a stored benchmark result
+    void SetBaseline(const Summary& s) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_baseline = s;
+        m_hasBaseline = s.p50Ns > 0;
+    }
+
+    // "name":{"count":N,"mean_ns":N,"p50_ns":N,"p99_ns":N,"max_ns":N[,"baseline_p50_ns":N,"p50_change_pct":F]}
+    std::string ToJson(const char* name) const {
+        Summary s = GetSummary();
+        Summary base;
+        bool hasBaseline;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            base = m_baseline;
+            hasBaseline = m_hasBaseline;
+        }
+
+        char buf[320];
+        int n = snprintf(buf, sizeof(buf), "\"%s\":{\"count\":%llu,\"mean_ns\":%lld,\"p50_ns\":%lld,\"p99_ns\":%lld,\"max_ns\":%lld",
+            name, static_cast<unsigned long long>(s.count), static_cast<long long>(s.meanNs),
+            static_cast<long long>(s.p50Ns), static_cast<long long>(s.p99Ns), static_cast<long long>(s.maxNs));
+        if (hasBaseline && base.p50Ns > 0 && n > 0 && n < static_cast<int>(sizeof(buf))) {
+            double change = 100.0 * static_cast<double>(s.p50Ns - base.p50Ns) / static_cast<double>(base.p50Ns);
+            snprintf(buf + n, sizeof(buf) - n, ",\"baseline_p50_ns\":%lld,\"p50_change_pct\":%.1f",
+                static_cast<long long>(base.p50Ns), change);
+        }
+        return std::string(buf) + "}";
+    }
+
+private:
+    static inline std::atomic<bool> s_enabled{ false };
+
+    mutable std::mutex m_mutex;
+    std::vector<int64_t> m_values;
+    uint64_t m_count = 0;
+    int64_t m_total = 0;
+    int64_t m_max = 0;
+    Summary m_baseline;
+    bool m_hasBaseline = false;
+};
+
+// Times the enclosing scope into a profile
+class TreadmillCallTimer {
+public:
+    explicit TreadmillCallTimer(TreadmillCallProfile& profile)
+        : m_profile(profile), m_startNs(TreadmillCallProfile::IsEnabled() ? TreadmillCallProfile::NowNs() : 0) {}
+
+    ~TreadmillCallTimer() {
+        if (m_startNs != 0) m_profile.Record(TreadmillCallProfile::NowNs() - m_startNs);
+    }
+
+    TreadmillCallTimer(const TreadmillCallTimer&) = delete;
+    TreadmillCallTimer& operator=(const TreadmillCallTimer&) = delete;
+
+private:
+    TreadmillCallProfile& m_profile;
+    int64_t m_startNs;
+};
+
+// std::lock_guard that records how long acquiring the mutex took (contention)
+class TreadmillTimedLock {
+public:
+    TreadmillTimedLock(std::mutex& mutex, TreadmillCallProfile& waitProfile) : m_mutex(mutex) {
+        if (!TreadmillCallProfile::IsEnabled()) {
+            m_mutex.lock();
+            return;
+        }
+        int64_t start = TreadmillCallProfile::NowNs();
+        m_mutex.lock();
+        waitProfile.Record(TreadmillCallProfile::NowNs() - start);
+    }
+
+    ~TreadmillTimedLock() { m_mutex.unlock(); }
+
+    TreadmillTimedLock(const TreadmillTimedLock&) = delete;
+    TreadmillTimedLock& operator=(const TreadmillTimedLock&) = delete;
+
+private:
+    std::mutex& m_mutex;
+};
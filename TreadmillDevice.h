@@ -1,6 +1,8 @@
 #pragma once
 
 #include "openvr_driver.h"
+#include "TreadmillCalibration.h"
+#include "TreadmillFootTracking.h"
 #include <atomic>
 #include <array>
 #include <string>
@@ -16,6 +18,8 @@ enum MyComponent
 {
     MyComponent_joystick_x,
     MyComponent_joystick_y,
+    MyComponent_step_click,     // footfall (StepTrigger, else StepCount)
+    MyComponent_speed_value,    // joystick magnitude after speed_factor
     MyComponent_MAX
 };
 
@@ -28,6 +32,10 @@ private:
     unsigned int my_tracker_id_;
     vr::DriverPose_t m_pose{};
     std::array<vr::VRInputComponentHandle_t, MyComponent_MAX> input_handles_;
+    bool step_pressed_ = false;
+    int64_t step_press_time_us_ = 0;
+    static constexpr int64_t StepClickHoldUs = 50000;   // how long step_click stays down
+    static constexpr int64_t StepClickGapUs = 1000;     // up time between back-to-back steps
 
 public:
     vr::TrackedDeviceIndex_t m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
@@ -60,4 +68,41 @@ public:
     void EnterStandby() override;
     void* GetComponent(const char* pchComponentNameAndVersion) override;
     void DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) override;
-};
\ No newline at end of file
+
+private:
+    // HMD displacement vs. joystick output, feeds the calibration estimators
+    TreadmillMotionWindow m_motionWindow;
+    void UpdateCalibration(float hmdX, float hmdZ, float hmdForwardX, float hmdForwardZ,
+                           float yawDeg, float joystickX, float joystickY);
+};
+
+// Foot tracker from an Omni pod (foot_trackers): pod 1 left, pod 2 right
+class TreadmillFootTracker : public vr::ITrackedDeviceServerDriver {
+public:
+    vr::TrackedDeviceIndex_t m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
+
+    explicit TreadmillFootTracker(int foot);  // 0 = left, 1 = right
+    
+    const char* SerialNumber() const;
+    void OnPodSample(const float wxyz[4], int64_t timeUs);  // publishing thread
+    vr::DriverPose_t GetPose();
+    
+    vr::EVRInitError Activate(vr::TrackedDeviceIndex_t unObjectId) override;
+    void Deactivate() override;
+    void EnterStandby() override;
+    void* GetComponent(const char* pchComponentNameAndVersion) override;
+    void DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) override;
+
+private:
+    int m_foot;
+    vr::DriverPose_t m_pose{};
+    TreadmillPodOrientation m_orientation;
+    TreadmillQuaternion m_rotation;     // as of the last pod sample
+    double m_angularVelocity[3] = {};
+    int64_t m_lastPodUs = 0;
+    uint32_t m_neutralGeneration = 0;
+};
+
+// Once per published frame before the foot trackers' GetPose: heading,
+// HMD-based floor position and the gait model (publishing thread)
+void AdvanceFootGait(int64_t timeUs);
\ No newline at end of file
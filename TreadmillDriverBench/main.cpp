@@ -0,0 +1,336 @@
+// ============================================================================
+// TreadmillDriverBench - ns per call of the driver's sample and frame paths
+// ============================================================================
+// Links driver_treadmill.cpp and TreadmillServerDriver.cpp against the mock
+// vrserver of the driver tests (../TreadmillDriverTests/MockHost.h). Like the
+// tests, the executable is its own OmniBridge: it exports OmniReader_* without
+// OmniReader_Poll, so the driver registers OnOmniData as the data callback and
+// the bench calls it the way OmniBridge's serial thread would.
+//
+//   omni_sample      the registered data callback (OnOmniData)
+//   update_inputs    TreadmillDevice::UpdateInputs
+//   controller_pose  TreadmillDevice::GetPose
+//   tracker_pose     TreadmillVisualTracker::GetPose
+//
+// Each path runs in every combination of
+//
+//   warm | cold              batches of calls | one call after evicting the caches
+//   uncontended | contended  alone | with a second thread running the other
+//                            side (frame paths vs. sample callback) on g_state
+//   log_off | log_on         debug logging off | on (into the mock log)
+//
+// and reports count, mean, p50, p99 and max ns per call, as JSON with --json.
+// With a baseline (a previous --json file) every entry also reports its p50
+// change, and --max-regression-pct turns a slower p50 into a failure.
+//
+//   TreadmillDriverBench.exe [--calls <n>] [--json <file>] [--baseline <file>]
+//                            [--update] [--max-regression-pct <n>]
+//
+// The baseline defaults to baseline.json in the working directory; --update
+// rewrites it from this run. Exit code 0 if within the regression limit (or
+// no limit), 1 on a regression, 2 if the bench could not run.
+// ============================================================================
+
+#include "../TreadmillDriverTests/MockHost.h"
+#include "../MinimalOmniReader.h"
+#include "../TreadmillCallProfile.h"
+#include "../TreadmillDevice.h"
+#include "../TreadmillServerDriver.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+extern "C" void* HmdDriverFactory(const char* pInterfaceName, int* pReturnCode);
+extern std::atomic<TreadmillConnectionState> g_connectionState;
+extern std::atomic<bool> g_debug;
+
+static constexpr int BatchCalls = 32;                   // warm: calls per timed batch
+static constexpr size_t EvictBytes = 32 * 1024 * 1024;  // cold: larger than the last level cache
+
+// ----------------------------------------------------------------------------
+// OmniBridge stand-in: callback only, samples come from the bench
+// ----------------------------------------------------------------------------
+
+static int g_fakeReader;
+static std::atomic<OmniDataCallback> g_callback{ nullptr };
+
+extern "C" __declspec(dllexport) void* OmniReader_Create() { return &g_fakeReader; }
+extern "C" __declspec(dllexport) bool OmniReader_Initialize(void*, const char*, int, int) { return true; }
+extern "C" __declspec(dllexport) void OmniReader_RegisterCallback(void*, OmniDataCallback callback) { g_callback.store(callback); }
+extern "C" __declspec(dllexport) void OmniReader_Disconnect(void*) {}
+extern "C" __declspec(dllexport) void OmniReader_Destroy(void*) {}
+
+// ----------------------------------------------------------------------------
+
+static std::string SelfPath() {
+    char path[MAX_PATH] = {};
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return path;
+}
+
+// Writes every cache line of a buffer larger than the caches
+static void EvictCaches() {
+    static std::vector<uint8_t> buffer(EvictBytes);
+    for (size_t i = 0; i < buffer.size(); i += 64) buffer[i]++;
+}
+
+struct Options {
+    int calls = 4096;                   // per entry: warm batches, cold calls / 8
+    std::string json;
+    std::string baseline = "baseline.json";
+    bool update = false;
+    double maxRegressionPct = 0.0;      // 0 = report only
+};
+
+struct Paths {
+    TreadmillDevice* controller = nullptr;
+    TreadmillVisualTracker* tracker = nullptr;
+    uint64_t sample = 0;
+
+    // Walking at a varying speed while turning, so the filters do real work
+    void Sample() {
+        double t = static_cast<double>(sample++);
+        float angle = static_cast<float>(std::fmod(t * 0.7, 360.0));
+        int x = 127 + static_cast<int>(std::lround(60.0 * std::sin(t * 0.013)));
+        int y = 127 + static_cast<int>(std::lround(100.0 * std::cos(t * 0.007)));
+        g_callback.load()(angle, x, y);
+    }
+
+    void Frame() {
+        controller->UpdateInputs();
+        controller->GetPose();
+        tracker->GetPose();
+    }
+};
+
+// Runs a competitor on another thread for the lifetime of the object
+class Contention {
+public:
+    explicit Contention(std::function<void()> work) {
+        if (!work) return;
+        m_thread = std::thread([this, work] {
+            while (!m_stop.load(std::memory_order_relaxed)) work();
+        });
+    }
+    ~Contention() {
+        m_stop.store(true);
+        if (m_thread.joinable()) m_thread.join();
+    }
+
+private:
+    std::atomic<bool> m_stop{ false };
+    std::thread m_thread;
+};
+
+static void Measure(TreadmillCallProfile& profile, const std::function<void()>& call, bool cold, int calls) {
+    for (int i = 0; i < 256; i++) call();  // settle filters, branch predictors, lazy allocations
+    if (cold) {
+        for (int i = 0; i < std::max(1, calls / 8); i++) {
+            EvictCaches();
+            int64_t startNs = TreadmillCallProfile::NowNs();
+            call();
+            profile.Record(TreadmillCallProfile::NowNs() - startNs);
+        }
+        return;
+    }
+    for (int i = 0; i < calls; i++) {
+        int64_t startNs = TreadmillCallProfile::NowNs();
+        for (int j = 0; j < BatchCalls; j++) call();
+        profile.Record((TreadmillCallProfile::NowNs() - startNs) / BatchCalls);
+    }
+}
+
+// "name":{...,"p50_ns":N,...} of a previous result, 0 if absent
+static TreadmillCallProfile::Summary FindBaseline(const std::string& json, const std::string& name) {
+    TreadmillCallProfile::Summary s;
+    size_t at = json.find("\"" + name + "\":{");
+    if (at == std::string::npos) return s;
+    unsigned long long count = 0;
+    long long mean = 0, p50 = 0, p99 = 0, max = 0;
+    if (sscanf(json.c_str() + at + name.size() + 4, "\"count\":%llu,\"mean_ns\":%lld,\"p50_ns\":%lld,\"p99_ns\":%lld,\"max_ns\":%lld",
+            &count, &mean, &p50, &p99, &max) == 5) {
+        s.count = count;
+        s.meanNs = mean;
+        s.p50Ns = p50;
+        s.p99Ns = p99;
+        s.maxNs = max;
+    }
+    return s;
+}
+
+static int RunBench(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider, const Options& options) {
+    context.settings.Clear();
+    context.settings.Set("driver_treadmill", "mytracker_model_number", "treadmill_bench");
+    context.settings.Set("driver_treadmill", "debug", "false");
+    context.settings.Set("driver_treadmill", "omnibridge_dll_path", SelfPath());
+    context.settings.Set("driver_treadmill", "frame_sampling", "false");        // OnOmniData feeds g_state
+    context.settings.Set("driver_treadmill", "publisher_thread", "false");
+    context.settings.Set("driver_treadmill", "frame_budget_degrade", "false");
+    context.settings.Set("driver_treadmill", "foot_trackers", "false");
+    if (provider->Init(&context) != vr::VRInitError_None) {
+        fprintf(stderr, "Init failed\n");
+        return 2;
+    }
+    for (int waitedMs = 0; g_connectionState.load() != TreadmillConnectionState::Streaming || !g_callback.load(); waitedMs += 10) {
+        if (waitedMs >= 5000) {
+            fprintf(stderr, "Driver did not connect to the bench's OmniReader_* exports\n");
+            context.host.DeactivateAll();
+            provider->Cleanup();
+            return 2;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    const MockDevices::Device* controller = context.devices.Find("treadmill_controller");
+    const MockDevices::Device* tracker = context.devices.Find("treadmill_visual_tracker");
+    if (!controller || !tracker) {
+        fprintf(stderr, "Driver did not add its devices\n");
+        context.host.DeactivateAll();
+        provider->Cleanup();
+        return 2;
+    }
+    Paths paths;
+    paths.controller = static_cast<TreadmillDevice*>(controller->driver);
+    paths.tracker = static_cast<TreadmillVisualTracker*>(tracker->driver);
+    context.host.SetHmdPose(0.0, 1.7, 0.0);
+
+    std::string baselineJson;
+    {
+        std::ifstream in(options.baseline, std::ios::binary);
+        std::stringstream text;
+        text << in.rdbuf();
+        baselineJson = text.str();
+    }
+    if (baselineJson.empty() && !options.update) printf("no baseline %s - reporting without comparison\n", options.baseline.c_str());
+
+    struct Target {
+        const char* name;
+        std::function<void()> call;
+        std::function<void()> competitor;  // the other side of g_state.mtx
+    };
+    const Target targets[] = {
+        { "omni_sample", [&] { paths.Sample(); }, [&] { paths.Frame(); } },
+        { "update_inputs", [&] { paths.controller->UpdateInputs(); }, [&] { paths.Sample(); } },
+        { "controller_pose", [&] { paths.controller->GetPose(); }, [&] { paths.Sample(); } },
+        { "tracker_pose", [&] { paths.tracker->GetPose(); }, [&] { paths.Sample(); } },
+    };
+
+    // Clock cost, included in every cold number (warm batches amortize it)
+    TreadmillCallProfile clock;
+    for (int i = 0; i < 4096; i++) {
+        int64_t startNs = TreadmillCallProfile::NowNs();
+        clock.Record(TreadmillCallProfile::NowNs() - startNs);
+    }
+
+    std::string json = "{\"calls\":" + std::to_string(options.calls) + ",\"batch_calls\":" + std::to_string(BatchCalls) +
+        ",\"clock_p50_ns\":" + std::to_string(clock.GetSummary().p50Ns) + ",\"results\":{";
+    bool first = true;
+    double worstChange = 0.0;
+    std::string worstName;
+
+    printf("%-44s %10s %10s %10s %10s\n", "", "mean ns", "p50 ns", "p99 ns", "vs base");
+    for (const Target& target : targets) {
+        for (bool cold : { false, true }) {
+            for (bool contended : { false, true }) {
+                for (bool logging : { false, true }) {
+                    std::string name = std::string(target.name) + (cold ? ".cold" : ".warm") +
+                        (contended ? ".contended" : ".uncontended") + (logging ? ".log_on" : ".log_off");
+
+                    // The competitor shares the flag, so it logs (and contends) the same way
+                    g_debug.store(logging);
+                    TreadmillCallProfile profile;
+                    {
+                        Contention contention(contended ? target.competitor : std::function<void()>());
+                        Measure(profile, target.call, cold, options.calls);
+                    }
+                    g_debug.store(false);
+
+                    TreadmillCallProfile::Summary base = FindBaseline(baselineJson, name);
+                    profile.SetBaseline(base);
+                    TreadmillCallProfile::Summary s = profile.GetSummary();
+                    double change = base.p50Ns > 0 ? 100.0 * (s.p50Ns - base.p50Ns) / base.p50Ns : 0.0;
+                    if (base.p50Ns > 0 && (worstName.empty() || change > worstChange)) {
+                        worstChange = change;
+                        worstName = name;
+                    }
+
+                    char changeText[32] = "-";
+                    if (base.p50Ns > 0) snprintf(changeText, sizeof(changeText), "%+.1f%%", change);
+                    printf("%-44s %10lld %10lld %10lld %10s\n", name.c_str(), static_cast<long long>(s.meanNs),
+                        static_cast<long long>(s.p50Ns), static_cast<long long>(s.p99Ns), changeText);
+                    fflush(stdout);
+
+                    json += (first ? "" : ",") + profile.ToJson(name.c_str());
+                    first = false;
+                }
+            }
+        }
+    }
+    json += "}}\n";
+
+    context.host.DeactivateAll();
+    provider->Cleanup();
+
+    printf("log lines %llu, clock %lld ns per read\n", static_cast<unsigned long long>(context.log.lines),
+        static_cast<long long>(clock.GetSummary().p50Ns));
+
+    for (const std::string& path : { options.json, options.update ? options.baseline : std::string() }) {
+        if (path.empty()) continue;
+        std::ofstream out(path, std::ios::binary);
+        out << json;
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", path.c_str());
+            return 2;
+        }
+        printf("results written to %s\n", path.c_str());
+    }
+
+    if (!worstName.empty()) printf("slowest vs. baseline: %s %+.1f%%\n", worstName.c_str(), worstChange);
+    bool regressed = options.maxRegressionPct > 0.0 && !options.update && worstChange > options.maxRegressionPct;
+    if (regressed) printf("p50 regression above %.1f%%\n", options.maxRegressionPct);
+    return regressed ? 1 : 0;
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillDriverBench [--calls <n>] [--json <file>] [--baseline <file>] [--update] [--max-regression-pct <n>]\n");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--calls") == 0 && i + 1 < argc) {
+            options.calls = std::max(64, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json = argv[++i];
+        } else if (strcmp(argv[i], "--baseline") == 0 && i + 1 < argc) {
+            options.baseline = argv[++i];
+        } else if (strcmp(argv[i], "--update") == 0) {
+            options.update = true;
+        } else if (strcmp(argv[i], "--max-regression-pct") == 0 && i + 1 < argc) {
+            options.maxRegressionPct = atof(argv[++i]);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    int returnCode = 0;
+    auto* provider = static_cast<vr::IServerTrackedDeviceProvider*>(
+        HmdDriverFactory(vr::IServerTrackedDeviceProvider_Version, &returnCode));
+    if (!provider) {
+        fprintf(stderr, "HmdDriverFactory returned no provider (%d)\n", returnCode);
+        return 2;
+    }
+
+    MockDriverContext context;
+    return RunBench(context, provider, options);
+}
@@ -0,0 +1,465 @@
+#pragma once
+
+// ============================================================================
+// MockHost - vrserver stand-in for the driver tests
+// ============================================================================
+// Implements the interfaces the driver asks its IVRDriverContext for
+// (settings, properties, input, server host, log) in-process. Devices are
+// activated as vrserver does it, from TrackedDeviceAdded, and everything the
+// driver sends back is kept per device:
+//
+//   UpdateBoolean/ScalarComponent   last value per component, and a trace line
+//   TrackedDevicePoseUpdated        last pose per device, and a trace line
+//   WritePropertyBatch              calls, entries, failed entries (in all and
+//                                   per device), values
+//   Activate                        time it took, per device
+//
+// The HMD pose GetRawTrackedDevicePoses returns is set by the test. Trace
+// lines have a fixed format so a run can be compared against a golden file:
+//
+//   I <serial><component> <value> <time offset>
+//   P <serial> <x> <y> <z> <qw> <qx> <qy> <qz> <time offset> <yaw rate> <valid> <result>
+// ============================================================================
+
+#include "../openvr_driver.h"
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+class MockSettings : public vr::IVRSettings {
+public:
+    void Set(const char* section, const char* key, const std::string& value) { m_values[Key(section, key)] = value; }
+    void Clear() { m_values.clear(); }
+
+    const char* GetSettingsErrorNameFromEnum(vr::EVRSettingsError eError) override {
+        return eError == vr::VRSettingsError_None ? "VRSettingsError_None" : "VRSettingsError_UnsetSettingHasNoDefault";
+    }
+
+    void SetBool(const char* pchSection, const char* pchSettingsKey, bool bValue, vr::EVRSettingsError* peError) override {
+        Set(pchSection, pchSettingsKey, bValue ? "true" : "false");
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+    void SetInt32(const char* pchSection, const char* pchSettingsKey, int32_t nValue, vr::EVRSettingsError* peError) override {
+        Set(pchSection, pchSettingsKey, std::to_string(nValue));
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+    void SetFloat(const char* pchSection, const char* pchSettingsKey, float flValue, vr::EVRSettingsError* peError) override {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.9g", flValue);
+        Set(pchSection, pchSettingsKey, buf);
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+    void SetString(const char* pchSection, const char* pchSettingsKey, const char* pchValue, vr::EVRSettingsError* peError) override {
+        Set(pchSection, pchSettingsKey, pchValue ? pchValue : "");
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+
+    bool GetBool(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) override {
+        const std::string* v = Find(pchSection, pchSettingsKey, peError);
+        return v && (*v == "true" || *v == "1");
+    }
+    int32_t GetInt32(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) override {
+        const std::string* v = Find(pchSection, pchSettingsKey, peError);
+        return v ? static_cast<int32_t>(strtol(v->c_str(), nullptr, 10)) : 0;
+    }
+    float GetFloat(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) override {
+        const std::string* v = Find(pchSection, pchSettingsKey, peError);
+        return v ? strtof(v->c_str(), nullptr) : 0.0f;
+    }
+    void GetString(const char* pchSection, const char* pchSettingsKey, char* pchValue, uint32_t unValueLen, vr::EVRSettingsError* peError) override {
+        const std::string* v = Find(pchSection, pchSettingsKey, peError);
+        if (pchValue && unValueLen > 0) {
+            snprintf(pchValue, unValueLen, "%s", v ? v->c_str() : "");
+        }
+    }
+
+    void RemoveSection(const char* pchSection, vr::EVRSettingsError* peError) override {
+        std::string prefix = std::string(pchSection) + "/";
+        for (auto it = m_values.begin(); it != m_values.end();) {
+            it = it->first.rfind(prefix, 0) == 0 ? m_values.erase(it) : std::next(it);
+        }
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+    void RemoveKeyInSection(const char* pchSection, const char* pchSettingsKey, vr::EVRSettingsError* peError) override {
+        m_values.erase(Key(pchSection, pchSettingsKey));
+        if (peError) *peError = vr::VRSettingsError_None;
+    }
+
+private:
+    std::map<std::string, std::string> m_values;
+
+    static std::string Key(const char* section, const char* key) { return std::string(section) + "/" + key; }
+
+    // Unset keys behave like a key missing from default.vrsettings
+    const std::string* Find(const char* section, const char* key, vr::EVRSettingsError* peError) const {
+        auto it = m_values.find(Key(section, key));
+        if (peError) *peError = it != m_values.end() ? vr::VRSettingsError_None : vr::VRSettingsError_UnsetSettingHasNoDefault;
+        return it != m_values.end() ? &it->second : nullptr;
+    }
+};
+
+// Container handle = device index (the HMD's 0 is k_ulInvalidPropertyContainer)
+class MockProperties : public vr::IVRProperties {
+public:
+    struct Stats {
+        uint64_t batches = 0;
+        uint64_t entries = 0;
+        uint64_t failed = 0;
+    };
+
+    Stats GetStats() const { return m_stats; }
+    Stats GetStats(vr::PropertyContainerHandle_t container) const {
+        auto it = m_containerStats.find(container);
+        return it != m_containerStats.end() ? it->second : Stats{};
+    }
+    void ResetStats() { m_stats = {}; m_containerStats.clear(); }
+    void Clear() { m_values.clear(); ResetStats(); }
+
+    // Typed value as written, or empty if the device never wrote it
+    std::string Value(vr::TrackedDeviceIndex_t device, vr::ETrackedDeviceProperty prop) const {
+        auto it = m_values.find({ device, prop });
+        return it != m_values.end() ? it->second : std::string();
+    }
+
+    vr::ETrackedPropertyError ReadPropertyBatch(vr::PropertyContainerHandle_t, vr::PropertyRead_t* pBatch, uint32_t unBatchEntryCount) override {
+        for (uint32_t i = 0; i < unBatchEntryCount; i++) pBatch[i].eError = vr::TrackedProp_NotYetAvailable;
+        return vr::TrackedProp_NotYetAvailable;
+    }
+
+    // Checks each entry the way vrserver does (tag known, buffer matches the
+    // type) and keeps the values; one call per batch
+    vr::ETrackedPropertyError WritePropertyBatch(vr::PropertyContainerHandle_t ulContainerHandle, vr::PropertyWrite_t* pBatch, uint32_t unBatchEntryCount) override {
+        Stats& container = m_containerStats[ulContainerHandle];
+        m_stats.batches++;
+        container.batches++;
+        if (ulContainerHandle == vr::k_ulInvalidPropertyContainer) {
+            m_stats.failed += unBatchEntryCount;
+            container.failed += unBatchEntryCount;
+            return vr::TrackedProp_InvalidContainer;
+        }
+        vr::ETrackedPropertyError result = vr::TrackedProp_Success;
+        for (uint32_t i = 0; i < unBatchEntryCount; i++) {
+            vr::PropertyWrite_t& w = pBatch[i];
+            m_stats.entries++;
+            container.entries++;
+            w.eError = Check(w);
+            if (w.eError != vr::TrackedProp_Success) {
+                m_stats.failed++;
+                container.failed++;
+                result = w.eError;
+                continue;
+            }
+            m_values[{ ulContainerHandle, w.prop }] = Format(w);
+        }
+        return result;
+    }
+
+    const char* GetPropErrorNameFromEnum(vr::ETrackedPropertyError error) override {
+        switch (error) {
+        case vr::TrackedProp_Success: return "TrackedProp_Success";
+        case vr::TrackedProp_WrongDataType: return "TrackedProp_WrongDataType";
+        case vr::TrackedProp_BufferTooSmall: return "TrackedProp_BufferTooSmall";
+        case vr::TrackedProp_InvalidContainer: return "TrackedProp_InvalidContainer";
+        case vr::TrackedProp_InvalidOperation: return "TrackedProp_InvalidOperation";
+        default: return "TrackedProp_Unknown";
+        }
+    }
+
+    vr::PropertyContainerHandle_t TrackedDeviceToPropertyContainer(vr::TrackedDeviceIndex_t nDevice) override {
+        return nDevice == vr::k_unTrackedDeviceIndexInvalid ? vr::k_ulInvalidPropertyContainer : nDevice;
+    }
+
+private:
+    Stats m_stats;
+    std::map<vr::PropertyContainerHandle_t, Stats> m_containerStats;
+    std::map<std::pair<vr::PropertyContainerHandle_t, vr::ETrackedDeviceProperty>, std::string> m_values;
+
+    static vr::ETrackedPropertyError Check(const vr::PropertyWrite_t& w) {
+        if (w.writeType != vr::PropertyWrite_Set) return vr::TrackedProp_Success;
+        if (!w.pvBuffer) return vr::TrackedProp_InvalidOperation;
+        switch (w.unTag) {
+        case vr::k_unStringPropertyTag:
+            return w.unBufferSize > 0 && static_cast<const char*>(w.pvBuffer)[w.unBufferSize - 1] == '\0'
+                ? vr::TrackedProp_Success : vr::TrackedProp_BufferTooSmall;
+        case vr::k_unInt32PropertyTag:
+            return w.unBufferSize == sizeof(int32_t) ? vr::TrackedProp_Success : vr::TrackedProp_WrongDataType;
+        case vr::k_unFloatPropertyTag:
+            return w.unBufferSize == sizeof(float) ? vr::TrackedProp_Success : vr::TrackedProp_WrongDataType;
+        case vr::k_unBoolPropertyTag:
+            return w.unBufferSize == sizeof(bool) ? vr::TrackedProp_Success : vr::TrackedProp_WrongDataType;
+        default:
+            return vr::TrackedProp_WrongDataType;
+        }
+    }
+
+    static std::string Format(const vr::PropertyWrite_t& w) {
+        char buf[64];
+        switch (w.unTag) {
+        case vr::k_unStringPropertyTag: return static_cast<const char*>(w.pvBuffer);
+        case vr::k_unInt32PropertyTag: snprintf(buf, sizeof(buf), "%d", *static_cast<const int32_t*>(w.pvBuffer)); return buf;
+        case vr::k_unFloatPropertyTag: snprintf(buf, sizeof(buf), "%g", *static_cast<const float*>(w.pvBuffer)); return buf;
+        case vr::k_unBoolPropertyTag: return *static_cast<const bool*>(w.pvBuffer) ? "true" : "false";
+        default: return std::string();
+        }
+    }
+};
+
+// Shared by the host interfaces: the devices and the trace of one run
+struct MockDevices {
+    struct Device {
+        std::string serial;
+        vr::ETrackedDeviceClass deviceClass = vr::TrackedDeviceClass_Invalid;
+        vr::ITrackedDeviceServerDriver* driver = nullptr;
+        vr::DriverPose_t lastPose{};
+        uint64_t poseUpdates = 0;
+        bool active = false;
+        double activateMs = 0.0;            // wall time of Activate
+    };
+    struct Component {
+        vr::TrackedDeviceIndex_t device = 0;  // devices[device - 1]
+        std::string path;
+        double value = 0.0;
+        uint64_t updates = 0;
+    };
+
+    std::vector<Device> devices;        // index = device index - 1 (0 is the HMD)
+    std::vector<Component> components;  // handle = index + 1
+    std::string trace;
+    bool tracing = false;
+
+    void Clear() {
+        devices.clear();
+        components.clear();
+        trace.clear();
+    }
+
+    void Trace(const char* fmt, ...) {
+        if (!tracing) return;
+        char buf[512];
+        va_list ap;
+        va_start(ap, fmt);
+        vsnprintf(buf, sizeof(buf), fmt, ap);
+        va_end(ap);
+        trace += buf;
+        trace += '\n';
+    }
+
+    const Device* Find(const char* serial) const {
+        for (const Device& d : devices) {
+            if (d.serial == serial) return &d;
+        }
+        return nullptr;
+    }
+
+    // Last value of "<serial><path>", 0 if never updated
+    double ComponentValue(const char* serial, const char* path) const {
+        for (const Component& c : components) {
+            if (c.path == path && devices[c.device - 1].serial == serial) return c.value;
+        }
+        return 0.0;
+    }
+};
+
+class MockDriverInput : public vr::IVRDriverInput {
+public:
+    explicit MockDriverInput(MockDevices& devices) : m_devices(devices) {}
+
+    vr::EVRInputError CreateBooleanComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError UpdateBooleanComponent(vr::VRInputComponentHandle_t ulComponent, bool bNewValue, double fTimeOffset) override {
+        return Update(ulComponent, bNewValue ? 1.0 : 0.0, fTimeOffset);
+    }
+    vr::EVRInputError CreateScalarComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle,
+        vr::EVRScalarType, vr::EVRScalarUnits) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError UpdateScalarComponent(vr::VRInputComponentHandle_t ulComponent, float fNewValue, double fTimeOffset) override {
+        return Update(ulComponent, fNewValue, fTimeOffset);
+    }
+    vr::EVRInputError CreateHapticComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError CreateSkeletonComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, const char*, const char*,
+        vr::EVRSkeletalTrackingLevel, const vr::VRBoneTransform_t*, uint32_t, vr::VRInputComponentHandle_t* pHandle) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError UpdateSkeletonComponent(vr::VRInputComponentHandle_t, vr::EVRSkeletalMotionRange, const vr::VRBoneTransform_t*, uint32_t) override {
+        return vr::VRInputError_None;
+    }
+    vr::EVRInputError CreatePoseComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError UpdatePoseComponent(vr::VRInputComponentHandle_t, const vr::HmdMatrix34_t*, double) override {
+        return vr::VRInputError_None;
+    }
+    vr::EVRInputError CreateEyeTrackingComponent(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) override {
+        return Create(ulContainer, pchName, pHandle);
+    }
+    vr::EVRInputError UpdateEyeTrackingComponent(vr::VRInputComponentHandle_t, const vr::VREyeTrackingData_t*, double) override {
+        return vr::VRInputError_None;
+    }
+
+private:
+    MockDevices& m_devices;
+
+    vr::EVRInputError Create(vr::PropertyContainerHandle_t ulContainer, const char* pchName, vr::VRInputComponentHandle_t* pHandle) {
+        if (ulContainer == vr::k_ulInvalidPropertyContainer || ulContainer > m_devices.devices.size()) return vr::VRInputError_InvalidHandle;
+        if (!pchName || !pHandle) return vr::VRInputError_InvalidParam;
+        MockDevices::Component c;
+        c.device = static_cast<vr::TrackedDeviceIndex_t>(ulContainer);
+        c.path = pchName;
+        m_devices.components.push_back(c);
+        *pHandle = m_devices.components.size();
+        return vr::VRInputError_None;
+    }
+
+    vr::EVRInputError Update(vr::VRInputComponentHandle_t handle, double value, double timeOffset) {
+        if (handle == vr::k_ulInvalidInputComponentHandle || handle > m_devices.components.size()) return vr::VRInputError_InvalidHandle;
+        MockDevices::Component& c = m_devices.components[handle - 1];
+        c.value = value;
+        c.updates++;
+        m_devices.Trace("I %s%s %.5f %.6f", m_devices.devices[c.device - 1].serial.c_str(), c.path.c_str(), value, timeOffset);
+        return vr::VRInputError_None;
+    }
+};
+
+class MockServerDriverHost : public vr::IVRServerDriverHost {
+public:
+    explicit MockServerDriverHost(MockDevices& devices) : m_devices(devices) { SetHmdPose(0.0, 1.7, 0.0); }
+
+    // Raw HMD pose (index 0) at x/y/z looking down -Z
+    void SetHmdPose(double x, double y, double z) {
+        m_hmd = {};
+        m_hmd.mDeviceToAbsoluteTracking.m[0][0] = 1.0f;
+        m_hmd.mDeviceToAbsoluteTracking.m[1][1] = 1.0f;
+        m_hmd.mDeviceToAbsoluteTracking.m[2][2] = 1.0f;
+        m_hmd.mDeviceToAbsoluteTracking.m[0][3] = static_cast<float>(x);
+        m_hmd.mDeviceToAbsoluteTracking.m[1][3] = static_cast<float>(y);
+        m_hmd.mDeviceToAbsoluteTracking.m[2][3] = static_cast<float>(z);
+        m_hmd.eTrackingResult = vr::TrackingResult_Running_OK;
+        m_hmd.bPoseIsValid = true;
+        m_hmd.bDeviceIsConnected = true;
+    }
+
+    // What vrserver does on shutdown before the provider's Cleanup
+    void DeactivateAll() {
+        for (MockDevices::Device& d : m_devices.devices) {
+            if (d.active) d.driver->Deactivate();
+            d.active = false;
+        }
+    }
+
+    bool TrackedDeviceAdded(const char* pchDeviceSerialNumber, vr::ETrackedDeviceClass eDeviceClass, vr::ITrackedDeviceServerDriver* pDriver) override {
+        if (!pchDeviceSerialNumber || !pDriver || m_devices.Find(pchDeviceSerialNumber)) return false;
+        MockDevices::Device d;
+        d.serial = pchDeviceSerialNumber;
+        d.deviceClass = eDeviceClass;
+        d.driver = pDriver;
+        m_devices.devices.push_back(d);
+        // Index 0 is the HMD, as with a real headset
+        vr::TrackedDeviceIndex_t index = static_cast<vr::TrackedDeviceIndex_t>(m_devices.devices.size());
+        auto start = std::chrono::steady_clock::now();
+        bool active = pDriver->Activate(index) == vr::VRInitError_None;
+        MockDevices::Device& added = m_devices.devices.back();
+        added.active = active;
+        added.activateMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return true;
+    }
+
+    void TrackedDevicePoseUpdated(uint32_t unWhichDevice, const vr::DriverPose_t& newPose, uint32_t unPoseStructSize) override {
+        if (unWhichDevice == 0 || unWhichDevice > m_devices.devices.size() || unPoseStructSize != sizeof(vr::DriverPose_t)) return;
+        MockDevices::Device& d = m_devices.devices[unWhichDevice - 1];
+        d.lastPose = newPose;
+        d.poseUpdates++;
+        m_devices.Trace("P %s %.5f %.5f %.5f %.5f %.5f %.5f %.5f %.6f %.5f %d %d", d.serial.c_str(),
+            newPose.vecPosition[0], newPose.vecPosition[1], newPose.vecPosition[2],
+            newPose.qRotation.w, newPose.qRotation.x, newPose.qRotation.y, newPose.qRotation.z,
+            newPose.poseTimeOffset, newPose.vecAngularVelocity[1], newPose.poseIsValid ? 1 : 0, static_cast<int>(newPose.result));
+    }
+
+    void VsyncEvent(double) override {}
+    void VendorSpecificEvent(uint32_t, vr::EVREventType, const vr::VREvent_Data_t&, double) override {}
+    bool IsExiting() override { return false; }
+    bool PollNextEvent(vr::VREvent_t*, uint32_t) override { return false; }
+
+    void GetRawTrackedDevicePoses(float, vr::TrackedDevicePose_t* pTrackedDevicePoseArray, uint32_t unTrackedDevicePoseArrayCount) override {
+        for (uint32_t i = 0; i < unTrackedDevicePoseArrayCount; i++) {
+            pTrackedDevicePoseArray[i] = {};
+        }
+        if (unTrackedDevicePoseArrayCount > 0) pTrackedDevicePoseArray[0] = m_hmd;
+    }
+
+    void RequestRestart(const char*, const char*, const char*, const char*) override {}
+    uint32_t GetFrameTimings(vr::Compositor_FrameTiming*, uint32_t) override { return 0; }
+    void SetDisplayEyeToHead(uint32_t, const vr::HmdMatrix34_t&, const vr::HmdMatrix34_t&) override {}
+    void SetDisplayProjectionRaw(uint32_t, const vr::HmdRect2_t&, const vr::HmdRect2_t&) override {}
+    void SetRecommendedRenderTargetSize(uint32_t, uint32_t, uint32_t) override {}
+
+private:
+    MockDevices& m_devices;
+    vr::TrackedDevicePose_t m_hmd{};
+};
+
+class MockDriverLog : public vr::IVRDriverLog {
+public:
+    bool verbose = false;
+    uint64_t lines = 0;
+
+    void Log(const char* pchLogMessage) override {
+        lines++;
+        if (verbose) fprintf(stderr, "%s\n", pchLogMessage);
+    }
+};
+
+// Not used by the driver, but InitServerDriverContext requires them
+class MockDriverManager : public vr::IVRDriverManager {
+public:
+    uint32_t GetDriverCount() const override { return 1; }
+    uint32_t GetDriverName(vr::DriverId_t, char* pchValue, uint32_t unBufferSize) override {
+        if (pchValue && unBufferSize > 0) snprintf(pchValue, unBufferSize, "treadmill");
+        return 10;
+    }
+    vr::DriverHandle_t GetDriverHandle(const char*) override { return 1; }
+    bool IsEnabled(vr::DriverId_t) const override { return true; }
+};
+
+class MockResources : public vr::IVRResources {
+public:
+    uint32_t LoadSharedResource(const char*, char*, uint32_t) override { return 0; }
+    uint32_t GetResourceFullPath(const char*, const char*, char* pchPathBuffer, uint32_t unBufferLen) override {
+        if (pchPathBuffer && unBufferLen > 0) pchPathBuffer[0] = '\0';
+        return 0;
+    }
+};
+
+class MockDriverContext : public vr::IVRDriverContext {
+public:
+    MockSettings settings;
+    MockProperties properties;
+    MockDevices devices;
+    MockDriverInput input{ devices };
+    MockServerDriverHost host{ devices };
+    MockDriverLog log;
+    MockDriverManager manager;
+    MockResources resources;
+
+    void* GetGenericInterface(const char* pchInterfaceVersion, vr::EVRInitError* peError) override {
+        void* found = nullptr;
+        if (strcmp(pchInterfaceVersion, vr::IVRSettings_Version) == 0) found = static_cast<vr::IVRSettings*>(&settings);
+        else if (strcmp(pchInterfaceVersion, vr::IVRProperties_Version) == 0) found = static_cast<vr::IVRProperties*>(&properties);
+        else if (strcmp(pchInterfaceVersion, vr::IVRDriverInput_Version) == 0) found = static_cast<vr::IVRDriverInput*>(&input);
+        else if (strcmp(pchInterfaceVersion, vr::IVRServerDriverHost_Version) == 0) found = static_cast<vr::IVRServerDriverHost*>(&host);
+        else if (strcmp(pchInterfaceVersion, vr::IVRDriverLog_Version) == 0) found = static_cast<vr::IVRDriverLog*>(&log);
+        else if (strcmp(pchInterfaceVersion, vr::IVRDriverManager_Version) == 0) found = static_cast<vr::IVRDriverManager*>(&manager);
+        else if (strcmp(pchInterfaceVersion, vr::IVRResources_Version) == 0) found = static_cast<vr::IVRResources*>(&resources);
+        if (peError) *peError = found ? vr::VRInitError_None : vr::VRInitError_Init_InterfaceNotFound;
+        return found;
+    }
+
+    vr::DriverHandle_t GetDriverHandle() override { return 1; }
+};
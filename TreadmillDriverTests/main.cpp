@@ -0,0 +1,399 @@
+// ============================================================================
+// TreadmillDriverTests - the driver on a mock vrserver, compared to golden output
+// ============================================================================
+// Links driver_treadmill.cpp and TreadmillServerDriver.cpp against MockHost.h
+// with TREADMILL_VIRTUAL_CLOCK, so TreadmillSampleHistory::NowUs() is the
+// frame time this test sets. The executable is its own OmniBridge: it exports
+// OmniReader_* and is configured as omnibridge_dll_path, and OmniReader_Poll
+// hands out the S rows of a recorded walk (DebugRequest "record" format) once
+// the virtual clock reaches their time.
+//
+//   activate   Init with foot trackers; every device's Activate must write
+//              its properties in one WritePropertyBatch without a failed
+//              entry, and WriteTreadmillProperties must report the entries
+//              of a batch the host rejects. Prints each Activate's time.
+//   replay     RunFrame at 90 Hz over the session; every input update and
+//              pose the driver sends is compared against the golden file.
+//              A game model walks the HMD by the published joystick and
+//              controller yaw, so the visual tracker sees the walk too.
+//
+//   TreadmillDriverTests.exe [--test <activate|replay|all>]
+//                            [--session <file>] [--golden <file>] [--update]
+//                            [--max-frame-cpu-us <n>] [--max-activate-us <n>]
+//                            [--verbose]
+//
+// Defaults are sessions/walk.csv and golden/walk.golden, relative to the
+// working directory. --update rewrites the golden file from this run.
+// Exit code 0 if every test passes (within the CPU and activation budgets),
+// 1 on a failure, a mismatch or over budget, 2 if a test could not run.
+// ============================================================================
+
+#include "MockHost.h"
+#include "../MinimalOmniReader.h"
+#include "../TreadmillPropertyTable.h"
+#include "../TreadmillServerDriver.h"
+#include "../TreadmillSampleHistory.h"
+#include "../TreadmillSessionRecording.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+extern "C" void* HmdDriverFactory(const char* pInterfaceName, int* pReturnCode);
+extern std::atomic<TreadmillConnectionState> g_connectionState;
+
+static constexpr int64_t FrameUs = 11111;               // 90 Hz
+static constexpr int64_t TrailingUs = 1000000;          // after the last sample: stall, not yet lost
+static constexpr double Tolerance = 1e-4;               // per number, compilers differ in the last digits
+static constexpr float GameSpeed = 1.4f;                // m/s at full stick, as calibration_target_speed
+
+// ----------------------------------------------------------------------------
+// OmniBridge stand-in
+// ----------------------------------------------------------------------------
+
+struct FakeOmniReader {
+    std::vector<TreadmillSessionEvent> samples;     // S rows of the session
+    size_t next = 0;
+    int64_t startUs = 0;                            // virtual time of the first sample
+    uint64_t sequence = 0;
+    double steps = 0.0;                             // StepCount, integrated from the recorded cadence
+    int64_t lastTimeUs = 0;
+    std::atomic<bool> connected{ false };
+};
+static FakeOmniReader g_fake;
+
+extern "C" __declspec(dllexport) void* OmniReader_Create() { return &g_fake; }
+
+extern "C" __declspec(dllexport) bool OmniReader_Initialize(void* handle, const char*, int, int) {
+    static_cast<FakeOmniReader*>(handle)->connected.store(true);
+    return true;
+}
+
+extern "C" __declspec(dllexport) void OmniReader_RegisterCallback(void*, OmniDataCallback) {}
+
+extern "C" __declspec(dllexport) size_t OmniReader_Poll(void* handle, OmniSample* samples, size_t maxSamples, uint64_t* sequence) {
+    FakeOmniReader& reader = *static_cast<FakeOmniReader*>(handle);
+    if (!reader.connected.load() || reader.samples.empty()) return 0;
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    int64_t firstUs = reader.samples.front().timeUs;
+    size_t count = 0;
+    while (count < maxSamples && reader.next < reader.samples.size()) {
+        const TreadmillSessionEvent& e = reader.samples[reader.next];
+        int64_t timeUs = reader.startUs + (e.timeUs - firstUs);
+        if (timeUs > nowUs) break;
+        if (reader.lastTimeUs != 0) reader.steps += e.cadence * (timeUs - reader.lastTimeUs) * 1e-6;
+        reader.lastTimeUs = timeUs;
+
+        OmniSample& s = samples[count++];
+        s = {};
+        s.sequence = ++reader.sequence;
+        s.timestampUs = timeUs;
+        s.ringAngle = e.ringAngle;
+        s.gamePadX = static_cast<int32_t>(std::lround(e.gamePadX));
+        s.gamePadY = static_cast<int32_t>(std::lround(e.gamePadY));
+        s.stepCount = static_cast<uint32_t>(reader.steps);
+        s.flags = OmniSample_StepCount;
+        reader.next++;
+    }
+    *sequence = reader.sequence;
+    return count;
+}
+
+extern "C" __declspec(dllexport) void OmniReader_Disconnect(void* handle) {
+    static_cast<FakeOmniReader*>(handle)->connected.store(false);
+}
+
+extern "C" __declspec(dllexport) void OmniReader_Destroy(void*) {}
+
+// ----------------------------------------------------------------------------
+
+static double ProcessCpuMs() {
+#ifdef _WIN32
+    FILETIME creation, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &creation, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 1e4;  // 100 ns units
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1e3 + (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1e3;
+#endif
+}
+
+static std::string SelfPath() {
+    char path[MAX_PATH] = {};
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return path;
+}
+
+// Lines equal, numbers within Tolerance; reports the first difference
+static size_t CompareLines(const std::vector<std::string>& actual, const std::vector<std::string>& expected) {
+    size_t mismatches = 0;
+    size_t lines = std::max(actual.size(), expected.size());
+    for (size_t i = 0; i < lines; i++) {
+        const std::string a = i < actual.size() ? actual[i] : "<missing>";
+        const std::string e = i < expected.size() ? expected[i] : "<missing>";
+        std::istringstream as(a), es(e);
+        std::string at, et;
+        bool same = true;
+        while (same) {
+            bool moreA = static_cast<bool>(as >> at);
+            bool moreE = static_cast<bool>(es >> et);
+            if (moreA != moreE) same = false;
+            if (!moreA || !moreE) break;
+            if (at == et) continue;
+            char* endA;
+            char* endE;
+            double va = strtod(at.c_str(), &endA);
+            double ve = strtod(et.c_str(), &endE);
+            same = *endA == '\0' && *endE == '\0' && std::fabs(va - ve) <= Tolerance;
+        }
+        if (!same && mismatches++ == 0) {
+            printf("  first difference at line %zu:\n    expected: %s\n    actual:   %s\n", i + 1, e.c_str(), a.c_str());
+        }
+    }
+    return mismatches;
+}
+
+static std::vector<std::string> SplitLines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream in(text);
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+struct Options {
+    std::string test = "all";
+    std::string session = "sessions/walk.csv";
+    std::string golden = "golden/walk.golden";
+    bool update = false;
+    double maxFrameCpuUs = 0.0;     // 0 = no budget
+    double maxActivateUs = 0.0;     // per device, 0 = no budget
+    bool verbose = false;
+};
+
+// Settings a replay needs to be deterministic; everything else keeps the
+// driver's defaults
+static void ConfigureReplay(MockSettings& settings, const Options& options) {
+    settings.Clear();
+    settings.Set("driver_treadmill", "mytracker_model_number", "treadmill_test");
+    settings.Set("driver_treadmill", "debug", options.verbose ? "true" : "false");
+    settings.Set("driver_treadmill", "omnibridge_dll_path", SelfPath());
+    settings.Set("driver_treadmill", "frame_sampling", "false");        // needs the master's shared memory
+    settings.Set("driver_treadmill", "publisher_thread", "false");      // RunFrame publishes
+    settings.Set("driver_treadmill", "frame_budget_degrade", "false");  // would follow the machine's speed
+    settings.Set("driver_treadmill", "speed_calibration", "off");       // learns from the game model
+    settings.Set("driver_treadmill", "yaw_correction", "false");
+    settings.Set("driver_treadmill", "foot_trackers", "false");
+}
+
+static int RunActivate(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider, const Options& options) {
+    ConfigureReplay(context.settings, options);
+    context.settings.Set("driver_treadmill", "foot_trackers", "true");
+    context.devices.Clear();
+    context.properties.Clear();
+    if (provider->Init(&context) != vr::VRInitError_None) {
+        fprintf(stderr, "Init failed\n");
+        return 2;
+    }
+
+    bool passed = !context.devices.devices.empty();
+    double totalMs = 0.0;
+    for (size_t i = 0; i < context.devices.devices.size(); i++) {
+        const MockDevices::Device& d = context.devices.devices[i];
+        MockProperties::Stats stats = context.properties.GetStats(static_cast<vr::PropertyContainerHandle_t>(i + 1));
+        bool overBudget = options.maxActivateUs > 0.0 && d.activateMs * 1000.0 > options.maxActivateUs;
+        bool ok = d.active && stats.batches == 1 && stats.entries > 0 && stats.failed == 0 && !overBudget;
+        printf("activate %s: %.3f ms, %llu property calls, %llu properties, %llu failed%s\n", d.serial.c_str(),
+            d.activateMs, static_cast<unsigned long long>(stats.batches), static_cast<unsigned long long>(stats.entries),
+            static_cast<unsigned long long>(stats.failed),
+            !d.active ? " - not active" : overBudget ? " - over the activation budget" : ok ? "" : " - FAILED");
+        totalMs += d.activateMs;
+        passed = passed && ok;
+    }
+    printf("  %zu devices in %.3f ms\n", context.devices.devices.size(), totalMs);
+
+    // A batch the host rejects as a whole: every entry counts as failed
+    const TreadmillProperty props[] = {
+        TreadmillProperty::String(vr::Prop_SerialNumber_String, "treadmill_test"),
+        TreadmillProperty::Int32(vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_GenericTracker),
+        TreadmillProperty::Float(vr::Prop_DeviceBatteryPercentage_Float, 1.0f),
+        TreadmillProperty::Bool(vr::Prop_Identifiable_Bool, false),
+    };
+    size_t rejected = WriteTreadmillProperties(vr::k_ulInvalidPropertyContainer, props, std::size(props), "test");
+    printf("  rejected batch: %zu of %zu properties reported failed\n", rejected, std::size(props));
+    passed = passed && rejected == std::size(props);
+
+    context.host.DeactivateAll();
+    provider->Cleanup();
+    context.devices.Clear();
+    context.properties.Clear();
+    return passed ? 0 : 1;
+}
+
+static int RunReplay(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider, const Options& options) {
+    std::vector<TreadmillSessionEvent> events;
+    std::string recordedSettings;
+    if (!TreadmillSessionRecorder::Load(options.session, events, recordedSettings)) {
+        fprintf(stderr, "Cannot read %s\n", options.session.c_str());
+        return 2;
+    }
+    g_fake.samples.clear();
+    for (const TreadmillSessionEvent& e : events) {
+        if (e.type == TreadmillSessionEvent::Sample) g_fake.samples.push_back(e);
+    }
+    if (g_fake.samples.empty()) {
+        fprintf(stderr, "No samples in %s\n", options.session.c_str());
+        return 2;
+    }
+
+    ConfigureReplay(context.settings, options);
+    if (provider->Init(&context) != vr::VRInitError_None) {
+        fprintf(stderr, "Init failed\n");
+        return 2;
+    }
+    // ConnectLoop runs on its own thread, in real time
+    for (int waitedMs = 0; g_connectionState.load() != TreadmillConnectionState::Streaming; waitedMs += 10) {
+        if (waitedMs >= 5000) {
+            fprintf(stderr, "Driver did not connect to the test's OmniReader_* exports\n");
+            context.host.DeactivateAll();
+            provider->Cleanup();
+            return 2;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    int64_t startUs = TreadmillSampleHistory::NowUs();
+    g_fake.startUs = startUs + FrameUs;
+    int64_t sessionUs = g_fake.samples.back().timeUs - g_fake.samples.front().timeUs;
+    int64_t frames = (sessionUs + TrailingUs) / FrameUs + 1;
+    double hmdX = 0.0, hmdZ = 0.0;
+    context.host.SetHmdPose(hmdX, 1.7, hmdZ);
+
+    context.devices.tracing = true;
+    double cpuStartMs = ProcessCpuMs();
+    for (int64_t frame = 1; frame <= frames; frame++) {
+        TreadmillSampleHistory::VirtualNowUs().store(startUs + frame * FrameUs);
+        context.devices.Trace("F %lld", static_cast<long long>(frame));
+        provider->RunFrame();
+
+        // The game: joystick forward is the controller's -Z, turned by its yaw
+        const MockDevices::Device* controller = context.devices.Find("treadmill_controller");
+        if (controller) {
+            const vr::HmdQuaternion_t& q = controller->lastPose.qRotation;
+            double x = context.devices.ComponentValue("treadmill_controller", "/input/joystick/x");
+            double z = -context.devices.ComponentValue("treadmill_controller", "/input/joystick/y");
+            double c = q.w * q.w - q.y * q.y, s = 2.0 * q.w * q.y;  // rotation about Y by the quaternion's angle
+            hmdX += (c * x + s * z) * GameSpeed * FrameUs * 1e-6;
+            hmdZ += (-s * x + c * z) * GameSpeed * FrameUs * 1e-6;
+            context.host.SetHmdPose(hmdX, 1.7, hmdZ);
+        }
+    }
+    double cpuMs = ProcessCpuMs() - cpuStartMs;
+    context.devices.tracing = false;
+
+    context.host.DeactivateAll();
+    provider->Cleanup();
+
+    double frameCpuUs = cpuMs * 1000.0 / frames;
+    printf("replay %s: %lld frames, %zu samples, cpu %.1f ms (%.1f us/frame)\n", options.session.c_str(),
+        static_cast<long long>(frames), g_fake.samples.size(), cpuMs, frameCpuUs);
+
+    if (options.update) {
+        std::filesystem::path golden(options.golden);
+        if (golden.has_parent_path()) std::filesystem::create_directories(golden.parent_path());
+        std::ofstream out(options.golden, std::ios::binary);
+        out << context.devices.trace;
+        if (!out) {
+            fprintf(stderr, "Cannot write %s\n", options.golden.c_str());
+            return 2;
+        }
+        printf("  golden file %s updated\n", options.golden.c_str());
+        return 0;
+    }
+
+    std::ifstream in(options.golden, std::ios::binary);
+    if (!in.is_open()) {
+        fprintf(stderr, "Cannot read %s (run with --update to create it)\n", options.golden.c_str());
+        return 2;
+    }
+    std::stringstream expected;
+    expected << in.rdbuf();
+    size_t mismatches = CompareLines(SplitLines(context.devices.trace), SplitLines(expected.str()));
+    bool overBudget = options.maxFrameCpuUs > 0.0 && frameCpuUs > options.maxFrameCpuUs;
+    printf("  %zu lines differ from %s%s\n", mismatches, options.golden.c_str(),
+        overBudget ? " - over the CPU budget" : "");
+    return mismatches == 0 && !overBudget ? 0 : 1;
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillDriverTests [--test <activate|replay|all>]\n");
+    printf("                            [--session <file>] [--golden <file>] [--update]\n");
+    printf("                            [--max-frame-cpu-us <n>] [--max-activate-us <n>] [--verbose]\n");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--test") == 0 && i + 1 < argc) {
+            options.test = argv[++i];
+        } else if (strcmp(argv[i], "--session") == 0 && i + 1 < argc) {
+            options.session = argv[++i];
+        } else if (strcmp(argv[i], "--golden") == 0 && i + 1 < argc) {
+            options.golden = argv[++i];
+        } else if (strcmp(argv[i], "--update") == 0) {
+            options.update = true;
+        } else if (strcmp(argv[i], "--max-frame-cpu-us") == 0 && i + 1 < argc) {
+            options.maxFrameCpuUs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-activate-us") == 0 && i + 1 < argc) {
+            options.maxActivateUs = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--verbose") == 0) {
+            options.verbose = true;
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    int returnCode = 0;
+    auto* provider = static_cast<vr::IServerTrackedDeviceProvider*>(
+        HmdDriverFactory(vr::IServerTrackedDeviceProvider_Version, &returnCode));
+    if (!provider) {
+        fprintf(stderr, "HmdDriverFactory returned no provider (%d)\n", returnCode);
+        return 2;
+    }
+
+    MockDriverContext context;
+    context.log.verbose = options.verbose;
+
+    struct Test { const char* name; int (*run)(MockDriverContext&, vr::IServerTrackedDeviceProvider*, const Options&); };
+    const Test tests[] = { { "activate", RunActivate }, { "replay", RunReplay } };
+    int result = 0;
+    bool ran = false;
+    for (const Test& t : tests) {
+        if (options.test != "all" && options.test != t.name) continue;
+        ran = true;
+        result = std::max(result, t.run(context, provider, options));
+    }
+    if (!ran) {
+        PrintUsage();
+        return 2;
+    }
+    return result;
+}
@@ -0,0 +1,203 @@
+#pragma once
+
+// ============================================================================
+// TreadmillFootTracking - foot trackers from the Omni pods
+// ============================================================================
+// Each pod streams an orientation quaternion (OmniReader_PollPods). With
+// foot_trackers the driver shows a generic tracker per foot:
+//
+//   Orientation: TreadmillPodOrientation - the pod's tilt against a flat-foot
+//                neutral pose, turned to the treadmill heading (the pods'
+//                own yaw has no fixed reference and drifts)
+//   Position:    TreadmillGaitModel - swing/stance phase from footfalls and
+//                cadence, stride from the stick speed
+//
+// Everything here is fixed-size state updated in place; the driver calls it
+// from the publishing thread only.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+struct TreadmillQuaternion {
+    double w = 1.0, x = 0.0, y = 0.0, z = 0.0;
+};
+
+inline TreadmillQuaternion QuatMultiply(const TreadmillQuaternion& a, const TreadmillQuaternion& b) {
+    return {
+        a.w * b.w - a.x * b.x - a.y * b.y - a.z * b.z,
+        a.w * b.x + a.x * b.w + a.y * b.z - a.z * b.y,
+        a.w * b.y - a.x * b.z + a.y * b.w + a.z * b.x,
+        a.w * b.z + a.x * b.y - a.y * b.x + a.z * b.w
+    };
+}
+
+inline TreadmillQuaternion QuatConjugate(const TreadmillQuaternion& q) {
+    return { q.w, -q.x, -q.y, -q.z };
+}
+
+inline TreadmillQuaternion QuatNormalize(const TreadmillQuaternion& q) {
+    double length = std::sqrt(q.w * q.w + q.x * q.x + q.y * q.y + q.z * q.z);
+    if (length < 1e-9) return {};
+    return { q.w / length, q.x / length, q.y / length, q.z / length };
+}
+
+// Same convention as the device poses: rotation by -yaw around +Y
+inline TreadmillQuaternion QuatFromYaw(double yawDeg) {
+    constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+    double half = yawDeg * DEG2RAD * 0.5;
+    return { std::cos(half), 0.0, -std::sin(half), 0.0 };
+}
+
+// Angular velocity (rad/s, driver space) that turns from into to in dtS
+inline void QuatAngularVelocity(const TreadmillQuaternion& from, const TreadmillQuaternion& to, double dtS, double out[3]) {
+    out[0] = out[1] = out[2] = 0.0;
+    if (dtS <= 0.0) return;
+    TreadmillQuaternion delta = QuatMultiply(to, QuatConjugate(from));
+    if (delta.w < 0.0) delta = { -delta.w, -delta.x, -delta.y, -delta.z };  // shortest way
+    double sinHalf = std::sqrt(delta.x * delta.x + delta.y * delta.y + delta.z * delta.z);
+    if (sinHalf < 1e-9) return;
+    double angle = 2.0 * std::atan2(sinHalf, delta.w);
+    double scale = angle / (sinHalf * dtS);
+    out[0] = delta.x * scale;
+    out[1] = delta.y * scale;
+    out[2] = delta.z * scale;
+}
+
+// Rotation by angular velocity w (rad/s) over dtS, the inverse of the above
+inline TreadmillQuaternion QuatFromAngularVelocity(const double w[3], double dtS) {
+    double rate = std::sqrt(w[0] * w[0] + w[1] * w[1] + w[2] * w[2]);
+    if (rate < 1e-9 || dtS <= 0.0) return {};
+    double half = rate * dtS * 0.5;
+    double s = std::sin(half) / rate;
+    return { std::cos(half), w[0] * s, w[1] * s, w[2] * s };
+}
+
+// The pod's raw orientation relative to a neutral pose captured with the
+// foot flat. Pod axes are taken as X to the toes, Y to the left, Z up (pod
+// strapped flat on the shoe).
+class TreadmillPodOrientation {
+public:
+    // wxyz as delivered by OmniReader_PollPods
+    void Update(const float wxyz[4]) {
+        m_raw = QuatNormalize({ wxyz[0], wxyz[1], wxyz[2], wxyz[3] });
+        m_hasRaw = true;
+    }
+
+    void CaptureNeutral() {
+        if (!m_hasRaw) return;
+        m_neutral = m_raw;
+        m_hasNeutral = true;
+    }
+    void ResetNeutral() { m_hasNeutral = false; }
+    bool HasNeutral() const { return m_hasNeutral; }
+    bool HasSample() const { return m_hasRaw; }
+
+    // Foot orientation in driver space: the heading, then the pod's tilt
+    TreadmillQuaternion Orientation(double headingDeg) const {
+        TreadmillQuaternion heading = QuatFromYaw(headingDeg);
+        if (!m_hasRaw || !m_hasNeutral) return heading;
+
+        // Rotation since the neutral pose in the pod's own frame, to SteamVR
+        // foot axes (toes -Z, left -X, up +Y): (x, y, z) -> (-y, z, -x)
+        TreadmillQuaternion rel = QuatMultiply(QuatConjugate(m_neutral), m_raw);
+        TreadmillQuaternion foot{ rel.w, -rel.y, rel.z, -rel.x };
+
+        // Keep the tilt only (swing-twist): the twist about up is the pod's yaw
+        TreadmillQuaternion twist = QuatNormalize({ foot.w, 0.0, foot.y, 0.0 });
+        TreadmillQuaternion swing = QuatMultiply(foot, QuatConjugate(twist));
+        return QuatNormalize(QuatMultiply(heading, swing));
+    }
+
+private:
+    TreadmillQuaternion m_raw;
+    TreadmillQuaternion m_neutral;
+    bool m_hasRaw = false;
+    bool m_hasNeutral = false;
+};
+
+// Both feet along the walking direction. The phase runs 0..2 over a stride:
+// 0..1 the left foot swings while the right one stands on the (moving)
+// treadmill surface, 1..2 the other way round. Footfalls end a swing; in
+// between the phase advances at the step cadence.
+class TreadmillGaitModel {
+public:
+    static constexpr double FootSpacingMeters = 0.2;    // between the feet
+    static constexpr double FootHeightMeters = 0.08;    // tracker above the floor
+    static constexpr double LiftMeters = 0.1;           // swing apex at full stride
+    static constexpr int64_t StandingAfterUs = 1500000; // no footfall for this long
+    static constexpr double StrideTimeConstantS = 0.2;
+
+    struct Foot {
+        double forward = 0.0;           // meters along the heading
+        double lift = 0.0;              // meters above FootHeightMeters
+        double forwardVelocity = 0.0;   // m/s
+        double liftVelocity = 0.0;
+    };
+
+    // speed: stick magnitude 0..1, cadence: steps/second, lastFootfallUs:
+    // newest footfall (0 = none yet), strideMeters: stride at full speed
+    void Advance(double speed, double cadence, int64_t lastFootfallUs, double strideMeters, int64_t timeUs) {
+        double dtS = m_lastTimeUs == 0 ? 0.0 : std::clamp((timeUs - m_lastTimeUs) * 1e-6, 0.0, 0.1);
+        m_lastTimeUs = timeUs;
+
+        m_walking = lastFootfallUs != 0 && timeUs - lastFootfallUs < StandingAfterUs && cadence > 0.2 && speed > 0.05;
+        m_rate = m_walking ? cadence : 0.0;
+
+        if (lastFootfallUs != m_lastFootfallUs) {
+            m_lastFootfallUs = lastFootfallUs;
+            // The swinging foot lands; a footfall right after the last one is a bounce
+            double swing = std::floor(m_phase);
+            if (m_phase - swing > 0.3) m_phase = std::fmod(swing + 1.0, 2.0);
+        } else {
+            // Hold just before landing until the footfall arrives
+            double swing = std::floor(m_phase);
+            m_phase = std::min(m_phase + m_rate * dtS, swing + 0.98);
+        }
+
+        double target = m_walking ? strideMeters * std::min(1.0, speed) : 0.0;
+        m_stride += (target - m_stride) * std::min(1.0, dtS / StrideTimeConstantS);
+        m_liftScale = strideMeters > 0.01 ? std::min(1.0, m_stride / strideMeters) : 0.0;
+    }
+
+    // 0 = left, 1 = right
+    Foot Get(int foot) const {
+        constexpr double PI = 3.14159265358979323846;
+        Foot f;
+        double s = m_phase - std::floor(m_phase);
+        bool swinging = static_cast<int>(m_phase) == foot;
+        if (swinging) {
+            double eased = s * s * (3.0 - 2.0 * s);
+            f.forward = m_stride * (eased - 0.5);
+            f.forwardVelocity = m_stride * 6.0 * s * (1.0 - s) * m_rate;
+            f.lift = LiftMeters * m_liftScale * std::sin(PI * s);
+            f.liftVelocity = LiftMeters * m_liftScale * PI * std::cos(PI * s) * m_rate;
+        } else {
+            f.forward = m_stride * (0.5 - s);
+            f.forwardVelocity = -m_stride * m_rate;
+        }
+        return f;
+    }
+
+    void Reset() {
+        m_phase = 0.0;
+        m_stride = 0.0;
+        m_rate = 0.0;
+        m_walking = false;
+        m_lastTimeUs = 0;
+    }
+
+    bool Walking() const { return m_walking; }
+    double Phase() const { return m_phase; }
+    double Stride() const { return m_stride; }  // meters, current
+
+private:
+    double m_phase = 0.0;
+    double m_stride = 0.0;
+    double m_rate = 0.0;        // phase units (steps) per second
+    double m_liftScale = 0.0;
+    bool m_walking = false;
+    int64_t m_lastTimeUs = 0;
+    int64_t m_lastFootfallUs = 0;
+};
@@ -0,0 +1,153 @@
+#pragma once
+
+// ============================================================================
+// TreadmillFrameBudget - per-phase timing and budget watchdog for RunFrame
+// ============================================================================
+// RunFrame runs inside vrserver's frame loop, so every microsecond it spends
+// delays all other drivers. The frame is split into phases (sampling, input,
+// controller pose, visual tracker pose, logging); each phase feeds a rolling
+// TreadmillCallProfile, and frames over the budget are counted.
+//
+// When more than OverrunLimit of the last WindowFrames frames overran, the
+// watchdog logs a compact breakdown (at most every WarnIntervalUs) and, if
+// allowed, reports IsDegraded() so RunFrame can shed non-essential work
+// until the frame has stayed within budget for RecoverFrames.
+//
+// Time spent in Log() inside a phase is booked to Phase_Logging instead of
+// that phase, so the phases add up to the frame total at most.
+// ============================================================================
+
+#include "TreadmillCallProfile.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+class TreadmillFrameBudget {
+public:
+    enum Phase {
+        Phase_Sampling,         // frame sampling and OmniReader_Poll
+        Phase_Input,            // TreadmillDevice::UpdateInputs
+        Phase_ControllerPose,   // TreadmillDevice::GetPose + TrackedDevicePoseUpdated
+        Phase_TrackerPose,      // TreadmillVisualTracker::GetPose (incl. GetRawTrackedDevicePoses) and the foot trackers
+        Phase_Logging,
+        Phase_Count
+    };
+
+    static constexpr int64_t DefaultBudgetUs = 1000;
+    static constexpr int WindowFrames = 90;         // ~1 s at 90 Hz
+    static constexpr int OverrunLimit = 9;          // 10% of the window
+    static constexpr int RecoverFrames = 450;       // ~5 s within budget
+    static constexpr int64_t WarnIntervalUs = 5000000;
+
+    void Configure(int64_t budgetUs, bool allowDegrade) {
+        m_budgetNs.store(std::max<int64_t>(1, budgetUs) * 1000);
+        m_allowDegrade.store(allowDegrade);
+        if (!allowDegrade) m_degraded.store(false);
+    }
+
+    int64_t BudgetUs() const { return m_budgetNs.load() / 1000; }
+    bool IsDegraded() const { return m_degraded.load(std::memory_order_relaxed); }
+
+    // Frame thread only: BeginFrame, EndPhase/AddPhaseTime, EndFrame
+    void BeginFrame(int64_t nowNs) {
+        m_frameStartNs = nowNs;
+        m_phaseStartNs = nowNs;
+        for (int64_t& ns : m_frameNs) ns = 0;
+    }
+
+    // Time since the previous phase ended (or the frame began), of which
+    // logNs went to Log()
+    void EndPhase(Phase phase, int64_t nowNs, int64_t logNs = 0) {
+        int64_t ns = nowNs - m_phaseStartNs;
+        logNs = std::clamp<int64_t>(logNs, 0, ns);
+        m_frameNs[phase] += ns - logNs;
+        m_frameNs[Phase_Logging] += logNs;
+        m_phaseStartNs = nowNs;
+    }
+
+    void AddPhaseTime(Phase phase, int64_t ns) { m_frameNs[phase] += ns; }
+
+    // Returns true and fills message when something should be logged
+    bool EndFrame(int64_t nowNs, char* message, size_t messageSize) {
+        int64_t totalNs = nowNs - m_frameStartNs;
+        for (int i = 0; i < Phase_Count; i++) m_phases[i].Record(m_frameNs[i]);
+        m_total.Record(totalNs);
+        m_frames.fetch_add(1, std::memory_order_relaxed);
+
+        bool overrun = totalNs > m_budgetNs.load(std::memory_order_relaxed);
+        if (overrun) m_overruns.fetch_add(1, std::memory_order_relaxed);
+
+        // Sliding count of overruns over the last WindowFrames frames
+        int slot = m_windowPos;
+        m_windowPos = (m_windowPos + 1) % WindowFrames;
+        m_windowOverruns += (overrun ? 1 : 0) - (m_window[slot] ? 1 : 0);
+        m_window[slot] = overrun;
+        m_framesSinceOverrun = overrun ? 0 : m_framesSinceOverrun + 1;
+
+        int64_t nowUs = nowNs / 1000;
+        if (m_degraded.load() && m_framesSinceOverrun >= RecoverFrames) {
+            m_degraded.store(false);
+            snprintf(message, messageSize, "treadmill: RunFrame back within budget (%.2f ms) - full work resumed",
+                m_budgetNs.load() / 1e6);
+            return true;
+        }
+
+        if (m_windowOverruns < OverrunLimit) return false;
+
+        bool degradeNow = m_allowDegrade.load() && !m_degraded.load();
+        if (degradeNow) m_degraded.store(true);
+        if (!degradeNow && nowUs - m_lastWarnUs < WarnIntervalUs) return false;
+        m_lastWarnUs = nowUs;
+
+        snprintf(message, messageSize,
+            "treadmill: RunFrame over budget (%.2f ms) in %d/%d frames: %.2f ms = sampling %.2f input %.2f pose %.2f tracker %.2f log %.2f%s",
+            m_budgetNs.load() / 1e6, m_windowOverruns, WindowFrames, totalNs / 1e6,
+            m_frameNs[Phase_Sampling] / 1e6, m_frameNs[Phase_Input] / 1e6, m_frameNs[Phase_ControllerPose] / 1e6,
+            m_frameNs[Phase_TrackerPose] / 1e6, m_frameNs[Phase_Logging] / 1e6,
+            m_degraded.load() ? " | degraded: tracker every 4th frame, diagnostics off" : "");
+        return true;
+    }
+
+    void Reset() {
+        for (auto& p : m_phases) p.Reset();
+        m_total.Reset();
+        m_frames.store(0);
+        m_overruns.store(0);
+    }
+
+    // {"budget_us":N,"frames":N,"overruns":N,"degraded":B,"total":{...},"sampling":{...},...}
+    std::string ToJson() const {
+        char head[160];
+        snprintf(head, sizeof(head), "{\"budget_us\":%lld,\"frames\":%llu,\"overruns\":%llu,\"degraded\":%s,",
+            static_cast<long long>(BudgetUs()), static_cast<unsigned long long>(m_frames.load()),
+            static_cast<unsigned long long>(m_overruns.load()), IsDegraded() ? "true" : "false");
+        return std::string(head) + m_total.ToJson("total") + "," +
+            m_phases[Phase_Sampling].ToJson("sampling") + "," +
+            m_phases[Phase_Input].ToJson("input") + "," +
+            m_phases[Phase_ControllerPose].ToJson("controller_pose") + "," +
+            m_phases[Phase_TrackerPose].ToJson("tracker_pose") + "," +
+            m_phases[Phase_Logging].ToJson("logging") + "}";
+    }
+
+private:
+    std::atomic<int64_t> m_budgetNs{ DefaultBudgetUs * 1000 };
+    std::atomic<bool> m_allowDegrade{ false };
+    std::atomic<bool> m_degraded{ false };
+    std::atomic<uint64_t> m_frames{ 0 };
+    std::atomic<uint64_t> m_overruns{ 0 };
+
+    TreadmillCallProfile m_phases[Phase_Count];
+    TreadmillCallProfile m_total;
+
+    // Frame thread state
+    int64_t m_frameStartNs = 0;
+    int64_t m_phaseStartNs = 0;
+    int64_t m_frameNs[Phase_Count] = {};
+    bool m_window[WindowFrames] = {};
+    int m_windowPos = 0;
+    int m_windowOverruns = 0;
+    int m_framesSinceOverrun = 0;
+    int64_t m_lastWarnUs = 0;
+};
@@ -0,0 +1,203 @@
+#pragma once
+
+// ============================================================================
+// TreadmillInstrument - scoped zones, counters and frame marks
+// ============================================================================
+// One set of macros for timing the hooks and callbacks of the driver, the
+// OpenVR wrapper and the OpenXR layer:
+//
+//   TREADMILL_ZONE("name");                  scope: start time + duration
+//   TREADMILL_COUNTER("name", value);        a value at this moment
+//   TREADMILL_FRAME_MARK("name");            frame boundary
+//   TREADMILL_METRIC_ADD(page, metric, n);   page.Add() + counter event
+//   if (TREADMILL_EVERY_N("name", n)) ...    log throttle: true on every nth
+//                                            call of this site + counter event
+//
+// Without TREADMILL_INSTRUMENTATION (Release builds) the macros expand to
+// nothing and TREADMILL_METRIC_ADD to the plain page.Add(). With it (Debug
+// builds) each event costs one steady-clock read and one write into a
+// process-wide ring of the last Capacity events.
+//
+// Names must be string literals (the ring stores the pointer). Readers take
+// a Snapshot() or write the ring as a Chrome trace (chrome://tracing,
+// ui.perfetto.dev) with WriteChromeTrace().
+// ============================================================================
+
+#include "TreadmillCallProfile.h"
+#include "TreadmillMetrics.h"
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+enum class TreadmillEventType : uint32_t {
+    Zone,
+    Counter,
+    FrameMark
+};
+
+struct TreadmillEvent {
+    const char* name;
+    TreadmillEventType type;
+    uint32_t threadId;
+    int64_t timeNs;     // TreadmillCallProfile::NowNs()
+    int64_t value;      // Zone: duration in ns, Counter: value
+};
+
+// One ring entry, fields published by the sequence counter
+struct alignas(64) TreadmillEventSlot {
+    std::atomic<uint64_t> seq{ 0 };
+    std::atomic<const char*> name{ nullptr };
+    std::atomic<uint32_t> type{ 0 };
+    std::atomic<uint32_t> threadId{ 0 };
+    std::atomic<int64_t> timeNs{ 0 };
+    std::atomic<int64_t> value{ 0 };
+};
+
+class TreadmillInstrument {
+public:
+    static constexpr size_t Capacity = 16384;  // power of two
+    static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    // Any thread. Slots carry a sequence counter (odd = being written) like
+    // TreadmillSampleHistory, so writers never wait for readers.
+    static void Record(const char* name, TreadmillEventType type, int64_t timeNs, int64_t value) {
+        uint64_t index = s_next.fetch_add(1, std::memory_order_relaxed);
+        TreadmillEventSlot& slot = s_slots[index & (Capacity - 1)];
+        slot.seq.store(2 * index + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        slot.name.store(name, std::memory_order_relaxed);
+        slot.type.store(static_cast<uint32_t>(type), std::memory_order_relaxed);
+        slot.threadId.store(ThreadId(), std::memory_order_relaxed);
+        slot.timeNs.store(timeNs, std::memory_order_relaxed);
+        slot.value.store(value, std::memory_order_relaxed);
+        slot.seq.store(2 * index + 2, std::memory_order_release);
+    }
+
+    // Events still in the ring, oldest first. Slots being written are skipped.
+    static std::vector<TreadmillEvent> Snapshot() {
+        std::vector<TreadmillEvent> events;
+        uint64_t next = s_next.load(std::memory_order_acquire);
+        uint64_t first = next > Capacity ? next - Capacity : 0;
+        events.reserve(static_cast<size_t>(next - first));
+        for (uint64_t index = first; index < next; index++) {
+            const TreadmillEventSlot& slot = s_slots[index & (Capacity - 1)];
+            uint64_t expectedSeq = 2 * index + 2;
+            if (slot.seq.load(std::memory_order_acquire) != expectedSeq) continue;
+            TreadmillEvent e;
+            e.name = slot.name.load(std::memory_order_relaxed);
+            e.type = static_cast<TreadmillEventType>(slot.type.load(std::memory_order_relaxed));
+            e.threadId = slot.threadId.load(std::memory_order_relaxed);
+            e.timeNs = slot.timeNs.load(std::memory_order_relaxed);
+            e.value = slot.value.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (slot.seq.load(std::memory_order_relaxed) != expectedSeq) continue;  // overwritten while copying
+            events.push_back(e);
+        }
+        return events;
+    }
+
+    // Chrome trace event format; timestamps in microseconds
+    static bool WriteChromeTrace(const std::filesystem::path& path, const char* processName) {
+        std::vector<TreadmillEvent> events = Snapshot();
+        FILE* file = nullptr;
+#ifdef _WIN32
+        if (_wfopen_s(&file, path.c_str(), L"wb") != 0) file = nullptr;
+#else
+        file = fopen(path.c_str(), "wb");
+#endif
+        if (!file) return false;
+
+        fprintf(file, "{\"traceEvents\":[\n{\"ph\":\"M\",\"pid\":1,\"tid\":0,\"name\":\"process_name\",\"args\":{\"name\":\"%s\"}}", processName);
+        for (const TreadmillEvent& e : events) {
+            double tsUs = e.timeNs / 1000.0;
+            switch (e.type) {
+            case TreadmillEventType::Zone:
+                fprintf(file, ",\n{\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"dur\":%.3f}",
+                    e.threadId, e.name, tsUs, e.value / 1000.0);
+                break;
+            case TreadmillEventType::Counter:
+                fprintf(file, ",\n{\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                    e.threadId, e.name, tsUs, static_cast<long long>(e.value));
+                break;
+            case TreadmillEventType::FrameMark:
+                fprintf(file, ",\n{\"ph\":\"i\",\"s\":\"p\",\"pid\":1,\"tid\":%u,\"name\":\"%s\",\"ts\":%.3f}",
+                    e.threadId, e.name, tsUs);
+                break;
+            }
+        }
+        fprintf(file, "\n]}\n");
+        bool ok = ferror(file) == 0;
+        fclose(file);
+        return ok;
+    }
+
+private:
+    inline static TreadmillEventSlot s_slots[Capacity];
+    inline static std::atomic<uint64_t> s_next{ 0 };
+
+    // Small dense ids for the trace viewer's thread rows
+    static uint32_t ThreadId() {
+        static std::atomic<uint32_t> s_nextThreadId{ 1 };
+        thread_local uint32_t id = s_nextThreadId.fetch_add(1, std::memory_order_relaxed);
+        return id;
+    }
+};
+
+class TreadmillZone {
+public:
+    explicit TreadmillZone(const char* name) : m_name(name), m_startNs(TreadmillCallProfile::NowNs()) {}
+    ~TreadmillZone() {
+        TreadmillInstrument::Record(m_name, TreadmillEventType::Zone, m_startNs, TreadmillCallProfile::NowNs() - m_startNs);
+    }
+    TreadmillZone(const TreadmillZone&) = delete;
+    TreadmillZone& operator=(const TreadmillZone&) = delete;
+
+private:
+    const char* m_name;
+    int64_t m_startNs;
+};
+
+#define TREADMILL_CONCAT_INNER(a, b) a##b
+#define TREADMILL_CONCAT(a, b) TREADMILL_CONCAT_INNER(a, b)
+
+#ifdef TREADMILL_INSTRUMENTATION
+#define TREADMILL_ZONE(name) TreadmillZone TREADMILL_CONCAT(treadmillZone_, __LINE__)(name)
+#define TREADMILL_COUNTER(name, value) \
+    TreadmillInstrument::Record((name), TreadmillEventType::Counter, TreadmillCallProfile::NowNs(), static_cast<int64_t>(value))
+#define TREADMILL_FRAME_MARK(name) \
+    TreadmillInstrument::Record((name), TreadmillEventType::FrameMark, TreadmillCallProfile::NowNs(), 0)
+#define TREADMILL_METRIC_ADD(page, metric, delta) do { \
+        (page).Add((metric), (delta)); \
+        TREADMILL_COUNTER(GetTreadmillMetricInfo(metric).name, (page).Get((page).Component(), (metric))); \
+    } while (0)
+#else
+#define TREADMILL_ZONE(name) ((void)0)
+#define TREADMILL_COUNTER(name, value) ((void)0)
+#define TREADMILL_FRAME_MARK(name) ((void)0)
+#define TREADMILL_METRIC_ADD(page, metric, delta) (page).Add((metric), (delta))
+#endif
+
+// Calls of one call site. The count is kept in every build, the throttled
+// logs need it; the counter event only exists with TREADMILL_INSTRUMENTATION.
+class TreadmillCallCounter {
+public:
+    explicit TreadmillCallCounter(const char* name) : m_name(name) {}
+
+    // Counts one call, true on every nth
+    bool Every(uint64_t n) {
+        uint64_t count = m_count.fetch_add(1, std::memory_order_relaxed) + 1;
+        TREADMILL_COUNTER(m_name, count);
+        return count % n == 0;
+    }
+
+private:
+    const char* m_name;
+    std::atomic<uint64_t> m_count{ 0 };
+};
+
+// One counter per expansion: each lambda type has its own static
+#define TREADMILL_EVERY_N(name, n) \
+    ([]() -> TreadmillCallCounter& { static TreadmillCallCounter counter(name); return counter; }().Every(n))
@@ -0,0 +1,412 @@
+// ============================================================================
+// TreadmillIpcBench - producer/consumer benchmark of TreadmillSharedRegion
+// ============================================================================
+// Runs one producer and 1-8 consumers on a private shared memory region (never
+// OmniBridge's) and measures how each consumer strategy sees the samples:
+//
+//   callback   consumers are callbacks on the producer thread - the in-process
+//              lower bound (OmniBridge's RegisterCallback path), no IPC
+//   poll       consumer processes wake every 8 ms and read the ring
+//   spin       consumer processes busy-wait on UpdateCount
+//   futex      consumer processes block in WaitForUpdate (futex on Linux,
+//              the region's 1 ms poll on Windows)
+//
+// Per consumer it reports samples received and lost, latency (producer stamp
+// -> consumer read, p50/p99/max) and CPU time. Without options it sweeps all
+// modes at 100, 1000 and 5000 Hz with 1, 4 and 8 consumers.
+//
+//   TreadmillIpcBench.exe [--mode <callback|poll|spin|futex|all>] [--rate <hz>]
+//                         [--consumers <n>] [--seconds <n>] [--json <file>]
+//
+// --json writes one JSON object per run (one per line). Exit code: 0 if every
+// consumer received samples without loss, 1 on loss, 2 on a setup error.
+// ============================================================================
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#define popen _popen
+#define pclose _pclose
+#else
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include "../TreadmillLatencyStats.h"
+#include "../TreadmillSampleHistory.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+static const wchar_t* RegionName = L"Local\\OmniTreadmillIpcBench";
+#else
+static const char* RegionName = "/OmniTreadmillIpcBench";
+#endif
+
+static const char* Modes[] = { "callback", "poll", "spin", "futex" };
+constexpr int PollIntervalMs = 8;
+constexpr int MaxConsumers = 8;
+
+// The sample index travels in gamePadX (an int32 in the ring, exact below 2^24)
+constexpr int64_t IndexWrap = 1 << 24;
+
+static double ProcessCpuMs() {
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0.0;
+    auto ticks = [](const FILETIME& t) { return (static_cast<uint64_t>(t.dwHighDateTime) << 32) | t.dwLowDateTime; };
+    return (ticks(kernel) + ticks(user)) / 10000.0;
+#else
+    rusage usage{};
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000.0 +
+           (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000.0;
+#endif
+}
+
+static std::string SelfPath() {
+    char path[4096] = {};
+#ifdef _WIN32
+    GetModuleFileNameA(nullptr, path, sizeof(path));
+#else
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length > 0) path[length] = '\0';
+#endif
+    return path;
+}
+
+static void CpuRelax() {
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _WIN32
+    YieldProcessor();
+#else
+    __builtin_ia32_pause();
+#endif
+#endif
+}
+
+// What one consumer saw; serialized as one JSON line from consumer processes
+struct ConsumerResult {
+    uint64_t received = 0;
+    uint64_t lost = 0;
+    double cpuMs = 0.0;
+    TreadmillLatencyStats latency;
+
+    // Account for sample `index` read at nowUs
+    void OnSample(int64_t index, int64_t timeUs, int64_t nowUs, int64_t& lastIndex) {
+        if (lastIndex >= 0) {
+            int64_t gap = (index - lastIndex + IndexWrap) % IndexWrap;
+            if (gap > 1) lost += static_cast<uint64_t>(gap - 1);
+        }
+        lastIndex = index;
+        received++;
+        latency.Record(nowUs - timeUs);
+    }
+
+    std::string ToJson() const {
+        char buf[96];
+        snprintf(buf, sizeof(buf), "{\"received\":%llu,\"lost\":%llu,\"cpu_ms\":%.2f,",
+            static_cast<unsigned long long>(received), static_cast<unsigned long long>(lost), cpuMs);
+        return buf + latency.ToJson("latency") + "}";
+    }
+};
+
+// ----------------------------------------------------------------------------
+// Consumer process: attach, read until the producer releases the region
+// ----------------------------------------------------------------------------
+static int RunConsumer(const char* mode) {
+    TreadmillSampleHistory history(RegionName);
+    int64_t attachDeadline = TreadmillSampleHistory::NowUs() + 2000000;
+    while (!history.Open()) {
+        if (TreadmillSampleHistory::NowUs() > attachDeadline) {
+            fprintf(stderr, "consumer: region not found\n");
+            return 2;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    const TreadmillSharedRegion& region = history.Region();
+
+    bool poll = strcmp(mode, "poll") == 0;
+    bool spin = strcmp(mode, "spin") == 0;
+    ConsumerResult result;
+    TreadmillSample samples[TreadmillSampleHistory::Capacity];
+    int64_t lastIndex = -1;
+    uint64_t count = region.UpdateCount();
+    bool seenConnected = false;
+    double cpuStartMs = ProcessCpuMs();
+    int64_t idleDeadline = TreadmillSampleHistory::NowUs() + 5000000;
+
+    for (;;) {
+        if (poll) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(PollIntervalMs));
+        } else if (spin) {
+            while (region.UpdateCount() == count && TreadmillSampleHistory::NowUs() < idleDeadline) CpuRelax();
+        } else {
+            region.WaitForUpdate(count, 100);
+        }
+        count = region.UpdateCount();
+        int n = history.Snapshot(samples, TreadmillSampleHistory::Capacity);
+        int64_t nowUs = TreadmillSampleHistory::NowUs();
+
+        for (int i = 0; i < n; i++) {
+            // Cursor on the index, not the stamp: a producer catching up publishes
+            // several samples within the same microsecond
+            int64_t index = static_cast<int64_t>(samples[i].gamePadX);
+            int64_t ahead = (index - lastIndex + IndexWrap) % IndexWrap;
+            if (lastIndex >= 0 && (ahead == 0 || ahead > IndexWrap / 2)) continue;
+            result.OnSample(index, samples[i].timeUs, nowUs, lastIndex);
+            idleDeadline = nowUs + 5000000;
+        }
+
+        bool connected = region.Read<uint32_t>(TreadmillSharedRegion::OffsetConnected) != 0;
+        seenConnected = seenConnected || connected;
+        if ((seenConnected && !connected) || nowUs > idleDeadline) break;
+    }
+
+    result.cpuMs = ProcessCpuMs() - cpuStartMs;
+    printf("%s\n", result.ToJson().c_str());
+    return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Producer: publish at rateHz for the run, consumers in-process or spawned
+// ----------------------------------------------------------------------------
+struct RunResult {
+    const char* mode = "";
+    int rateHz = 0;
+    int consumers = 0;
+    int seconds = 0;
+    uint64_t published = 0;
+    double achievedHz = 0.0;
+    double producerCpuMs = 0.0;
+    std::vector<std::string> consumerJson;
+    uint64_t totalLost = 0;
+    bool complete = true;
+};
+
+static bool RunBench(const char* mode, int rateHz, int consumers, int seconds, RunResult& run) {
+    run.mode = mode;
+    run.rateHz = rateHz;
+    run.consumers = consumers;
+    run.seconds = seconds;
+
+    TreadmillSharedRegion::Remove(RegionName);
+    TreadmillSharedRegion region(RegionName);
+    if (!region.Create()) {
+        fprintf(stderr, "Cannot create the shared memory region\n");
+        return false;
+    }
+
+    bool callback = strcmp(mode, "callback") == 0;
+    std::vector<ConsumerResult> inProcess(callback ? consumers : 0);
+    std::vector<int64_t> lastIndex(inProcess.size(), -1);
+    std::vector<FILE*> children;
+
+    if (!callback) {
+        std::string self = SelfPath();
+        for (int i = 0; i < consumers; i++) {
+            char command[4200];
+#ifdef _WIN32
+            // cmd.exe strips the outer quotes, keep the ones around the path
+            snprintf(command, sizeof(command), "\"\"%s\" --consumer %s\"", self.c_str(), mode);
+#else
+            snprintf(command, sizeof(command), "'%s' --consumer %s", self.c_str(), mode);
+#endif
+            FILE* child = popen(command, "r");
+            if (!child) {
+                fprintf(stderr, "Cannot start consumer %d\n", i);
+                return false;
+            }
+            children.push_back(child);
+        }
+        // Consumers attach within a few ms; give slow machines room
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    }
+
+    double cpuStartMs = ProcessCpuMs();
+    int64_t periodUs = 1000000 / rateHz;
+    int64_t startUs = TreadmillSampleHistory::NowUs();
+    int64_t endUs = startUs + seconds * 1000000LL;
+    int64_t nextUs = startUs;
+    int64_t index = 0;
+
+    while (nextUs < endUs) {
+        for (;;) {
+            int64_t left = nextUs - TreadmillSampleHistory::NowUs();
+            if (left <= 0) break;
+#ifdef _WIN32
+            // Sleep has ms granularity: sleep while far away, yield the rest so 5 kHz stays 5 kHz
+            if (left > 2000) {
+                Sleep(static_cast<DWORD>((left - 2000) / 1000));
+            } else {
+                std::this_thread::yield();
+            }
+#else
+            std::this_thread::sleep_for(std::chrono::microseconds(left));
+#endif
+        }
+
+        TreadmillSample s;
+        s.timeUs = TreadmillSampleHistory::NowUs();
+        s.yaw = static_cast<float>(index % 360);
+        s.gamePadX = static_cast<float>(index % IndexWrap);
+        region.Publish(s, 0.0f, 0.0f);
+
+        for (size_t i = 0; i < inProcess.size(); i++) {
+            int64_t nowUs = TreadmillSampleHistory::NowUs();
+            inProcess[i].OnSample(index % IndexWrap, s.timeUs, nowUs, lastIndex[i]);
+            inProcess[i].cpuMs += (TreadmillSampleHistory::NowUs() - nowUs) / 1000.0;
+        }
+
+        index++;
+        nextUs += periodUs;
+    }
+
+    int64_t elapsedUs = TreadmillSampleHistory::NowUs() - startUs;
+    run.producerCpuMs = ProcessCpuMs() - cpuStartMs;
+    run.published = static_cast<uint64_t>(index);
+    run.achievedHz = elapsedUs > 0 ? index * 1e6 / elapsedUs : 0.0;
+
+    // Releasing the lease tells the consumer processes to report
+    region.Close();
+    TreadmillSharedRegion::Remove(RegionName);
+
+    for (ConsumerResult& result : inProcess) {
+        run.consumerJson.push_back(result.ToJson());
+        run.totalLost += result.lost;
+        if (result.received == 0) run.complete = false;
+    }
+    for (FILE* child : children) {
+        char line[512] = {};
+        bool ok = fgets(line, sizeof(line), child) != nullptr;
+        pclose(child);
+        line[strcspn(line, "\r\n")] = '\0';
+
+        unsigned long long received = 0, lost = 0;
+        if (!ok || sscanf(line, "{\"received\":%llu,\"lost\":%llu", &received, &lost) != 2) {
+            run.consumerJson.push_back("null");
+            run.complete = false;
+            continue;
+        }
+        run.consumerJson.push_back(line);
+        run.totalLost += lost;
+        if (received == 0) run.complete = false;
+    }
+    return true;
+}
+
+static std::string RunToJson(const RunResult& run) {
+    char buf[256];
+    snprintf(buf, sizeof(buf),
+        "{\"mode\":\"%s\",\"rate_hz\":%d,\"consumers\":%d,\"seconds\":%d,\"published\":%llu,"
+        "\"achieved_hz\":%.1f,\"producer_cpu_ms\":%.2f,\"consumer\":[",
+        run.mode, run.rateHz, run.consumers, run.seconds, static_cast<unsigned long long>(run.published),
+        run.achievedHz, run.producerCpuMs);
+    std::string json = buf;
+    for (size_t i = 0; i < run.consumerJson.size(); i++) {
+        if (i > 0) json += ",";
+        json += run.consumerJson[i];
+    }
+    return json + "]}";
+}
+
+static void PrintRun(const RunResult& run) {
+    printf("%-8s %5d Hz  %d consumer%s  published %llu (%.0f Hz)  producer cpu %.1f ms\n",
+        run.mode, run.rateHz, run.consumers, run.consumers == 1 ? "" : "s",
+        static_cast<unsigned long long>(run.published), run.achievedHz, run.producerCpuMs);
+    for (size_t i = 0; i < run.consumerJson.size(); i++) {
+        unsigned long long received = 0, lost = 0, count = 0;
+        long long p50 = 0, p99 = 0, max = 0;
+        double cpuMs = 0.0;
+        if (sscanf(run.consumerJson[i].c_str(),
+                "{\"received\":%llu,\"lost\":%llu,\"cpu_ms\":%lf,\"latency\":{\"count\":%llu,\"p50_us\":%lld,\"p99_us\":%lld,\"max_us\":%lld",
+                &received, &lost, &cpuMs, &count, &p50, &p99, &max) != 7) {
+            printf("  #%zu  no report\n", i);
+            continue;
+        }
+        printf("  #%zu  received %llu  lost %llu  p50 %lld us  p99 %lld us  max %lld us  cpu %.1f ms\n",
+            i, received, lost, p50, p99, max, cpuMs);
+    }
+    fflush(stdout);
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillIpcBench [--mode <callback|poll|spin|futex|all>] [--rate <hz>]\n"
+           "                         [--consumers <n>] [--seconds <n>] [--json <file>]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc == 3 && strcmp(argv[1], "--consumer") == 0) return RunConsumer(argv[2]);
+
+    const char* mode = "all";
+    int rate = 0;
+    int consumers = 0;
+    int seconds = 2;
+    const char* jsonPath = nullptr;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--mode") == 0 && i + 1 < argc) {
+            mode = argv[++i];
+        } else if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rate = std::clamp(atoi(argv[++i]), 100, 5000);
+        } else if (strcmp(argv[i], "--consumers") == 0 && i + 1 < argc) {
+            consumers = std::clamp(atoi(argv[++i]), 1, MaxConsumers);
+        } else if (strcmp(argv[i], "--seconds") == 0 && i + 1 < argc) {
+            seconds = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            jsonPath = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    std::vector<const char*> modes;
+    for (const char* m : Modes) {
+        if (strcmp(mode, "all") == 0 || strcmp(mode, m) == 0) modes.push_back(m);
+    }
+    if (modes.empty()) {
+        PrintUsage();
+        return 1;
+    }
+    std::vector<int> rates = rate > 0 ? std::vector<int>{ rate } : std::vector<int>{ 100, 1000, 5000 };
+    std::vector<int> counts = consumers > 0 ? std::vector<int>{ consumers } : std::vector<int>{ 1, 4, 8 };
+
+    FILE* json = nullptr;
+    if (jsonPath && !(json = fopen(jsonPath, "w"))) {
+        fprintf(stderr, "Cannot write %s\n", jsonPath);
+        return 2;
+    }
+
+    bool lossFree = true;
+    for (const char* m : modes) {
+        for (int r : rates) {
+            for (int c : counts) {
+                RunResult run;
+                if (!RunBench(m, r, c, seconds, run)) {
+                    if (json) fclose(json);
+                    return 2;
+                }
+                PrintRun(run);
+                if (json) {
+                    fprintf(json, "%s\n", RunToJson(run).c_str());
+                    fflush(json);
+                }
+                if (!run.complete) {
+                    if (json) fclose(json);
+                    fprintf(stderr, "A consumer did not report\n");
+                    return 2;
+                }
+                if (run.totalLost > 0) lossFree = false;
+            }
+        }
+    }
+
+    if (json) fclose(json);
+    return lossFree ? 0 : 1;
+}
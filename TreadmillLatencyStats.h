@@ -0,0 +1,81 @@
+#pragma once
+
+// ============================================================================
+// TreadmillLatencyStats - delivery latency of treadmill samples
+// ============================================================================
+// Keeps the last Window latencies (microseconds from OmniBridge receiving a
+// packet to a host consuming it) and reports count, p50, p99 and max.
+// Both timestamps come from the same QPC clock (TreadmillSampleHistory::NowUs),
+// so the numbers compare across processes and transports.
+// ============================================================================
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class TreadmillLatencyStats {
+public:
+    static constexpr size_t Window = 4096;
+
+    struct Summary {
+        uint64_t count = 0;     // samples recorded since the last Reset
+        int64_t p50Us = 0;      // percentiles over the last Window samples
+        int64_t p99Us = 0;
+        int64_t maxUs = 0;      // max since the last Reset
+    };
+
+    void Record(int64_t latencyUs) {
+        if (latencyUs < 0) latencyUs = 0;  // clock read on another core, never negative
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_values.size() < Window) {
+            m_values.push_back(latencyUs);
+        } else {
+            m_values[m_count % Window] = latencyUs;
+        }
+        m_count++;
+        m_max = std::max(m_max, latencyUs);
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_values.clear();
+        m_count = 0;
+        m_max = 0;
+    }
+
+    Summary GetSummary() const {
+        std::vector<int64_t> sorted;
+        Summary s;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            sorted = m_values;
+            s.count = m_count;
+            s.maxUs = m_max;
+        }
+        if (sorted.empty()) return s;
+
+        std::sort(sorted.begin(), sorted.end());
+        s.p50Us = sorted[(sorted.size() - 1) * 50 / 100];
+        s.p99Us = sorted[(sorted.size() - 1) * 99 / 100];
+        return s;
+    }
+
+    // "name":{"count":N,"p50_us":N,"p99_us":N,"max_us":N}
+    std::string ToJson(const char* name) const {
+        Summary s = GetSummary();
+        char buf[192];
+        snprintf(buf, sizeof(buf), "\"%s\":{\"count\":%llu,\"p50_us\":%lld,\"p99_us\":%lld,\"max_us\":%lld}",
+            name, static_cast<unsigned long long>(s.count),
+            static_cast<long long>(s.p50Us), static_cast<long long>(s.p99Us), static_cast<long long>(s.maxUs));
+        return buf;
+    }
+
+private:
+    mutable std::mutex m_mutex;
+    std::vector<int64_t> m_values;
+    uint64_t m_count = 0;
+    int64_t m_max = 0;
+};
@@ -0,0 +1,159 @@
+#pragma once
+
+// ============================================================================
+// TreadmillLocomotion - walking as a moving standing universe
+// ============================================================================
+// For titles that neither the OpenVR wrapper nor the OpenXR layer reach, the
+// driver can integrate the treadmill stick into a world translation
+// (universe_locomotion) and TreadmillLocomotion.exe shifts the standing
+// universe by it, so the user walks through any SteamVR title.
+//
+//   Driver:    TreadmillLocomotionIntegrator, once per filtered sample,
+//              published as the locomotion_x_um / locomotion_z_um gauges
+//              of the driver's metrics block (TreadmillMetrics.h)
+//   Companion: TreadmillUniverseOffsetWriter against IVRChaperoneSetup
+//
+// The translation is in raw tracking space (the controller pose's space),
+// so it applies to the standing zero pose without any rotation.
+// ============================================================================
+
+#include <cmath>
+#include <cstdint>
+
+class TreadmillLocomotionIntegrator {
+public:
+    static constexpr int64_t MaxStepUs = 100000;  // gaps longer than this count as 100 ms
+
+    // stickX/stickY: treadmill stick -1..1 (X lateral, Y forward), yawDeg:
+    // controller yaw as in TreadmillDevice::GetPose, metersPerSecond at 1.0
+    void Integrate(float stickX, float stickY, float yawDeg, float metersPerSecond, int64_t timeUs) {
+        int64_t dtUs = m_lastTimeUs == 0 ? 0 : timeUs - m_lastTimeUs;
+        m_lastTimeUs = timeUs;
+        if (dtUs <= 0) return;
+        if (dtUs > MaxStepUs) dtUs = MaxStepUs;
+
+        // Same convention as the controller pose: rotation by -yaw around +Y,
+        // forward = -Z, so forward = (sin, 0, -cos) and right = (cos, 0, sin)
+        constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+        double theta = static_cast<double>(yawDeg) * DEG2RAD;
+        double c = std::cos(theta);
+        double s = std::sin(theta);
+        double distance = static_cast<double>(metersPerSecond) * dtUs * 1e-6;
+        m_x += distance * (stickX * c + stickY * s);
+        m_z += distance * (stickX * s - stickY * c);
+    }
+
+    void Reset() {
+        m_x = 0.0;
+        m_z = 0.0;
+        m_lastTimeUs = 0;
+    }
+
+    double X() const { return m_x; }    // meters
+    double Z() const { return m_z; }
+
+private:
+    double m_x = 0.0;
+    double m_z = 0.0;
+    int64_t m_lastTimeUs = 0;
+};
+
+// Row-major 3x4 like vr::HmdMatrix34_t
+struct TreadmillMatrix34 {
+    float m[3][4];
+};
+
+// The part of IVRChaperoneSetup the writer needs, so it can run against a
+// stub as well as the real interface
+class TreadmillChaperoneSetup {
+public:
+    virtual ~TreadmillChaperoneSetup() = default;
+    virtual bool GetWorkingStandingZeroPose(TreadmillMatrix34& pose) = 0;
+    virtual void SetWorkingStandingZeroPose(const TreadmillMatrix34& pose) = 0;
+    virtual bool CommitWorkingCopy() = 0;    // to the live configuration
+};
+
+// Applies the offset at most every MinIntervalUs and only when it moved by
+// MinStepMeters, so each update is one Set + Commit however fast the driver
+// integrates. The standing pose found at Begin() is restored by End().
+class TreadmillUniverseOffsetWriter {
+public:
+    static constexpr int64_t DefaultIntervalUs = 11111;     // 90 Hz
+    static constexpr double DefaultMinStepMeters = 0.0005;
+
+    explicit TreadmillUniverseOffsetWriter(TreadmillChaperoneSetup& chaperone) : m_chaperone(chaperone) {}
+
+    void Configure(int64_t minIntervalUs, double minStepMeters) {
+        m_minIntervalUs = minIntervalUs;
+        m_minStepMeters = minStepMeters;
+    }
+
+    // Captures the base pose; x/z are the driver's offset at that moment and
+    // become the zero point, so the universe does not jump on start
+    bool Begin(double x, double z) {
+        if (!m_chaperone.GetWorkingStandingZeroPose(m_base)) return false;
+        m_originX = x;
+        m_originZ = z;
+        m_appliedX = 0.0;
+        m_appliedZ = 0.0;
+        m_lastWriteUs = 0;
+        m_active = true;
+        return true;
+    }
+
+    // Returns true when an update was committed
+    bool Update(double x, double z, int64_t nowUs) {
+        if (!m_active) return false;
+        if (m_lastWriteUs != 0 && nowUs - m_lastWriteUs < m_minIntervalUs) {
+            m_skipped++;
+            return false;
+        }
+        double dx = (x - m_originX) - m_appliedX;
+        double dz = (z - m_originZ) - m_appliedZ;
+        if (std::fabs(dx) < m_minStepMeters && std::fabs(dz) < m_minStepMeters) {
+            m_skipped++;
+            return false;
+        }
+        if (!Write(x - m_originX, z - m_originZ)) return false;
+        m_lastWriteUs = nowUs;
+        return true;
+    }
+
+    void End() {
+        if (!m_active) return;
+        m_chaperone.SetWorkingStandingZeroPose(m_base);
+        m_chaperone.CommitWorkingCopy();
+        m_active = false;
+    }
+
+    bool IsActive() const { return m_active; }
+    uint64_t Writes() const { return m_writes; }
+    uint64_t Skipped() const { return m_skipped; }
+
+private:
+    TreadmillChaperoneSetup& m_chaperone;
+    TreadmillMatrix34 m_base = {};
+    int64_t m_minIntervalUs = DefaultIntervalUs;
+    double m_minStepMeters = DefaultMinStepMeters;
+    double m_originX = 0.0, m_originZ = 0.0;
+    double m_appliedX = 0.0, m_appliedZ = 0.0;
+    int64_t m_lastWriteUs = 0;
+    uint64_t m_writes = 0;
+    uint64_t m_skipped = 0;
+    bool m_active = false;
+
+    // The user walked (x, z) through raw space; moving the standing origin
+    // the opposite way keeps them in place physically but moves them in
+    // the world
+    bool Write(double x, double z) {
+        TreadmillMatrix34 pose = m_base;
+        pose.m[0][3] = static_cast<float>(m_base.m[0][3] - x);
+        pose.m[2][3] = static_cast<float>(m_base.m[2][3] - z);
+        m_chaperone.SetWorkingStandingZeroPose(pose);
+        if (!m_chaperone.CommitWorkingCopy()) return false;
+        m_appliedX = x;
+        m_appliedZ = z;
+        m_writes++;
+        return true;
+    }
+};
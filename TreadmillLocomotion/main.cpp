@@ -0,0 +1,189 @@
+// ============================================================================
+// TreadmillLocomotion - walk through any SteamVR title
+// ============================================================================
+// Companion for the driver's universe_locomotion mode: reads the walked
+// offset from the driver's metrics block (TreadmillMetrics.h) and shifts
+// the standing universe by it through IVRChaperoneSetup, at most --rate
+// times a second (TreadmillLocomotion.h). The original standing pose is
+// restored on exit or when the driver goes away.
+//
+//   TreadmillLocomotion.exe [--rate <hz>] [--min-step <mm>] [--openvr <openvr_api.dll>]
+//
+// Runs as an OpenVR background application, so SteamVR must be running.
+// ============================================================================
+
+#include "../TreadmillLocomotion.h"
+#include "../TreadmillMetrics.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#ifndef _WIN32
+#include <csignal>
+#include <dlfcn.h>
+#endif
+
+// ============================================================================
+// OPENVR (loaded at runtime, like the wrapper)
+// ============================================================================
+
+#ifdef _WIN32
+#define VR_CALLTYPE __cdecl
+#else
+#define VR_CALLTYPE
+#endif
+
+static constexpr int VRApplication_Background = 3;
+static constexpr int EChaperoneConfigFile_Live = 1;
+static const char* const IVRChaperoneSetup_Version = "IVRChaperoneSetup_006";
+
+typedef uint32_t (VR_CALLTYPE *PFN_VR_InitInternal2)(int*, int, const char*);
+typedef void (VR_CALLTYPE *PFN_VR_ShutdownInternal)();
+typedef void* (VR_CALLTYPE *PFN_VR_GetGenericInterface)(const char*, int*);
+
+// vr::IVRChaperoneSetup (IVRChaperoneSetup_006), vtable order as in openvr.h;
+// only CommitWorkingCopy and the standing zero pose are called
+class IVRChaperoneSetup006 {
+public:
+    virtual bool CommitWorkingCopy(int configFile) = 0;
+    virtual void RevertWorkingCopy() = 0;
+    virtual bool GetWorkingPlayAreaSize(float* sizeX, float* sizeZ) = 0;
+    virtual bool GetWorkingPlayAreaRect(void* rect) = 0;
+    virtual bool GetWorkingCollisionBoundsInfo(void* quads, uint32_t* count) = 0;
+    virtual bool GetLiveCollisionBoundsInfo(void* quads, uint32_t* count) = 0;
+    virtual bool GetWorkingSeatedZeroPoseToRawTrackingPose(TreadmillMatrix34* pose) = 0;
+    virtual bool GetWorkingStandingZeroPoseToRawTrackingPose(TreadmillMatrix34* pose) = 0;
+    virtual void SetWorkingPlayAreaSize(float sizeX, float sizeZ) = 0;
+    virtual void SetWorkingCollisionBoundsInfo(void* quads, uint32_t count) = 0;
+    virtual void SetWorkingPerimeter(void* points, uint32_t count) = 0;
+    virtual void SetWorkingSeatedZeroPoseToRawTrackingPose(const TreadmillMatrix34* pose) = 0;
+    virtual void SetWorkingStandingZeroPoseToRawTrackingPose(const TreadmillMatrix34* pose) = 0;
+};
+
+class OpenVRChaperoneSetup : public TreadmillChaperoneSetup {
+public:
+    explicit OpenVRChaperoneSetup(IVRChaperoneSetup006* setup) : m_setup(setup) {}
+
+    bool GetWorkingStandingZeroPose(TreadmillMatrix34& pose) override {
+        return m_setup->GetWorkingStandingZeroPoseToRawTrackingPose(&pose);
+    }
+    void SetWorkingStandingZeroPose(const TreadmillMatrix34& pose) override {
+        m_setup->SetWorkingStandingZeroPoseToRawTrackingPose(&pose);
+    }
+    bool CommitWorkingCopy() override {
+        return m_setup->CommitWorkingCopy(EChaperoneConfigFile_Live);
+    }
+
+private:
+    IVRChaperoneSetup006* m_setup;
+};
+
+static std::atomic<bool> g_stop{ false };
+
+#ifdef _WIN32
+static BOOL WINAPI OnConsoleCtrl(DWORD) {
+    g_stop.store(true);
+    return TRUE;  // main restores the universe and exits
+}
+#else
+static void OnSignal(int) {
+    g_stop.store(true);
+}
+#endif
+
+static void PrintUsage() {
+    printf("Usage: TreadmillLocomotion [--rate <hz>] [--min-step <mm>] [--openvr <openvr_api.dll>]\n");
+}
+
+int main(int argc, char** argv) {
+    int rateHz = 90;
+    double minStepMm = TreadmillUniverseOffsetWriter::DefaultMinStepMeters * 1000.0;
+#ifdef _WIN32
+    std::string openvrPath = "openvr_api.dll";
+#else
+    std::string openvrPath = "libopenvr_api.so";
+#endif
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rate") == 0 && i + 1 < argc) {
+            rateHz = std::clamp(atoi(argv[++i]), 1, 500);
+        } else if (strcmp(argv[i], "--min-step") == 0 && i + 1 < argc) {
+            minStepMm = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--openvr") == 0 && i + 1 < argc) {
+            openvrPath = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    HMODULE openvr = LoadLibraryA(openvrPath.c_str());
+    auto resolve = [openvr](const char* name) { return openvr ? reinterpret_cast<void*>(GetProcAddress(openvr, name)) : nullptr; };
+    SetConsoleCtrlHandler(OnConsoleCtrl, TRUE);
+#else
+    void* openvr = dlopen(openvrPath.c_str(), RTLD_NOW);
+    auto resolve = [openvr](const char* name) { return openvr ? dlsym(openvr, name) : nullptr; };
+    signal(SIGINT, OnSignal);
+    signal(SIGTERM, OnSignal);
+#endif
+    auto initInternal2 = reinterpret_cast<PFN_VR_InitInternal2>(resolve("VR_InitInternal2"));
+    auto shutdownInternal = reinterpret_cast<PFN_VR_ShutdownInternal>(resolve("VR_ShutdownInternal"));
+    auto getGenericInterface = reinterpret_cast<PFN_VR_GetGenericInterface>(resolve("VR_GetGenericInterface"));
+    if (!initInternal2 || !shutdownInternal || !getGenericInterface) {
+        fprintf(stderr, "Cannot load OpenVR from %s\n", openvrPath.c_str());
+        return 2;
+    }
+
+    int error = 0;
+    initInternal2(&error, VRApplication_Background, nullptr);
+    if (error != 0) {
+        fprintf(stderr, "VR_InitInternal2 failed (%d) - is SteamVR running?\n", error);
+        return 2;
+    }
+    auto* setup = static_cast<IVRChaperoneSetup006*>(getGenericInterface(IVRChaperoneSetup_Version, &error));
+    if (!setup || error != 0) {
+        fprintf(stderr, "%s not available (%d)\n", IVRChaperoneSetup_Version, error);
+        shutdownInternal();
+        return 2;
+    }
+
+    OpenVRChaperoneSetup chaperone(setup);
+    TreadmillUniverseOffsetWriter writer(chaperone);
+    writer.Configure(1000000 / rateHz, minStepMm / 1000.0);
+
+    TreadmillMetricsPage page;
+    auto interval = std::chrono::microseconds(1000000 / rateHz);
+    printf("Waiting for the driver (universe_locomotion = true)...\n");
+    while (!g_stop.load()) {
+        auto next = std::chrono::steady_clock::now() + interval;
+        if (!page.IsOpen()) page.Open();
+
+        bool alive = page.IsAlive(TreadmillComponent::Driver);
+        double x = page.Get(TreadmillComponent::Driver, TreadmillMetric::LocomotionXUm) * 1e-6;
+        double z = page.Get(TreadmillComponent::Driver, TreadmillMetric::LocomotionZUm) * 1e-6;
+        int64_t nowUs = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+
+        if (alive && !writer.IsActive()) {
+            if (writer.Begin(x, z)) printf("Driver found - moving the standing universe at up to %d Hz\n", rateHz);
+        } else if (!alive && writer.IsActive()) {
+            writer.End();
+            printf("Driver gone - standing universe restored (%llu updates, %llu skipped)\n",
+                static_cast<unsigned long long>(writer.Writes()), static_cast<unsigned long long>(writer.Skipped()));
+        } else if (alive) {
+            writer.Update(x, z, nowUs);
+        }
+        std::this_thread::sleep_until(next);
+    }
+
+    writer.End();
+    printf("Standing universe restored (%llu updates, %llu skipped)\n",
+        static_cast<unsigned long long>(writer.Writes()), static_cast<unsigned long long>(writer.Skipped()));
+    shutdownInternal();
+    return 0;
+}
@@ -0,0 +1,309 @@
+#pragma once
+
+// ============================================================================
+// TreadmillMetrics - live counters and gauges in a shared-memory page
+// ============================================================================
+// Every native component (driver, OpenVR wrapper, OpenXR layer) owns one
+// block of a named page and publishes a fixed set of metrics into it.
+// TreadmillMetrics.exe (TreadmillMetricsCli) reads the page while the
+// components run and renders it or writes Prometheus text.
+//
+//   Windows: named file mapping "Local\OmniTreadmillMetrics"
+//   Linux:   POSIX shared memory "/OmniTreadmillMetrics"
+//
+// Publishing is one relaxed atomic store (Set) or a relaxed load and store
+// (Add). Each metric of a block has a single writer thread; if two processes
+// of the same component run, the last one to Create() owns the block.
+//
+// Heartbeat() also samples the host process's resident memory and handle
+// (fd) count once a second, so long runs can be watched for leaks.
+// ============================================================================
+
+#include "TreadmillSharedRegion.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <dirent.h>
+#include <cstdio>
+#endif
+
+enum class TreadmillComponent : uint32_t {
+    Driver,
+    Wrapper,
+    Layer,
+    Count
+};
+
+enum class TreadmillMetric : uint32_t {
+    SamplesTotal,           // treadmill samples consumed
+    SamplesPerSecond,       // SamplesTotal rate over the last second
+    FilterLagUs,            // time constant of the stick filter
+    DroppedSamplesTotal,    // samples lost between producer and consumer
+    FrameOverheadNs,        // our time per frame / hooked call
+    InjectionsTotal,        // joystick values handed to SteamVR or the game
+    ResidentBytes,          // working set of the host process
+    HandleCount,            // open handles (Windows) or fds (Linux) of the host process
+    LocomotionXUm,          // universe_locomotion offset in raw tracking space (TreadmillLocomotion.h)
+    LocomotionZUm,
+    Count
+};
+
+struct TreadmillMetricInfo {
+    const char* name;       // Prometheus name without the treadmill_ prefix
+    const char* help;
+    bool counter;           // false = gauge
+};
+
+inline const TreadmillMetricInfo& GetTreadmillMetricInfo(TreadmillMetric metric) {
+    static const TreadmillMetricInfo infos[] = {
+        { "samples_total", "Treadmill samples consumed", true },
+        { "samples_per_second", "Treadmill samples consumed per second", false },
+        { "filter_lag_us", "Time constant of the stick filter in microseconds", false },
+        { "dropped_samples_total", "Samples lost between OmniBridge and this component", true },
+        { "frame_overhead_ns", "Time spent per frame or hooked call in nanoseconds", false },
+        { "injections_total", "Joystick values handed to SteamVR or the game", true },
+        { "resident_bytes", "Working set of the host process in bytes", false },
+        { "handle_count", "Open handles or file descriptors of the host process", false },
+        { "locomotion_x_um", "Walked distance along raw tracking X in micrometers", false },
+        { "locomotion_z_um", "Walked distance along raw tracking Z in micrometers", false },
+    };
+    static_assert(sizeof(infos) / sizeof(infos[0]) == static_cast<size_t>(TreadmillMetric::Count), "metric table out of sync");
+    return infos[static_cast<size_t>(metric)];
+}
+
+inline const char* GetTreadmillComponentName(TreadmillComponent component) {
+    switch (component) {
+    case TreadmillComponent::Driver: return "driver";
+    case TreadmillComponent::Wrapper: return "wrapper";
+    case TreadmillComponent::Layer: return "layer";
+    default: return "unknown";
+    }
+}
+
+class TreadmillMetricsPage {
+public:
+    static constexpr uint32_t Magic = 0x54454D4F;  // 'OMET'
+    static constexpr uint32_t Version = 3;
+    static constexpr size_t ComponentCount = static_cast<size_t>(TreadmillComponent::Count);
+    static constexpr size_t MetricCount = static_cast<size_t>(TreadmillMetric::Count);
+
+    // Header, then one cache-line aligned block per component
+    static constexpr size_t OffsetMagic = 0;
+    static constexpr size_t OffsetVersion = 4;
+    static constexpr size_t OffsetComponentCount = 8;
+    static constexpr size_t OffsetMetricCount = 12;
+    static constexpr size_t HeaderSize = 64;
+    static constexpr size_t BlockPid = 0;           // uint32, 0 = not running
+    static constexpr size_t BlockHeartbeat = 8;     // int64, TickCountMs of the last Heartbeat()
+    static constexpr size_t BlockValues = 16;       // int64[MetricCount]
+    static constexpr size_t BlockSize = 128;
+    static constexpr size_t Size = HeaderSize + ComponentCount * BlockSize;
+    static constexpr int64_t StaleAfterMs = 2000;
+
+    static_assert(BlockValues + MetricCount * sizeof(int64_t) <= BlockSize, "metric block too small");
+    static_assert(std::atomic<int64_t>::is_always_lock_free, "metrics need lock-free 64-bit atomics");
+
+    TreadmillMetricsPage() = default;
+    ~TreadmillMetricsPage() { Close(); }
+    TreadmillMetricsPage(const TreadmillMetricsPage&) = delete;
+    TreadmillMetricsPage& operator=(const TreadmillMetricsPage&) = delete;
+
+    // Publisher: create (or attach to) the page and take over the component's block
+    bool Create(TreadmillComponent component) {
+        if (m_view) return m_writable;
+        if (!Map(true)) return false;
+        m_writable = true;
+        m_component = component;
+
+        if (Load32(OffsetMagic) != Magic || Load32(OffsetVersion) != Version) {
+            Store32(OffsetComponentCount, static_cast<uint32_t>(ComponentCount));
+            Store32(OffsetMetricCount, static_cast<uint32_t>(MetricCount));
+            Store32(OffsetVersion, Version);
+            std::atomic_thread_fence(std::memory_order_release);
+            Store32(OffsetMagic, Magic);
+        }
+
+        for (size_t i = 0; i < MetricCount; i++) Set(static_cast<TreadmillMetric>(i), 0);
+        Slot(Block(component) + BlockHeartbeat).store(TreadmillSharedRegion::TickCountMs(), std::memory_order_relaxed);
+        Store32(Block(component) + BlockPid, CurrentPid());
+        m_rateTotal = 0;
+        m_rateTimeMs = 0;
+        return true;
+    }
+
+    // Reader: attach read-only. Fails while no component has created the page.
+    bool Open() {
+        if (m_view) return true;
+        if (!Map(false)) return false;
+        if (Load32(OffsetMagic) != Magic || Load32(OffsetVersion) != Version) {
+            Close();
+            return false;
+        }
+        m_writable = false;
+        return true;
+    }
+
+    void Close() {
+        if (m_view && m_writable) Store32(Block(m_component) + BlockPid, 0);
+#ifdef _WIN32
+        if (m_view) UnmapViewOfFile(m_view);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        if (m_view) munmap(m_view, Size);
+#endif
+        m_view = nullptr;
+        m_writable = false;
+    }
+
+    bool IsOpen() const { return m_view != nullptr; }
+    TreadmillComponent Component() const { return m_component; }
+
+    void Set(TreadmillMetric metric, int64_t value) {
+        if (!m_writable) return;
+        Value(m_component, metric).store(value, std::memory_order_relaxed);
+    }
+
+    void Add(TreadmillMetric metric, int64_t delta = 1) {
+        if (!m_writable) return;
+        std::atomic<int64_t>& v = Value(m_component, metric);
+        v.store(v.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+    }
+
+    // Publisher, once per frame or packet from one thread: marks the block
+    // alive and refreshes SamplesPerSecond and the process gauges about once
+    // a second
+    void Heartbeat() {
+        if (!m_writable) return;
+        int64_t nowMs = TreadmillSharedRegion::TickCountMs();
+        Slot(Block(m_component) + BlockHeartbeat).store(nowMs, std::memory_order_relaxed);
+
+        int64_t total = Get(m_component, TreadmillMetric::SamplesTotal);
+        if (m_rateTimeMs == 0) {
+            m_rateTimeMs = nowMs;
+            m_rateTotal = total;
+        } else if (nowMs - m_rateTimeMs >= 1000) {
+            Set(TreadmillMetric::SamplesPerSecond, (total - m_rateTotal) * 1000 / (nowMs - m_rateTimeMs));
+            m_rateTimeMs = nowMs;
+            m_rateTotal = total;
+            SampleProcess();
+        }
+    }
+
+    int64_t Get(TreadmillComponent component, TreadmillMetric metric) const {
+        if (!m_view) return 0;
+        return Value(component, metric).load(std::memory_order_relaxed);
+    }
+
+    uint32_t Pid(TreadmillComponent component) const {
+        return m_view ? Load32(Block(component) + BlockPid) : 0;
+    }
+
+    // Running and heartbeat within StaleAfterMs
+    bool IsAlive(TreadmillComponent component) const {
+        if (!m_view || Pid(component) == 0) return false;
+        int64_t heartbeat = Slot(Block(component) + BlockHeartbeat).load(std::memory_order_relaxed);
+        return TreadmillSharedRegion::TickCountMs() - heartbeat <= StaleAfterMs;
+    }
+
+private:
+#ifdef _WIN32
+    static constexpr const wchar_t* PageName = L"Local\\OmniTreadmillMetrics";
+    HANDLE m_mapping = nullptr;
+#else
+    static constexpr const char* PageName = "/OmniTreadmillMetrics";
+#endif
+    uint8_t* m_view = nullptr;
+    bool m_writable = false;
+    TreadmillComponent m_component = TreadmillComponent::Driver;
+    int64_t m_rateTotal = 0;
+    int64_t m_rateTimeMs = 0;
+
+    bool Map(bool writable) {
+#ifdef _WIN32
+        if (writable) {
+            m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(Size), PageName);
+        } else {
+            m_mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, PageName);
+        }
+        if (!m_mapping) return false;
+        m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, writable ? FILE_MAP_ALL_ACCESS : FILE_MAP_READ, 0, 0, Size));
+#else
+        int fd = writable ? shm_open(PageName, O_CREAT | O_RDWR, 0600) : shm_open(PageName, O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st{};
+        bool sized = fstat(fd, &st) == 0 &&
+            (static_cast<size_t>(st.st_size) >= Size || (writable && ftruncate(fd, Size) == 0));
+        void* view = sized ? mmap(nullptr, Size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        m_view = view == MAP_FAILED ? nullptr : static_cast<uint8_t*>(view);
+#endif
+        if (!m_view) {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    static size_t Block(TreadmillComponent component) {
+        return HeaderSize + static_cast<size_t>(component) * BlockSize;
+    }
+
+    // The page is zero-filled shared memory; std::atomic<int64_t> is a plain
+    // lock-free int64 on every supported platform, so it can live there
+    std::atomic<int64_t>& Slot(size_t offset) const {
+        return *reinterpret_cast<std::atomic<int64_t>*>(m_view + offset);
+    }
+
+    std::atomic<int64_t>& Value(TreadmillComponent component, TreadmillMetric metric) const {
+        return Slot(Block(component) + BlockValues + static_cast<size_t>(metric) * sizeof(int64_t));
+    }
+
+    uint32_t Load32(size_t offset) const {
+        return reinterpret_cast<const std::atomic<uint32_t>*>(m_view + offset)->load(std::memory_order_acquire);
+    }
+
+    void Store32(size_t offset, uint32_t value) {
+        reinterpret_cast<std::atomic<uint32_t>*>(m_view + offset)->store(value, std::memory_order_release);
+    }
+
+    void SampleProcess() {
+#ifdef _WIN32
+        PROCESS_MEMORY_COUNTERS counters{};
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+            Set(TreadmillMetric::ResidentBytes, static_cast<int64_t>(counters.WorkingSetSize));
+        }
+        DWORD handles = 0;
+        if (GetProcessHandleCount(GetCurrentProcess(), &handles)) {
+            Set(TreadmillMetric::HandleCount, static_cast<int64_t>(handles));
+        }
+#else
+        long pages = 0, residentPages = 0;
+        FILE* statm = fopen("/proc/self/statm", "r");
+        if (statm) {
+            if (fscanf(statm, "%ld %ld", &pages, &residentPages) == 2) {
+                Set(TreadmillMetric::ResidentBytes, static_cast<int64_t>(residentPages) * sysconf(_SC_PAGESIZE));
+            }
+            fclose(statm);
+        }
+        DIR* fds = opendir("/proc/self/fd");
+        if (fds) {
+            int64_t count = 0;
+            while (readdir(fds)) count++;
+            closedir(fds);
+            Set(TreadmillMetric::HandleCount, count - 3);  // ".", ".." and the directory itself
+        }
+#endif
+    }
+
+    static uint32_t CurrentPid() {
+#ifdef _WIN32
+        return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+};
@@ -0,0 +1,145 @@
+// ============================================================================
+// TreadmillMetrics - live view of the treadmill metrics page
+// ============================================================================
+// Reads the shared-memory page the driver, OpenVR wrapper and OpenXR layer
+// publish into (TreadmillMetrics.h) and renders it in the console.
+//
+//   TreadmillMetrics.exe [--interval <ms>] [--once] [--prometheus <file>]
+//
+// --prometheus rewrites <file> in Prometheus text format on every refresh,
+// e.g. for the node_exporter textfile collector.
+// ============================================================================
+
+#include "../TreadmillMetrics.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+static std::string FormatPrometheus(const TreadmillMetricsPage& page) {
+    std::string out;
+    char line[256];
+
+    out += "# HELP treadmill_up Component publishing metrics\n# TYPE treadmill_up gauge\n";
+    for (size_t c = 0; c < TreadmillMetricsPage::ComponentCount; c++) {
+        auto component = static_cast<TreadmillComponent>(c);
+        snprintf(line, sizeof(line), "treadmill_up{component=\"%s\"} %d\n",
+            GetTreadmillComponentName(component), page.IsAlive(component) ? 1 : 0);
+        out += line;
+    }
+
+    for (size_t m = 0; m < TreadmillMetricsPage::MetricCount; m++) {
+        auto metric = static_cast<TreadmillMetric>(m);
+        const TreadmillMetricInfo& info = GetTreadmillMetricInfo(metric);
+        snprintf(line, sizeof(line), "# HELP treadmill_%s %s\n# TYPE treadmill_%s %s\n",
+            info.name, info.help, info.name, info.counter ? "counter" : "gauge");
+        out += line;
+
+        for (size_t c = 0; c < TreadmillMetricsPage::ComponentCount; c++) {
+            auto component = static_cast<TreadmillComponent>(c);
+            if (!page.IsAlive(component)) continue;
+            snprintf(line, sizeof(line), "treadmill_%s{component=\"%s\"} %lld\n",
+                info.name, GetTreadmillComponentName(component), static_cast<long long>(page.Get(component, metric)));
+            out += line;
+        }
+    }
+    return out;
+}
+
+// Write next to the target and rename, so scrapers never see half a file
+static bool WriteFileAtomically(const std::string& path, const std::string& text) {
+    std::string temp = path + ".tmp";
+    {
+        std::ofstream file(temp, std::ios::out | std::ios::trunc | std::ios::binary);
+        if (!file.is_open()) return false;
+        file << text;
+        if (!file.good()) return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, path, ec);
+    return !ec;
+}
+
+static void Render(const TreadmillMetricsPage& page) {
+    printf("%-8s %8s %10s %9s %10s %8s %13s %11s %8s %8s\n",
+        "", "pid", "samples", "samples/s", "lag ms", "dropped", "overhead us", "injections", "rss MB", "handles");
+    for (size_t c = 0; c < TreadmillMetricsPage::ComponentCount; c++) {
+        auto component = static_cast<TreadmillComponent>(c);
+        const char* name = GetTreadmillComponentName(component);
+        if (!page.IsAlive(component)) {
+            printf("%-8s %8s\n", name, "-");
+            continue;
+        }
+        printf("%-8s %8u %10lld %9lld %10.1f %8lld %13.1f %11lld %8.1f %8lld\n",
+            name, page.Pid(component),
+            static_cast<long long>(page.Get(component, TreadmillMetric::SamplesTotal)),
+            static_cast<long long>(page.Get(component, TreadmillMetric::SamplesPerSecond)),
+            page.Get(component, TreadmillMetric::FilterLagUs) / 1000.0,
+            static_cast<long long>(page.Get(component, TreadmillMetric::DroppedSamplesTotal)),
+            page.Get(component, TreadmillMetric::FrameOverheadNs) / 1000.0,
+            static_cast<long long>(page.Get(component, TreadmillMetric::InjectionsTotal)),
+            page.Get(component, TreadmillMetric::ResidentBytes) / (1024.0 * 1024.0),
+            static_cast<long long>(page.Get(component, TreadmillMetric::HandleCount)));
+    }
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillMetrics [--interval <ms>] [--once] [--prometheus <file>]\n");
+}
+
+int main(int argc, char** argv) {
+    int intervalMs = 500;
+    bool once = false;
+    std::string prometheusPath;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--interval") == 0 && i + 1 < argc) {
+            intervalMs = std::max(50, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--once") == 0) {
+            once = true;
+        } else if (strcmp(argv[i], "--prometheus") == 0 && i + 1 < argc) {
+            prometheusPath = argv[++i];
+        } else {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+#ifdef _WIN32
+    // Cursor-home escape codes for the live view
+    HANDLE console = GetStdHandle(STD_OUTPUT_HANDLE);
+    DWORD mode = 0;
+    if (GetConsoleMode(console, &mode)) {
+        SetConsoleMode(console, mode | ENABLE_VIRTUAL_TERMINAL_PROCESSING);
+    }
+#endif
+
+    TreadmillMetricsPage page;
+    for (;;) {
+        if (!page.IsOpen() && !page.Open()) {
+            if (once) {
+                fprintf(stderr, "No treadmill component is running (metrics page not found)\n");
+                return 2;
+            }
+        }
+
+        if (!once) printf("\x1b[H\x1b[2J");
+        if (page.IsOpen()) {
+            Render(page);
+            if (!prometheusPath.empty() && !WriteFileAtomically(prometheusPath, FormatPrometheus(page))) {
+                fprintf(stderr, "Cannot write %s\n", prometheusPath.c_str());
+            }
+        } else {
+            printf("Waiting for the driver, wrapper or layer...\n");
+        }
+        fflush(stdout);
+
+        if (once) return 0;
+        std::this_thread::sleep_for(std::chrono::milliseconds(intervalMs));
+    }
+}
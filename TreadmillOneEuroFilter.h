@@ -0,0 +1,101 @@
+#pragma once
+
+// ============================================================================
+// TreadmillOneEuroFilter - speed-adaptive low-pass filter (Casiez et al.)
+// ============================================================================
+// A plain EMA has to trade jitter at rest against lag while moving. The
+// One-Euro filter lowers its cutoff while the signal is steady (minCutoff,
+// removes jitter) and raises it with the signal's speed (beta, removes lag).
+//
+// Driven by sample timestamps, so it behaves the same whether it runs per
+// packet (60-120 Hz) or per frame (90-144 Hz).
+//
+// Stick values are filtered as-is, yaw in radians via FilterAngle(), so one
+// minCutoff/beta pair suits both. Use either Filter() or FilterAngle() on an
+// instance, not both.
+// ============================================================================
+
+#include <cmath>
+#include <cstdint>
+
+class TreadmillOneEuroFilter {
+public:
+    static constexpr float DefaultMinCutoff = 1.0f;   // Hz
+    static constexpr float DefaultBeta = 0.5f;
+    static constexpr float DefaultDerivativeCutoff = 1.0f;  // Hz
+
+    void Configure(float minCutoff, float beta, float derivativeCutoff = DefaultDerivativeCutoff) {
+        m_minCutoff = minCutoff > 0.0f ? minCutoff : DefaultMinCutoff;
+        m_beta = beta >= 0.0f ? beta : 0.0f;
+        m_derivativeCutoff = derivativeCutoff > 0.0f ? derivativeCutoff : DefaultDerivativeCutoff;
+    }
+
+    void Reset() { m_initialized = false; }
+
+    // Cutoff used for the last sample (Hz); 1 / (2 pi cutoff) is the current lag
+    float Cutoff() const { return static_cast<float>(m_cutoff); }
+
+    float Filter(float value, int64_t timeUs) {
+        return static_cast<float>(Step(value, timeUs));
+    }
+
+    // Ring angle in degrees [0, 360). Filtered unwrapped, so 359° -> 1° is a
+    // 2° step and not a 358° jump.
+    float FilterAngle(float degrees, int64_t timeUs) {
+        constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+        if (!m_initialized) {
+            m_unwrapped = degrees * DEG2RAD;
+        } else {
+            double delta = std::fmod(static_cast<double>(degrees) - m_lastAngle + 540.0, 360.0);
+            if (delta < 0.0) delta += 360.0;
+            m_unwrapped += (delta - 180.0) * DEG2RAD;
+        }
+        m_lastAngle = degrees;
+
+        double out = std::fmod(Step(m_unwrapped, timeUs) / DEG2RAD, 360.0);
+        return static_cast<float>(out < 0.0 ? out + 360.0 : out);
+    }
+
+private:
+    float m_minCutoff = DefaultMinCutoff;
+    float m_beta = DefaultBeta;
+    float m_derivativeCutoff = DefaultDerivativeCutoff;
+
+    bool m_initialized = false;
+    int64_t m_lastTimeUs = 0;
+    double m_value = 0.0;       // filtered value
+    double m_derivative = 0.0;  // filtered derivative (units per second)
+    double m_cutoff = DefaultMinCutoff;
+
+    double m_unwrapped = 0.0;   // FilterAngle only
+    float m_lastAngle = 0.0f;
+
+    static double Alpha(double cutoffHz, double dt) {
+        constexpr double TWO_PI = 2.0 * 3.14159265358979323846;
+        double tau = 1.0 / (TWO_PI * cutoffHz);
+        return 1.0 / (1.0 + tau / dt);
+    }
+
+    double Step(double value, int64_t timeUs) {
+        if (!m_initialized) {
+            m_initialized = true;
+            m_lastTimeUs = timeUs;
+            m_value = value;
+            m_derivative = 0.0;
+            m_cutoff = m_minCutoff;
+            return m_value;
+        }
+
+        // Same or older timestamp (duplicate frame, reordered packet): hold
+        double dt = static_cast<double>(timeUs - m_lastTimeUs) * 1e-6;
+        if (dt <= 0.0) return m_value;
+        m_lastTimeUs = timeUs;
+
+        double rawDerivative = (value - m_value) / dt;
+        m_derivative += Alpha(m_derivativeCutoff, dt) * (rawDerivative - m_derivative);
+
+        m_cutoff = m_minCutoff + m_beta * std::fabs(m_derivative);
+        m_value += Alpha(m_cutoff, dt) * (value - m_value);
+        return m_value;
+    }
+};
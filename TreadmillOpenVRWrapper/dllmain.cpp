@@ -107,6 +107,14 @@ static void ShutdownWrapper() {
     
     OmniBridge::Shutdown();
     
+#ifdef TREADMILL_INSTRUMENTATION
+    // Debug builds: keep the last instrumentation events for chrome://tracing
+    std::wstring tracePath = GetModuleDirectory(g_thisModule) + L"\\treadmill_wrapper_trace.json";
+    if (TreadmillInstrument::WriteChromeTrace(tracePath, "TreadmillOpenVRWrapper")) {
+        LogInfo("Trace written to %ls", tracePath.c_str());
+    }
+#endif
+    
     if (g_realOpenVR) {
         FreeLibrary(g_realOpenVR);
         g_realOpenVR = nullptr;
@@ -183,6 +191,7 @@ __declspec(dllexport) void VR_CALLTYPE VR_ShutdownInternal() {
     if (Real_VR_ShutdownInternal) {
         Real_VR_ShutdownInternal();
     }
+    ResetActionTracking();
 }
 
 // VR_GetVRInitErrorAsEnglishDescription
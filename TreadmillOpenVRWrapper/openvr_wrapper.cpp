@@ -3,9 +3,17 @@
 // TreadmillOpenVRWrapper - OpenVR Function Pointers and IVRInput Wrapper Impl
 // ============================================================================
 #include <cstring>
+#include <chrono>
+#include <shared_mutex>
 
 using namespace TreadmillWrapper;
 
+// Our share of a hooked call: from the real function's return to ours
+static void PublishOverhead(std::chrono::steady_clock::time_point start) {
+    g_metrics.Set(TreadmillMetric::FrameOverheadNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
 // ============================================================================
 // REAL FUNCTION POINTERS
 // ============================================================================
@@ -47,10 +55,19 @@ bool LoadOpenVRFunctions(HMODULE realDll) {
 // IVRINPUT WRAPPER
 // ============================================================================
 
-// Store the real IVRInput interface and action name mappings
+// Store the real IVRInput interface and action name mappings. Handles are
+// only valid for one VR session, so the maps are cleared on VR_ShutdownInternal.
 static void* g_realIVRInput = nullptr;
 static std::unordered_map<VRActionHandle_t, std::string> g_actionNames;
 static std::unordered_map<VRActionHandle_t, bool> g_isMovementAction;
+static std::shared_mutex g_actionsMutex;
+
+void ResetActionTracking() {
+    std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+    LogDebug("Forgetting %zu action handles", g_actionNames.size());
+    g_actionNames.clear();
+    g_isMovementAction.clear();
+}
 
 // IVRInput vtable function types
 typedef EVRInputError (*PFN_GetActionHandle)(void* self, const char* pchActionName, VRActionHandle_t* pHandle);
@@ -58,6 +75,7 @@ typedef EVRInputError (*PFN_GetAnalogActionData)(void* self, VRActionHandle_t ac
 
 // Our wrapped functions
 static EVRInputError Wrapped_GetActionHandle(void* self, const char* pchActionName, VRActionHandle_t* pHandle) {
+    TREADMILL_ZONE("IVRInput::GetActionHandle");
     // Get real vtable
     void** vtable = *(void***)g_realIVRInput;
     auto realFunc = (PFN_GetActionHandle)vtable[IVRInputVTable::GetActionHandle];
@@ -65,9 +83,6 @@ static EVRInputError Wrapped_GetActionHandle(void* self, const char* pchActionNa
     EVRInputError result = realFunc(g_realIVRInput, pchActionName, pHandle);
     
     if (result == VRInputError_None && pHandle && pchActionName) {
-        // Store action name for later lookup
-        g_actionNames[*pHandle] = pchActionName;
-        
         // Check if this is a movement action
         bool isMovement = false;
         for (const auto& pattern : g_config.actionPatterns) {
@@ -76,7 +91,13 @@ static EVRInputError Wrapped_GetActionHandle(void* self, const char* pchActionNa
                 break;
             }
         }
-        g_isMovementAction[*pHandle] = isMovement;
+        
+        // Store action name for later lookup
+        {
+            std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+            g_actionNames[*pHandle] = pchActionName;
+            g_isMovementAction[*pHandle] = isMovement;
+        }
         
         if (isMovement) {
             LogDebug("Detected movement action: %s (handle=0x%llX)", pchActionName, *pHandle);
@@ -87,19 +108,26 @@ static EVRInputError Wrapped_GetActionHandle(void* self, const char* pchActionNa
 }
 
 static EVRInputError Wrapped_GetAnalogActionData(void* self, VRActionHandle_t action, InputAnalogActionData_t* pActionData, uint32_t unActionDataSize, VRInputValueHandle_t ulRestrictToDevice) {
+    TREADMILL_ZONE("IVRInput::GetAnalogActionData");
     // Get real vtable
     void** vtable = *(void***)g_realIVRInput;
     auto realFunc = (PFN_GetAnalogActionData)vtable[IVRInputVTable::GetAnalogActionData];
     
     // Call real function first
     EVRInputError result = realFunc(g_realIVRInput, action, pActionData, unActionDataSize, ulRestrictToDevice);
+    auto hookStart = std::chrono::steady_clock::now();
     
     // Inject treadmill data if this is a movement action
     if (result == VRInputError_None && pActionData) {
-        auto it = g_isMovementAction.find(action);
-        bool isMovement = (it != g_isMovementAction.end() && it->second);
+        bool isMovement;
+        {
+            std::shared_lock<std::shared_mutex> lock(g_actionsMutex);
+            auto it = g_isMovementAction.find(action);
+            isMovement = (it != g_isMovementAction.end() && it->second);
+        }
         
         if (isMovement && OmniBridge::IsConnected()) {
+            OmniBridge::SampleFrame();
             float treadmillX = g_treadmillState.x.load();
             float treadmillY = g_treadmillState.y.load();
             bool treadmillActive = (std::abs(treadmillX) > 0.05f || std::abs(treadmillY) > 0.05f);
@@ -129,13 +157,14 @@ static EVRInputError Wrapped_GetAnalogActionData(void* self, VRActionHandle_t ac
                 }
                 break;
             }
+            if (treadmillActive) TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
             
             // Debug log occasionally
-            static uint64_t callCount = 0;
-            if (++callCount % 500 == 0 && treadmillActive) {
+            if (TREADMILL_EVERY_N("IVRInput::GetAnalogActionData movement", 500) && treadmillActive) {
                 LogTrace("Injected treadmill into action 0x%llX: X=%.3f Y=%.3f", 
                     action, pActionData->x, pActionData->y);
             }
+            PublishOverhead(hookStart);
         }
     }
     
@@ -154,10 +183,12 @@ typedef bool (*PFN_GetControllerStateWithPose)(void* self, int eOrigin, TrackedD
 
 // Wrapped GetControllerState - injects treadmill input
 static bool Wrapped_GetControllerState(void* self, TrackedDeviceIndex_t unControllerDeviceIndex, VRControllerState_t* pControllerState, uint32_t unControllerStateSize) {
+    TREADMILL_ZONE("IVRSystem::GetControllerState");
     void** vtable = *(void***)g_realIVRSystem;
     auto realFunc = (PFN_GetControllerState)vtable[IVRSystemVTable::GetControllerState];
     
     bool result = realFunc(g_realIVRSystem, unControllerDeviceIndex, pControllerState, unControllerStateSize);
+    auto hookStart = std::chrono::steady_clock::now();
     
     if (result && pControllerState && OmniBridge::IsConnected()) {
         // Filter by target controller if configured
@@ -168,6 +199,7 @@ static bool Wrapped_GetControllerState(void* self, TrackedDeviceIndex_t unContro
             return result;  // Skip injection for non-target controllers
         }
         
+        OmniBridge::SampleFrame();
         float treadmillX = g_treadmillState.x.load();
         float treadmillY = g_treadmillState.y.load();
         bool treadmillActive = (std::abs(treadmillX) > 0.05f || std::abs(treadmillY) > 0.05f);
@@ -193,23 +225,27 @@ static bool Wrapped_GetControllerState(void* self, TrackedDeviceIndex_t unContro
                 break;
             }
             
+            TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
+            
             // Debug log occasionally
-            static uint64_t callCount = 0;
-            if (++callCount % 500 == 0) {
+            if (TREADMILL_EVERY_N("IVRSystem::GetControllerState injections", 500)) {
                 LogTrace("Injected into GetControllerState (device %u): X=%.3f Y=%.3f", 
                     unControllerDeviceIndex, treadmillX, treadmillY);
             }
         }
+        PublishOverhead(hookStart);
     }
     
     return result;
 }
 
 static bool Wrapped_GetControllerStateWithPose(void* self, int eOrigin, TrackedDeviceIndex_t unControllerDeviceIndex, VRControllerState_t* pControllerState, uint32_t unControllerStateSize, void* pTrackedDevicePose) {
+    TREADMILL_ZONE("IVRSystem::GetControllerStateWithPose");
     void** vtable = *(void***)g_realIVRSystem;
     auto realFunc = (PFN_GetControllerStateWithPose)vtable[IVRSystemVTable::GetControllerStateWithPose];
     
     bool result = realFunc(g_realIVRSystem, eOrigin, unControllerDeviceIndex, pControllerState, unControllerStateSize, pTrackedDevicePose);
+    auto hookStart = std::chrono::steady_clock::now();
     
     if (result && pControllerState && OmniBridge::IsConnected()) {
         // Filter by target controller if configured
@@ -218,6 +254,7 @@ static bool Wrapped_GetControllerStateWithPose(void* self, int eOrigin, TrackedD
             return result;  // Skip injection for non-target controllers
         }
         
+        OmniBridge::SampleFrame();
         float treadmillX = g_treadmillState.x.load();
         float treadmillY = g_treadmillState.y.load();
         bool treadmillActive = (std::abs(treadmillX) > 0.05f || std::abs(treadmillY) > 0.05f);
@@ -243,12 +280,14 @@ static bool Wrapped_GetControllerStateWithPose(void* self, int eOrigin, TrackedD
                 break;
             }
             
-            static uint64_t callCount = 0;
-            if (++callCount % 500 == 0) {
+            TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
+            
+            if (TREADMILL_EVERY_N("IVRSystem::GetControllerStateWithPose injections", 500)) {
                 LogTrace("Injected into GetControllerStateWithPose (device %u): X=%.3f Y=%.3f", 
                     unControllerDeviceIndex, treadmillX, treadmillY);
             }
         }
+        PublishOverhead(hookStart);
     }
     
     return result;
@@ -201,6 +201,9 @@ namespace IVRSystemVTable {
 // Wrap the IVRInput interface to inject treadmill data
 void* WrapIVRInput(void* realInterface);
 
+// Drop the action handles of the ending VR session
+void ResetActionTracking();
+
 // IVRInput virtual function indices (from OpenVR SDK)
 namespace IVRInputVTable {
     enum {
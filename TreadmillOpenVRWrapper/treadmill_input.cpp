@@ -19,35 +19,36 @@ namespace TreadmillWrapper {
 
 TreadmillState g_treadmillState;
 Config g_config;
+TreadmillMetricsPage g_metrics;
 
 HMODULE OmniBridge::s_library = nullptr;
 void* OmniBridge::s_reader = nullptr;
 std::atomic<bool> OmniBridge::s_connected{ false };
+TreadmillSampleHistory OmniBridge::s_history;
+std::atomic<bool> OmniBridge::s_historyOpen{ false };
+std::atomic<uint64_t> OmniBridge::s_lastHistoryAttempt{ 0 };
+std::mutex OmniBridge::s_historyMutex;
 
 // ============================================================================
 // OMNIBRIDGE
 // ============================================================================
 
 void OmniBridge::OnOmniData(float ringAngle, int gamePadX, int gamePadY) {
+    TREADMILL_ZONE("OmniBridge::OnOmniData");
     auto now = std::chrono::steady_clock::now();
     uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()).count();
     
-    // Normalize to [-1, 1]
-    float x = (static_cast<float>(gamePadX) - 127.0f) / 127.0f;
-    float y = -(static_cast<float>(gamePadY) - 127.0f) / 127.0f; // Invert Y
+    // Packet interval for the EMA lag (callback thread only)
+    static int64_t s_lastSampleUs = 0;
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    int64_t intervalUs = s_lastSampleUs != 0 ? nowUs - s_lastSampleUs : 0;
+    s_lastSampleUs = nowUs;
+    TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::SamplesTotal, 1);
     
-    // Apply deadzone
-    x = ApplyDeadzone(x, g_config.deadzone);
-    y = ApplyDeadzone(y, g_config.deadzone);
-    
-    // Apply speed multiplier
-    x *= g_config.speedMultiplier;
-    y *= g_config.speedMultiplier;
-    
-    // Clamp
-    x = std::clamp(x, -1.0f, 1.0f);
-    y = std::clamp(y, -1.0f, 1.0f);
+    // Normalize, deadzone, speed multiplier
+    float x, y;
+    ProcessGamePad(static_cast<float>(gamePadX), static_cast<float>(gamePadY), x, y);
     
     // Update state with smoothing
     float prevX = g_treadmillState.x.load();
@@ -56,15 +57,28 @@ void OmniBridge::OnOmniData(float ringAngle, int gamePadX, int gamePadY) {
     float smoothedX = ApplySmoothing(prevX, x, g_config.smoothing);
     float smoothedY = ApplySmoothing(prevY, y, g_config.smoothing);
     
-    g_treadmillState.x.store(smoothedX);
-    g_treadmillState.y.store(smoothedY);
-    g_treadmillState.yaw.store(ringAngle);
+    // With frame sampling, SampleFrame() owns x/y/yaw
+    if (!s_historyOpen.load()) {
+        if (g_config.filter == Config::Filter::OneEuro) {
+            ApplyOneEuro(x, y, nowUs);
+            smoothedX = x;
+            smoothedY = y;
+        } else if (intervalUs > 0 && g_config.smoothing > 0.0f) {
+            // An EMA lags (1 - smoothing) / smoothing packet intervals
+            g_metrics.Set(TreadmillMetric::FilterLagUs,
+                static_cast<int64_t>(intervalUs * (1.0f - g_config.smoothing) / g_config.smoothing));
+        }
+        g_treadmillState.x.store(smoothedX);
+        g_treadmillState.y.store(smoothedY);
+        g_treadmillState.yaw.store(ringAngle);
+    }
     g_treadmillState.lastUpdateTime.store(timestamp);
     g_treadmillState.updateCount.fetch_add(1);
     g_treadmillState.active.store(true);
+    g_metrics.Heartbeat();
     
     // Trace log occasionally (debug only)
-    if (g_treadmillState.updateCount.load() % 100 == 0) {
+    if (TREADMILL_EVERY_N("OmniBridge::OnOmniData calls", 100)) {
         LogTrace("Treadmill: X=%.3f Y=%.3f Yaw=%.1f", 
             g_treadmillState.x.load(), g_treadmillState.y.load(), ringAngle);
     }
@@ -116,9 +130,17 @@ bool OmniBridge::Initialize(const std::wstring& dllPath, const std::string& comP
         return false;
     }
     
+    if (!g_metrics.Create(TreadmillComponent::Wrapper)) {
+        LogDebug("Metrics page not available");
+    }
+    
     pfnRegister(s_reader, (void*)OnOmniData);
     s_connected.store(true);
     
+    if (g_config.frameSampling) {
+        TryOpenHistory();
+    }
+    
     LogInfo("Treadmill connected successfully!");
     return true;
 }
@@ -126,6 +148,12 @@ bool OmniBridge::Initialize(const std::wstring& dllPath, const std::string& comP
 void OmniBridge::Shutdown() {
     s_connected.store(false);
     
+    {
+        std::lock_guard<std::mutex> lock(s_historyMutex);
+        s_historyOpen.store(false);
+        s_history.Close();
+    }
+    
     if (s_reader && s_library) {
         auto pfnDisconnect = (PFN_Disconnect)GetProcAddress(s_library, "OmniReader_Disconnect");
         auto pfnDestroy = (PFN_Destroy)GetProcAddress(s_library, "OmniReader_Destroy");
@@ -140,6 +168,7 @@ void OmniBridge::Shutdown() {
     
     s_reader = nullptr;
     s_library = nullptr;
+    g_metrics.Close();
     
     LogInfo("OmniBridge shut down");
 }
@@ -148,6 +177,66 @@ bool OmniBridge::IsConnected() {
     return s_connected.load();
 }
 
+bool OmniBridge::TryOpenHistory() {
+    std::lock_guard<std::mutex> lock(s_historyMutex);
+    if (s_historyOpen.load()) return true;
+    
+    if (!s_history.Open()) {
+        LogDebug("Sample history not available yet - using callback data");
+        return false;
+    }
+    
+    s_historyOpen.store(true);
+    LogInfo("Sample history attached - sampling treadmill at frame time");
+    return true;
+}
+
+void OmniBridge::SampleFrame() {
+    TREADMILL_ZONE("OmniBridge::SampleFrame");
+    if (!g_config.frameSampling || !s_connected.load()) return;
+    
+    if (!s_historyOpen.load()) {
+        // The master may start (or fail over) after us - retry about once a second
+        uint64_t nowMs = static_cast<uint64_t>(TreadmillSampleHistory::NowUs() / 1000);
+        uint64_t last = s_lastHistoryAttempt.load();
+        if (nowMs - last < 1000 || !s_lastHistoryAttempt.compare_exchange_strong(last, nowMs)) return;
+        if (!TryOpenHistory()) return;
+    }
+    
+    // Shutdown() closes the history under the same lock; it also serializes
+    // the render threads that call us, so the frame interval below is theirs
+    std::lock_guard<std::mutex> lock(s_historyMutex);
+    if (!s_historyOpen.load()) return;
+    
+    TreadmillSample sample;
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    int64_t lookaheadUs = static_cast<int64_t>(g_config.frameSamplingLookaheadMs * 1000.0f);
+    if (!s_history.SampleAt(nowUs, sample, g_config.frameSamplingInterpolation, lookaheadUs)) return;
+    
+    static int64_t s_lastFrameUs = 0;
+    int64_t intervalUs = s_lastFrameUs != 0 ? nowUs - s_lastFrameUs : 0;
+    s_lastFrameUs = nowUs;
+    
+    // One-Euro is time based and runs just as well at frame rate; the EMA is
+    // rescaled to the frame interval so "smoothing" means the same as per packet
+    float x, y;
+    ProcessGamePad(sample.gamePadX, sample.gamePadY, x, y);
+    if (g_config.filter == Config::Filter::OneEuro) {
+        ApplyOneEuro(x, y, sample.timeUs);
+    } else if (intervalUs > 0 && g_config.smoothing > 0.0f) {
+        float factor = SmoothingForInterval(g_config.smoothing, intervalUs);
+        x = ApplySmoothing(g_treadmillState.x.load(), x, factor);
+        y = ApplySmoothing(g_treadmillState.y.load(), y, factor);
+        g_metrics.Set(TreadmillMetric::FilterLagUs,
+            static_cast<int64_t>(intervalUs * (1.0f - factor) / factor));
+    } else {
+        g_metrics.Set(TreadmillMetric::FilterLagUs, 0);
+    }
+    g_treadmillState.x.store(x);
+    g_treadmillState.y.store(y);
+    g_treadmillState.yaw.store(sample.yaw);
+}
+
 // ============================================================================
 // CONFIGURATION
 // ============================================================================
@@ -190,6 +279,14 @@ Config Config::Load(const std::wstring& jsonPath) {
             else if (key == "speedMultiplier") config.speedMultiplier = std::stof(value);
             else if (key == "deadzone") config.deadzone = std::stof(value);
             else if (key == "smoothing") config.smoothing = std::stof(value);
+            else if (key == "frameSampling") config.frameSampling = (value == "true");
+            else if (key == "frameSamplingInterpolation") {
+                config.frameSamplingInterpolation = (value == "linear") ? TreadmillInterpolation::Linear : TreadmillInterpolation::Hermite;
+            }
+            else if (key == "frameSamplingLookaheadMs") config.frameSamplingLookaheadMs = std::clamp(std::stof(value), 0.0f, 100.0f);
+            else if (key == "filter") config.filter = (value == "oneeuro") ? Filter::OneEuro : Filter::Ema;
+            else if (key == "oneEuroMinCutoff") config.oneEuroMinCutoff = std::stof(value);
+            else if (key == "oneEuroBeta") config.oneEuroBeta = std::stof(value);
             else if (key == "targetControllerIndex") config.targetControllerIndex = std::stoi(value);
             else if (key == "inputMode") {
                 if (value == "override") config.inputMode = InputMode::Override;
@@ -219,6 +316,43 @@ float ApplySmoothing(float current, float target, float factor) {
     return current + (target - current) * factor;
 }
 
+// factor is tuned per packet (~60 Hz); scale it so the EMA decays at the same
+// rate in time when it runs at a different interval
+float SmoothingForInterval(float factor, int64_t intervalUs) {
+    constexpr double ReferenceIntervalUs = 1e6 / 60.0;
+    if (intervalUs <= 0 || factor <= 0.0f || factor >= 1.0f) return factor;
+    return static_cast<float>(1.0 - std::pow(1.0 - factor, intervalUs / ReferenceIntervalUs));
+}
+
+// One filter pair per process; the callback and SampleFrame() may run on
+// different threads, but only one of them feeds the filters at a time
+static TreadmillOneEuroFilter s_filterX;
+static TreadmillOneEuroFilter s_filterY;
+static std::mutex s_filterMutex;
+
+void ApplyOneEuro(float& x, float& y, int64_t timeUs) {
+    std::lock_guard<std::mutex> lock(s_filterMutex);
+    s_filterX.Configure(g_config.oneEuroMinCutoff, g_config.oneEuroBeta);
+    s_filterY.Configure(g_config.oneEuroMinCutoff, g_config.oneEuroBeta);
+    x = s_filterX.Filter(x, timeUs);
+    y = s_filterY.Filter(y, timeUs);
+    
+    constexpr double TWO_PI = 2.0 * 3.14159265358979323846;
+    g_metrics.Set(TreadmillMetric::FilterLagUs, static_cast<int64_t>(1e6 / (TWO_PI * s_filterX.Cutoff())));
+}
+
+void ProcessGamePad(float gamePadX, float gamePadY, float& x, float& y) {
+    // Normalize to [-1, 1], Y inverted
+    x = (gamePadX - 127.0f) / 127.0f;
+    y = -(gamePadY - 127.0f) / 127.0f;
+    
+    x = ApplyDeadzone(x, g_config.deadzone);
+    y = ApplyDeadzone(y, g_config.deadzone);
+    
+    x = std::clamp(x * g_config.speedMultiplier, -1.0f, 1.0f);
+    y = std::clamp(y * g_config.speedMultiplier, -1.0f, 1.0f);
+}
+
 bool MatchesPattern(const std::string& text, const std::string& pattern) {
     // Simple wildcard matching (* at start/end)
     std::string lowerText = text;
@@ -78,6 +78,13 @@ static void InitializeLayer() {
 static void ShutdownLayer() {
     Log("Shutting down layer...");
     OmniBridge::Shutdown();
+#ifdef TREADMILL_INSTRUMENTATION
+    // Debug builds: keep the last instrumentation events for chrome://tracing
+    std::wstring tracePath = GetModuleDirectory(g_thisModule) + L"\\treadmill_layer_trace.json";
+    if (TreadmillInstrument::WriteChromeTrace(tracePath, "TreadmillOpenXRLayer")) {
+        Log("Trace written to %ls", tracePath.c_str());
+    }
+#endif
     ShutdownLogging();
     g_initialized = false;
 }
@@ -237,6 +244,16 @@ XrResult XRAPI_CALL TreadmillLayer_xrGetInstanceProcAddr(
         return XR_SUCCESS;
     }
     
+    if (strcmp(name, "xrDestroyAction") == 0) {
+        *function = (PFN_xrVoidFunction)TreadmillLayer_xrDestroyAction;
+        return XR_SUCCESS;
+    }
+    
+    if (strcmp(name, "xrDestroyActionSet") == 0) {
+        *function = (PFN_xrVoidFunction)TreadmillLayer_xrDestroyActionSet;
+        return XR_SUCCESS;
+    }
+    
     if (strcmp(name, "xrDestroyInstance") == 0) {
         *function = (PFN_xrVoidFunction)TreadmillLayer_xrDestroyInstance;
         return XR_SUCCESS;
@@ -3,9 +3,17 @@
 // TreadmillOpenXRLayer - OpenXR Function Interception Implementation
 // ============================================================================
 #include <cstring>
+#include <chrono>
+#include <shared_mutex>
 
 using namespace TreadmillLayer;
 
+// Our share of an intercepted call, excluding the next layer / runtime
+static void PublishOverhead(std::chrono::steady_clock::time_point start) {
+    g_metrics.Set(TreadmillMetric::FrameOverheadNs, std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count());
+}
+
 // ============================================================================
 // DISPATCH TABLE
 // ============================================================================
@@ -19,6 +27,8 @@ typedef XrResult (XRAPI_CALL *PFN_xrGetActionStateVector2f)(XrSession, const XrA
 typedef XrResult (XRAPI_CALL *PFN_xrSyncActions)(XrSession, const XrActionsSyncInfo*);
 typedef XrResult (XRAPI_CALL *PFN_xrCreateActionSet)(XrInstance, const XrActionSetCreateInfo*, XrActionSet*);
 typedef XrResult (XRAPI_CALL *PFN_xrCreateAction)(XrActionSet, const XrActionCreateInfo*, XrAction*);
+typedef XrResult (XRAPI_CALL *PFN_xrDestroyAction)(XrAction);
+typedef XrResult (XRAPI_CALL *PFN_xrDestroyActionSet)(XrActionSet);
 
 static PFN_xrDestroyInstance Real_xrDestroyInstance = nullptr;
 static PFN_xrGetActionStateFloat Real_xrGetActionStateFloat = nullptr;
@@ -26,10 +36,33 @@ static PFN_xrGetActionStateVector2f Real_xrGetActionStateVector2f = nullptr;
 static PFN_xrSyncActions Real_xrSyncActions = nullptr;
 static PFN_xrCreateActionSet Real_xrCreateActionSet = nullptr;
 static PFN_xrCreateAction Real_xrCreateAction = nullptr;
+static PFN_xrDestroyAction Real_xrDestroyAction = nullptr;
+static PFN_xrDestroyActionSet Real_xrDestroyActionSet = nullptr;
 
-// Action tracking
+// Action tracking - entries leave with their action, action set or instance,
+// so games that rebuild their actions per session don't grow these maps
 static std::unordered_map<XrAction, std::string> g_actionNames;
 static std::unordered_map<XrAction, bool> g_isMovementAction;
+static std::unordered_map<XrAction, XrActionSet> g_actionSetOf;
+static std::shared_mutex g_actionsMutex;
+
+// Returns whether action is a movement action; fills name if given and known
+static bool LookupMovementAction(XrAction action, std::string* name) {
+    std::shared_lock<std::shared_mutex> lock(g_actionsMutex);
+    auto it = g_isMovementAction.find(action);
+    if (it == g_isMovementAction.end() || !it->second) return false;
+    if (name) {
+        auto nameIt = g_actionNames.find(action);
+        if (nameIt != g_actionNames.end()) *name = nameIt->second;
+    }
+    return true;
+}
+
+static void ForgetAction(XrAction action) {
+    g_actionNames.erase(action);
+    g_isMovementAction.erase(action);
+    g_actionSetOf.erase(action);
+}
 
 void InitializeDispatchTable(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr) {
     g_nextGetInstanceProcAddr = getInstanceProcAddr;
@@ -56,6 +89,12 @@ void InitializeDispatchTable(XrInstance instance, PFN_xrGetInstanceProcAddr getI
     if (XR_SUCCEEDED(getInstanceProcAddr(instance, "xrCreateAction", &func))) {
         Real_xrCreateAction = (PFN_xrCreateAction)func;
     }
+    if (XR_SUCCEEDED(getInstanceProcAddr(instance, "xrDestroyAction", &func))) {
+        Real_xrDestroyAction = (PFN_xrDestroyAction)func;
+    }
+    if (XR_SUCCEEDED(getInstanceProcAddr(instance, "xrDestroyActionSet", &func))) {
+        Real_xrDestroyActionSet = (PFN_xrDestroyActionSet)func;
+    }
     
     Log("Dispatch table initialized");
 }
@@ -65,11 +104,16 @@ void InitializeDispatchTable(XrInstance instance, PFN_xrGetInstanceProcAddr getI
 // ============================================================================
 
 XrResult XRAPI_CALL TreadmillLayer_xrDestroyInstance(XrInstance instance) {
+    TREADMILL_ZONE("xrDestroyInstance");
     Log("xrDestroyInstance called");
     
     // Clear action tracking
-    g_actionNames.clear();
-    g_isMovementAction.clear();
+    {
+        std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+        g_actionNames.clear();
+        g_isMovementAction.clear();
+        g_actionSetOf.clear();
+    }
     
     if (Real_xrDestroyInstance) {
         return Real_xrDestroyInstance(instance);
@@ -78,6 +122,7 @@ XrResult XRAPI_CALL TreadmillLayer_xrDestroyInstance(XrInstance instance) {
 }
 
 XrResult XRAPI_CALL TreadmillLayer_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet) {
+    TREADMILL_ZONE("xrCreateActionSet");
     if (!Real_xrCreateActionSet) {
         return XR_ERROR_FUNCTION_UNSUPPORTED;
     }
@@ -92,6 +137,7 @@ XrResult XRAPI_CALL TreadmillLayer_xrCreateActionSet(XrInstance instance, const
 }
 
 XrResult XRAPI_CALL TreadmillLayer_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action) {
+    TREADMILL_ZONE("xrCreateAction");
     if (!Real_xrCreateAction) {
         return XR_ERROR_FUNCTION_UNSUPPORTED;
     }
@@ -100,7 +146,6 @@ XrResult XRAPI_CALL TreadmillLayer_xrCreateAction(XrActionSet actionSet, const X
     
     if (XR_SUCCEEDED(result) && createInfo && action) {
         std::string actionName = createInfo->actionName;
-        g_actionNames[*action] = actionName;
         
         // Check if this is a movement action
         bool isMovement = false;
@@ -110,7 +155,12 @@ XrResult XRAPI_CALL TreadmillLayer_xrCreateAction(XrActionSet actionSet, const X
                 break;
             }
         }
-        g_isMovementAction[*action] = isMovement;
+        {
+            std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+            g_actionNames[*action] = actionName;
+            g_isMovementAction[*action] = isMovement;
+            g_actionSetOf[*action] = actionSet;
+        }
         
         if (isMovement) {
             Log("Movement action created: %s (type=%d)", actionName.c_str(), createInfo->actionType);
@@ -120,33 +170,70 @@ XrResult XRAPI_CALL TreadmillLayer_xrCreateAction(XrActionSet actionSet, const X
     return result;
 }
 
+XrResult XRAPI_CALL TreadmillLayer_xrDestroyAction(XrAction action) {
+    TREADMILL_ZONE("xrDestroyAction");
+    if (!Real_xrDestroyAction) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+        ForgetAction(action);
+    }
+    return Real_xrDestroyAction(action);
+}
+
+// Destroying an action set destroys its actions too
+XrResult XRAPI_CALL TreadmillLayer_xrDestroyActionSet(XrActionSet actionSet) {
+    TREADMILL_ZONE("xrDestroyActionSet");
+    if (!Real_xrDestroyActionSet) {
+        return XR_ERROR_FUNCTION_UNSUPPORTED;
+    }
+    {
+        std::unique_lock<std::shared_mutex> lock(g_actionsMutex);
+        for (auto it = g_actionSetOf.begin(); it != g_actionSetOf.end();) {
+            XrAction action = it->first;
+            bool inSet = it->second == actionSet;
+            ++it;
+            if (inSet) ForgetAction(action);
+        }
+    }
+    return Real_xrDestroyActionSet(actionSet);
+}
+
 XrResult XRAPI_CALL TreadmillLayer_xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo) {
+    TREADMILL_ZONE("xrSyncActions");
     if (!Real_xrSyncActions) {
         return XR_ERROR_FUNCTION_UNSUPPORTED;
     }
     
+    // Action states are latched here once per frame - sample the treadmill now
+    TREADMILL_FRAME_MARK("xrSyncActions");
+    auto hookStart = std::chrono::steady_clock::now();
+    OmniBridge::SampleFrame();
+    PublishOverhead(hookStart);
+    
     return Real_xrSyncActions(session, syncInfo);
 }
 
 XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state) {
+    TREADMILL_ZONE("xrGetActionStateFloat");
     if (!Real_xrGetActionStateFloat || !getInfo || !state) {
         return XR_ERROR_VALIDATION_FAILURE;
     }
     
     XrResult result = Real_xrGetActionStateFloat(session, getInfo, state);
+    auto hookStart = std::chrono::steady_clock::now();
     
     // Check if this is a movement action and inject treadmill data
     if (XR_SUCCEEDED(result) && OmniBridge::IsConnected()) {
-        auto it = g_isMovementAction.find(getInfo->action);
-        bool isMovement = (it != g_isMovementAction.end() && it->second);
+        std::string name;
+        bool isMovement = LookupMovementAction(getInfo->action, &name);
         
         if (isMovement) {
             float treadmillValue = 0.0f;
             
             // Determine which axis based on action name
-            auto nameIt = g_actionNames.find(getInfo->action);
-            if (nameIt != g_actionNames.end()) {
-                std::string name = nameIt->second;
+            if (!name.empty()) {
                 if (name.find("forward") != std::string::npos || 
                     name.find("vertical") != std::string::npos ||
                     name.find("y") != std::string::npos) {
@@ -176,7 +263,9 @@ XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateFloat(XrSession session, cons
                     state->isActive = true;
                     break;
                 }
+                TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
             }
+            PublishOverhead(hookStart);
         }
     }
     
@@ -184,16 +273,17 @@ XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateFloat(XrSession session, cons
 }
 
 XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* state) {
+    TREADMILL_ZONE("xrGetActionStateVector2f");
     if (!Real_xrGetActionStateVector2f || !getInfo || !state) {
         return XR_ERROR_VALIDATION_FAILURE;
     }
     
     XrResult result = Real_xrGetActionStateVector2f(session, getInfo, state);
+    auto hookStart = std::chrono::steady_clock::now();
     
     // Check if this is a movement action and inject treadmill data
     if (XR_SUCCEEDED(result) && OmniBridge::IsConnected()) {
-        auto it = g_isMovementAction.find(getInfo->action);
-        bool isMovement = (it != g_isMovementAction.end() && it->second);
+        bool isMovement = LookupMovementAction(getInfo->action, nullptr);
         
         if (isMovement) {
             float treadmillX = g_treadmillState.x.load();
@@ -224,12 +314,14 @@ XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateVector2f(XrSession session, c
                     break;
                 }
                 
+                if (treadmillActive) TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
+                
                 // Debug log occasionally
-                static uint64_t callCount = 0;
-                if (++callCount % 500 == 0 && treadmillActive) {
+                if (TREADMILL_EVERY_N("xrGetActionStateVector2f movement", 500) && treadmillActive) {
                     Log("Injected Vector2f: X=%.3f Y=%.3f", state->x, state->y);
                 }
             }
+            PublishOverhead(hookStart);
         }
     }
     
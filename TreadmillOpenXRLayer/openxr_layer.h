@@ -211,6 +211,8 @@ XrResult XRAPI_CALL TreadmillLayer_xrGetActionStateVector2f(XrSession session, c
 XrResult XRAPI_CALL TreadmillLayer_xrSyncActions(XrSession session, const XrActionsSyncInfo* syncInfo);
 XrResult XRAPI_CALL TreadmillLayer_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo* createInfo, XrActionSet* actionSet);
 XrResult XRAPI_CALL TreadmillLayer_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo* createInfo, XrAction* action);
+XrResult XRAPI_CALL TreadmillLayer_xrDestroyAction(XrAction action);
+XrResult XRAPI_CALL TreadmillLayer_xrDestroyActionSet(XrActionSet actionSet);
 
 // Initialize dispatch table
 void InitializeDispatchTable(XrInstance instance, PFN_xrGetInstanceProcAddr getInstanceProcAddr);
@@ -15,10 +15,15 @@ namespace TreadmillLayer {
 
 TreadmillState g_treadmillState;
 Config g_config;
+TreadmillMetricsPage g_metrics;
 
 HMODULE OmniBridge::s_library = nullptr;
 void* OmniBridge::s_reader = nullptr;
 std::atomic<bool> OmniBridge::s_connected{ false };
+TreadmillSampleHistory OmniBridge::s_history;
+std::atomic<bool> OmniBridge::s_historyOpen{ false };
+std::atomic<uint64_t> OmniBridge::s_lastHistoryAttempt{ 0 };
+std::mutex OmniBridge::s_historyMutex;
 
 static std::ofstream g_logFile;
 static std::mutex g_logMutex;
@@ -79,33 +84,48 @@ void Log(const char* format, ...) {
 // ============================================================================
 
 void OmniBridge::OnOmniData(float ringAngle, int gamePadX, int gamePadY) {
+    TREADMILL_ZONE("OmniBridge::OnOmniData");
     auto now = std::chrono::steady_clock::now();
     uint64_t timestamp = std::chrono::duration_cast<std::chrono::milliseconds>(
         now.time_since_epoch()).count();
     
-    float x = (static_cast<float>(gamePadX) - 127.0f) / 127.0f;
-    float y = -(static_cast<float>(gamePadY) - 127.0f) / 127.0f;
+    // Packet interval for the EMA lag (callback thread only)
+    static int64_t s_lastSampleUs = 0;
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    int64_t intervalUs = s_lastSampleUs != 0 ? nowUs - s_lastSampleUs : 0;
+    s_lastSampleUs = nowUs;
+    TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::SamplesTotal, 1);
     
-    x = ApplyDeadzone(x, g_config.deadzone);
-    y = ApplyDeadzone(y, g_config.deadzone);
-    
-    x *= g_config.speedMultiplier;
-    y *= g_config.speedMultiplier;
-    
-    x = std::clamp(x, -1.0f, 1.0f);
-    y = std::clamp(y, -1.0f, 1.0f);
+    float x, y;
+    ProcessGamePad(static_cast<float>(gamePadX), static_cast<float>(gamePadY), x, y);
     
     float prevX = g_treadmillState.x.load();
     float prevY = g_treadmillState.y.load();
     
-    g_treadmillState.x.store(ApplySmoothing(prevX, x, g_config.smoothing));
-    g_treadmillState.y.store(ApplySmoothing(prevY, y, g_config.smoothing));
-    g_treadmillState.yaw.store(ringAngle);
+    // With frame sampling, SampleFrame() owns x/y/yaw
+    if (!s_historyOpen.load()) {
+        if (g_config.filter == Config::Filter::OneEuro) {
+            ApplyOneEuro(x, y, nowUs);
+        } else {
+            x = ApplySmoothing(prevX, x, g_config.smoothing);
+            y = ApplySmoothing(prevY, y, g_config.smoothing);
+            
+            // An EMA lags (1 - smoothing) / smoothing packet intervals
+            if (intervalUs > 0 && g_config.smoothing > 0.0f) {
+                g_metrics.Set(TreadmillMetric::FilterLagUs,
+                    static_cast<int64_t>(intervalUs * (1.0f - g_config.smoothing) / g_config.smoothing));
+            }
+        }
+        g_treadmillState.x.store(x);
+        g_treadmillState.y.store(y);
+        g_treadmillState.yaw.store(ringAngle);
+    }
     g_treadmillState.lastUpdateTime.store(timestamp);
     g_treadmillState.updateCount.fetch_add(1);
     g_treadmillState.active.store(true);
+    g_metrics.Heartbeat();
     
-    if (g_treadmillState.updateCount.load() % 100 == 0) {
+    if (TREADMILL_EVERY_N("OmniBridge::OnOmniData calls", 100)) {
         Log("Treadmill: X=%.3f Y=%.3f Yaw=%.1f", 
             g_treadmillState.x.load(), g_treadmillState.y.load(), ringAngle);
     }
@@ -155,14 +175,28 @@ bool OmniBridge::Initialize(const std::wstring& dllPath, const std::string& comP
         return false;
     }
     
+    if (!g_metrics.Create(TreadmillComponent::Layer)) {
+        Log("Metrics page not available");
+    }
+    
     pfnRegister(s_reader, (void*)OnOmniData);
     s_connected.store(true);
     
+    if (g_config.frameSampling) {
+        TryOpenHistory();
+    }
+    
     Log("Treadmill connected successfully!");
     return true;
 }
 
 void OmniBridge::Shutdown() {
+    {
+        std::lock_guard<std::mutex> lock(s_historyMutex);
+        s_historyOpen.store(false);
+        s_history.Close();
+    }
+    
     if (s_reader && s_library) {
         auto pfnDisconnect = (PFN_Disconnect)GetProcAddress(s_library, "OmniReader_Disconnect");
         auto pfnDestroy = (PFN_Destroy)GetProcAddress(s_library, "OmniReader_Destroy");
@@ -177,6 +211,7 @@ void OmniBridge::Shutdown() {
     
     s_reader = nullptr;
     s_library = nullptr;
+    g_metrics.Close();
     s_connected.store(false);
     
     Log("OmniBridge shut down");
@@ -186,6 +221,50 @@ bool OmniBridge::IsConnected() {
     return s_connected.load();
 }
 
+bool OmniBridge::TryOpenHistory() {
+    std::lock_guard<std::mutex> lock(s_historyMutex);
+    if (s_historyOpen.load()) return true;
+    
+    if (!s_history.Open()) {
+        Log("Sample history not available yet - using callback data");
+        return false;
+    }
+    
+    s_historyOpen.store(true);
+    Log("Sample history attached - sampling treadmill at frame time");
+    return true;
+}
+
+void OmniBridge::SampleFrame() {
+    TREADMILL_ZONE("OmniBridge::SampleFrame");
+    if (!g_config.frameSampling || !s_connected.load()) return;
+    
+    if (!s_historyOpen.load()) {
+        // The master may start (or fail over) after us - retry about once a second
+        uint64_t nowMs = static_cast<uint64_t>(TreadmillSampleHistory::NowUs() / 1000);
+        uint64_t last = s_lastHistoryAttempt.load();
+        if (nowMs - last < 1000 || !s_lastHistoryAttempt.compare_exchange_strong(last, nowMs)) return;
+        if (!TryOpenHistory()) return;
+    }
+    
+    TreadmillSample sample;
+    int64_t lookaheadUs = static_cast<int64_t>(g_config.frameSamplingLookaheadMs * 1000.0f);
+    if (!s_history.SampleAt(TreadmillSampleHistory::NowUs(), sample, g_config.frameSamplingInterpolation, lookaheadUs)) return;
+    
+    // Interpolation replaces the per-packet EMA here; One-Euro is time based
+    // and runs just as well at frame rate
+    float x, y;
+    ProcessGamePad(sample.gamePadX, sample.gamePadY, x, y);
+    if (g_config.filter == Config::Filter::OneEuro) {
+        ApplyOneEuro(x, y, sample.timeUs);
+    } else {
+        g_metrics.Set(TreadmillMetric::FilterLagUs, 0);
+    }
+    g_treadmillState.x.store(x);
+    g_treadmillState.y.store(y);
+    g_treadmillState.yaw.store(sample.yaw);
+}
+
 // ============================================================================
 // CONFIGURATION
 // ============================================================================
@@ -224,6 +303,14 @@ Config Config::Load(const std::wstring& jsonPath) {
             else if (key == "speedMultiplier") config.speedMultiplier = std::stof(value);
             else if (key == "deadzone") config.deadzone = std::stof(value);
             else if (key == "smoothing") config.smoothing = std::stof(value);
+            else if (key == "frameSampling") config.frameSampling = (value == "true");
+            else if (key == "frameSamplingInterpolation") {
+                config.frameSamplingInterpolation = (value == "linear") ? TreadmillInterpolation::Linear : TreadmillInterpolation::Hermite;
+            }
+            else if (key == "frameSamplingLookaheadMs") config.frameSamplingLookaheadMs = std::clamp(std::stof(value), 0.0f, 100.0f);
+            else if (key == "filter") config.filter = (value == "oneeuro") ? Filter::OneEuro : Filter::Ema;
+            else if (key == "oneEuroMinCutoff") config.oneEuroMinCutoff = std::stof(value);
+            else if (key == "oneEuroBeta") config.oneEuroBeta = std::stof(value);
             else if (key == "inputMode") {
                 if (value == "override") config.inputMode = InputMode::Override;
                 else if (value == "additive") config.inputMode = InputMode::Additive;
@@ -252,6 +339,35 @@ float ApplySmoothing(float current, float target, float factor) {
     return current + (target - current) * factor;
 }
 
+// One filter pair per process; the callback and SampleFrame() may run on
+// different threads, but only one of them feeds the filters at a time
+static TreadmillOneEuroFilter s_filterX;
+static TreadmillOneEuroFilter s_filterY;
+static std::mutex s_filterMutex;
+
+void ApplyOneEuro(float& x, float& y, int64_t timeUs) {
+    std::lock_guard<std::mutex> lock(s_filterMutex);
+    s_filterX.Configure(g_config.oneEuroMinCutoff, g_config.oneEuroBeta);
+    s_filterY.Configure(g_config.oneEuroMinCutoff, g_config.oneEuroBeta);
+    x = s_filterX.Filter(x, timeUs);
+    y = s_filterY.Filter(y, timeUs);
+    
+    constexpr double TWO_PI = 2.0 * 3.14159265358979323846;
+    g_metrics.Set(TreadmillMetric::FilterLagUs, static_cast<int64_t>(1e6 / (TWO_PI * s_filterX.Cutoff())));
+}
+
+void ProcessGamePad(float gamePadX, float gamePadY, float& x, float& y) {
+    // Normalize to [-1, 1], Y inverted
+    x = (gamePadX - 127.0f) / 127.0f;
+    y = -(gamePadY - 127.0f) / 127.0f;
+    
+    x = ApplyDeadzone(x, g_config.deadzone);
+    y = ApplyDeadzone(y, g_config.deadzone);
+    
+    x = std::clamp(x * g_config.speedMultiplier, -1.0f, 1.0f);
+    y = std::clamp(y * g_config.speedMultiplier, -1.0f, 1.0f);
+}
+
 bool MatchesPattern(const std::string& text, const std::string& pattern) {
     std::string lowerText = text;
     std::string lowerPattern = pattern;
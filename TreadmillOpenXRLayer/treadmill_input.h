@@ -4,6 +4,10 @@
 #pragma once
 
 #include "framework.h"
+#include "../TreadmillSampleHistory.h"
+#include "../TreadmillOneEuroFilter.h"
+#include "../TreadmillMetrics.h"
+#include "../TreadmillInstrument.h"
 
 namespace TreadmillLayer {
 
@@ -35,6 +39,10 @@ public:
     static void Shutdown();
     static bool IsConnected();
     
+    // Re-sample g_treadmillState at the current time from OmniBridge's sample history.
+    // Idempotent, so it may be called on every input query of a frame.
+    static void SampleFrame();
+    
 private:
     typedef void* (*PFN_Create)();
     typedef bool (*PFN_Initialize)(void*, const char*, int, int);
@@ -46,6 +54,12 @@ private:
     static void* s_reader;
     static std::atomic<bool> s_connected;
     
+    static TreadmillSampleHistory s_history;
+    static std::atomic<bool> s_historyOpen;
+    static std::atomic<uint64_t> s_lastHistoryAttempt;
+    static std::mutex s_historyMutex;
+    static bool TryOpenHistory();
+    
     static void OnOmniData(float ringAngle, int gamePadX, int gamePadY);
 };
 
@@ -61,6 +75,20 @@ struct Config {
     float deadzone = 0.1f;
     float smoothing = 0.3f;
     
+    // "ema" uses smoothing above, "oneeuro" adapts the cutoff to stick speed
+    enum class Filter {
+        Ema,
+        OneEuro
+    };
+    Filter filter = Filter::Ema;
+    float oneEuroMinCutoff = TreadmillOneEuroFilter::DefaultMinCutoff;
+    float oneEuroBeta = TreadmillOneEuroFilter::DefaultBeta;
+    
+    // Sample the treadmill at frame time (interpolated) instead of packet arrival time
+    bool frameSampling = true;
+    TreadmillInterpolation frameSamplingInterpolation = TreadmillInterpolation::Hermite;
+    float frameSamplingLookaheadMs = TreadmillSampleHistory::DefaultMaxExtrapolationUs / 1000.0f;  // max extrapolation
+    
     enum class InputMode {
         Override,
         Additive,
@@ -85,6 +113,9 @@ struct Config {
 
 extern Config g_config;
 
+// Live counters for external tools (TreadmillMetrics.h), created in OmniBridge::Initialize
+extern TreadmillMetricsPage g_metrics;
+
 // ============================================================================
 // LOGGING
 // ============================================================================
@@ -99,6 +130,8 @@ void ShutdownLogging();
 
 float ApplyDeadzone(float value, float deadzone);
 float ApplySmoothing(float current, float target, float factor);
+void ApplyOneEuro(float& x, float& y, int64_t timeUs);
+void ProcessGamePad(float gamePadX, float gamePadY, float& x, float& y);
 bool MatchesPattern(const std::string& text, const std::string& pattern);
 
 } // namespace TreadmillLayer
@@ -0,0 +1,96 @@
+#pragma once
+
+// ============================================================================
+// TreadmillPropertyTable - device properties written in one batch
+// ============================================================================
+// Each Set*Property call is a separate IPC into vrserver. Activate() lists
+// a device's properties in a table instead and hands the whole table to
+// IVRProperties::WritePropertyBatch, so activation costs one call however
+// many properties a device has.
+//
+//   const TreadmillProperty props[] = {
+//       TreadmillProperty::String(vr::Prop_SerialNumber_String, "treadmill_xy"),
+//       TreadmillProperty::Bool(vr::Prop_Identifiable_Bool, true),
+//   };
+//   WriteTreadmillProperties(container, props, std::size(props), "controller");
+// ============================================================================
+
+#include "openvr_driver.h"
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <vector>
+
+extern void Log(const char* fmt, ...);
+
+struct TreadmillProperty {
+    vr::ETrackedDeviceProperty prop;
+    vr::PropertyTypeTag_t tag;
+    const char* stringValue;    // must outlive the write
+    int32_t int32Value;
+    float floatValue;
+    bool boolValue;
+
+    static TreadmillProperty String(vr::ETrackedDeviceProperty prop, const char* value) {
+        return { prop, vr::k_unStringPropertyTag, value, 0, 0.0f, false };
+    }
+    static TreadmillProperty Int32(vr::ETrackedDeviceProperty prop, int32_t value) {
+        return { prop, vr::k_unInt32PropertyTag, nullptr, value, 0.0f, false };
+    }
+    static TreadmillProperty Float(vr::ETrackedDeviceProperty prop, float value) {
+        return { prop, vr::k_unFloatPropertyTag, nullptr, 0, value, false };
+    }
+    static TreadmillProperty Bool(vr::ETrackedDeviceProperty prop, bool value) {
+        return { prop, vr::k_unBoolPropertyTag, nullptr, 0, 0.0f, value };
+    }
+};
+
+// One WritePropertyBatch for the whole table; entries that failed are
+// logged with their property id. Returns the number of failed entries.
+inline size_t WriteTreadmillProperties(vr::PropertyContainerHandle_t container, const TreadmillProperty* props, size_t count,
+    const char* deviceName) {
+    // Values are read from the table itself; only the batch is built here
+    std::vector<vr::PropertyWrite_t> batch(count);
+    for (size_t i = 0; i < count; i++) {
+        const TreadmillProperty& p = props[i];
+        vr::PropertyWrite_t& w = batch[i];
+        w = {};
+        w.writeType = vr::PropertyWrite_Set;
+        w.prop = p.prop;
+        w.unTag = p.tag;
+        switch (p.tag) {
+        case vr::k_unStringPropertyTag:
+            w.pvBuffer = const_cast<char*>(p.stringValue ? p.stringValue : "");
+            w.unBufferSize = static_cast<uint32_t>(strlen(static_cast<const char*>(w.pvBuffer)) + 1);
+            break;
+        case vr::k_unInt32PropertyTag:
+            w.pvBuffer = const_cast<int32_t*>(&p.int32Value);
+            w.unBufferSize = sizeof(int32_t);
+            break;
+        case vr::k_unFloatPropertyTag:
+            w.pvBuffer = const_cast<float*>(&p.floatValue);
+            w.unBufferSize = sizeof(float);
+            break;
+        default:
+            w.pvBuffer = const_cast<bool*>(&p.boolValue);
+            w.unBufferSize = sizeof(bool);
+            break;
+        }
+    }
+
+    vr::ETrackedPropertyError error = vr::VRPropertiesRaw()->WritePropertyBatch(container, batch.data(), static_cast<uint32_t>(count));
+    size_t failed = 0;
+    if (error != vr::TrackedProp_Success) {
+        for (const vr::PropertyWrite_t& w : batch) {
+            if (w.eError == vr::TrackedProp_Success) continue;
+            failed++;
+            Log("treadmill: %s property %d not written: %s", deviceName, static_cast<int>(w.prop),
+                vr::VRPropertiesRaw()->GetPropErrorNameFromEnum(w.eError));
+        }
+        if (failed == 0) {
+            Log("treadmill: %s property batch failed: %s", deviceName, vr::VRPropertiesRaw()->GetPropErrorNameFromEnum(error));
+            failed = count;
+        }
+    }
+    return failed;
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+// ============================================================================
+// TreadmillSampleHistory - time-indexed treadmill samples for frame sampling
+// ============================================================================
+// OmniBridge (master) publishes the last 64 samples behind the shared memory
+// header, each stamped with QueryPerformanceCounter in microseconds. This
+// reader maps that ring read-only and lets a host ask for the treadmill state
+// at an exact frame time (SampleAt) instead of the state at arrival time.
+//
+// Mapping and layout come from TreadmillSharedRegion (Windows and Linux).
+// No locks: every slot carries a sequence counter (odd = being written,
+// 2n+2 = sample n complete) and torn reads are simply discarded.
+// ============================================================================
+
+#include "TreadmillSharedRegion.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <mutex>
+
+enum class TreadmillInterpolation {
+    Linear,
+    Hermite     // cubic Hermite with finite-difference tangents
+};
+
+class TreadmillSampleHistory {
+public:
+    static constexpr int Capacity = TreadmillSharedRegion::HistoryCapacity;
+    static constexpr int64_t DefaultMaxExtrapolationUs = 20000;
+
+    explicit TreadmillSampleHistory(const TreadmillSharedRegion::NameChar* name = TreadmillSharedRegion::DefaultName)
+        : m_region(name) {}
+    ~TreadmillSampleHistory() { Close(); }
+    TreadmillSampleHistory(const TreadmillSampleHistory&) = delete;
+    TreadmillSampleHistory& operator=(const TreadmillSampleHistory&) = delete;
+
+    // Same clock OmniBridge stamps samples with (MSVC steady_clock is QPC based)
+#ifdef TREADMILL_VIRTUAL_CLOCK
+    // Test builds (TreadmillDriverTests) advance the clock per frame, so a
+    // replay gives the same output on any machine and under any load
+    static std::atomic<int64_t>& VirtualNowUs() {
+        static std::atomic<int64_t> nowUs{ 1000000 };
+        return nowUs;
+    }
+    static int64_t NowUs() { return VirtualNowUs().load(std::memory_order_relaxed); }
+#else
+    static int64_t NowUs() {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+#endif
+
+    // Attach to the shared memory of the running OmniBridge master.
+    // Fails if there is no master yet or it predates the history ring.
+    bool Open() { return m_region.Open(); }
+
+    void Close() { m_region.Close(); }
+
+    bool IsOpen() const { return m_region.IsOpen(); }
+
+    const TreadmillSharedRegion& Region() const { return m_region; }
+
+    // Copy up to maxCount of the newest complete samples, oldest first.
+    // Returns the number of samples copied.
+    int Snapshot(TreadmillSample* out, int maxCount) const {
+        if (!m_region.IsOpen() || !out || maxCount <= 0) return 0;
+
+        int64_t head = Read<int64_t>(OffsetHistoryHead);
+        // Slot head % Capacity may be under rewrite, so at most Capacity - 1 are stable
+        int64_t first = std::max<int64_t>(0, head - std::min(Capacity - 1, maxCount));
+        int count = 0;
+
+        for (int64_t index = first; index < head; index++) {
+            size_t slot = HistoryOffset + static_cast<size_t>(index % Capacity) * SlotSize;
+            int64_t expectedSeq = 2 * index + 2;
+
+            if (Read<int64_t>(slot + SlotSeq) != expectedSeq) continue;
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            TreadmillSample s;
+            s.timeUs = Read<int64_t>(slot + SlotTimestamp);
+            s.yaw = Read<float>(slot + SlotYaw);
+            s.gamePadX = static_cast<float>(Read<int32_t>(slot + SlotRawX));
+            s.gamePadY = static_cast<float>(Read<int32_t>(slot + SlotRawY));
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (Read<int64_t>(slot + SlotSeq) != expectedSeq) continue;  // overwritten while copying
+
+            out[count++] = s;
+        }
+        return count;
+    }
+
+    // Treadmill state at timeUs. Interpolates between the surrounding samples,
+    // holds the oldest sample before the window and extrapolates at most
+    // maxExtrapolationUs past the newest one.
+    bool SampleAt(int64_t timeUs, TreadmillSample& out,
+                  TreadmillInterpolation mode = TreadmillInterpolation::Hermite,
+                  int64_t maxExtrapolationUs = DefaultMaxExtrapolationUs) const {
+        TreadmillSample samples[Capacity];
+        int count = Snapshot(samples, Capacity);
+        return Interpolate(samples, count, timeUs, out, mode, maxExtrapolationUs);
+    }
+
+    // Newest sample at or before timeUs - what a host shows without resampling
+    static bool Latest(const TreadmillSample* samples, int count, int64_t timeUs, TreadmillSample& out) {
+        if (!samples || count <= 0) return false;
+        int i = count - 1;
+        while (i > 0 && samples[i].timeUs > timeUs) i--;
+        out = samples[i];
+        return true;
+    }
+
+    // Interpolation on an arbitrary, time-ordered sample array (oldest first)
+    static bool Interpolate(const TreadmillSample* samples, int count, int64_t timeUs, TreadmillSample& out,
+                            TreadmillInterpolation mode = TreadmillInterpolation::Hermite,
+                            int64_t maxExtrapolationUs = DefaultMaxExtrapolationUs) {
+        if (!samples || count <= 0) return false;
+
+        const TreadmillSample& oldest = samples[0];
+        const TreadmillSample& newest = samples[count - 1];
+
+        if (count == 1 || timeUs <= oldest.timeUs) {
+            out = count == 1 ? newest : oldest;
+            out.timeUs = timeUs;
+            return true;
+        }
+
+        if (timeUs >= newest.timeUs) {
+            // Bounded linear extrapolation from the last two samples
+            const TreadmillSample& prev = samples[count - 2];
+            double span = static_cast<double>(newest.timeUs - prev.timeUs);
+            double ahead = static_cast<double>(std::min(timeUs - newest.timeUs, std::max<int64_t>(0, maxExtrapolationUs)));
+            double f = span > 0.0 ? ahead / span : 0.0;
+
+            out.timeUs = timeUs;
+            out.yaw = WrapAngle(newest.yaw + static_cast<float>(AngleDelta(prev.yaw, newest.yaw) * f));
+            out.gamePadX = ClampPad(newest.gamePadX + static_cast<float>((newest.gamePadX - prev.gamePadX) * f));
+            out.gamePadY = ClampPad(newest.gamePadY + static_cast<float>((newest.gamePadY - prev.gamePadY) * f));
+            return true;
+        }
+
+        // samples[i].timeUs <= timeUs < samples[i + 1].timeUs
+        int i = 0;
+        while (i < count - 2 && samples[i + 1].timeUs <= timeUs) i++;
+
+        const TreadmillSample& p0 = samples[i];
+        const TreadmillSample& p1 = samples[i + 1];
+        double h = static_cast<double>(p1.timeUs - p0.timeUs);
+        double u = h > 0.0 ? static_cast<double>(timeUs - p0.timeUs) / h : 1.0;
+
+        // Yaw is unwrapped relative to p0 so 359° -> 1° interpolates through 0°
+        double yaw0 = 0.0;
+        double yaw1 = AngleDelta(p0.yaw, p1.yaw);
+
+        out.timeUs = timeUs;
+
+        if (mode == TreadmillInterpolation::Linear) {
+            out.yaw = WrapAngle(p0.yaw + static_cast<float>(yaw1 * u));
+            out.gamePadX = p0.gamePadX + static_cast<float>((p1.gamePadX - p0.gamePadX) * u);
+            out.gamePadY = p0.gamePadY + static_cast<float>((p1.gamePadY - p0.gamePadY) * u);
+            return true;
+        }
+
+        // Tangents (per microsecond) from neighbours, one-sided at the ends
+        const TreadmillSample& pm = samples[i > 0 ? i - 1 : i];
+        const TreadmillSample& pp = samples[i + 2 < count ? i + 2 : i + 1];
+        double hm = static_cast<double>(p1.timeUs - pm.timeUs);
+        double hp = static_cast<double>(pp.timeUs - p0.timeUs);
+
+        double yawM = -AngleDelta(pm.yaw, p0.yaw);
+        double yawP = yaw1 + AngleDelta(p1.yaw, pp.yaw);
+        double m0Yaw = hm > 0.0 ? (yaw1 - yawM) / hm : 0.0;
+        double m1Yaw = hp > 0.0 ? (yawP - yaw0) / hp : 0.0;
+
+        out.yaw = WrapAngle(p0.yaw + static_cast<float>(Hermite(yaw0, yaw1, m0Yaw * h, m1Yaw * h, u)));
+        out.gamePadX = ClampPad(static_cast<float>(Hermite(p0.gamePadX, p1.gamePadX,
+            hm > 0.0 ? (p1.gamePadX - pm.gamePadX) / hm * h : 0.0,
+            hp > 0.0 ? (pp.gamePadX - p0.gamePadX) / hp * h : 0.0, u)));
+        out.gamePadY = ClampPad(static_cast<float>(Hermite(p0.gamePadY, p1.gamePadY,
+            hm > 0.0 ? (p1.gamePadY - pm.gamePadY) / hm * h : 0.0,
+            hp > 0.0 ? (pp.gamePadY - p0.gamePadY) / hp * h : 0.0, u)));
+        return true;
+    }
+
+private:
+    using Layout = TreadmillSharedRegion;
+    static constexpr size_t OffsetHistoryHead = Layout::OffsetHistoryHead;
+    static constexpr size_t HistoryOffset = Layout::HistoryOffset;
+    static constexpr size_t SlotSize = Layout::SlotSize;
+    static constexpr size_t SlotSeq = Layout::SlotSeq;
+    static constexpr size_t SlotTimestamp = Layout::SlotTimestamp;
+    static constexpr size_t SlotYaw = Layout::SlotYaw;
+    static constexpr size_t SlotRawX = Layout::SlotRawX;
+    static constexpr size_t SlotRawY = Layout::SlotRawY;
+
+    TreadmillSharedRegion m_region;
+
+    template <typename T>
+    T Read(size_t offset) const { return m_region.Read<T>(offset); }
+
+    // Signed shortest difference to - from in degrees, [-180, 180)
+    static double AngleDelta(float from, float to) {
+        double d = std::fmod(static_cast<double>(to) - from + 540.0, 360.0);
+        if (d < 0.0) d += 360.0;
+        return d - 180.0;
+    }
+
+    static float WrapAngle(float deg) {
+        float w = std::fmod(deg, 360.0f);
+        return w < 0.0f ? w + 360.0f : w;
+    }
+
+    static float ClampPad(float v) {
+        return std::clamp(v, 0.0f, 255.0f);
+    }
+
+    static double Hermite(double p0, double p1, double m0, double m1, double u) {
+        double u2 = u * u;
+        double u3 = u2 * u;
+        return (2.0 * u3 - 3.0 * u2 + 1.0) * p0 + (u3 - 2.0 * u2 + u) * m0
+             + (-2.0 * u3 + 3.0 * u2) * p1 + (u3 - u2) * m1;
+    }
+};
+
+// ----------------------------------------------------------------------------
+// TreadmillFrameJudder - frame-to-frame variation of the output speed
+// ----------------------------------------------------------------------------
+// Fed once per frame with the stick magnitude a host would have used without
+// resampling (latest sample at or before the frame) and the resampled one.
+// Without resampling, 90-144 Hz frames over a 60-120 Hz stream repeat some
+// values and skip others, which shows up as a larger standard deviation of
+// the per-frame change.
+class TreadmillFrameJudder {
+public:
+    struct Summary {
+        uint64_t frames = 0;
+        double heldStdDev = 0.0;        // per-frame speed change, latest sample
+        double resampledStdDev = 0.0;   // per-frame speed change, resampled
+    };
+
+    static float Speed(const TreadmillSample& s) {
+        float x = (s.gamePadX - 127.0f) / 127.0f;
+        float y = (s.gamePadY - 127.0f) / 127.0f;
+        return std::min(1.0f, std::sqrt(x * x + y * y));
+    }
+
+    void Add(float heldSpeed, float resampledSpeed) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_hasLast) {
+            m_frames++;
+            m_held.Add(heldSpeed - m_lastHeld);
+            m_resampled.Add(resampledSpeed - m_lastResampled);
+        }
+        m_hasLast = true;
+        m_lastHeld = heldSpeed;
+        m_lastResampled = resampledSpeed;
+    }
+
+    void Reset() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_frames = 0;
+        m_hasLast = false;
+        m_held = Running();
+        m_resampled = Running();
+    }
+
+    Summary GetSummary() const {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        Summary s;
+        s.frames = m_frames;
+        s.heldStdDev = m_held.StdDev();
+        s.resampledStdDev = m_resampled.StdDev();
+        return s;
+    }
+
+private:
+    // Welford running variance
+    struct Running {
+        uint64_t n = 0;
+        double mean = 0.0;
+        double m2 = 0.0;
+
+        void Add(double v) {
+            n++;
+            double d = v - mean;
+            mean += d / n;
+            m2 += d * (v - mean);
+        }
+
+        double StdDev() const { return n > 1 ? std::sqrt(m2 / (n - 1)) : 0.0; }
+    };
+
+    mutable std::mutex m_mutex;
+    uint64_t m_frames = 0;
+    bool m_hasLast = false;
+    float m_lastHeld = 0.0f;
+    float m_lastResampled = 0.0f;
+    Running m_held;
+    Running m_resampled;
+};
@@ -1,9 +1,84 @@
 #include "TreadmillServerDriver.h"
 #include "TreadmillDevice.h"
+#include "TreadmillLatencyStats.h"
+#include "TreadmillMetrics.h"
+#include "TreadmillFrameBudget.h"
+#include "TreadmillInstrument.h"
+#include <algorithm>
+#include <chrono>
 #include <mutex>
+#include <string>
+#include <vector>
+#ifndef _WIN32
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#if defined(_WIN32) && !defined(CREATE_WAITABLE_TIMER_HIGH_RESOLUTION)
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002  // older SDKs
+#endif
 
 extern void Log(const char* fmt, ...);
 extern void OnOmniData(float ringAngle, int gamePadX, int gamePadY);
+extern void OnFrameSample(float ringAngle, float gamePadX, float gamePadY, int64_t timeUs);
+extern void OnRingDelta(int8_t ringDelta, int64_t timeUs, int64_t intervalUs);
+extern void OnStepCount(uint32_t stepCount, int64_t timeUs);
+extern void OnStepTrigger(uint8_t stepTrigger, int64_t timeUs);
+extern std::atomic<bool> g_frameSampling;
+extern std::atomic<bool> g_frameSamplingActive;
+extern std::atomic<bool> g_frameSamplingLinear;
+extern std::atomic<int64_t> g_frameSamplingLookaheadUs;
+extern TreadmillFrameJudder g_frameJudder;
+extern TreadmillLatencyStats g_latencyPoll;
+extern TreadmillLatencyStats g_latencyHistory;
+extern TreadmillMetricsPage g_metrics;
+extern TreadmillFrameBudget g_frameBudget;
+extern int64_t TakeLogTimeNs();
+extern std::atomic<bool> g_publisherThread;
+extern std::atomic<int> g_publisherRateHz;
+extern std::atomic<TreadmillConnectionState> g_connectionState;
+extern std::atomic<int64_t> g_lastOmniSampleUs;
+extern std::atomic<bool> g_footTrackers;
+extern std::atomic<uint64_t> g_linkStalls;
+extern std::atomic<uint64_t> g_linkReconnects;
+extern std::atomic<int64_t> g_linkLastReconnectMs;
+extern void OnLinkStall();
+
+// Sample deadlines: the Omni streams continuously, so a short gap already
+// means no data (outputs zeroed) and a long one a dead link (reconnect)
+static constexpr int64_t LinkStallAfterUs = 250000;
+static constexpr int64_t ConnectionLostAfterUs = 2000000;
+static constexpr int ReconnectMinBackoffMs = 500;
+static constexpr int ReconnectMaxBackoffMs = 30000;
+
+// COM ports as SerialPort.GetPortNames() (ComPortHelper) sees them
+static std::vector<std::string> ListComPorts() {
+    std::vector<std::string> ports;
+#ifdef _WIN32
+    HKEY key;
+    if (RegOpenKeyExW(HKEY_LOCAL_MACHINE, L"HARDWARE\\DEVICEMAP\\SERIALCOMM", 0, KEY_READ, &key) != ERROR_SUCCESS) {
+        return ports;
+    }
+    for (DWORD index = 0;; index++) {
+        wchar_t name[256];
+        char value[64];
+        DWORD nameLength = 256;
+        DWORD valueSize = sizeof(value) - 1;
+        DWORD type = 0;
+        LONG result = RegEnumValueW(key, index, name, &nameLength, nullptr, &type, reinterpret_cast<BYTE*>(value), &valueSize);
+        if (result == ERROR_NO_MORE_ITEMS) break;
+        if (result != ERROR_SUCCESS || type != REG_SZ) continue;
+        // REG_SZ read through the W API: UTF-16 "COMn"
+        const wchar_t* wide = reinterpret_cast<const wchar_t*>(value);
+        std::string port;
+        for (size_t i = 0; i < valueSize / sizeof(wchar_t) && wide[i] != L'\0'; i++) port += static_cast<char>(wide[i]);
+        if (!port.empty()) ports.push_back(port);
+    }
+    RegCloseKey(key);
+    std::sort(ports.begin(), ports.end());
+#endif
+    return ports;
+}
 
 vr::EVRInitError TreadmillServerDriver::Init(vr::IVRDriverContext* pDriverContext) {
     try {
@@ -21,6 +96,11 @@ vr::EVRInitError TreadmillServerDriver::Init(vr::IVRDriverContext* pDriverContex
         }
         
         Log("treadmill: Init called");
+        
+        // Optional - diagnostics only
+        if (!g_metrics.Create(TreadmillComponent::Driver)) {
+            Log("treadmill: Metrics page not available");
+        }
 
         // Load DLL path from settings (default: hardcoded path)
         char dllPath[512];
@@ -40,76 +120,66 @@ vr::EVRInitError TreadmillServerDriver::Init(vr::IVRDriverContext* pDriverContex
                 strcpy_s(dllPath, sizeof(dllPath), "C:\\Program Files (x86)\\Steam\\steamapps\\common\\SteamVR\\drivers\\treadmill\\bin\\win64\\OmniBridge.dll");
             }
         }
+        m_dllPath = dllPath;
         
-        // Convert char* to wchar_t* for LoadLibrary
-        wchar_t wDllPath[512];
-        MultiByteToWideChar(CP_UTF8, 0, dllPath, -1, wDllPath, 512);
-
-        // Load OmniBridge.dll
-        omniReaderLib = LoadLibrary(wDllPath);
-
-        if (!omniReaderLib) {
-            DWORD err = GetLastError();
-            char buf[256];
-            FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM, nullptr, err, 0, buf, sizeof(buf), nullptr);
-            Log("treadmill: LoadLibrary failed for '%s': %s", dllPath, buf);
-            return vr::VRInitError_Driver_Failed;
+        // Load COM port from settings (default: "COM3")
+        char comPort[64] = "COM3";
+        if (vr::VRSettings()) {
+            vr::EVRSettingsError se = vr::VRSettingsError_None;
+            vr::VRSettings()->GetString(
+                "driver_treadmill", 
+                "com_port", 
+                comPort, 
+                sizeof(comPort), 
+                &se
+            );
+            if (se != vr::VRSettingsError_None) {
+                Log("treadmill: com_port not found in settings, using default COM3");
+                strcpy_s(comPort, sizeof(comPort), "COM3");
+            }
         }
+        m_comPort = comPort;
         
-        Log("treadmill: OmniBridge.dll loaded from: %s", dllPath);
-
-        // Load all functions with detailed debugging
-        pfnCreate = (PFN_OmniReader_Create)GetProcAddress(omniReaderLib, "OmniReader_Create");
-        if (!pfnCreate) Log("treadmill: GetProcAddress failed for OmniReader_Create");
-        
-        pfnInitialize = (PFN_OmniReader_Initialize)GetProcAddress(omniReaderLib, "OmniReader_Initialize");
-        if (!pfnInitialize) Log("treadmill: GetProcAddress failed for OmniReader_Initialize");
-        
-        pfnRegisterCallback = (PFN_OmniReader_RegisterCallback)GetProcAddress(omniReaderLib, "OmniReader_RegisterCallback");
-        if (!pfnRegisterCallback) Log("treadmill: GetProcAddress failed for OmniReader_RegisterCallback");
-        
-        pfnDisconnect = (PFN_OmniReader_Disconnect)GetProcAddress(omniReaderLib, "OmniReader_Disconnect");
-        if (!pfnDisconnect) Log("treadmill: GetProcAddress failed for OmniReader_Disconnect");
-        
-        pfnDestroy = (PFN_OmniReader_Destroy)GetProcAddress(omniReaderLib, "OmniReader_Destroy");
-        if (!pfnDestroy) Log("treadmill: GetProcAddress failed for OmniReader_Destroy");
-
-        if (!pfnCreate || !pfnInitialize || !pfnRegisterCallback || !pfnDisconnect || !pfnDestroy) {
-            Log("treadmill: Not all functions could be loaded from OmniBridge.dll");
-            FreeLibrary(omniReaderLib);
-            omniReaderLib = nullptr;
-            return vr::VRInitError_Driver_Failed;
-        }
-
-        // Initialize OmniReader
-        m_omniReader = pfnCreate();
-        if (m_omniReader) {
-            pfnRegisterCallback(m_omniReader, OnOmniData);
+        if (vr::VRSettings()) {
+            vr::EVRSettingsError se = vr::VRSettingsError_None;
+            bool rescan = vr::VRSettings()->GetBool("driver_treadmill", "com_port_rescan", &se);
+            if (se == vr::VRSettingsError_None) {
+                m_comPortRescan = rescan;
+                Log("treadmill: com_port_rescan loaded from settings: %s", rescan ? "true" : "false");
+            }
             
-            // Load COM port from settings (default: "COM3")
-            char comPort[64] = "COM3";
-            if (vr::VRSettings()) {
-                vr::EVRSettingsError se = vr::VRSettingsError_None;
-                vr::VRSettings()->GetString(
-                    "driver_treadmill", 
-                    "com_port", 
-                    comPort, 
-                    sizeof(comPort), 
-                    &se
-                );
-                if (se != vr::VRSettingsError_None) {
-                    Log("treadmill: com_port not found in settings, using default COM3");
-                    strcpy_s(comPort, sizeof(comPort), "COM3");
-                }
+            char format[16] = {};
+            se = vr::VRSettingsError_None;
+            vr::VRSettings()->GetString("driver_treadmill", "broadcast_format", format, sizeof(format), &se);
+            if (se == vr::VRSettingsError_None) {
+                std::string mode(format);
+                std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+                m_broadcastFormat = mode == "binary" ? TreadmillBroadcastFormat::Binary
+                    : mode == "osc" ? TreadmillBroadcastFormat::Osc : TreadmillBroadcastFormat::Off;
+                Log("treadmill: broadcast_format loaded from settings: %s", format);
             }
             
-            if (pfnInitialize(m_omniReader, comPort, 0, 115200)) {
-                Log("treadmill: OmniReader connected on %s", comPort);
-            } else {
-                Log("treadmill: OmniReader failed to initialize on %s", comPort);
+            char address[64] = {};
+            se = vr::VRSettingsError_None;
+            vr::VRSettings()->GetString("driver_treadmill", "broadcast_address", address, sizeof(address), &se);
+            if (se == vr::VRSettingsError_None && address[0] != '\0') {
+                m_broadcastAddress = address;
+                Log("treadmill: broadcast_address loaded from settings: %s", address);
+            }
+            
+            se = vr::VRSettingsError_None;
+            int32_t port = vr::VRSettings()->GetInt32("driver_treadmill", "broadcast_port", &se);
+            if (se == vr::VRSettingsError_None && port > 0 && port <= 65535) {
+                m_broadcastPort = port;
+                Log("treadmill: broadcast_port loaded from settings: %d", port);
+            }
+            
+            se = vr::VRSettingsError_None;
+            int32_t rate = vr::VRSettings()->GetInt32("driver_treadmill", "broadcast_rate_hz", &se);
+            if (se == vr::VRSettingsError_None && rate >= 1 && rate <= 1000) {
+                m_broadcastRateHz = rate;
+                Log("treadmill: broadcast_rate_hz loaded from settings: %d", rate);
             }
-        } else {
-            Log("treadmill: OmniReader_Create failed");
         }
 
         // 1. Treadmill-Controller (invisible, for inputs)
@@ -138,6 +208,31 @@ vr::EVRInitError TreadmillServerDriver::Init(vr::IVRDriverContext* pDriverContex
         );
         Log("treadmill: Visual Tracker added: %s", trackerAdded ? "true" : "false");
 
+        // 3. Foot trackers from the pods (foot_trackers)
+        if (g_footTrackers.load()) {
+            for (int foot = 0; foot < 2; foot++) {
+                m_feet[foot] = std::make_unique<TreadmillFootTracker>(foot);
+                bool footAdded = pDriverHost->TrackedDeviceAdded(
+                    m_feet[foot]->SerialNumber(),
+                    vr::TrackedDeviceClass_GenericTracker,
+                    m_feet[foot].get()
+                );
+                Log("treadmill: Foot Tracker %s added: %s", m_feet[foot]->SerialNumber(), footAdded ? "true" : "false");
+            }
+        }
+
+        // OmniBridge (.NET start-up, COM port configuration) would hold up
+        // SteamVR's start; the devices show as searching until it streams
+        m_connectorStop.store(false);
+        g_connectionState.store(TreadmillConnectionState::Loading);   // not the previous Init's
+        m_connector = std::thread(&TreadmillServerDriver::ConnectLoop, this);
+
+        if (g_publisherThread.load()) {
+            m_publisherRunning.store(true);
+            m_publisher = std::thread(&TreadmillServerDriver::PublisherLoop, this);
+            Log("treadmill: Publisher thread started at %d Hz - RunFrame handles events only", g_publisherRateHz.load());
+        }
+
         return vr::VRInitError_None;
     } catch (const std::exception &e) {
         Log("treadmill: Init exception: %s", e.what());
@@ -148,9 +243,243 @@ vr::EVRInitError TreadmillServerDriver::Init(vr::IVRDriverContext* pDriverContex
     }
 }
 
+// Loads OmniBridge.dll and resolves its exports (connection thread)
+bool TreadmillServerDriver::LoadOmniBridge() {
+    // Convert char* to wchar_t* for LoadLibrary
+    wchar_t wDllPath[512];
+    MultiByteToWideChar(CP_UTF8, 0, m_dllPath.c_str(), -1, wDllPath, 512);
+
+    // Load OmniBridge.dll
+    omniReaderLib = LoadLibrary(wDllPath);
+
+    if (!omniReaderLib) {
+        DWORD err = GetLastError();
+        char buf[256];
+        FormatMessageA(FORMAT_MESSAGE_FROM_SYSTEM, nullptr, err, 0, buf, sizeof(buf), nullptr);
+        Log("treadmill: LoadLibrary failed for '%s': %s", m_dllPath.c_str(), buf);
+        return false;
+    }
+    
+    Log("treadmill: OmniBridge.dll loaded from: %s", m_dllPath.c_str());
+
+    // Load all functions with detailed debugging
+    pfnCreate = (PFN_OmniReader_Create)GetProcAddress(omniReaderLib, "OmniReader_Create");
+    if (!pfnCreate) Log("treadmill: GetProcAddress failed for OmniReader_Create");
+    
+    pfnInitialize = (PFN_OmniReader_Initialize)GetProcAddress(omniReaderLib, "OmniReader_Initialize");
+    if (!pfnInitialize) Log("treadmill: GetProcAddress failed for OmniReader_Initialize");
+    
+    pfnRegisterCallback = (PFN_OmniReader_RegisterCallback)GetProcAddress(omniReaderLib, "OmniReader_RegisterCallback");
+    if (!pfnRegisterCallback) Log("treadmill: GetProcAddress failed for OmniReader_RegisterCallback");
+    
+    pfnDisconnect = (PFN_OmniReader_Disconnect)GetProcAddress(omniReaderLib, "OmniReader_Disconnect");
+    if (!pfnDisconnect) Log("treadmill: GetProcAddress failed for OmniReader_Disconnect");
+    
+    pfnDestroy = (PFN_OmniReader_Destroy)GetProcAddress(omniReaderLib, "OmniReader_Destroy");
+    if (!pfnDestroy) Log("treadmill: GetProcAddress failed for OmniReader_Destroy");
+
+    if (!pfnCreate || !pfnInitialize || !pfnRegisterCallback || !pfnDisconnect || !pfnDestroy) {
+        Log("treadmill: Not all functions could be loaded from OmniBridge.dll");
+        FreeLibrary(omniReaderLib);
+        omniReaderLib = nullptr;
+        return false;
+    }
+    
+    // Optional: batch pull on the frame thread instead of the data callback
+    pfnPoll = (PFN_OmniReader_Poll)GetProcAddress(omniReaderLib, "OmniReader_Poll");
+    Log("treadmill: OmniReader_Poll %s", pfnPoll ? "available - polling in RunFrame" : "not exported - using data callback");
+    
+    // Optional: pod quaternions for the foot trackers
+    pfnEnablePods = (PFN_OmniReader_EnablePods)GetProcAddress(omniReaderLib, "OmniReader_EnablePods");
+    pfnPollPods = (PFN_OmniReader_PollPods)GetProcAddress(omniReaderLib, "OmniReader_PollPods");
+    if (!pfnEnablePods || !pfnPollPods) {
+        pfnEnablePods = nullptr;
+        pfnPollPods = nullptr;
+        if (g_footTrackers.load()) Log("treadmill: OmniReader_PollPods not exported - foot trackers stay without data");
+    }
+    
+    // Optional: UDP/OSC broadcast for external consumers
+    pfnConfigureBroadcast = (PFN_OmniReader_ConfigureBroadcast)GetProcAddress(omniReaderLib, "OmniReader_ConfigureBroadcast");
+    if (!pfnConfigureBroadcast && m_broadcastFormat != TreadmillBroadcastFormat::Off) {
+        Log("treadmill: OmniReader_ConfigureBroadcast not exported - broadcast_format ignored");
+    }
+    return true;
+}
+
+// Loading -> Connecting -> Streaming, each retried with a doubling backoff
+// (ReconnectMinBackoffMs..ReconnectMaxBackoffMs). The publishing thread
+// watches the stream from there (UpdateConnectionState); on Lost the link
+// is dropped and the loop starts over at the shortest backoff.
+void TreadmillServerDriver::ConnectLoop() {
+    int64_t startNs = TreadmillCallProfile::NowNs();
+    int backoffMs = ReconnectMinBackoffMs;
+    
+    // Short steps so Cleanup is not held up
+    auto waitBackoff = [this, &backoffMs]() {
+        for (int waitedMs = 0; waitedMs < backoffMs && !m_connectorStop.load(); waitedMs += 100) {
+            Sleep(100);
+        }
+        backoffMs = std::min(backoffMs * 2, ReconnectMaxBackoffMs);
+    };
+    
+    // A missing or half-installed OmniBridge can be fixed while SteamVR runs
+    for (int attempt = 1; !m_omniReader; attempt++) {
+        if (m_connectorStop.load()) return;
+        g_connectionState.store(TreadmillConnectionState::Loading);
+        if (LoadOmniBridge()) {
+            g_connectionState.store(TreadmillConnectionState::Connecting);
+            m_omniReader = pfnCreate();
+            if (m_omniReader) break;
+            Log("treadmill: OmniReader_Create failed");
+            FreeLibrary(omniReaderLib);
+            omniReaderLib = nullptr;
+        }
+        g_connectionState.store(TreadmillConnectionState::Failed);
+        Log("treadmill: OmniBridge.dll unusable (attempt %d) - retrying in %.1f s", attempt, backoffMs / 1000.0);
+        waitBackoff();
+    }
+    m_pollSequence = 0;     // a new reader numbers its samples from 1
+    m_podSequence = 0;
+    if (!pfnPoll) {
+        pfnRegisterCallback(m_omniReader, OnOmniData);
+    }
+    
+    // Sends from the reader's sample ring, so it keeps going across reconnects
+    if (pfnConfigureBroadcast && m_broadcastFormat != TreadmillBroadcastFormat::Off) {
+        bool ok = pfnConfigureBroadcast(m_omniReader, m_broadcastAddress.c_str(), m_broadcastPort, m_broadcastRateHz,
+            static_cast<int>(m_broadcastFormat));
+        Log("treadmill: Broadcast to %s:%d at %d Hz %s", m_broadcastAddress.c_str(), m_broadcastPort, m_broadcastRateHz,
+            ok ? "started" : "failed - check broadcast_address");
+    }
+    
+    int64_t lostAtNs = 0;
+    backoffMs = ReconnectMinBackoffMs;
+    for (int attempt = 1; !m_connectorStop.load(); attempt++) {
+        std::string port;
+        if (TryConnect(attempt, port)) {
+            int64_t connectedNs = TreadmillCallProfile::NowNs();
+            if (lostAtNs == 0) {
+                Log("treadmill: OmniReader connected on %s after %.0f ms", port.c_str(), (connectedNs - startNs) / 1e6);
+            } else {
+                int64_t reconnectMs = (connectedNs - lostAtNs) / 1000000;
+                g_linkReconnects.fetch_add(1);
+                g_linkLastReconnectMs.store(reconnectMs);
+                Log("treadmill: OmniReader reconnected on %s after %lld ms (%d attempts)", port.c_str(),
+                    static_cast<long long>(reconnectMs), attempt);
+            }
+            
+            // Asked again once connected: a shared memory consumer gets no pod data
+            if (g_footTrackers.load() && pfnEnablePods && !pfnEnablePods(m_omniReader, true)) {
+                Log("treadmill: Another process owns the treadmill - foot trackers stay without pod data");
+            }
+            
+            {
+                std::lock_guard<std::mutex> readerLock(m_readerMutex);
+                m_historyAttach.store(true);    // opened by the publishing thread
+                g_lastOmniSampleUs.store(TreadmillSampleHistory::NowUs());  // grace period before "lost"
+                m_readerReady.store(true, std::memory_order_release);
+            }
+            g_connectionState.store(TreadmillConnectionState::Streaming);
+            
+            // Until the publishing thread reports the link lost (UpdateConnectionState)
+            while (!m_connectorStop.load() && g_connectionState.load() != TreadmillConnectionState::Lost) {
+                Sleep(100);
+            }
+            if (m_connectorStop.load()) return;
+            
+            // Drop the dead link; the publishing thread skips the reader meanwhile
+            lostAtNs = TreadmillCallProfile::NowNs();
+            {
+                std::lock_guard<std::mutex> readerLock(m_readerMutex);
+                m_readerReady.store(false);
+                g_frameSamplingActive.store(false);
+                m_historyDetach.store(true);    // the publishing thread may be waiting on it
+                pfnDisconnect(m_omniReader);
+                // The cursors stay: the reader's rings survive Disconnect, and
+                // polling from 0 would replay the samples from before the loss
+                m_pollLastTimeUs = 0;
+                m_historyLastTimeUs = 0;
+            }
+            g_connectionState.store(TreadmillConnectionState::Connecting);
+            Log("treadmill: Reconnecting to the treadmill");
+            attempt = 0;
+            backoffMs = ReconnectMinBackoffMs;
+            continue;
+        }
+        Log("treadmill: OmniReader failed to initialize (attempt %d) - retrying in %.1f s", attempt, backoffMs / 1000.0);
+        waitBackoff();
+    }
+}
+
+// The configured port first; with com_port_rescan every other port that is
+// present now, as OmniBridge's ComPortHelper lists them (SERIALCOMM)
+bool TreadmillServerDriver::TryConnect(int attempt, std::string& port) {
+    std::vector<std::string> present = ListComPorts();
+    bool configuredPresent = std::find(present.begin(), present.end(), m_comPort) != present.end();
+    if (attempt == 1 || !configuredPresent) {
+        std::string list;
+        for (const std::string& p : present) list += (list.empty() ? "" : ", ") + p;
+        Log("treadmill: COM ports present: %s%s", list.empty() ? "none" : list.c_str(),
+            configuredPresent ? "" : " - configured port missing (unplugged?)");
+    }
+    
+    // Pod streaming is configured as part of Initialize
+    if (g_footTrackers.load() && pfnEnablePods) pfnEnablePods(m_omniReader, true);
+    
+    // Also without the port: Initialize first tries another process's shared memory
+    std::vector<std::string> candidates{ m_comPort };
+    if (m_comPortRescan) {
+        for (const std::string& p : present) {
+            if (p != m_comPort) candidates.push_back(p);
+        }
+    }
+    for (const std::string& candidate : candidates) {
+        if (m_connectorStop.load()) return false;
+        if (pfnInitialize(m_omniReader, candidate.c_str(), 0, 115200)) {
+            port = candidate;
+            return true;
+        }
+        pfnDisconnect(m_omniReader);  // release what the failed attempt opened
+    }
+    return false;
+}
+
+// Publishing thread: sample deadlines. A short gap zeroes the outputs
+// (stall), a long one marks the link lost so ConnectLoop reconnects.
+void TreadmillServerDriver::UpdateConnectionState(int64_t nowUs) {
+    TreadmillConnectionState state = g_connectionState.load();
+    int64_t silentUs = nowUs - g_lastOmniSampleUs.load(std::memory_order_relaxed);
+    
+    if (silentUs > LinkStallAfterUs && !m_linkStalled) {
+        m_linkStalled = true;
+        g_linkStalls.fetch_add(1);
+        OnLinkStall();
+        Log("treadmill: No treadmill sample for %lld ms - outputs zeroed", static_cast<long long>(silentUs / 1000));
+    } else if (silentUs <= LinkStallAfterUs && m_linkStalled) {
+        m_linkStalled = false;
+    }
+    
+    if (state == TreadmillConnectionState::Streaming && silentUs > ConnectionLostAfterUs) {
+        g_connectionState.store(TreadmillConnectionState::Lost);
+        Log("treadmill: No treadmill samples for %.1f s - connection lost", silentUs / 1e6);
+    }
+}
+
 void TreadmillServerDriver::Cleanup() {
     Log("treadmill: Cleanup called");
     
+    // Waits for a connection attempt in progress
+    m_connectorStop.store(true);
+    if (m_connector.joinable()) m_connector.join();
+    
+    // Before anything it publishes from goes away
+    m_publisherRunning.store(false);
+    if (m_publisher.joinable()) m_publisher.join();
+    
+    m_readerReady.store(false);
+    g_frameSamplingActive.store(false);
+    m_history.Close();
+    
     if (m_omniReader && pfnDisconnect && pfnDestroy) {
         pfnDisconnect(m_omniReader);
         pfnDestroy(m_omniReader);
@@ -162,8 +491,12 @@ void TreadmillServerDriver::Cleanup() {
         omniReaderLib = nullptr;
     }
     
+    m_feet[0].reset();
+    m_feet[1].reset();
     m_visualTracker.reset();
     m_device.reset();
+    
+    g_metrics.Close();
 }
 
 const char* const* TreadmillServerDriver::GetInterfaceVersions() {
@@ -171,20 +504,267 @@ const char* const* TreadmillServerDriver::GetInterfaceVersions() {
 }
 
 void TreadmillServerDriver::RunFrame() {
+    TREADMILL_FRAME_MARK("RunFrame");
+    TREADMILL_ZONE("RunFrame");
+    
+    // Drain vrserver's events every frame; nothing here reacts to them yet
+    vr::VREvent_t event;
+    while (vr::VRServerDriverHost()->PollNextEvent(&event, sizeof(event))) {
+    }
+    
+    if (!m_publisherRunning.load(std::memory_order_relaxed)) {
+        PublishFrame();
+    }
+    g_metrics.Heartbeat();
+}
+
+// MMCSS "Games" on Windows; SCHED_FIFO, then SCHED_RR elsewhere. Without
+// the rights for either the thread keeps its normal priority.
+static void* RaisePublisherPriority() {
+#ifdef _WIN32
+    typedef HANDLE (WINAPI *PFN_AvSetMmThreadCharacteristicsW)(LPCWSTR, LPDWORD);
+    HMODULE avrt = LoadLibraryW(L"avrt.dll");
+    auto pfnAvSet = avrt ? (PFN_AvSetMmThreadCharacteristicsW)GetProcAddress(avrt, "AvSetMmThreadCharacteristicsW") : nullptr;
+    DWORD taskIndex = 0;
+    HANDLE task = pfnAvSet ? pfnAvSet(L"Games", &taskIndex) : nullptr;
+    if (task) {
+        Log("treadmill: Publisher thread registered with MMCSS (Games)");
+        return task;  // reverted when the thread ends
+    }
+    if (avrt) FreeLibrary(avrt);
+    bool raised = SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_TIME_CRITICAL) != 0;
+    Log("treadmill: MMCSS not available - publisher thread %s", raised ? "at time-critical priority" : "at normal priority");
+    return nullptr;
+#else
+    for (int policy : { SCHED_FIFO, SCHED_RR }) {
+        sched_param param{};
+        param.sched_priority = sched_get_priority_min(policy) + 1;
+        if (pthread_setschedparam(pthread_self(), policy, &param) == 0) {
+            Log("treadmill: Publisher thread at %s priority %d", policy == SCHED_FIFO ? "SCHED_FIFO" : "SCHED_RR", param.sched_priority);
+            return nullptr;
+        }
+    }
+    Log("treadmill: No real-time scheduling allowed - publisher thread at normal priority");
+    return nullptr;
+#endif
+}
+
+static void RevertPublisherPriority(void* task) {
+#ifdef _WIN32
+    if (!task) return;
+    typedef BOOL (WINAPI *PFN_AvRevertMmThreadCharacteristics)(HANDLE);
+    HMODULE avrt = GetModuleHandleW(L"avrt.dll");
+    auto pfnAvRevert = avrt ? (PFN_AvRevertMmThreadCharacteristics)GetProcAddress(avrt, "AvRevertMmThreadCharacteristics") : nullptr;
+    if (pfnAvRevert) pfnAvRevert(static_cast<HANDLE>(task));
+    if (avrt) FreeLibrary(avrt);
+#else
+    (void)task;
+#endif
+}
+
+// Publishes once per period, and as soon as OmniBridge publishes a sample
+// when the history is attached (futex wake on Linux, 1 ms poll on Windows)
+void TreadmillServerDriver::PublisherLoop() {
+    void* task = RaisePublisherPriority();
+    int64_t periodUs = 1000000 / std::max(1, g_publisherRateHz.load());
+#ifdef _WIN32
+    // High-resolution timer (Windows 10 1803+), else the default one
+    HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+    if (!timer) timer = CreateWaitableTimerExW(nullptr, nullptr, 0, TIMER_ALL_ACCESS);
+#endif
+    uint64_t lastUpdateCount = 0;
+    auto next = std::chrono::steady_clock::now();
+    
+    while (m_publisherRunning.load()) {
+        next += std::chrono::microseconds(periodUs);
+        auto now = std::chrono::steady_clock::now();
+        if (next < now) next = now;  // late (e.g. after a stall) - do not burst
+        
+        if (m_history.IsOpen()) {
+            auto leftMs = std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count();
+            leftMs = std::clamp<int64_t>(leftMs, 1, std::max<int64_t>(1, periodUs / 1000));
+            m_history.Region().WaitForUpdate(lastUpdateCount, static_cast<uint32_t>(leftMs));
+            lastUpdateCount = m_history.Region().UpdateCount();
+            
+            // Woken early by a sample: the next period counts from now, else
+            // every sample would push the deadline further ahead
+            auto woke = std::chrono::steady_clock::now();
+            if (woke < next) next = woke;
+        } else {
+#ifdef _WIN32
+            LARGE_INTEGER due;
+            due.QuadPart = -std::chrono::duration_cast<std::chrono::microseconds>(next - now).count() * 10;  // relative, 100 ns
+            if (timer && SetWaitableTimer(timer, &due, 0, nullptr, nullptr, FALSE)) {
+                WaitForSingleObject(timer, INFINITE);
+            } else {
+                std::this_thread::sleep_until(next);
+            }
+#else
+            std::this_thread::sleep_until(next);
+#endif
+        }
+        if (!m_publisherRunning.load()) break;
+        PublishFrame();
+    }
+    
+#ifdef _WIN32
+    if (timer) CloseHandle(timer);
+#endif
+    RevertPublisherPriority(task);
+}
+
+void TreadmillServerDriver::PublishFrame() {
+    TREADMILL_FRAME_MARK("PublishFrame");
+    TREADMILL_ZONE("PublishFrame");
+    int64_t frameStartNs = TreadmillCallProfile::NowNs();
+    g_frameBudget.BeginFrame(frameStartNs);
+    // Over budget with frame_budget_degrade: shed judder/latency statistics
+    // and update the visual tracker only every 4th frame
+    bool degraded = g_frameBudget.IsDegraded();
+    // Reader fields are the connection thread's until then, and while it
+    // reconnects (never waited for - the frame just goes without samples)
+    std::unique_lock<std::mutex> readerLock(m_readerMutex, std::try_to_lock);
+    bool readerReady = readerLock.owns_lock() && m_readerReady.load(std::memory_order_acquire);
+    
+    // Only this thread maps and unmaps the history - PublisherLoop waits on it
+    // without the reader lock. After a lost link the next connect reattaches.
+    if (m_historyDetach.exchange(false)) {
+        m_history.Close();
+    }
+    
+    // Sample the treadmill at this frame's time instead of packet arrival time
+    if (g_frameSampling.load() && readerReady) {
+        if (m_historyAttach.exchange(false)) {
+            bool historyOpen = m_history.IsOpen() || m_history.Open();
+            Log("treadmill: Sample history %s", historyOpen ? "attached - sampling at frame time" : "not available - using callback data");
+        } else if (!m_history.IsOpen() && ++m_historyRetryFrames % 90 == 0) {
+            // The master may come up later (or fail over) - retry about once a second
+            if (m_history.Open()) Log("treadmill: Sample history attached");
+        }
+        
+        int64_t nowUs = TreadmillSampleHistory::NowUs();
+        TreadmillSample samples[TreadmillSampleHistory::Capacity];
+        int count = m_history.Snapshot(samples, TreadmillSampleHistory::Capacity);
+        
+        TreadmillSample sample;
+        TreadmillInterpolation mode = g_frameSamplingLinear.load() ? TreadmillInterpolation::Linear : TreadmillInterpolation::Hermite;
+        // A stalled link would replay its last sample every frame
+        if (!m_linkStalled && TreadmillSampleHistory::Interpolate(samples, count, nowUs, sample, mode, g_frameSamplingLookaheadUs.load())) {
+            OnFrameSample(sample.yaw, sample.gamePadX, sample.gamePadY, nowUs);
+            
+            // Compare against what this frame would have shown without resampling
+            TreadmillSample held;
+            TreadmillSampleHistory::Latest(samples, count, nowUs, held);
+            if (!degraded) g_frameJudder.Add(TreadmillFrameJudder::Speed(held), TreadmillFrameJudder::Speed(sample));
+        }
+        
+        // Latency of each sample the first frame it becomes visible
+        if (count > 0 && samples[count - 1].timeUs != m_historyLastTimeUs) {
+            if (!degraded) g_latencyHistory.Record(nowUs - samples[count - 1].timeUs);
+            m_historyLastTimeUs = samples[count - 1].timeUs;
+            g_lastOmniSampleUs.store(nowUs, std::memory_order_relaxed);
+        }
+    }
+    g_frameSamplingActive.store(g_frameSampling.load() && readerReady && m_history.IsOpen());
+    
+    // Drain new samples on this thread (no callback, no foreign thread)
+    if (readerReady && pfnPoll && m_omniReader) {
+        OmniSample samples[64];
+        size_t count;
+        do {
+            uint64_t expectedSequence = m_pollSequence + 1;
+            count = pfnPoll(m_omniReader, samples, 64, &m_pollSequence);
+            int64_t nowUs = TreadmillSampleHistory::NowUs();
+            // Frame sampling already produced this frame's state
+            bool frameSampled = g_frameSamplingActive.load();
+            for (size_t i = 0; i < count; i++) {
+                const OmniSample& sample = samples[i];
+                if (!degraded) g_latencyPoll.Record(nowUs - sample.timestampUs);
+                
+                // Sequences are contiguous unless OmniBridge's ring overran us
+                if (expectedSequence > 1 && sample.sequence > expectedSequence) {
+                    TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::DroppedSamplesTotal, static_cast<int64_t>(sample.sequence - expectedSequence));
+                }
+                expectedSequence = sample.sequence + 1;
+                
+                if (!frameSampled) {
+                    OnFrameSample(sample.ringAngle, static_cast<float>(sample.gamePadX), static_cast<float>(sample.gamePadY),
+                        sample.timestampUs);
+                }
+                
+                // Rate measurement for the Kalman yaw, needed with frame sampling too
+                if ((sample.flags & OmniSample_RingDelta) && m_pollLastTimeUs != 0) {
+                    OnRingDelta(static_cast<int8_t>(sample.ringDelta), sample.timestampUs, sample.timestampUs - m_pollLastTimeUs);
+                }
+                m_pollLastTimeUs = sample.timestampUs;
+                
+                if (sample.flags & OmniSample_StepCount) {
+                    OnStepCount(sample.stepCount, sample.timestampUs);
+                }
+                if (sample.flags & OmniSample_StepTrigger) {
+                    OnStepTrigger(sample.stepTrigger, sample.timestampUs);
+                }
+            }
+            TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::SamplesTotal, static_cast<int64_t>(count));
+            if (count > 0) g_lastOmniSampleUs.store(nowUs, std::memory_order_relaxed);
+        } while (count == 64);
+    }
+    
+    // Pod orientations for the foot trackers, after the gait has seen this frame's steps
+    if (m_feet[0]) {
+        AdvanceFootGait(TreadmillSampleHistory::NowUs());
+        if (readerReady && pfnPollPods && m_omniReader) {
+            OmniPodSample pods[32];
+            size_t count;
+            do {
+                count = pfnPollPods(m_omniReader, pods, 32, &m_podSequence);
+                for (size_t i = 0; i < count; i++) {
+                    if (pods[i].flags & OmniPod_Pod1) m_feet[0]->OnPodSample(pods[i].pod1, pods[i].timestampUs);
+                    if (pods[i].flags & OmniPod_Pod2) m_feet[1]->OnPodSample(pods[i].pod2, pods[i].timestampUs);
+                }
+            } while (count == 32);
+        }
+    }
+    if (readerReady) UpdateConnectionState(TreadmillSampleHistory::NowUs());
+    if (readerLock.owns_lock()) readerLock.unlock();
+    g_frameBudget.EndPhase(TreadmillFrameBudget::Phase_Sampling, TreadmillCallProfile::NowNs(), TakeLogTimeNs());
+    
     // Controller input updates
     if (m_device && m_device->m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
         m_device->UpdateInputs();
+        g_frameBudget.EndPhase(TreadmillFrameBudget::Phase_Input, TreadmillCallProfile::NowNs(), TakeLogTimeNs());
         vr::DriverPose_t pose = m_device->GetPose();
         vr::VRServerDriverHost()->TrackedDevicePoseUpdated(
             m_device->m_unObjectId, pose, sizeof(vr::DriverPose_t));
+        g_frameBudget.EndPhase(TreadmillFrameBudget::Phase_ControllerPose, TreadmillCallProfile::NowNs(), TakeLogTimeNs());
     }
     
     // NEW: Visual tracker pose updates
-    if (m_visualTracker && m_visualTracker->m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
+    bool trackerDue = !degraded || ++m_degradedTrackerFrames % 4 == 0;
+    if (trackerDue && m_visualTracker && m_visualTracker->m_unObjectId != vr::k_unTrackedDeviceIndexInvalid) {
         vr::DriverPose_t trackerPose = m_visualTracker->GetPose();
         vr::VRServerDriverHost()->TrackedDevicePoseUpdated(
             m_visualTracker->m_unObjectId, trackerPose, sizeof(vr::DriverPose_t));
+        g_frameBudget.EndPhase(TreadmillFrameBudget::Phase_TrackerPose, TreadmillCallProfile::NowNs(), TakeLogTimeNs());
     }
+    
+    // Foot tracker poses, every frame - they carry the gait motion
+    for (auto& foot : m_feet) {
+        if (!foot || foot->m_unObjectId == vr::k_unTrackedDeviceIndexInvalid) continue;
+        vr::DriverPose_t footPose = foot->GetPose();
+        vr::VRServerDriverHost()->TrackedDevicePoseUpdated(foot->m_unObjectId, footPose, sizeof(vr::DriverPose_t));
+    }
+    if (m_feet[0]) g_frameBudget.EndPhase(TreadmillFrameBudget::Phase_TrackerPose, TreadmillCallProfile::NowNs(), TakeLogTimeNs());
+    
+    g_frameBudget.AddPhaseTime(TreadmillFrameBudget::Phase_Logging, TakeLogTimeNs());   // outside any phase
+    int64_t frameEndNs = TreadmillCallProfile::NowNs();
+    char budgetMessage[320];
+    if (g_frameBudget.EndFrame(frameEndNs, budgetMessage, sizeof(budgetMessage))) {
+        Log("%s", budgetMessage);
+    }
+    TakeLogTimeNs();  // the warning is outside the measured frame
+    
+    g_metrics.Set(TreadmillMetric::FrameOverheadNs, frameEndNs - frameStartNs);
 }
 
 bool TreadmillServerDriver::ShouldBlockStandbyMode() { return false; }
@@ -3,11 +3,24 @@
 #include <windows.h>
 #include "openvr_driver.h"
 #include "TreadmillDevice.h"
+#include "TreadmillSampleHistory.h"
+#include "TreadmillBroadcast.h"
+#include "MinimalOmniReader.h"
 #include <atomic>
 #include <thread>
 #include <memory>
+#include <mutex>
+#include <string>
 
-typedef void (*OmniDataCallback)(float ringAngle, int gamePadX, int gamePadY);
+// OmniBridge connection as seen by the devices' poses
+enum class TreadmillConnectionState {
+    Loading,        // loading OmniBridge.dll (starts the .NET runtime)
+    Connecting,     // opening and configuring the COM port, retried
+    Streaming,
+    Lost,           // connected, but no samples for a while
+    Failed          // OmniBridge.dll unusable - loading is retried
+};
+const char* TreadmillConnectionStateName(TreadmillConnectionState state);
 
 class TreadmillServerDriver : public vr::IServerTrackedDeviceProvider {
 public:
@@ -30,12 +43,59 @@ private:
     typedef void (*PFN_OmniReader_RegisterCallback)(void*, OmniDataCallback);
     typedef void (*PFN_OmniReader_Disconnect)(void*);
     typedef void (*PFN_OmniReader_Destroy)(void*);
+    typedef size_t (*PFN_OmniReader_Poll)(void*, OmniSample*, size_t, uint64_t*);
+    typedef bool (*PFN_OmniReader_EnablePods)(void*, bool);
+    typedef size_t (*PFN_OmniReader_PollPods)(void*, OmniPodSample*, size_t, uint64_t*);
+    typedef bool (*PFN_OmniReader_ConfigureBroadcast)(void*, const char*, int, int, int);
     
     PFN_OmniReader_Create pfnCreate = nullptr;
     PFN_OmniReader_Initialize pfnInitialize = nullptr;
     PFN_OmniReader_RegisterCallback pfnRegisterCallback = nullptr;
     PFN_OmniReader_Disconnect pfnDisconnect = nullptr;
     PFN_OmniReader_Destroy pfnDestroy = nullptr;
+    PFN_OmniReader_Poll pfnPoll = nullptr;  // optional, older OmniBridge builds lack it
+    uint64_t m_pollSequence = 0;
+    int64_t m_pollLastTimeUs = 0;  // previous polled sample, for RingDelta rates
+    PFN_OmniReader_EnablePods pfnEnablePods = nullptr;  // optional, pod quaternions for the foot trackers
+    PFN_OmniReader_PollPods pfnPollPods = nullptr;
+    uint64_t m_podSequence = 0;
+    PFN_OmniReader_ConfigureBroadcast pfnConfigureBroadcast = nullptr;  // optional, UDP/OSC broadcast
 
     std::unique_ptr<TreadmillVisualTracker> m_visualTracker;  // NEU!
+    std::unique_ptr<TreadmillFootTracker> m_feet[2];          // foot_trackers: left, right
+
+    // Timestamped samples published by OmniBridge, sampled at frame time
+    TreadmillSampleHistory m_history;
+    uint32_t m_historyRetryFrames = 0;
+    std::atomic<bool> m_historyAttach{ false };    // set by ConnectLoop, handled by PublishFrame
+    std::atomic<bool> m_historyDetach{ false };
+    int64_t m_historyLastTimeUs = 0;
+
+    uint32_t m_degradedTrackerFrames = 0;  // tracker update cadence while over budget
+
+    // Sampling, inputs and poses - from RunFrame, or from the publisher
+    // thread (publisher_thread) so they no longer follow vrserver's cadence
+    void PublishFrame();
+    void PublisherLoop();
+    std::thread m_publisher;
+    std::atomic<bool> m_publisherRunning{ false };
+
+    // OmniBridge is loaded and connected on m_connector so Init returns
+    // at once; the reader fields above are only used after m_readerReady
+    bool LoadOmniBridge();
+    void ConnectLoop();
+    bool TryConnect(int attempt, std::string& port);
+    void UpdateConnectionState(int64_t nowUs);
+    std::thread m_connector;
+    std::atomic<bool> m_connectorStop{ false };
+    std::atomic<bool> m_readerReady{ false };
+    std::mutex m_readerMutex;       // connection thread while (re)connecting, publishing thread per frame
+    std::string m_dllPath;
+    std::string m_comPort;
+    bool m_comPortRescan = false;   // also try other present ports
+    bool m_linkStalled = false;     // publishing thread: sample deadline missed
+    TreadmillBroadcastFormat m_broadcastFormat = TreadmillBroadcastFormat::Off;
+    std::string m_broadcastAddress = "127.0.0.1";
+    int m_broadcastPort = TreadmillBroadcastDefaultPort;
+    int m_broadcastRateHz = 90;
 };
\ No newline at end of file
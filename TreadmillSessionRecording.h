@@ -0,0 +1,155 @@
+#pragma once
+
+// ============================================================================
+// TreadmillSessionRecording - record a walk and read it back for replay
+// ============================================================================
+// A recording holds every sample that went through the filter chain, with
+// its timestamp and the chain's output at that moment, so a later build
+// can replay the same input and compare the output (DebugRequest "replay").
+//
+//   # settings <pipeline settings at record time>
+//   X,<timeUs>,<x>,<y>,<yaw>      (filter chain reset, EMA continues from x/y/yaw)
+//   S,<timeUs>,<ringAngle>,<gamePadX>,<gamePadY>,<cadence>,<outX>,<outY>,<outYaw>
+//   R,<timeUs>,<yawRate>          (Kalman rate measurement from RingDelta)
+//   L,<timeUs>                    (link stall, movement zeroed)
+//
+// outX/outY are the joystick values before speed_factor, outYaw the
+// smoothed yaw before the learned yaw offset. A recording starts with an X
+// row: the live chain is reset when recording starts, so a replay from a
+// fresh chain sees the same state.
+// ============================================================================
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct TreadmillSessionEvent {
+    enum Type { Sample, Rate, Reset, Stall } type = Sample;
+    int64_t timeUs = 0;
+    float ringAngle = 0.0f;     // Rate: yaw rate in degrees/second
+    float gamePadX = 0.0f;
+    float gamePadY = 0.0f;
+    float cadence = 0.0f;
+    float outX = 0.0f;
+    float outY = 0.0f;
+    float outYaw = 0.0f;
+};
+
+class TreadmillSessionRecorder {
+public:
+    ~TreadmillSessionRecorder() { Stop(); }
+
+    bool Start(const std::string& path, const std::string& settings) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CloseLocked();
+#ifdef _WIN32
+        if (fopen_s(&m_file, path.c_str(), "w") != 0) m_file = nullptr;
+#else
+        m_file = fopen(path.c_str(), "w");
+#endif
+        if (!m_file) return false;
+        fprintf(m_file, "# settings %s\n", settings.c_str());
+        m_events = 0;
+        m_recording.store(true);
+        return true;
+    }
+
+    // Returns the number of events written
+    uint64_t Stop() {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        CloseLocked();
+        return m_events;
+    }
+
+    // Cheap check for the hot path before building an event
+    bool IsRecording() const { return m_recording.load(std::memory_order_relaxed); }
+
+    void Write(const TreadmillSessionEvent& e) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_file) return;
+        if (e.type == TreadmillSessionEvent::Rate) {
+            fprintf(m_file, "R,%lld,%.9g\n", static_cast<long long>(e.timeUs), e.ringAngle);
+        } else if (e.type == TreadmillSessionEvent::Reset) {
+            fprintf(m_file, "X,%lld,%.9g,%.9g,%.9g\n", static_cast<long long>(e.timeUs), e.outX, e.outY, e.outYaw);
+        } else if (e.type == TreadmillSessionEvent::Stall) {
+            fprintf(m_file, "L,%lld\n", static_cast<long long>(e.timeUs));
+        } else {
+            fprintf(m_file, "S,%lld,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g,%.9g\n", static_cast<long long>(e.timeUs),
+                e.ringAngle, e.gamePadX, e.gamePadY, e.cadence, e.outX, e.outY, e.outYaw);
+        }
+        m_events++;
+    }
+
+    static bool Load(const std::string& path, std::vector<TreadmillSessionEvent>& events, std::string& settings) {
+        std::ifstream file(path);
+        if (!file.is_open()) return false;
+
+        events.clear();
+        settings.clear();
+        std::string line;
+        while (std::getline(file, line)) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            if (line.rfind("# settings ", 0) == 0) {
+                settings = line.substr(11);
+                continue;
+            }
+            if (line.size() < 2 || line[1] != ',') continue;
+
+            std::istringstream fields(line.substr(2));
+            std::string field;
+            std::vector<std::string> values;
+            while (std::getline(fields, field, ',')) values.push_back(field);
+
+            TreadmillSessionEvent e;
+            try {
+                if (line[0] == 'S' && values.size() == 8) {
+                    e.type = TreadmillSessionEvent::Sample;
+                    e.timeUs = std::stoll(values[0]);
+                    e.ringAngle = std::stof(values[1]);
+                    e.gamePadX = std::stof(values[2]);
+                    e.gamePadY = std::stof(values[3]);
+                    e.cadence = std::stof(values[4]);
+                    e.outX = std::stof(values[5]);
+                    e.outY = std::stof(values[6]);
+                    e.outYaw = std::stof(values[7]);
+                } else if (line[0] == 'R' && values.size() == 2) {
+                    e.type = TreadmillSessionEvent::Rate;
+                    e.timeUs = std::stoll(values[0]);
+                    e.ringAngle = std::stof(values[1]);
+                } else if (line[0] == 'X' && values.size() == 4) {
+                    e.type = TreadmillSessionEvent::Reset;
+                    e.timeUs = std::stoll(values[0]);
+                    e.outX = std::stof(values[1]);
+                    e.outY = std::stof(values[2]);
+                    e.outYaw = std::stof(values[3]);
+                } else if (line[0] == 'L' && values.size() == 1) {
+                    e.type = TreadmillSessionEvent::Stall;
+                    e.timeUs = std::stoll(values[0]);
+                } else {
+                    continue;
+                }
+            } catch (...) {
+                continue;  // skip malformed lines
+            }
+            events.push_back(e);
+        }
+        return true;
+    }
+
+private:
+    std::mutex m_mutex;
+    FILE* m_file = nullptr;
+    uint64_t m_events = 0;
+    std::atomic<bool> m_recording{ false };
+
+    void CloseLocked() {
+        m_recording.store(false);
+        if (m_file) fclose(m_file);
+        m_file = nullptr;
+    }
+};
@@ -0,0 +1,338 @@
+#pragma once
+
+// ============================================================================
+// TreadmillSharedRegion - portable access to OmniBridge's shared memory
+// ============================================================================
+// Same layout as OmniBridge/TreadmillSharedMemory.cs (version 3), so native
+// producers and consumers interoperate with OmniBridge on Windows and can run
+// the same multi-process topology on Linux:
+//
+//   Windows: named file mapping "Local\OmniTreadmillData". OmniBridge does
+//            not signal, so WaitForUpdate() polls at 1 ms.
+//   Linux:   POSIX shared memory "/OmniTreadmillData" (shm_open + mmap).
+//            Publish() wakes consumers through a futex on the low 32 bits
+//            of UpdateCount; WaitForUpdate() sleeps on it.
+//
+// Producers: Create() + Publish() (+ RenewLease() while idle).
+// Consumers: Open() + WaitForUpdate() / Read<T>() / IsLeaseExpired().
+// ============================================================================
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <climits>
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+struct TreadmillSample {
+    int64_t timeUs = 0;         // steady_clock / QPC microseconds
+    float yaw = 0.0f;           // ring angle in degrees [0, 360)
+    float gamePadX = 127.0f;    // raw pad value 0..255, 127 = center
+    float gamePadY = 127.0f;
+};
+
+class TreadmillSharedRegion {
+public:
+    // Mirrors TreadmillSharedMemory.SharedData / HistorySample (Pack = 1)
+    static constexpr uint32_t Magic = 0x4F4D4E49;  // 'OMNI'
+    static constexpr uint32_t Version = 3;
+    static constexpr size_t OffsetMagic = 0;
+    static constexpr size_t OffsetVersion = 4;
+    static constexpr size_t OffsetX = 8;
+    static constexpr size_t OffsetY = 12;
+    static constexpr size_t OffsetYaw = 16;
+    static constexpr size_t OffsetRawX = 20;
+    static constexpr size_t OffsetRawY = 24;
+    static constexpr size_t OffsetConnected = 28;
+    static constexpr size_t OffsetLastUpdate = 32;
+    static constexpr size_t OffsetUpdateCount = 40;
+    static constexpr size_t OffsetMasterPid = 48;
+    static constexpr size_t OffsetHeartbeat = 52;
+    static constexpr size_t OffsetLeaseExpiry = 60;
+    static constexpr size_t OffsetHistoryHead = 68;
+
+    static constexpr size_t HistoryOffset = 128;
+    static constexpr int HistoryCapacity = 64;
+    static constexpr size_t SlotSize = 48;
+    static constexpr size_t SlotSeq = 0;
+    static constexpr size_t SlotTimestamp = 8;
+    static constexpr size_t SlotX = 16;
+    static constexpr size_t SlotY = 20;
+    static constexpr size_t SlotYaw = 24;
+    static constexpr size_t SlotRawX = 28;
+    static constexpr size_t SlotRawY = 32;
+
+    static constexpr size_t Size = HistoryOffset + HistoryCapacity * SlotSize;
+    static constexpr int64_t LeaseDurationMs = 25;
+
+#ifdef _WIN32
+    using NameChar = wchar_t;
+    static constexpr const wchar_t* DefaultName = L"Local\\OmniTreadmillData";
+#else
+    using NameChar = char;
+    static constexpr const char* DefaultName = "/OmniTreadmillData";
+#endif
+
+    // Benches and tests pass their own name so they never touch a live OmniBridge
+    explicit TreadmillSharedRegion(const NameChar* name = DefaultName) : m_name(name) {}
+    ~TreadmillSharedRegion() { Close(); }
+    TreadmillSharedRegion(const TreadmillSharedRegion&) = delete;
+    TreadmillSharedRegion& operator=(const TreadmillSharedRegion&) = delete;
+
+    // Lease clock: Environment.TickCount64 in OmniBridge (uptime ms on Windows,
+    // CLOCK_MONOTONIC ms on Linux) - identical in all processes
+    static int64_t TickCountMs() {
+#ifdef _WIN32
+        return static_cast<int64_t>(GetTickCount64());
+#else
+        timespec ts{};
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+#endif
+    }
+
+    // Producer: create (or reuse) the region and take over as master.
+    // An existing history is continued so consumer cursors stay valid.
+    bool Create() {
+        if (m_view) return m_writable;
+#ifdef _WIN32
+        m_mapping = CreateFileMappingW(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, static_cast<DWORD>(Size), m_name);
+        if (!m_mapping) return false;
+        m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size));
+#else
+        int fd = shm_open(m_name, O_CREAT | O_RDWR, 0600);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || (static_cast<size_t>(st.st_size) < Size && ftruncate(fd, Size) != 0)) {
+            close(fd);
+            return false;
+        }
+        void* view = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        m_view = view == MAP_FAILED ? nullptr : static_cast<uint8_t*>(view);
+#endif
+        if (!m_view) {
+            Close();
+            return false;
+        }
+        m_writable = true;
+
+        int64_t historyHead = 0;
+        if (Read<uint32_t>(OffsetMagic) == Magic && Read<uint32_t>(OffsetVersion) >= 3) {
+            historyHead = Read<int64_t>(OffsetHistoryHead);
+        }
+
+        Write<uint32_t>(OffsetVersion, Version);
+        Write<float>(OffsetX, 0.0f);
+        Write<float>(OffsetY, 0.0f);
+        Write<float>(OffsetYaw, 0.0f);
+        Write<int32_t>(OffsetRawX, 127);
+        Write<int32_t>(OffsetRawY, 127);
+        Write<uint32_t>(OffsetConnected, 0);
+        Write<int64_t>(OffsetLastUpdate, 0);
+        Write<uint32_t>(OffsetMasterPid, CurrentPid());
+        Write<int64_t>(OffsetHistoryHead, historyHead);
+        RenewLease();
+        std::atomic_thread_fence(std::memory_order_release);
+        Write<uint32_t>(OffsetMagic, Magic);
+        return true;
+    }
+
+    // Consumer: attach read-only. Fails without a version 3 producer.
+    bool Open() {
+        if (m_view) return true;
+#ifdef _WIN32
+        m_mapping = OpenFileMappingW(FILE_MAP_READ, FALSE, m_name);
+        if (!m_mapping) return false;
+        m_view = static_cast<uint8_t*>(MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0));
+#else
+        int fd = shm_open(m_name, O_RDONLY, 0);
+        if (fd < 0) return false;
+        struct stat st{};
+        void* view = MAP_FAILED;
+        if (fstat(fd, &st) == 0 && static_cast<size_t>(st.st_size) >= Size) {
+            view = mmap(nullptr, Size, PROT_READ, MAP_SHARED, fd, 0);
+        }
+        close(fd);
+        m_view = view == MAP_FAILED ? nullptr : static_cast<uint8_t*>(view);
+#endif
+        // Version 3 producers always create the region with room for the ring
+        if (!m_view || Read<uint32_t>(OffsetMagic) != Magic || Read<uint32_t>(OffsetVersion) < 3) {
+            Close();
+            return false;
+        }
+        m_writable = false;
+        return true;
+    }
+
+    void Close() {
+        if (m_view && m_writable) SetDisconnected();
+#ifdef _WIN32
+        if (m_view) UnmapViewOfFile(m_view);
+        if (m_mapping) CloseHandle(m_mapping);
+        m_mapping = nullptr;
+#else
+        if (m_view) munmap(m_view, Size);
+#endif
+        m_view = nullptr;
+        m_writable = false;
+    }
+
+    bool IsOpen() const { return m_view != nullptr; }
+
+    // Linux: drop the name once the run is over (mapped views stay valid).
+    // Windows frees the mapping with its last handle, so there is nothing to do.
+    static void Remove(const NameChar* name) {
+#ifndef _WIN32
+        shm_unlink(name);
+#else
+        (void)name;
+#endif
+    }
+
+    // volatile: the other side lives in another process, never cache these accesses.
+    // Fields are packed (Pack = 1), so x64 accesses one in one go only if it stays
+    // within a cache line. All do except LeaseExpiry (bytes 60-67), which straddles
+    // the first line and may be read half old, half new - see IsLeaseExpired.
+    template <typename T>
+    T Read(size_t offset) const {
+        return *reinterpret_cast<const volatile T*>(m_view + offset);
+    }
+
+    uint64_t UpdateCount() const {
+        return static_cast<uint64_t>(Read<int64_t>(OffsetUpdateCount));
+    }
+
+    // Append one sample to the history ring and update the latest-value header
+    // (producer only, single writer). x/y are the processed stick values.
+    void Publish(const TreadmillSample& s, float x, float y) {
+        if (!m_writable) return;
+
+        int64_t index = Read<int64_t>(OffsetHistoryHead);
+        size_t slot = HistoryOffset + static_cast<size_t>(index % HistoryCapacity) * SlotSize;
+
+        // Odd sequence first, so a reader racing this write discards the slot
+        Write<int64_t>(slot + SlotSeq, 2 * index + 1);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Write<int64_t>(slot + SlotTimestamp, s.timeUs);
+        Write<float>(slot + SlotX, x);
+        Write<float>(slot + SlotY, y);
+        Write<float>(slot + SlotYaw, s.yaw);
+        Write<int32_t>(slot + SlotRawX, static_cast<int32_t>(s.gamePadX));
+        Write<int32_t>(slot + SlotRawY, static_cast<int32_t>(s.gamePadY));
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Write<int64_t>(slot + SlotSeq, 2 * index + 2);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Write<int64_t>(OffsetHistoryHead, index + 1);
+
+        Write<float>(OffsetX, x);
+        Write<float>(OffsetY, y);
+        Write<float>(OffsetYaw, s.yaw);
+        Write<int32_t>(OffsetRawX, static_cast<int32_t>(s.gamePadX));
+        Write<int32_t>(OffsetRawY, static_cast<int32_t>(s.gamePadY));
+        Write<uint32_t>(OffsetConnected, 1);
+        Write<int64_t>(OffsetLastUpdate, std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count());
+        RenewLease();
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Write<int64_t>(OffsetUpdateCount, Read<int64_t>(OffsetUpdateCount) + 1);
+        WakeConsumers();
+    }
+
+    // Producers without a steady packet stream must call this every few ms
+    void RenewLease() {
+        if (!m_writable) return;
+        int64_t now = TickCountMs();
+        Write<int64_t>(OffsetHeartbeat, now);
+        Write<int64_t>(OffsetLeaseExpiry, now + LeaseDurationMs);
+    }
+
+    // Release the lease so consumers notice immediately (producer only)
+    void SetDisconnected() {
+        if (!m_writable) return;
+        Write<uint32_t>(OffsetConnected, 0);
+        Write<uint32_t>(OffsetMasterPid, 0);
+        Write<int64_t>(OffsetLeaseExpiry, 0);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Write<int64_t>(OffsetUpdateCount, Read<int64_t>(OffsetUpdateCount) + 1);
+        WakeConsumers();
+    }
+
+    // A crashed or stalled producer stops renewing its lease. LeaseExpiry crosses
+    // a cache line, so a renewal (or release) can be seen half done: read until
+    // two reads agree.
+    bool IsLeaseExpired() const {
+        if (!m_view) return false;
+        int64_t expiry = Read<int64_t>(OffsetLeaseExpiry);
+        for (int64_t again; (again = Read<int64_t>(OffsetLeaseExpiry)) != expiry;) expiry = again;
+        return expiry <= TickCountMs();
+    }
+
+    // Block until UpdateCount differs from lastCount or timeoutMs passes.
+    // Returns true if there was an update.
+    bool WaitForUpdate(uint64_t lastCount, uint32_t timeoutMs) const {
+        if (!m_view) return false;
+        if (UpdateCount() != lastCount) return true;
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+#ifdef _WIN32
+        while (UpdateCount() == lastCount) {
+            if (std::chrono::steady_clock::now() >= deadline) return false;
+            Sleep(1);
+        }
+        return true;
+#else
+        // The futex word is the low half of UpdateCount (little endian)
+        auto* word = reinterpret_cast<uint32_t*>(m_view + OffsetUpdateCount);
+        uint32_t expected = static_cast<uint32_t>(lastCount);
+        while (UpdateCount() == lastCount) {
+            auto left = deadline - std::chrono::steady_clock::now();
+            if (left <= std::chrono::steady_clock::duration::zero()) return false;
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+            timespec ts{ static_cast<time_t>(ns / 1000000000), static_cast<long>(ns % 1000000000) };
+            // Shared (not PRIVATE) futex: waiter and waker are different processes
+            syscall(SYS_futex, word, FUTEX_WAIT, expected, &ts, nullptr, 0);
+        }
+        return true;
+#endif
+    }
+
+private:
+    const NameChar* m_name;
+#ifdef _WIN32
+    HANDLE m_mapping = nullptr;
+#endif
+    uint8_t* m_view = nullptr;
+    bool m_writable = false;
+
+    template <typename T>
+    void Write(size_t offset, T value) {
+        *reinterpret_cast<volatile T*>(m_view + offset) = value;
+    }
+
+    void WakeConsumers() {
+#ifndef _WIN32
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(m_view + OffsetUpdateCount), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#endif
+    }
+
+    static uint32_t CurrentPid() {
+#ifdef _WIN32
+        return static_cast<uint32_t>(GetCurrentProcessId());
+#else
+        return static_cast<uint32_t>(getpid());
+#endif
+    }
+};
@@ -0,0 +1,449 @@
+// ============================================================================
+// TreadmillSharedRegionTests - producer and consumer in separate processes
+// ============================================================================
+// Starts producers as copies of itself (--producer) on a private region name
+// (never OmniBridge's) and checks the consumer side of TreadmillSharedRegion
+// and TreadmillSampleHistory from this process:
+//
+//   torn       the producer publishes flat out; every sample Snapshot returns
+//              must be whole (all fields from the same index) and every
+//              LeaseExpiry read must be 0 or near the lease clock
+//   wakeup     the producer publishes at 500 Hz; WaitForUpdate must return
+//              within --max-wakeup-p99-us of the producer's stamp (p99), and
+//              the producer's Close must show as an expired lease at once
+//   crash      the producer publishes at 1 kHz and dies without releasing
+//              the lease; IsLeaseExpired must turn true LeaseDurationMs after
+//              its last sample, give or take the lease clock's granularity
+//   failover   (Windows, not part of all) two OmniBridge readers (--reader)
+//              on a treadmill; the master is killed and the consumer must
+//              hold the lease again within --max-takeover-ms
+//
+//   TreadmillSharedRegionTests.exe [--test <torn|wakeup|crash|failover|all>]
+//                                  [--max-wakeup-p99-us <n>]
+//                                  [--omnibridge <path>] [--com <port>] [--baud <n>]
+//                                  [--max-takeover-ms <n>]
+//
+// Exit code 0 if every test passes, 1 on a failure, 2 if a test could not run.
+// ============================================================================
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#define popen _popen
+#define pclose _pclose
+#endif
+
+#include "../TreadmillLatencyStats.h"
+#include "../TreadmillSampleHistory.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+static const wchar_t* RegionName = L"Local\\OmniTreadmillRegionTests";
+static constexpr int64_t TickGranularityMs = 16;       // GetTickCount64 follows the 15.6 ms system tick
+static constexpr int64_t DefaultMaxWakeupP99Us = 20000; // WaitForUpdate polls with Sleep(1)
+#else
+static const char* RegionName = "/OmniTreadmillRegionTests";
+static constexpr int64_t TickGranularityMs = 1;
+static constexpr int64_t DefaultMaxWakeupP99Us = 2000;
+#endif
+
+static constexpr int64_t SlackMs = 5;                   // scheduling on a loaded machine
+
+static std::string SelfPath() {
+    char path[4096] = {};
+#ifdef _WIN32
+    GetModuleFileNameA(nullptr, path, sizeof(path));
+#else
+    ssize_t length = readlink("/proc/self/exe", path, sizeof(path) - 1);
+    if (length > 0) path[length] = '\0';
+#endif
+    return path;
+}
+
+static int64_t NowUs() {
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Every field of sample n derives from n, so a sample mixed from two is visible
+static TreadmillSample PatternSample(int64_t n) {
+    TreadmillSample s;
+    s.timeUs = n * 10 + 7;
+    s.yaw = static_cast<float>(n % 360);
+    s.gamePadX = static_cast<float>(n % 251);
+    s.gamePadY = static_cast<float>(n % 241);
+    return s;
+}
+
+static bool IsPatternSample(const TreadmillSample& s) {
+    if (s.timeUs < 7 || (s.timeUs - 7) % 10 != 0) return false;
+    TreadmillSample expected = PatternSample((s.timeUs - 7) / 10);
+    return s.yaw == expected.yaw && s.gamePadX == expected.gamePadX && s.gamePadY == expected.gamePadY;
+}
+
+// ----------------------------------------------------------------------------
+// Producer process
+// ----------------------------------------------------------------------------
+
+// --producer <pattern|clock> <rate hz, 0 = flat out> <milliseconds> <close|crash>
+static int RunProducer(const char* kind, int rateHz, int durationMs, const char* end) {
+    TreadmillSharedRegion region(RegionName);
+    if (!region.Create()) return 2;
+    bool pattern = strcmp(kind, "pattern") == 0;
+    auto start = std::chrono::steady_clock::now();
+    auto until = start + std::chrono::milliseconds(durationMs);
+    int64_t n = 0;
+    for (auto next = start; std::chrono::steady_clock::now() < until; n++) {
+        TreadmillSample s = pattern ? PatternSample(n) : TreadmillSample{};
+        if (!pattern) s.timeUs = NowUs();
+        region.Publish(s, 0.0f, 0.0f);
+        if (rateHz > 0) {
+            next += std::chrono::microseconds(1000000 / rateHz);
+            std::this_thread::sleep_until(next);
+        }
+    }
+    printf("%lld\n", static_cast<long long>(n));
+    fflush(stdout);
+    if (strcmp(end, "crash") == 0) _Exit(3);   // no Close: the lease stays as last renewed
+    region.Close();
+    return 0;
+}
+
+#ifdef _WIN32
+typedef void* (*PFN_OmniReader_Create)();
+typedef bool (*PFN_OmniReader_Initialize)(void*, const char*, int, int);
+typedef void (*PFN_OmniReader_Destroy)(void*);
+
+// --reader <OmniBridge.dll> <COM port> <baud> <milliseconds>: one OmniBridge
+// reader, master or consumer as OmniBridge decides, as a driver or game holds it
+static int RunReader(const char* dllPath, const char* comPort, int baudRate, int durationMs) {
+    HMODULE dll = LoadLibraryA(dllPath);
+    if (!dll) return 2;
+    auto create = reinterpret_cast<PFN_OmniReader_Create>(GetProcAddress(dll, "OmniReader_Create"));
+    auto initialize = reinterpret_cast<PFN_OmniReader_Initialize>(GetProcAddress(dll, "OmniReader_Initialize"));
+    auto destroy = reinterpret_cast<PFN_OmniReader_Destroy>(GetProcAddress(dll, "OmniReader_Destroy"));
+    if (!create || !initialize || !destroy) return 2;
+
+    void* reader = create();
+    bool initialized = reader && initialize(reader, comPort, 0, baudRate);
+    printf("%lu %d\n", GetCurrentProcessId(), initialized ? 1 : 0);
+    fflush(stdout);
+    if (initialized) Sleep(durationMs);
+    if (reader) destroy(reader);
+    return initialized ? 0 : 2;
+}
+#endif
+
+// ----------------------------------------------------------------------------
+// Tests (consumer side)
+// ----------------------------------------------------------------------------
+
+struct Producer {
+    FILE* pipe = nullptr;
+
+    bool Start(const char* kind, int rateHz, int durationMs, const char* end) {
+        TreadmillSharedRegion::Remove(RegionName);  // a crashed run's region would be continued
+        std::string command = "\"" + SelfPath() + "\" --producer " + kind + " " + std::to_string(rateHz) + " " +
+            std::to_string(durationMs) + " " + end;
+#ifdef _WIN32
+        command = "\"" + command + "\"";            // cmd /c strips the outer quotes
+#endif
+        pipe = popen(command.c_str(), "r");
+        return pipe != nullptr;
+    }
+
+    // Samples the producer published; -1 if it printed nothing
+    long long Finish(int* exitCode = nullptr) {
+        long long published = -1;
+        if (!pipe) return published;
+        if (fscanf(pipe, "%lld", &published) != 1) published = -1;
+        int status = pclose(pipe);
+        pipe = nullptr;
+#ifndef _WIN32
+        if (WIFEXITED(status)) status = WEXITSTATUS(status);
+#endif
+        if (exitCode) *exitCode = status;
+        return published;
+    }
+};
+
+#ifdef _WIN32
+// One --reader process; Start returns once OmniBridge initialized it
+struct Reader {
+    FILE* pipe = nullptr;
+    DWORD pid = 0;
+
+    bool Start(const std::string& dllPath, const std::string& comPort, int baudRate, int durationMs) {
+        std::string command = "\"\"" + SelfPath() + "\" --reader \"" + dllPath + "\" " + comPort + " " +
+            std::to_string(baudRate) + " " + std::to_string(durationMs) + "\"";
+        pipe = popen(command.c_str(), "r");
+        unsigned long readerPid = 0;
+        int initialized = 0;
+        if (!pipe || fscanf(pipe, "%lu %d", &readerPid, &initialized) != 2) return false;
+        pid = readerPid;
+        return initialized != 0;
+    }
+
+    // What a crashing game or Task Manager does: no Disconnect, no lease release
+    void Kill() {
+        HANDLE process = OpenProcess(PROCESS_TERMINATE, FALSE, pid);
+        if (!process) return;
+        TerminateProcess(process, 3);
+        CloseHandle(process);
+    }
+
+    void Finish() {
+        if (pipe) pclose(pipe);
+        pipe = nullptr;
+    }
+};
+#endif
+
+static bool OpenRegion(TreadmillSampleHistory& history) {
+    for (int waitedMs = 0; !history.Open(); waitedMs++) {
+        if (waitedMs >= 5000) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+struct Options {
+    std::string test = "all";
+    int64_t maxWakeupP99Us = DefaultMaxWakeupP99Us;
+    std::string omniBridge;                             // empty = OmniBridge.dll next to this executable
+    std::string comPort = "COM3";
+    int baudRate = 115200;
+    int64_t maxTakeoverMs = 50;
+};
+
+static int TestTorn(const Options&) {
+    Producer producer;
+    TreadmillSampleHistory history(RegionName);
+    if (!producer.Start("pattern", 0, 2000, "close") || !OpenRegion(history)) {
+        fprintf(stderr, "torn: producer did not start\n");
+        producer.Finish();
+        return 2;
+    }
+    const TreadmillSharedRegion& region = history.Region();
+    TreadmillSample samples[TreadmillSampleHistory::Capacity];
+    uint64_t checked = 0, torn = 0, leaseReads = 0, badLeases = 0;
+    while (region.Read<uint32_t>(TreadmillSharedRegion::OffsetMasterPid) != 0) {
+        int count = history.Snapshot(samples, TreadmillSampleHistory::Capacity);
+        for (int i = 0; i < count; i++) {
+            if (!IsPatternSample(samples[i])) torn++;
+        }
+        checked += count;
+
+        int64_t expiry = region.Read<int64_t>(TreadmillSharedRegion::OffsetLeaseExpiry);
+        int64_t now = TreadmillSharedRegion::TickCountMs();
+        if (expiry != 0 && std::llabs(expiry - now) > 1000) badLeases++;
+        leaseReads++;
+    }
+    long long published = producer.Finish();
+    printf("torn: %lld published, %llu samples checked, %llu torn; %llu lease reads, %llu out of range\n",
+        published, static_cast<unsigned long long>(checked), static_cast<unsigned long long>(torn),
+        static_cast<unsigned long long>(leaseReads), static_cast<unsigned long long>(badLeases));
+    if (published <= 0 || checked == 0) return 2;
+    return torn == 0 && badLeases == 0 ? 0 : 1;
+}
+
+static int TestWakeup(const Options& options) {
+    Producer producer;
+    TreadmillSampleHistory history(RegionName);
+    if (!producer.Start("clock", 500, 2000, "close") || !OpenRegion(history)) {
+        fprintf(stderr, "wakeup: producer did not start\n");
+        producer.Finish();
+        return 2;
+    }
+    const TreadmillSharedRegion& region = history.Region();
+    TreadmillLatencyStats latency;
+    uint64_t last = region.UpdateCount();
+    int64_t releaseSeenUs = -1;
+    while (true) {
+        if (!region.WaitForUpdate(last, 1000)) break;
+        int64_t nowUs = NowUs();
+        last = region.UpdateCount();
+        if (region.Read<uint32_t>(TreadmillSharedRegion::OffsetMasterPid) == 0) {
+            // Close: the release bumps UpdateCount with the lease already at 0
+            releaseSeenUs = region.IsLeaseExpired() ? 0 : -1;
+            break;
+        }
+        TreadmillSample newest;
+        if (history.Snapshot(&newest, 1) == 1) latency.Record(nowUs - newest.timeUs);
+    }
+    long long published = producer.Finish();
+    TreadmillLatencyStats::Summary s = latency.GetSummary();
+    printf("wakeup: %lld published, %llu woken, p50 %lld us, p99 %lld us, max %lld us (max p99 %lld); release %s\n",
+        published, static_cast<unsigned long long>(s.count), static_cast<long long>(s.p50Us),
+        static_cast<long long>(s.p99Us), static_cast<long long>(s.maxUs), static_cast<long long>(options.maxWakeupP99Us),
+        releaseSeenUs == 0 ? "seen as expired" : "NOT seen as expired");
+    if (published <= 0 || s.count == 0) return 2;
+    return s.p99Us <= options.maxWakeupP99Us && releaseSeenUs == 0 ? 0 : 1;
+}
+
+static int TestCrash(const Options&) {
+    Producer producer;
+    TreadmillSampleHistory history(RegionName);
+    if (!producer.Start("clock", 1000, 300, "crash") || !OpenRegion(history)) {
+        fprintf(stderr, "crash: producer did not start\n");
+        producer.Finish();
+        return 2;
+    }
+    const TreadmillSharedRegion& region = history.Region();
+
+    // The lease as the producer last renewed it, and when we saw that renewal
+    uint64_t last = region.UpdateCount();
+    auto lastUpdate = std::chrono::steady_clock::now();
+    while (!region.IsLeaseExpired()) {
+        uint64_t count = region.UpdateCount();
+        if (count != last) {
+            last = count;
+            lastUpdate = std::chrono::steady_clock::now();
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    double detectMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - lastUpdate).count();
+    int exitCode = 0;
+    long long published = producer.Finish(&exitCode);
+    bool released = region.Read<uint32_t>(TreadmillSharedRegion::OffsetMasterPid) == 0;
+
+    double minMs = static_cast<double>(TreadmillSharedRegion::LeaseDurationMs - TickGranularityMs - 1);
+    double maxMs = static_cast<double>(TreadmillSharedRegion::LeaseDurationMs + TickGranularityMs + SlackMs);
+    printf("crash: %lld published, exit %d, lease expired %.1f ms after the last sample (%.0f..%.0f)%s\n",
+        published, exitCode, detectMs, minMs, maxMs, released ? " - but the lease was released" : "");
+    if (published <= 0) return 2;
+    return !released && detectMs >= minMs && detectMs <= maxMs ? 0 : 1;
+}
+
+// Runs against OmniBridge's own region, so nothing else may be using the treadmill
+static int TestFailover(const Options& options) {
+#ifndef _WIN32
+    (void)options;
+    fprintf(stderr, "failover: needs Windows, OmniBridge.dll and a treadmill\n");
+    return 2;
+#else
+    TreadmillSampleHistory history;
+    if (history.Open() && !history.Region().IsLeaseExpired()) {
+        fprintf(stderr, "failover: an OmniBridge master is already running - close SteamVR and games first\n");
+        return 2;
+    }
+    history.Close();
+
+    std::string dllPath = options.omniBridge;
+    if (dllPath.empty()) dllPath = SelfPath().substr(0, SelfPath().find_last_of("\\/") + 1) + "OmniBridge.dll";
+
+    // The master is killed long before its time is up; the consumer outlives the measurement
+    Reader master, consumer;
+    bool started = master.Start(dllPath, options.comPort, options.baudRate, 60000) && OpenRegion(history);
+    const TreadmillSharedRegion& region = history.Region();
+    for (int waitedMs = 0; started && region.Read<int64_t>(TreadmillSharedRegion::OffsetHistoryHead) == 0; waitedMs++) {
+        if (waitedMs >= 5000) started = false;      // no motion data: the treadmill is off or elsewhere
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    started = started && region.Read<uint32_t>(TreadmillSharedRegion::OffsetMasterPid) == master.pid &&
+        consumer.Start(dllPath, options.comPort, options.baudRate, 5000);
+    if (!started) {
+        fprintf(stderr, "failover: no master streaming from %s with %s\n", options.comPort.c_str(), dllPath.c_str());
+        master.Kill();
+        master.Finish();
+        consumer.Finish();
+        return 2;
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));   // the consumer thread is polling
+
+    int64_t killUs = NowUs();
+    master.Kill();
+    int64_t expiredUs = -1, takeoverUs = -1, sampleUs = -1, headAtTakeover = 0;
+    while (sampleUs < 0 && NowUs() - killUs < 2000000) {
+        int64_t sinceKillUs = NowUs() - killUs;
+        bool expired = region.IsLeaseExpired();
+        if (expiredUs < 0 && expired) expiredUs = sinceKillUs;
+        if (takeoverUs < 0 && !expired && region.Read<uint32_t>(TreadmillSharedRegion::OffsetMasterPid) == consumer.pid) {
+            takeoverUs = sinceKillUs;
+            headAtTakeover = region.Read<int64_t>(TreadmillSharedRegion::OffsetHistoryHead);
+        }
+        if (takeoverUs >= 0 && region.Read<int64_t>(TreadmillSharedRegion::OffsetHistoryHead) > headAtTakeover) {
+            sampleUs = sinceKillUs;
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    master.Finish();
+    consumer.Finish();
+
+    // The last renewal came at most LeaseDurationMs before expiry; the lease
+    // clock moves in steps of its granularity
+    int64_t maxExpiryMs = TreadmillSharedRegion::LeaseDurationMs + TickGranularityMs + SlackMs;
+    printf("failover: lease expired %.1f ms after the kill (max %lld), consumer took over at %.1f ms (max %lld), "
+        "first sample at %.1f ms\n",
+        expiredUs / 1000.0, static_cast<long long>(maxExpiryMs), takeoverUs / 1000.0,
+        static_cast<long long>(options.maxTakeoverMs), sampleUs / 1000.0);
+    if (expiredUs < 0 || takeoverUs < 0) return 1;
+    return expiredUs <= maxExpiryMs * 1000 && takeoverUs <= options.maxTakeoverMs * 1000 ? 0 : 1;
+#endif
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillSharedRegionTests.exe [--test <torn|wakeup|crash|failover|all>]\n");
+    printf("                                      [--max-wakeup-p99-us <n>]\n");
+    printf("                                      [--omnibridge <path>] [--com <port>] [--baud <n>]\n");
+    printf("                                      [--max-takeover-ms <n>]\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc == 6 && strcmp(argv[1], "--producer") == 0) {
+        return RunProducer(argv[2], atoi(argv[3]), atoi(argv[4]), argv[5]);
+    }
+#ifdef _WIN32
+    if (argc == 6 && strcmp(argv[1], "--reader") == 0) {
+        return RunReader(argv[2], argv[3], atoi(argv[4]), atoi(argv[5]));
+    }
+#endif
+
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--test") == 0 && i + 1 < argc) {
+            options.test = argv[++i];
+        } else if (strcmp(argv[i], "--max-wakeup-p99-us") == 0 && i + 1 < argc) {
+            options.maxWakeupP99Us = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--omnibridge") == 0 && i + 1 < argc) {
+            options.omniBridge = argv[++i];
+        } else if (strcmp(argv[i], "--com") == 0 && i + 1 < argc) {
+            options.comPort = argv[++i];
+        } else if (strcmp(argv[i], "--baud") == 0 && i + 1 < argc) {
+            options.baudRate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-takeover-ms") == 0 && i + 1 < argc) {
+            options.maxTakeoverMs = atoll(argv[++i]);
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+
+    struct Test { const char* name; int (*run)(const Options&); bool inAll; };
+    const Test tests[] = {
+        { "torn", TestTorn, true },
+        { "wakeup", TestWakeup, true },
+        { "crash", TestCrash, true },
+        { "failover", TestFailover, false },    // needs a treadmill
+    };
+    int result = 0;
+    bool ran = false;
+    for (const Test& t : tests) {
+        if (options.test == "all" ? !t.inAll : options.test != t.name) continue;
+        ran = true;
+        result = std::max(result, t.run(options));
+    }
+    TreadmillSharedRegion::Remove(RegionName);
+    if (!ran) {
+        PrintUsage();
+        return 2;
+    }
+    return result;
+}
@@ -0,0 +1,46 @@
+// ============================================================================
+// TreadmillSoak - shared by the driver, OpenXR layer and OpenVR wrapper phases
+// ============================================================================
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Live objects the fakes handed out; after teardown every count is back to 0
+struct SoakHandles {
+    std::atomic<int64_t> readers{ 0 };          // OmniReader_Create .. OmniReader_Destroy
+    std::atomic<int64_t> xrInstances{ 0 };
+    std::atomic<int64_t> xrSessions{ 0 };
+    std::atomic<int64_t> xrActionSets{ 0 };
+    std::atomic<int64_t> xrActions{ 0 };
+
+    int64_t Total() const {
+        return readers.load() + xrInstances.load() + xrSessions.load() + xrActionSets.load() + xrActions.load();
+    }
+};
+extern SoakHandles g_soakHandles;
+
+// Heap blocks allocated and not yet freed by the whole process (main.cpp
+// replaces the global operator new / delete)
+int64_t SoakLiveAllocations();
+
+// The executable, which is also the OmniBridge.dll of every module
+std::wstring SoakSelfPathW();
+
+// Advances the virtual clock by one 90 Hz frame and hands the walk's next
+// sample to every reader with a registered callback, as OmniBridge's serial
+// thread does for the layer and the wrapper
+void SoakFrame();
+
+// One OpenXR instance: a reader, then sessions that each create an action
+// set and its actions, sync and query them every frame and tear them down
+// again. Fills sessionGrowth with the live allocations gained from the
+// second to the last session (the first one fills lazy caches). False if
+// the layer did not connect to the reader.
+bool SoakOpenXrInstance(int sessions, int framesPerSession, int64_t& sessionGrowth);
+
+// One OpenVR session: a reader, the IVRInput wrapper, the game's action
+// handles and its per-frame analog queries, then VR_ShutdownInternal's reset.
+// False if the wrapper did not connect to the reader.
+bool SoakOpenVrSession(int framesPerSession);
@@ -0,0 +1,511 @@
+// ============================================================================
+// TreadmillSoak - hours of treadmill use in minutes, failing on growth
+// ============================================================================
+// Links the driver (driver_treadmill.cpp, TreadmillServerDriver.cpp on the
+// mock vrserver of ../TreadmillDriverTests/MockHost.h), the OpenXR layer's
+// interceptor and the OpenVR wrapper's IVRInput hooks into one process with
+// TREADMILL_VIRTUAL_CLOCK. The executable is the OmniBridge.dll of all three:
+// its OmniReader_* exports hand out counted readers that stream a synthetic
+// walk (OmniReader_Poll for the driver, the registered callback for the
+// layer and the wrapper).
+//
+// Every round, each module goes through the lifetimes a long play session
+// brings, and is torn down again:
+//
+//   driver    Init, --round-seconds of 90 Hz frames paced at --speed times
+//             real time, a DebugRequest "record" session, and halfway a
+//             3 s silence as when the OmniBridge master dies: the driver
+//             must report the link lost and reconnect. Then Cleanup.
+//   openxr    --xr-instances instances, each with a reader and
+//             --xr-sessions sessions that create an action set and its
+//             actions, sync and query them every frame and destroy them
+//   openvr    --vr-sessions VR sessions: a reader, the IVRInput wrapper,
+//             action handle lookups and analog queries every frame, then
+//             VR_ShutdownInternal's ResetActionTracking
+//
+// After every round the soak samples live heap blocks (it replaces the
+// global operator new / delete), resident memory, open handles (fds on
+// Linux) and the fakes' live readers, instances, sessions, action sets and
+// actions. It fails if
+//
+//   - any fake object is still alive after a round,
+//   - an OpenXR instance gains heap blocks from session to session,
+//   - heap blocks, resident memory or handles grow from the end of the
+//     warm-up rounds to the end of the run by more than --max-alloc-growth,
+//     --max-rss-growth-mb or --max-handle-growth.
+//
+//   TreadmillSoak.exe [--rounds <n>] [--warmup <n>] [--round-seconds <n>]
+//                     [--speed <x>] [--xr-instances <n>] [--xr-sessions <n>]
+//                     [--vr-sessions <n>] [--max-alloc-growth <n>]
+//                     [--max-rss-growth-mb <n>] [--max-handle-growth <n>]
+//                     [--json <file>]
+//
+// Defaults replay an hour (20 rounds of 180 s) at 100x. --speed 0 runs
+// unpaced. --json writes one object per round. Exit code 0 if nothing grew,
+// 1 on growth or a leaked object, 2 if the soak could not run.
+// ============================================================================
+
+#include "../TreadmillDriverTests/MockHost.h"
+#include "../MinimalOmniReader.h"
+#include "../TreadmillServerDriver.h"
+#include "../TreadmillSampleHistory.h"
+#include "Soak.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <new>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <psapi.h>
+#else
+#include <dirent.h>
+#endif
+
+extern "C" void* HmdDriverFactory(const char* pInterfaceName, int* pReturnCode);
+extern std::atomic<TreadmillConnectionState> g_connectionState;
+
+static constexpr int64_t FrameUs = 11111;               // 90 Hz
+static constexpr int64_t SampleUs = 16667;              // 60 Hz, as OmniBridge's serial thread
+static constexpr int64_t MasterLossUs = 3000000;        // longer than the driver's ConnectionLostAfterUs
+static constexpr int64_t SessionSlackBlocks = 2;        // per OpenXR instance, sessions 2..n
+
+SoakHandles g_soakHandles;
+
+// ----------------------------------------------------------------------------
+// Heap accounting: every allocation of the process goes through here
+// ----------------------------------------------------------------------------
+
+static std::atomic<int64_t> g_liveAllocations{ 0 };
+
+void* operator new(size_t size) {
+    void* p = malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    g_liveAllocations.fetch_add(1, std::memory_order_relaxed);
+    return p;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    if (!p) return;
+    g_liveAllocations.fetch_sub(1, std::memory_order_relaxed);
+    free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    operator delete(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+void operator delete[](void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+int64_t SoakLiveAllocations() {
+    return g_liveAllocations.load();
+}
+
+// ----------------------------------------------------------------------------
+// OmniBridge stand-in: any number of readers, each streaming the same walk
+// ----------------------------------------------------------------------------
+
+struct SoakReader {
+    bool connected = false;
+    int64_t nextUs = 0;             // virtual time of the next sample
+    uint64_t sequence = 0;
+    OmniDataCallback callback = nullptr;
+};
+
+static std::mutex g_readersMutex;
+static std::vector<SoakReader*> g_readers;
+static std::atomic<int64_t> g_silentFromUs{ 0 };        // the master is gone in [from, until)
+static std::atomic<int64_t> g_silentUntilUs{ 0 };
+static uint64_t g_callbackSample = 0;
+
+// Walking at a varying speed while turning
+static void WalkSample(uint64_t n, float& angle, int& x, int& y) {
+    double t = static_cast<double>(n);
+    angle = static_cast<float>(std::fmod(t * 0.7, 360.0));
+    x = 127 + static_cast<int>(std::lround(60.0 * std::sin(t * 0.013)));
+    y = 127 + static_cast<int>(std::lround(100.0 * std::cos(t * 0.007)));
+}
+
+extern "C" __declspec(dllexport) void* OmniReader_Create() {
+    SoakReader* reader = new SoakReader();
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    g_readers.push_back(reader);
+    g_soakHandles.readers.fetch_add(1);
+    return reader;
+}
+
+extern "C" __declspec(dllexport) bool OmniReader_Initialize(void* handle, const char*, int, int) {
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    SoakReader* reader = static_cast<SoakReader*>(handle);
+    reader->connected = true;
+    reader->nextUs = TreadmillSampleHistory::NowUs();
+    return true;
+}
+
+extern "C" __declspec(dllexport) void OmniReader_RegisterCallback(void* handle, OmniDataCallback callback) {
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    static_cast<SoakReader*>(handle)->callback = callback;
+}
+
+extern "C" __declspec(dllexport) size_t OmniReader_Poll(void* handle, OmniSample* samples, size_t maxSamples, uint64_t* sequence) {
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    SoakReader& reader = *static_cast<SoakReader*>(handle);
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    size_t count = 0;
+    while (reader.connected && count < maxSamples && reader.nextUs <= nowUs) {
+        int64_t timeUs = reader.nextUs;
+        reader.nextUs += SampleUs;
+        if (timeUs >= g_silentFromUs.load() && timeUs < g_silentUntilUs.load()) continue;
+        OmniSample& s = samples[count++];
+        s = {};
+        s.sequence = ++reader.sequence;
+        s.timestampUs = timeUs;
+        int x, y;
+        WalkSample(reader.sequence, s.ringAngle, x, y);
+        s.gamePadX = x;
+        s.gamePadY = y;
+    }
+    *sequence = reader.sequence;
+    return count;
+}
+
+extern "C" __declspec(dllexport) void OmniReader_Disconnect(void* handle) {
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    static_cast<SoakReader*>(handle)->connected = false;
+}
+
+extern "C" __declspec(dllexport) void OmniReader_Destroy(void* handle) {
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    auto it = std::find(g_readers.begin(), g_readers.end(), static_cast<SoakReader*>(handle));
+    if (it == g_readers.end()) return;
+    g_readers.erase(it);
+    g_soakHandles.readers.fetch_sub(1);
+    delete static_cast<SoakReader*>(handle);
+}
+
+void SoakFrame() {
+    TreadmillSampleHistory::VirtualNowUs().fetch_add(FrameUs);
+    float angle;
+    int x, y;
+    WalkSample(++g_callbackSample, angle, x, y);
+    std::lock_guard<std::mutex> lock(g_readersMutex);
+    for (SoakReader* reader : g_readers) {
+        if (reader->connected && reader->callback) reader->callback(angle, x, y);
+    }
+}
+
+// ----------------------------------------------------------------------------
+
+static std::string SelfPath() {
+    char path[MAX_PATH] = {};
+    GetModuleFileNameA(nullptr, path, MAX_PATH);
+    return path;
+}
+
+std::wstring SoakSelfPathW() {
+    return std::filesystem::path(SelfPath()).wstring();
+}
+
+struct ProcessUsage {
+    int64_t residentBytes = 0;
+    int64_t handles = 0;
+};
+
+// As TreadmillMetricsPage samples the host process
+static ProcessUsage SampleProcess() {
+    ProcessUsage usage;
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        usage.residentBytes = static_cast<int64_t>(counters.WorkingSetSize);
+    }
+    DWORD handles = 0;
+    if (GetProcessHandleCount(GetCurrentProcess(), &handles)) usage.handles = handles;
+#else
+    long pages = 0, residentPages = 0;
+    FILE* statm = fopen("/proc/self/statm", "r");
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &pages, &residentPages) == 2) {
+            usage.residentBytes = static_cast<int64_t>(residentPages) * sysconf(_SC_PAGESIZE);
+        }
+        fclose(statm);
+    }
+    DIR* fds = opendir("/proc/self/fd");
+    if (fds) {
+        int64_t count = 0;
+        while (readdir(fds)) count++;
+        closedir(fds);
+        usage.handles = count - 3;  // ".", ".." and the directory itself
+    }
+#endif
+    return usage;
+}
+
+struct Options {
+    int rounds = 20;
+    int warmup = 2;                     // rounds before the growth baseline
+    int roundSeconds = 180;             // virtual seconds of driver frames per round
+    double speed = 100.0;               // times real time, 0 = unpaced
+    int xrInstances = 2;
+    int xrSessions = 4;
+    int vrSessions = 4;
+    int sessionFrames = 900;            // per OpenXR and OpenVR session
+    int64_t maxAllocGrowth = 64;        // heap blocks
+    double maxRssGrowthMb = 8.0;
+    int64_t maxHandleGrowth = 4;
+    std::string json;
+};
+
+struct RoundResult {
+    int round = 0;
+    int64_t allocations = 0;
+    ProcessUsage usage;
+    int64_t liveFakes = 0;
+    int64_t xrSessionGrowth = 0;        // largest of the round's instances
+    double realMs = 0.0;
+};
+
+static bool WaitForState(TreadmillConnectionState state, int timeoutMs) {
+    for (int waitedMs = 0; g_connectionState.load() != state; waitedMs += 10) {
+        if (waitedMs >= timeoutMs) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return true;
+}
+
+static void Teardown(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider) {
+    context.host.DeactivateAll();
+    provider->Cleanup();
+    context.devices.Clear();
+    context.properties.Clear();
+}
+
+static bool DriverRound(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider, const Options& options) {
+    context.settings.Clear();
+    context.settings.Set("driver_treadmill", "mytracker_model_number", "treadmill_soak");
+    context.settings.Set("driver_treadmill", "debug", "false");
+    context.settings.Set("driver_treadmill", "omnibridge_dll_path", SelfPath());
+    context.settings.Set("driver_treadmill", "frame_sampling", "false");        // needs the master's shared memory
+    context.settings.Set("driver_treadmill", "publisher_thread", "false");      // the soak's frames publish
+    context.settings.Set("driver_treadmill", "frame_budget_degrade", "false");
+    if (provider->Init(&context) != vr::VRInitError_None) {
+        fprintf(stderr, "Init failed\n");
+        return false;
+    }
+    // ConnectLoop runs on its own thread, in real time
+    if (!WaitForState(TreadmillConnectionState::Streaming, 5000)) {
+        fprintf(stderr, "Driver did not connect to the soak's OmniReader_* exports\n");
+        Teardown(context, provider);
+        return false;
+    }
+    const MockDevices::Device* controller = context.devices.Find("treadmill_controller");
+    if (!controller) {
+        fprintf(stderr, "Driver did not add its controller\n");
+        Teardown(context, provider);
+        return false;
+    }
+
+    char response[256] = {};
+    std::string recording = (std::filesystem::temp_directory_path() / "treadmill_soak_session.csv").string();
+    controller->driver->DebugRequest(("record " + recording).c_str(), response, sizeof(response));
+
+    int64_t frames = static_cast<int64_t>(options.roundSeconds) * 1000000 / FrameUs;
+    int64_t lossFrame = frames / 2;
+    int64_t virtualStartUs = TreadmillSampleHistory::NowUs();
+    auto realStart = std::chrono::steady_clock::now();
+    bool ok = true;
+    for (int64_t frame = 1; frame <= frames && ok; frame++) {
+        int64_t nowUs = TreadmillSampleHistory::VirtualNowUs().fetch_add(FrameUs) + FrameUs;
+        if (frame == lossFrame) {
+            g_silentFromUs.store(nowUs);
+            g_silentUntilUs.store(nowUs + MasterLossUs);
+        }
+        provider->RunFrame();
+
+        // The master is back: the driver must have dropped the link and connect again
+        if (frame > lossFrame && nowUs >= g_silentUntilUs.load() && g_silentFromUs.load() != 0) {
+            g_silentFromUs.store(0);
+            g_silentUntilUs.store(0);
+            if (g_connectionState.load() != TreadmillConnectionState::Lost) {
+                fprintf(stderr, "Driver did not report the lost master\n");
+                ok = false;
+            } else if (!WaitForState(TreadmillConnectionState::Streaming, 5000)) {
+                fprintf(stderr, "Driver did not reconnect after the lost master\n");
+                ok = false;
+            }
+            // The wait is not part of the replay
+            virtualStartUs = nowUs;
+            realStart = std::chrono::steady_clock::now();
+        }
+
+        if (options.speed > 0.0 && frame % 90 == 0) {
+            auto due = realStart + std::chrono::microseconds(
+                static_cast<int64_t>((nowUs - virtualStartUs) / options.speed));
+            std::this_thread::sleep_until(due);
+        }
+    }
+
+    controller->driver->DebugRequest("record stop", response, sizeof(response));
+    Teardown(context, provider);
+    std::error_code ignored;
+    std::filesystem::remove(recording, ignored);
+    return ok;
+}
+
+static void WriteJson(FILE* out, const RoundResult& r) {
+    fprintf(out, "{\"round\":%d,\"allocations\":%lld,\"rss_bytes\":%lld,\"handles\":%lld,\"live_fakes\":%lld,"
+        "\"xr_session_growth\":%lld,\"real_ms\":%.0f}\n",
+        r.round, static_cast<long long>(r.allocations), static_cast<long long>(r.usage.residentBytes),
+        static_cast<long long>(r.usage.handles), static_cast<long long>(r.liveFakes),
+        static_cast<long long>(r.xrSessionGrowth), r.realMs);
+}
+
+static int RunSoak(MockDriverContext& context, vr::IServerTrackedDeviceProvider* provider, const Options& options) {
+    FILE* json = nullptr;
+    if (!options.json.empty()) {
+        json = fopen(options.json.c_str(), "w");
+        if (!json) {
+            fprintf(stderr, "Cannot write %s\n", options.json.c_str());
+            return 2;
+        }
+    }
+
+    std::vector<RoundResult> results;
+    bool leaked = false;
+    for (int round = 1; round <= options.rounds; round++) {
+        auto start = std::chrono::steady_clock::now();
+        RoundResult r;
+        r.round = round;
+        if (!DriverRound(context, provider, options)) {
+            if (json) fclose(json);
+            return 2;
+        }
+        for (int i = 0; i < options.xrInstances; i++) {
+            int64_t growth = 0;
+            if (!SoakOpenXrInstance(options.xrSessions, options.sessionFrames, growth)) {
+                fprintf(stderr, "OpenXR layer did not connect to the soak's OmniReader_* exports\n");
+                if (json) fclose(json);
+                return 2;
+            }
+            r.xrSessionGrowth = std::max(r.xrSessionGrowth, growth);
+        }
+        for (int i = 0; i < options.vrSessions; i++) {
+            if (!SoakOpenVrSession(options.sessionFrames)) {
+                fprintf(stderr, "OpenVR wrapper did not connect to the soak's OmniReader_* exports\n");
+                if (json) fclose(json);
+                return 2;
+            }
+        }
+        r.realMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        r.allocations = SoakLiveAllocations();
+        r.usage = SampleProcess();
+        r.liveFakes = g_soakHandles.Total();
+        results.push_back(r);
+
+        printf("round %3d: %8lld heap blocks, rss %7.1f MB, %4lld handles, %lld live fakes, "
+            "xr session growth %lld, %.0f ms\n", round, static_cast<long long>(r.allocations),
+            r.usage.residentBytes / (1024.0 * 1024.0), static_cast<long long>(r.usage.handles),
+            static_cast<long long>(r.liveFakes), static_cast<long long>(r.xrSessionGrowth), r.realMs);
+        if (json) WriteJson(json, r);
+
+        if (r.liveFakes != 0) {
+            fprintf(stderr, "  still alive: %lld readers, %lld instances, %lld sessions, %lld action sets, %lld actions\n",
+                static_cast<long long>(g_soakHandles.readers.load()), static_cast<long long>(g_soakHandles.xrInstances.load()),
+                static_cast<long long>(g_soakHandles.xrSessions.load()), static_cast<long long>(g_soakHandles.xrActionSets.load()),
+                static_cast<long long>(g_soakHandles.xrActions.load()));
+            leaked = true;
+        }
+        if (r.xrSessionGrowth > SessionSlackBlocks) {
+            fprintf(stderr, "  an OpenXR instance gained %lld heap blocks from session 2 to %d\n",
+                static_cast<long long>(r.xrSessionGrowth), options.xrSessions);
+            leaked = true;
+        }
+    }
+    if (json) fclose(json);
+
+    const RoundResult& first = results[std::min<size_t>(options.warmup, results.size()) - 1];
+    const RoundResult& last = results.back();
+    int64_t allocGrowth = last.allocations - first.allocations;
+    double rssGrowthMb = (last.usage.residentBytes - first.usage.residentBytes) / (1024.0 * 1024.0);
+    int64_t handleGrowth = last.usage.handles - first.usage.handles;
+    bool grew = allocGrowth > options.maxAllocGrowth || rssGrowthMb > options.maxRssGrowthMb ||
+        handleGrowth > options.maxHandleGrowth;
+    printf("rounds %d..%d: %+lld heap blocks (max %lld), %+.1f MB rss (max %.1f), %+lld handles (max %lld)%s\n",
+        first.round, last.round, static_cast<long long>(allocGrowth), static_cast<long long>(options.maxAllocGrowth),
+        rssGrowthMb, options.maxRssGrowthMb, static_cast<long long>(handleGrowth),
+        static_cast<long long>(options.maxHandleGrowth), grew || leaked ? " - FAILED" : "");
+    return grew || leaked ? 1 : 0;
+}
+
+static void PrintUsage() {
+    printf("Usage: TreadmillSoak.exe [--rounds <n>] [--warmup <n>] [--round-seconds <n>]\n");
+    printf("                         [--speed <x>] [--xr-instances <n>] [--xr-sessions <n>]\n");
+    printf("                         [--vr-sessions <n>] [--max-alloc-growth <n>]\n");
+    printf("                         [--max-rss-growth-mb <n>] [--max-handle-growth <n>]\n");
+    printf("                         [--json <file>]\n");
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--rounds") == 0 && i + 1 < argc) {
+            options.rounds = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--warmup") == 0 && i + 1 < argc) {
+            options.warmup = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--round-seconds") == 0 && i + 1 < argc) {
+            options.roundSeconds = std::max(10, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--speed") == 0 && i + 1 < argc) {
+            options.speed = std::max(0.0, atof(argv[++i]));
+        } else if (strcmp(argv[i], "--xr-instances") == 0 && i + 1 < argc) {
+            options.xrInstances = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--xr-sessions") == 0 && i + 1 < argc) {
+            options.xrSessions = std::max(1, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--vr-sessions") == 0 && i + 1 < argc) {
+            options.vrSessions = std::max(0, atoi(argv[++i]));
+        } else if (strcmp(argv[i], "--max-alloc-growth") == 0 && i + 1 < argc) {
+            options.maxAllocGrowth = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--max-rss-growth-mb") == 0 && i + 1 < argc) {
+            options.maxRssGrowthMb = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--max-handle-growth") == 0 && i + 1 < argc) {
+            options.maxHandleGrowth = atoll(argv[++i]);
+        } else if (strcmp(argv[i], "--json") == 0 && i + 1 < argc) {
+            options.json = argv[++i];
+        } else {
+            PrintUsage();
+            return 2;
+        }
+    }
+    if (options.rounds <= options.warmup) {
+        fprintf(stderr, "--rounds must be larger than --warmup (%d)\n", options.warmup);
+        return 2;
+    }
+
+    int returnCode = 0;
+    auto* provider = static_cast<vr::IServerTrackedDeviceProvider*>(
+        HmdDriverFactory(vr::IServerTrackedDeviceProvider_Version, &returnCode));
+    if (!provider) {
+        fprintf(stderr, "HmdDriverFactory returned no provider (%d)\n", returnCode);
+        return 2;
+    }
+
+    MockDriverContext context;
+    return RunSoak(context, provider, options);
+}
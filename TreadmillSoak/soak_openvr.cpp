@@ -0,0 +1,85 @@
+// ============================================================================
+// TreadmillSoak - OpenVR wrapper phase against a fake IVRInput
+// ============================================================================
+// The soak is vrclient: WrapIVRInput wraps its IVRInput, whose action handles
+// are stable within a VR session and new in the next one, as with a game
+// that calls VR_Init again after VR_Shutdown.
+// ============================================================================
+
+#include "../TreadmillOpenVRWrapper/pch.h"
+#include "Soak.h"
+#include <map>
+#include <string>
+
+namespace {
+
+typedef EVRInputError (*PFN_GetActionHandle)(void* self, const char* pchActionName, VRActionHandle_t* pHandle);
+typedef EVRInputError (*PFN_GetAnalogActionData)(void* self, VRActionHandle_t action, InputAnalogActionData_t* pActionData, uint32_t unActionDataSize, VRInputValueHandle_t ulRestrictToDevice);
+
+std::map<std::string, VRActionHandle_t> g_handles;     // this VR session's
+VRActionHandle_t g_nextHandle = 0x1000;
+
+EVRInputError Fake_GetActionHandle(void*, const char* pchActionName, VRActionHandle_t* pHandle) {
+    auto it = g_handles.find(pchActionName);
+    if (it == g_handles.end()) it = g_handles.emplace(pchActionName, g_nextHandle++).first;
+    *pHandle = it->second;
+    return VRInputError_None;
+}
+
+EVRInputError Fake_GetAnalogActionData(void*, VRActionHandle_t, InputAnalogActionData_t* pActionData, uint32_t, VRInputValueHandle_t) {
+    *pActionData = {};
+    pActionData->bActive = true;
+    pActionData->y = 0.1f;
+    return VRInputError_None;
+}
+
+void* g_fakeVTable[64];
+
+struct FakeIVRInput {
+    void** vtable = g_fakeVTable;
+};
+FakeIVRInput g_fakeInput;
+
+const char* const GameActions[] = {
+    "/actions/main/in/move",
+    "/actions/main/in/walk",
+    "/actions/main/in/turn",
+    "/actions/main/in/jump",
+    "/actions/main/in/grab",
+};
+
+} // namespace
+
+bool SoakOpenVrSession(int framesPerSession) {
+    using namespace TreadmillWrapper;
+
+    g_fakeVTable[IVRInputVTable::GetActionHandle] = reinterpret_cast<void*>(Fake_GetActionHandle);
+    g_fakeVTable[IVRInputVTable::GetAnalogActionData] = reinterpret_cast<void*>(Fake_GetAnalogActionData);
+
+    bool connected = OmniBridge::Initialize(SoakSelfPathW(), g_config.comPort, g_config.baudRate);
+    void* input = WrapIVRInput(&g_fakeInput);
+    void** vtable = *static_cast<void***>(input);
+    auto getActionHandle = reinterpret_cast<PFN_GetActionHandle>(vtable[IVRInputVTable::GetActionHandle]);
+    auto getAnalogActionData = reinterpret_cast<PFN_GetAnalogActionData>(vtable[IVRInputVTable::GetAnalogActionData]);
+
+    VRActionHandle_t handles[sizeof(GameActions) / sizeof(GameActions[0])] = {};
+    for (int frame = 0; frame < framesPerSession; frame++) {
+        // Games look their handles up again now and then (SkyrimVR on every menu change)
+        if (frame % 90 == 0) {
+            for (size_t i = 0; i < sizeof(GameActions) / sizeof(GameActions[0]); i++) {
+                getActionHandle(input, GameActions[i], &handles[i]);
+            }
+        }
+        SoakFrame();
+        for (VRActionHandle_t handle : handles) {
+            InputAnalogActionData_t data{};
+            getAnalogActionData(input, handle, &data, sizeof(data), 0);
+        }
+    }
+
+    // What VR_ShutdownInternal does before the real shutdown
+    ResetActionTracking();
+    g_handles.clear();
+    OmniBridge::Shutdown();
+    return connected;
+}
@@ -0,0 +1,234 @@
+// ============================================================================
+// TreadmillSoak - OpenXR layer phase against a fake runtime
+// ============================================================================
+// The soak is the runtime below the layer: InitializeDispatchTable gets its
+// xrGetInstanceProcAddr, and every handle it creates is a counted heap
+// object. Destroying an action set destroys its actions and destroying the
+// instance destroys everything left, as the spec requires of a runtime.
+// ============================================================================
+
+#include "../TreadmillOpenXRLayer/pch.h"
+#include "Soak.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+enum class FakeKind { Instance, Session, ActionSet, Action };
+
+struct FakeXrObject {
+    FakeKind kind;
+    FakeXrObject* owner;    // instance of a session or action set, action set of an action
+};
+
+std::vector<FakeXrObject*> g_objects;
+
+std::atomic<int64_t>& Counter(FakeKind kind) {
+    switch (kind) {
+    case FakeKind::Instance: return g_soakHandles.xrInstances;
+    case FakeKind::Session: return g_soakHandles.xrSessions;
+    case FakeKind::ActionSet: return g_soakHandles.xrActionSets;
+    case FakeKind::Action:
+    default: return g_soakHandles.xrActions;
+    }
+}
+
+FakeXrObject* Create(FakeKind kind, FakeXrObject* owner) {
+    FakeXrObject* object = new FakeXrObject{ kind, owner };
+    g_objects.push_back(object);
+    Counter(kind).fetch_add(1);
+    return object;
+}
+
+bool Live(const void* handle, FakeKind kind) {
+    auto it = std::find(g_objects.begin(), g_objects.end(), static_cast<const FakeXrObject*>(handle));
+    return it != g_objects.end() && (*it)->kind == kind;
+}
+
+bool OwnedBy(const FakeXrObject* object, const FakeXrObject* owner) {
+    for (const FakeXrObject* o = object->owner; o; o = o->owner) {
+        if (o == owner) return true;
+    }
+    return false;
+}
+
+// Destroys object and everything it owns
+void Destroy(FakeXrObject* object) {
+    std::vector<FakeXrObject*> doomed;
+    for (FakeXrObject* o : g_objects) {
+        if (o == object || OwnedBy(o, object)) doomed.push_back(o);
+    }
+    for (FakeXrObject* o : doomed) {
+        g_objects.erase(std::find(g_objects.begin(), g_objects.end(), o));
+        Counter(o->kind).fetch_sub(1);
+        delete o;
+    }
+}
+
+XrResult XRAPI_CALL Fake_xrDestroyInstance(XrInstance instance) {
+    if (!Live(instance, FakeKind::Instance)) return XR_ERROR_HANDLE_INVALID;
+    Destroy(reinterpret_cast<FakeXrObject*>(instance));
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrCreateActionSet(XrInstance instance, const XrActionSetCreateInfo*, XrActionSet* actionSet) {
+    if (!Live(instance, FakeKind::Instance) || !actionSet) return XR_ERROR_VALIDATION_FAILURE;
+    *actionSet = reinterpret_cast<XrActionSet>(Create(FakeKind::ActionSet, reinterpret_cast<FakeXrObject*>(instance)));
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrCreateAction(XrActionSet actionSet, const XrActionCreateInfo*, XrAction* action) {
+    if (!Live(actionSet, FakeKind::ActionSet) || !action) return XR_ERROR_VALIDATION_FAILURE;
+    *action = reinterpret_cast<XrAction>(Create(FakeKind::Action, reinterpret_cast<FakeXrObject*>(actionSet)));
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrDestroyAction(XrAction action) {
+    if (!Live(action, FakeKind::Action)) return XR_ERROR_HANDLE_INVALID;
+    Destroy(reinterpret_cast<FakeXrObject*>(action));
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrDestroyActionSet(XrActionSet actionSet) {
+    if (!Live(actionSet, FakeKind::ActionSet)) return XR_ERROR_HANDLE_INVALID;
+    Destroy(reinterpret_cast<FakeXrObject*>(actionSet));
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrSyncActions(XrSession session, const XrActionsSyncInfo*) {
+    return Live(session, FakeKind::Session) ? XR_SUCCESS : XR_ERROR_HANDLE_INVALID;
+}
+
+// The game's own input: the stick slightly forward, so Additive has something to add to
+XrResult XRAPI_CALL Fake_xrGetActionStateFloat(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateFloat* state) {
+    if (!Live(session, FakeKind::Session) || !Live(getInfo->action, FakeKind::Action)) return XR_ERROR_HANDLE_INVALID;
+    state->currentState = 0.1f;
+    state->changedSinceLastSync = 0;
+    state->lastChangeTime = 0;
+    state->isActive = 1;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrGetActionStateVector2f(XrSession session, const XrActionStateGetInfo* getInfo, XrActionStateVector2f* state) {
+    if (!Live(session, FakeKind::Session) || !Live(getInfo->action, FakeKind::Action)) return XR_ERROR_HANDLE_INVALID;
+    state->x = 0.0f;
+    state->y = 0.1f;
+    state->changedSinceLastSync = 0;
+    state->lastChangeTime = 0;
+    state->isActive = 1;
+    return XR_SUCCESS;
+}
+
+XrResult XRAPI_CALL Fake_xrGetInstanceProcAddr(XrInstance, const char* name, PFN_xrVoidFunction* function) {
+    struct Entry { const char* name; PFN_xrVoidFunction function; };
+    static const Entry entries[] = {
+        { "xrDestroyInstance", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrDestroyInstance) },
+        { "xrCreateActionSet", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrCreateActionSet) },
+        { "xrCreateAction", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrCreateAction) },
+        { "xrDestroyAction", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrDestroyAction) },
+        { "xrDestroyActionSet", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrDestroyActionSet) },
+        { "xrSyncActions", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrSyncActions) },
+        { "xrGetActionStateFloat", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrGetActionStateFloat) },
+        { "xrGetActionStateVector2f", reinterpret_cast<PFN_xrVoidFunction>(Fake_xrGetActionStateVector2f) },
+    };
+    for (const Entry& e : entries) {
+        if (strcmp(name, e.name) == 0) {
+            *function = e.function;
+            return XR_SUCCESS;
+        }
+    }
+    *function = nullptr;
+    return XR_ERROR_FUNCTION_UNSUPPORTED;
+}
+
+struct GameAction {
+    const char* name;
+    bool vector;
+};
+
+// Two movement actions (matched by the default actionPatterns) among the rest
+const GameAction GameActions[] = {
+    { "move", true },
+    { "locomotion_forward", false },
+    { "turn", true },
+    { "jump", false },
+    { "grab_left", false },
+    { "grab_right", false },
+};
+
+} // namespace
+
+bool SoakOpenXrInstance(int sessions, int framesPerSession, int64_t& sessionGrowth) {
+    using namespace TreadmillLayer;
+
+    bool connected = OmniBridge::Initialize(SoakSelfPathW(), g_config.comPort, g_config.baudRate);
+    XrInstance instance = reinterpret_cast<XrInstance>(Create(FakeKind::Instance, nullptr));
+    InitializeDispatchTable(instance, Fake_xrGetInstanceProcAddr);
+
+    int64_t afterFirstSession = 0;
+    for (int s = 0; s < sessions; s++) {
+        XrSession session = reinterpret_cast<XrSession>(Create(FakeKind::Session, reinterpret_cast<FakeXrObject*>(instance)));
+
+        XrActionSetCreateInfo setInfo{};
+        snprintf(setInfo.actionSetName, sizeof(setInfo.actionSetName), "gameplay_%d", s);
+        XrActionSet actionSet = XR_NULL_HANDLE;
+        TreadmillLayer_xrCreateActionSet(instance, &setInfo, &actionSet);
+
+        std::vector<XrAction> actions;
+        std::vector<bool> vectors;
+        for (const GameAction& a : GameActions) {
+            XrActionCreateInfo actionInfo{};
+            snprintf(actionInfo.actionName, sizeof(actionInfo.actionName), "%s", a.name);
+            actionInfo.actionType = a.vector ? 3 : 2;   // XR_ACTION_TYPE_VECTOR2F_INPUT / FLOAT_INPUT
+            XrAction action = XR_NULL_HANDLE;
+            if (XR_SUCCEEDED(TreadmillLayer_xrCreateAction(actionSet, &actionInfo, &action))) {
+                actions.push_back(action);
+                vectors.push_back(a.vector);
+            }
+        }
+
+        XrActionsSyncInfo syncInfo{};
+        for (int frame = 0; frame < framesPerSession; frame++) {
+            SoakFrame();
+            TreadmillLayer_xrSyncActions(session, &syncInfo);
+            for (size_t i = 0; i < actions.size(); i++) {
+                XrActionStateGetInfo getInfo{};
+                getInfo.action = actions[i];
+                if (vectors[i]) {
+                    XrActionStateVector2f state{};
+                    TreadmillLayer_xrGetActionStateVector2f(session, &getInfo, &state);
+                } else {
+                    XrActionStateFloat state{};
+                    TreadmillLayer_xrGetActionStateFloat(session, &getInfo, &state);
+                }
+            }
+        }
+
+        // Games tear down either way: actions first, or only their set
+        if (s % 2 == 0) {
+            for (XrAction action : actions) TreadmillLayer_xrDestroyAction(action);
+        }
+        TreadmillLayer_xrDestroyActionSet(actionSet);
+        Destroy(reinterpret_cast<FakeXrObject*>(session));
+
+        if (s == 0) afterFirstSession = SoakLiveAllocations();
+    }
+    sessionGrowth = sessions > 1 ? SoakLiveAllocations() - afterFirstSession : 0;
+
+    // Leaves one action set with its actions for the instance to take along
+    XrActionSetCreateInfo setInfo{};
+    snprintf(setInfo.actionSetName, sizeof(setInfo.actionSetName), "menu");
+    XrActionSet actionSet = XR_NULL_HANDLE;
+    if (XR_SUCCEEDED(TreadmillLayer_xrCreateActionSet(instance, &setInfo, &actionSet))) {
+        XrActionCreateInfo actionInfo{};
+        snprintf(actionInfo.actionName, sizeof(actionInfo.actionName), "menu_move");
+        XrAction action = XR_NULL_HANDLE;
+        TreadmillLayer_xrCreateAction(actionSet, &actionInfo, &action);
+    }
+
+    TreadmillLayer_xrDestroyInstance(instance);
+    OmniBridge::Shutdown();
+    return connected;
+}
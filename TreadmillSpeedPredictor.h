@@ -0,0 +1,156 @@
+#pragma once
+
+// ============================================================================
+// TreadmillSpeedPredictor - NLMS forecast of walking speed
+// ============================================================================
+// The filtered stick speed trails the user by serial, firmware and filter
+// delay. This predictor forecasts the speed change over a fixed horizon from
+// the last Taps speed changes and the step cadence, learning its weights
+// online with normalized LMS (O(Features) per sample).
+//
+// Training needs no ground truth: each sample is kept until a sample at least
+// horizon later arrives, whose speed is the target.
+//
+// The output blends filtered and predicted speed by a confidence that
+// compares the predictor's error with the error of simply holding the value,
+// so a predictor that does not help falls back to the filtered speed.
+// ============================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+class TreadmillSpeedPredictor {
+public:
+    static constexpr int Taps = 8;                  // recent speed changes
+    static constexpr int Features = Taps + 2;       // + cadence, cadence change
+    static constexpr int64_t DefaultHorizonUs = 20000;
+    static constexpr float DefaultStepSize = 0.1f;  // NLMS mu, 0 < mu < 2
+
+    struct Stats {
+        uint64_t trained = 0;       // samples that reached their horizon
+        double rmse = 0.0;          // prediction error (speed units)
+        double holdRmse = 0.0;      // error of holding the current speed
+        float confidence = 0.0f;    // blend weight of the prediction [0, 1]
+    };
+
+    void Configure(int64_t horizonUs, float stepSize) {
+        m_horizonUs = std::max<int64_t>(0, horizonUs);
+        m_stepSize = std::clamp(stepSize, 0.0f, 1.9f);
+    }
+
+    void Reset() {
+        int64_t horizonUs = m_horizonUs;
+        float stepSize = m_stepSize;
+        *this = TreadmillSpeedPredictor();
+        Configure(horizonUs, stepSize);
+    }
+
+    // Feed one filtered speed sample (0..1) and the step cadence (steps/s).
+    // Returns the speed to output now, i.e. the forecast for timeUs + horizon
+    // blended with speed by confidence.
+    float Update(float speed, float cadence, int64_t timeUs) {
+        Train(speed, timeUs);
+
+        // Features: speed changes (newest first) and scaled cadence
+        for (int i = Taps - 1; i > 0; i--) m_speedDeltas[i] = m_speedDeltas[i - 1];
+        m_speedDeltas[0] = m_hasLast ? speed - m_lastSpeed : 0.0f;
+
+        Pending p;
+        p.timeUs = timeUs;
+        p.speed = speed;
+        for (int i = 0; i < Taps; i++) p.features[i] = m_speedDeltas[i];
+        p.features[Taps] = cadence * CadenceScale;
+        p.features[Taps + 1] = m_hasLast ? (cadence - m_lastCadence) * CadenceScale : 0.0f;
+
+        p.predictedDelta = 0.0f;
+        for (int i = 0; i < Features; i++) p.predictedDelta += m_weights[i] * p.features[i];
+
+        m_hasLast = true;
+        m_lastSpeed = speed;
+        m_lastCadence = cadence;
+
+        // Keep for training; on overflow drop the oldest (horizon far above the sample spacing)
+        if (m_pendingCount == PendingCapacity) {
+            m_pendingHead = (m_pendingHead + 1) % PendingCapacity;
+            m_pendingCount--;
+        }
+        m_pending[(m_pendingHead + m_pendingCount) % PendingCapacity] = p;
+        m_pendingCount++;
+
+        float predicted = std::clamp(speed + p.predictedDelta, 0.0f, 1.0f);
+        return speed + Confidence() * (predicted - speed);
+    }
+
+    Stats GetStats() const {
+        Stats s;
+        s.trained = m_trained;
+        s.rmse = std::sqrt(m_errorMse);
+        s.holdRmse = std::sqrt(m_holdMse);
+        s.confidence = Confidence();
+        return s;
+    }
+
+private:
+    static constexpr int PendingCapacity = 64;
+    static constexpr float CadenceScale = 0.25f;     // ~0..4 steps/s -> ~0..1
+    static constexpr double ErrorAlpha = 0.02;       // EMA of squared errors
+    static constexpr uint64_t WarmupSamples = 50;
+
+    struct Pending {
+        int64_t timeUs = 0;
+        float speed = 0.0f;
+        float predictedDelta = 0.0f;
+        float features[Features] = {};
+    };
+
+    int64_t m_horizonUs = DefaultHorizonUs;
+    float m_stepSize = DefaultStepSize;
+
+    float m_weights[Features] = {};
+    float m_speedDeltas[Taps] = {};
+    bool m_hasLast = false;
+    float m_lastSpeed = 0.0f;
+    float m_lastCadence = 0.0f;
+
+    Pending m_pending[PendingCapacity];
+    int m_pendingHead = 0;
+    int m_pendingCount = 0;
+
+    uint64_t m_trained = 0;
+    double m_errorMse = 0.0;
+    double m_holdMse = 0.0;
+
+    float Confidence() const {
+        if (m_trained < WarmupSamples || m_holdMse <= 0.0) return 0.0f;
+        return static_cast<float>(std::clamp(1.0 - m_errorMse / m_holdMse, 0.0, 1.0));
+    }
+
+    // Samples whose horizon has passed learn from the speed seen now
+    void Train(float speed, int64_t timeUs) {
+        while (m_pendingCount > 0) {
+            Pending& p = m_pending[m_pendingHead];
+            if (timeUs - p.timeUs < m_horizonUs) break;
+
+            float target = speed - p.speed;
+
+            // Track the error of the prediction made back then, not of the updated weights
+            double error = target - p.predictedDelta;
+            m_errorMse += ErrorAlpha * (error * error - m_errorMse);
+            m_holdMse += ErrorAlpha * (static_cast<double>(target) * target - m_holdMse);
+            m_trained++;
+
+            float estimate = 0.0f;
+            float norm = 1e-4f;
+            for (int i = 0; i < Features; i++) {
+                estimate += m_weights[i] * p.features[i];
+                norm += p.features[i] * p.features[i];
+            }
+            float gain = m_stepSize * (target - estimate) / norm;
+            for (int i = 0; i < Features; i++) m_weights[i] += gain * p.features[i];
+
+            m_pendingHead = (m_pendingHead + 1) % PendingCapacity;
+            m_pendingCount--;
+        }
+    }
+};
@@ -0,0 +1,135 @@
+#pragma once
+
+// ============================================================================
+// TreadmillYawKalman - constant-velocity Kalman filter for the ring yaw
+// ============================================================================
+// State: unwrapped yaw (degrees) and yaw rate (degrees/second).
+// Measurements:
+//   UpdateAngle() - RingAngle, wrapped [0, 360), quantized
+//   UpdateRate()  - rate derived from RingDelta
+// Process noise is white yaw acceleration with spectral density
+// processNoise (deg^2/s^3); raise it if pivots lag, lower it if the yaw
+// wanders while standing.
+//
+// Unlike an EMA, the filter follows a steady turn without lag (the rate is
+// part of the state), and Yaw()/YawRate() can feed pose prediction directly.
+// ============================================================================
+
+#include <cmath>
+#include <cstdint>
+
+class TreadmillYawKalman {
+public:
+    struct Params {
+        double processNoise = 20000.0;  // deg^2/s^3
+        double angleNoise = 0.5;        // RingAngle std dev, degrees
+        double rateNoise = 20.0;        // rate std dev, degrees/second
+    };
+
+    struct State {
+        float yaw = 0.0f;       // degrees [0, 360)
+        float yawRate = 0.0f;   // degrees/second, positive = increasing RingAngle
+        double pYaw = 0.0;      // covariance: var(yaw)
+        double pYawRate = 0.0;  //             cov(yaw, rate)
+        double pRate = 0.0;     //             var(rate)
+    };
+
+    // Gaps longer than this restart the filter from the next angle
+    static constexpr int64_t MaxGapUs = 500000;
+
+    void Configure(const Params& params) { m_params = params; }
+    void Reset() { m_initialized = false; }
+    bool IsInitialized() const { return m_initialized; }
+
+    void UpdateAngle(float degrees, int64_t timeUs) {
+        double r = m_params.angleNoise * m_params.angleNoise;
+
+        if (!m_initialized || timeUs - m_timeUs > MaxGapUs) {
+            m_initialized = true;
+            m_timeUs = timeUs;
+            m_yaw = degrees;
+            m_rate = 0.0;
+            m_p00 = r;
+            m_p01 = 0.0;
+            m_p11 = InitialRateVariance;
+            return;
+        }
+
+        // Late measurements are moved to the state time along the current rate
+        double z = degrees;
+        if (timeUs < m_timeUs) {
+            z += m_rate * (m_timeUs - timeUs) * 1e-6;
+        } else {
+            PredictTo(timeUs);
+        }
+
+        // Residual on the circle, the state itself stays unwrapped
+        double y = std::fmod(z - m_yaw + 540.0, 360.0);
+        if (y < 0.0) y += 360.0;
+        y -= 180.0;
+
+        double s = m_p00 + r;
+        double k0 = m_p00 / s;
+        double k1 = m_p01 / s;
+        m_yaw += k0 * y;
+        m_rate += k1 * y;
+
+        double p00 = m_p00, p01 = m_p01;
+        m_p00 = p00 - k0 * p00;
+        m_p01 = p01 - k0 * p01;
+        m_p11 = m_p11 - k1 * p01;
+    }
+
+    void UpdateRate(float degreesPerSecond, int64_t timeUs) {
+        if (!m_initialized) return;  // needs an angle first
+        if (timeUs > m_timeUs) PredictTo(timeUs);
+
+        double s = m_p11 + m_params.rateNoise * m_params.rateNoise;
+        double k0 = m_p01 / s;
+        double k1 = m_p11 / s;
+        double y = degreesPerSecond - m_rate;
+        m_yaw += k0 * y;
+        m_rate += k1 * y;
+
+        double p01 = m_p01, p11 = m_p11;
+        m_p00 = m_p00 - k0 * p01;
+        m_p01 = p01 - k0 * p11;
+        m_p11 = p11 - k1 * p11;
+    }
+
+    State GetState() const {
+        State s;
+        double w = std::fmod(m_yaw, 360.0);
+        s.yaw = static_cast<float>(w < 0.0 ? w + 360.0 : w);
+        s.yawRate = static_cast<float>(m_rate);
+        s.pYaw = m_p00;
+        s.pYawRate = m_p01;
+        s.pRate = m_p11;
+        return s;
+    }
+
+private:
+    static constexpr double InitialRateVariance = 100.0 * 100.0;  // (100 deg/s)^2
+
+    Params m_params;
+    bool m_initialized = false;
+    int64_t m_timeUs = 0;
+    double m_yaw = 0.0;     // unwrapped
+    double m_rate = 0.0;
+    double m_p00 = 0.0, m_p01 = 0.0, m_p11 = 0.0;
+
+    void PredictTo(int64_t timeUs) {
+        double dt = (timeUs - m_timeUs) * 1e-6;
+        m_timeUs = timeUs;
+        if (dt <= 0.0) return;
+
+        m_yaw += m_rate * dt;
+
+        // P = F P F' + Q, F = [1 dt; 0 1], Q = q [dt^3/3 dt^2/2; dt^2/2 dt]
+        double q = m_params.processNoise;
+        double dt2 = dt * dt;
+        m_p00 += dt * (2.0 * m_p01 + dt * m_p11) + q * dt2 * dt / 3.0;
+        m_p01 += dt * m_p11 + q * dt2 / 2.0;
+        m_p11 += q * dt;
+    }
+};
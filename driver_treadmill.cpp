@@ -5,6 +5,17 @@
 #include "TreadmillServerDriver.h"
 #include "TreadmillDevice.h"
 #include "MinimalOmniReader.h"
+#include "TreadmillLatencyStats.h"
+#include "TreadmillOneEuroFilter.h"
+#include "TreadmillYawKalman.h"
+#include "TreadmillSpeedPredictor.h"
+#include "TreadmillCallProfile.h"
+#include "TreadmillMetrics.h"
+#include "TreadmillFrameBudget.h"
+#include "TreadmillInstrument.h"
+#include "TreadmillSessionRecording.h"
+#include "TreadmillLocomotion.h"
+#include "TreadmillPropertyTable.h"
 #include <atomic>
 #include <mutex>
 #include <array>
@@ -17,6 +28,8 @@
 #include <cctype>
 #include <cmath>
 #include <chrono>
+#include <memory>
+#include <vector>
 #include <debugapi.h>
 
 struct XYState {
@@ -29,6 +42,34 @@ struct XYState {
     float y_smoothed = 0.0f;
     float yaw_smoothed = 0.0f;
     
+    // One-Euro filters (filter = "oneeuro"), driven by sample timestamps
+    TreadmillOneEuroFilter filterX;
+    TreadmillOneEuroFilter filterY;
+    TreadmillOneEuroFilter filterYaw;
+    
+    // Kalman yaw (yaw_kalman), replaces the yaw filter above while enabled
+    TreadmillYawKalman yawKalman;
+    float yawRate = 0.0f;  // degrees/second, 0 without Kalman
+    
+    // Speed prediction (speed_prediction): UpdateInputs scales x/y_smoothed
+    // by speedScale so the EMA/One-Euro state itself stays untouched
+    TreadmillSpeedPredictor speedPredictor;
+    float speedScale = 1.0f;
+    float cadence = 0.0f;           // steps/second from StepCount
+    uint32_t lastStepCount = 0;
+    int64_t lastStepTimeUs = 0;
+    
+    // Footfalls for /input/step/click, consumed by UpdateInputs
+    int64_t pendingStepTimeUs = 0;  // 0 = none
+    int64_t lastFootfallUs = 0;     // not consumed - the foot trackers' gait phase
+    uint8_t lastStepTrigger = 0;
+    bool stepTriggerSeen = false;   // StepTrigger present - StepCount no longer reports steps
+    
+    int64_t lastSampleTimeUs = 0;   // for the EMA lag in the metrics page
+    
+    // universe_locomotion: walked distance for TreadmillLocomotion.exe
+    TreadmillLocomotionIntegrator locomotion;
+    
     uint64_t dataId = 0;  // Timestamp/ID for tracing
     uint64_t logCounter = 0;  // Shared log counter for all components
     
@@ -49,11 +90,190 @@ static const char* my_tracker_settings_key_smoothing_factor = "smoothing_factor"
 static const char* my_tracker_settings_key_com_port = "com_port";
 static const char* my_tracker_settings_key_debug = "debug";
 static const char* my_tracker_settings_key_omnibridge_dll_path = "omnibridge_dll_path";
+static const char* my_tracker_settings_key_frame_sampling = "frame_sampling";
+static const char* my_tracker_settings_key_frame_sampling_interpolation = "frame_sampling_interpolation";
+static const char* my_tracker_settings_key_frame_sampling_lookahead_ms = "frame_sampling_lookahead_ms";
+static const char* my_tracker_settings_key_filter = "filter";
+static const char* my_tracker_settings_key_oneeuro_min_cutoff = "oneeuro_min_cutoff";
+static const char* my_tracker_settings_key_oneeuro_beta = "oneeuro_beta";
+static const char* my_tracker_settings_key_yaw_kalman = "yaw_kalman";
+static const char* my_tracker_settings_key_kalman_process_noise = "kalman_process_noise";
+static const char* my_tracker_settings_key_kalman_angle_noise = "kalman_angle_noise";
+static const char* my_tracker_settings_key_kalman_rate_noise = "kalman_rate_noise";
+static const char* my_tracker_settings_key_ring_delta_scale = "ring_delta_scale";
+static const char* my_tracker_settings_key_speed_prediction = "speed_prediction";
+static const char* my_tracker_settings_key_speed_prediction_horizon_ms = "speed_prediction_horizon_ms";
+static const char* my_tracker_settings_key_speed_prediction_step_size = "speed_prediction_step_size";
+static const char* my_tracker_settings_key_speed_calibration = "speed_calibration";
+static const char* my_tracker_settings_key_calibration_target_speed = "calibration_target_speed";
+static const char* my_tracker_settings_key_yaw_correction = "yaw_correction";
+static const char* my_tracker_settings_key_profile_hot_path = "profile_hot_path";
+static const char* my_tracker_settings_key_frame_budget_ms = "frame_budget_ms";
+static const char* my_tracker_settings_key_frame_budget_degrade = "frame_budget_degrade";
+static const char* my_tracker_settings_key_universe_locomotion = "universe_locomotion";
+static const char* my_tracker_settings_key_publisher_thread = "publisher_thread";
+static const char* my_tracker_settings_key_publisher_rate_hz = "publisher_rate_hz";
+static const char* my_tracker_settings_key_foot_trackers = "foot_trackers";
+static const char* my_tracker_settings_key_foot_stride_m = "foot_stride_m";
+static const char* my_tracker_settings_key_foot_eye_height_m = "foot_eye_height_m";
 
 std::atomic<bool> g_debug{ DEBUG_ENABLED };
 std::atomic<float> g_speedFactor{ 1.0f };
 std::atomic<float> g_smoothingFactor{ 0.3f };
 
+// Frame sampling: RunFrame samples OmniBridge's history at frame time and
+// OnOmniData leaves g_state alone while that is active
+std::atomic<bool> g_frameSampling{ true };
+std::atomic<bool> g_frameSamplingActive{ false };
+std::atomic<bool> g_frameSamplingLinear{ false };  // default cubic Hermite
+std::atomic<int64_t> g_frameSamplingLookaheadUs{ TreadmillSampleHistory::DefaultMaxExtrapolationUs };
+
+// Per-frame speed variation with and without resampling (DebugRequest "judder")
+TreadmillFrameJudder g_frameJudder;
+
+// Smoothing filter: EMA with g_smoothingFactor, or One-Euro (min cutoff / beta)
+std::atomic<bool> g_oneEuro{ false };
+std::atomic<float> g_oneEuroMinCutoff{ TreadmillOneEuroFilter::DefaultMinCutoff };
+std::atomic<float> g_oneEuroBeta{ TreadmillOneEuroFilter::DefaultBeta };
+
+// Kalman yaw: fuses RingAngle with the rate from RingDelta and publishes the
+// yaw rate as angular velocity for pose prediction
+std::atomic<bool> g_yawKalman{ false };
+std::atomic<float> g_kalmanProcessNoise{ 20000.0f };   // deg^2/s^3
+std::atomic<float> g_kalmanAngleNoise{ 0.5f };         // degrees
+std::atomic<float> g_kalmanRateNoise{ 20.0f };         // degrees/second
+std::atomic<float> g_ringDeltaScale{ 360.0f / 256.0f }; // degrees per RingDelta count, 0 = ignore RingDelta
+
+// Speed prediction: forecast the stick speed horizon ahead to hide pipeline delay
+std::atomic<bool> g_speedPrediction{ false };
+std::atomic<int64_t> g_speedPredictionHorizonUs{ TreadmillSpeedPredictor::DefaultHorizonUs };
+std::atomic<float> g_speedPredictionStepSize{ TreadmillSpeedPredictor::DefaultStepSize };
+
+// Speed calibration: learn the game's m/s per joystick unit from HMD movement
+enum SpeedCalibrationMode { SpeedCalibration_Off, SpeedCalibration_Suggest, SpeedCalibration_Apply };
+std::atomic<int> g_speedCalibration{ SpeedCalibration_Suggest };
+std::atomic<float> g_calibrationTargetSpeed{ 1.4f };  // m/s at treadmill stick 1.0
+TreadmillSpeedCalibrator g_speedCalibrator;
+
+// Yaw correction: learned offset between ring zero and the game's world forward,
+// added to the yaw of both device poses
+std::atomic<bool> g_yawCorrection{ true };
+std::atomic<float> g_yawOffset{ 0.0f };  // degrees
+
+// Universe locomotion: integrate the stick into a world offset that
+// TreadmillLocomotion.exe applies to the standing universe; the joystick
+// then stays centered so games do not move the user twice
+std::atomic<bool> g_universeLocomotion{ false };
+
+// Publisher thread: poses and inputs from a driver-owned, elevated-priority
+// thread at publisher_rate_hz (and on every new sample), RunFrame only
+// handles events. Read once in Init.
+std::atomic<bool> g_publisherThread{ false };
+std::atomic<int> g_publisherRateHz{ 250 };
+
+// Foot trackers from the pod quaternions (TreadmillFootTracking.h). Read
+// once in Init; the gait state belongs to the publishing thread.
+std::atomic<bool> g_footTrackers{ false };
+std::atomic<float> g_footStrideM{ 0.7f };       // stride at full stick speed
+std::atomic<float> g_footEyeHeightM{ 1.6f };    // HMD above the floor, places the feet
+std::atomic<uint64_t> g_footPodSamples{ 0 };
+std::atomic<int64_t> g_footLastPodUs{ 0 };
+std::atomic<uint32_t> g_footNeutralGeneration{ 0 };  // bumped by DebugRequest "feet reset"
+std::atomic<float> g_footStrideNow{ 0.0f };
+std::atomic<bool> g_footWalking{ false };
+TreadmillGaitModel g_footGait;
+struct TreadmillFootFrame {
+    double headingDeg = 0.0;
+    double baseX = 0.0, floorY = 0.0, baseZ = 0.0;
+};
+TreadmillFootFrame g_footFrame;
+TreadmillYawOffsetEstimator g_yawOffsetEstimator;
+
+static float WrapYaw(float deg) {
+    float w = std::fmod(deg, 360.0f);
+    return w < 0.0f ? w + 360.0f : w;
+}
+
+// Delivery latency per transport (packet received by OmniBridge -> consumed
+// in RunFrame), reported as JSON by DebugRequest "latency"
+TreadmillLatencyStats g_latencyPoll;
+TreadmillLatencyStats g_latencyHistory;
+
+// Cost per call of the sample/frame hot paths and the wait for g_state.mtx,
+// reported as JSON by DebugRequest "profile" (off unless enabled there or by
+// profile_hot_path)
+TreadmillCallProfile g_profileOmniSample;
+TreadmillCallProfile g_profileUpdateInputs;
+TreadmillCallProfile g_profileDevicePose;
+TreadmillCallProfile g_profileTrackerPose;
+TreadmillCallProfile g_profileStateLock;
+
+// Live counters for external tools (TreadmillMetrics.h), created in Init
+TreadmillMetricsPage g_metrics;
+
+// Per-phase RunFrame timing and overrun watchdog, reported by DebugRequest "budget"
+TreadmillFrameBudget g_frameBudget;
+
+// Set by the connection thread (TreadmillServerDriver::ConnectLoop) and
+// the publishing thread; the poses report it to SteamVR
+std::atomic<TreadmillConnectionState> g_connectionState{ TreadmillConnectionState::Loading };
+std::atomic<int64_t> g_lastOmniSampleUs{ 0 };  // arrival of the newest OmniBridge sample
+
+// Link health (DebugRequest "connection")
+std::atomic<uint64_t> g_linkStalls{ 0 };        // sample deadline missed, outputs zeroed
+std::atomic<uint64_t> g_linkReconnects{ 0 };    // successful reconnects after a loss
+std::atomic<int64_t> g_linkLastReconnectMs{ -1 }; // loss to streaming again, -1 = none yet
+
+const char* TreadmillConnectionStateName(TreadmillConnectionState state) {
+    switch (state) {
+    case TreadmillConnectionState::Loading: return "loading";
+    case TreadmillConnectionState::Connecting: return "connecting";
+    case TreadmillConnectionState::Streaming: return "streaming";
+    case TreadmillConnectionState::Lost: return "lost";
+    case TreadmillConnectionState::Failed: return "failed";
+    default: return "unknown";
+    }
+}
+
+// Searching until the treadmill streams, out of range (last pose kept)
+// while it is lost, disconnected when OmniBridge cannot be used at all
+static void ApplyConnectionState(vr::DriverPose_t& pose) {
+    switch (g_connectionState.load(std::memory_order_relaxed)) {
+    case TreadmillConnectionState::Streaming:
+        pose.poseIsValid = true;
+        pose.deviceIsConnected = true;
+        pose.result = vr::TrackingResult_Running_OK;
+        break;
+    case TreadmillConnectionState::Lost:
+        pose.poseIsValid = true;
+        pose.deviceIsConnected = true;
+        pose.result = vr::TrackingResult_Running_OutOfRange;
+        break;
+    case TreadmillConnectionState::Failed:
+        pose.poseIsValid = false;
+        pose.deviceIsConnected = false;
+        pose.result = vr::TrackingResult_Uninitialized;
+        break;
+    default:
+        pose.poseIsValid = false;
+        pose.deviceIsConnected = true;
+        pose.result = vr::TrackingResult_Running_OutOfRange;
+        break;
+    }
+}
+
+// Filter chain input/output of a walk, DebugRequest "record" / "replay"
+TreadmillSessionRecorder g_recorder;
+
+// Time spent in Log() on the calling thread since the last TakeLogTimeNs()
+static thread_local int64_t t_logTimeNs = 0;
+
+int64_t TakeLogTimeNs() {
+    int64_t ns = t_logTimeNs;
+    t_logTimeNs = 0;
+    return ns;
+}
+
 void trim(std::string& s) {
     size_t start = s.find_first_not_of(" \t\r\n");
     size_t end = s.find_last_not_of(" \t\r\n");
@@ -63,6 +283,7 @@ void trim(std::string& s) {
 
 void Log(const char* fmt, ...) {
     if (!g_debug.load()) return;
+    int64_t startNs = TreadmillCallProfile::NowNs();
     char buf[1024];
     va_list ap;
     va_start(ap, fmt);
@@ -77,6 +298,7 @@ void Log(const char* fmt, ...) {
         OutputDebugStringA(buf);
         OutputDebugStringA("\n");
     }
+    t_logTimeNs += TreadmillCallProfile::NowNs() - startNs;
 }
 
 static void SetDebugFromString(const char* s) {
@@ -89,6 +311,36 @@ static void SetDebugFromString(const char* s) {
     Log("treadmill: DEBUG set to %d (source=\"%s\")", g_debug.load() ? 1 : 0, s);
 }
 
+static const char* SpeedCalibrationName(int mode) {
+    return mode == SpeedCalibration_Apply ? "apply" : mode == SpeedCalibration_Suggest ? "suggest" : "off";
+}
+
+static std::string ReplaySession(const std::string& path);
+static void ResetFilterChain(XYState& s, float x, float y, float yaw);
+
+// Everything FilterSample depends on, stored with a recording so a replay
+// can tell a changed configuration from a changed pipeline
+static std::string PipelineSettings() {
+    char buf[320];
+    snprintf(buf, sizeof(buf),
+        "filter=%s smoothing=%g oneeuro_min_cutoff=%g oneeuro_beta=%g yaw_kalman=%d kalman_noise=%g/%g/%g "
+        "speed_prediction=%d horizon_us=%lld step_size=%g",
+        g_oneEuro.load() ? "oneeuro" : "ema", g_smoothingFactor.load(), g_oneEuroMinCutoff.load(), g_oneEuroBeta.load(),
+        g_yawKalman.load() ? 1 : 0, g_kalmanProcessNoise.load(), g_kalmanAngleNoise.load(), g_kalmanRateNoise.load(),
+        g_speedPrediction.load() ? 1 : 0, static_cast<long long>(g_speedPredictionHorizonUs.load()), g_speedPredictionStepSize.load());
+    return buf;
+}
+
+static bool ParseSpeedCalibration(std::string mode, int& out) {
+    trim(mode);
+    std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+    if (mode == "off") out = SpeedCalibration_Off;
+    else if (mode == "suggest") out = SpeedCalibration_Suggest;
+    else if (mode == "apply") out = SpeedCalibration_Apply;
+    else return false;
+    return true;
+}
+
 // TreadmillDevice implementation
 TreadmillDevice::TreadmillDevice(unsigned int my_tracker_id) {
     is_active_ = false;
@@ -119,20 +371,219 @@ TreadmillDevice::TreadmillDevice(unsigned int my_tracker_id) {
             g_smoothingFactor.store(smoothing);
             Log("treadmill: smoothing_factor loaded from settings: %f", smoothing);
         }
+        
+        se = vr::VRSettingsError_None;
+        bool frameSampling = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_frame_sampling, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_frameSampling.store(frameSampling);
+            Log("treadmill: frame_sampling loaded from settings: %s", frameSampling ? "true" : "false");
+        }
+        
+        char interpolation[32] = {};
+        se = vr::VRSettingsError_None;
+        vr::VRSettings()->GetString(my_tracker_main_settings_section, my_tracker_settings_key_frame_sampling_interpolation, interpolation, sizeof(interpolation), &se);
+        if (se == vr::VRSettingsError_None) {
+            std::string mode(interpolation);
+            trim(mode);
+            std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+            g_frameSamplingLinear.store(mode == "linear");
+            Log("treadmill: frame_sampling_interpolation loaded from settings: %s", g_frameSamplingLinear.load() ? "linear" : "hermite");
+        }
+        
+        se = vr::VRSettingsError_None;
+        float lookaheadMs = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_frame_sampling_lookahead_ms, &se);
+        if (se == vr::VRSettingsError_None && lookaheadMs >= 0.0f && lookaheadMs <= 100.0f) {
+            g_frameSamplingLookaheadUs.store(static_cast<int64_t>(lookaheadMs * 1000.0f));
+            Log("treadmill: frame_sampling_lookahead_ms loaded from settings: %f", lookaheadMs);
+        }
+        
+        char filter[32] = {};
+        se = vr::VRSettingsError_None;
+        vr::VRSettings()->GetString(my_tracker_main_settings_section, my_tracker_settings_key_filter, filter, sizeof(filter), &se);
+        if (se == vr::VRSettingsError_None) {
+            std::string mode(filter);
+            trim(mode);
+            std::transform(mode.begin(), mode.end(), mode.begin(), [](unsigned char c){ return static_cast<char>(std::tolower(c)); });
+            g_oneEuro.store(mode == "oneeuro");
+            Log("treadmill: filter loaded from settings: %s", g_oneEuro.load() ? "oneeuro" : "ema");
+        }
+        
+        se = vr::VRSettingsError_None;
+        float minCutoff = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_oneeuro_min_cutoff, &se);
+        if (se == vr::VRSettingsError_None && minCutoff > 0.0f) {
+            g_oneEuroMinCutoff.store(minCutoff);
+            Log("treadmill: oneeuro_min_cutoff loaded from settings: %f", minCutoff);
+        }
+        
+        se = vr::VRSettingsError_None;
+        float beta = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_oneeuro_beta, &se);
+        if (se == vr::VRSettingsError_None && beta >= 0.0f) {
+            g_oneEuroBeta.store(beta);
+            Log("treadmill: oneeuro_beta loaded from settings: %f", beta);
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool yawKalman = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_yaw_kalman, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_yawKalman.store(yawKalman);
+            Log("treadmill: yaw_kalman loaded from settings: %s", yawKalman ? "true" : "false");
+        }
+        
+        struct { const char* key; std::atomic<float>* target; float minimum; } kalmanSettings[] = {
+            { my_tracker_settings_key_kalman_process_noise, &g_kalmanProcessNoise, 0.0f },
+            { my_tracker_settings_key_kalman_angle_noise, &g_kalmanAngleNoise, 0.0f },
+            { my_tracker_settings_key_kalman_rate_noise, &g_kalmanRateNoise, 0.0f },
+        };
+        for (auto& ks : kalmanSettings) {
+            se = vr::VRSettingsError_None;
+            float v = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, ks.key, &se);
+            if (se == vr::VRSettingsError_None && v > ks.minimum) {
+                ks.target->store(v);
+                Log("treadmill: %s loaded from settings: %f", ks.key, v);
+            }
+        }
+        
+        se = vr::VRSettingsError_None;
+        float ringDeltaScale = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_ring_delta_scale, &se);
+        if (se == vr::VRSettingsError_None && ringDeltaScale >= 0.0f) {
+            g_ringDeltaScale.store(ringDeltaScale);
+            Log("treadmill: ring_delta_scale loaded from settings: %f", ringDeltaScale);
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool speedPrediction = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_speed_prediction, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_speedPrediction.store(speedPrediction);
+            Log("treadmill: speed_prediction loaded from settings: %s", speedPrediction ? "true" : "false");
+        }
+        
+        se = vr::VRSettingsError_None;
+        float horizonMs = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_speed_prediction_horizon_ms, &se);
+        if (se == vr::VRSettingsError_None && horizonMs >= 0.0f && horizonMs <= 200.0f) {
+            g_speedPredictionHorizonUs.store(static_cast<int64_t>(horizonMs * 1000.0f));
+            Log("treadmill: speed_prediction_horizon_ms loaded from settings: %f", horizonMs);
+        }
+        
+        se = vr::VRSettingsError_None;
+        float stepSize = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_speed_prediction_step_size, &se);
+        if (se == vr::VRSettingsError_None && stepSize > 0.0f && stepSize < 2.0f) {
+            g_speedPredictionStepSize.store(stepSize);
+            Log("treadmill: speed_prediction_step_size loaded from settings: %f", stepSize);
+        }
+        
+        char calibration[32] = {};
+        se = vr::VRSettingsError_None;
+        vr::VRSettings()->GetString(my_tracker_main_settings_section, my_tracker_settings_key_speed_calibration, calibration, sizeof(calibration), &se);
+        int calibrationMode;
+        if (se == vr::VRSettingsError_None && ParseSpeedCalibration(calibration, calibrationMode)) {
+            g_speedCalibration.store(calibrationMode);
+            Log("treadmill: speed_calibration loaded from settings: %s", SpeedCalibrationName(calibrationMode));
+        }
+        
+        se = vr::VRSettingsError_None;
+        float targetSpeed = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_calibration_target_speed, &se);
+        if (se == vr::VRSettingsError_None && targetSpeed > 0.0f) {
+            g_calibrationTargetSpeed.store(targetSpeed);
+            Log("treadmill: calibration_target_speed loaded from settings: %f", targetSpeed);
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool yawCorrection = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_yaw_correction, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_yawCorrection.store(yawCorrection);
+            Log("treadmill: yaw_correction loaded from settings: %s", yawCorrection ? "true" : "false");
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool profileHotPath = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_profile_hot_path, &se);
+        if (se == vr::VRSettingsError_None) {
+            TreadmillCallProfile::SetEnabled(profileHotPath);
+            Log("treadmill: profile_hot_path loaded from settings: %s", profileHotPath ? "true" : "false");
+        }
+        
+        float frameBudgetMs = static_cast<float>(TreadmillFrameBudget::DefaultBudgetUs) / 1000.0f;
+        bool frameBudgetDegrade = false;
+        se = vr::VRSettingsError_None;
+        float budgetMs = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_frame_budget_ms, &se);
+        if (se == vr::VRSettingsError_None && budgetMs > 0.0f) {
+            frameBudgetMs = budgetMs;
+            Log("treadmill: frame_budget_ms loaded from settings: %.2f", frameBudgetMs);
+        }
+        se = vr::VRSettingsError_None;
+        bool budgetDegrade = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_frame_budget_degrade, &se);
+        if (se == vr::VRSettingsError_None) {
+            frameBudgetDegrade = budgetDegrade;
+            Log("treadmill: frame_budget_degrade loaded from settings: %s", frameBudgetDegrade ? "true" : "false");
+        }
+        g_frameBudget.Configure(static_cast<int64_t>(frameBudgetMs * 1000.0f), frameBudgetDegrade);
+        
+        se = vr::VRSettingsError_None;
+        bool universeLocomotion = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_universe_locomotion, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_universeLocomotion.store(universeLocomotion);
+            Log("treadmill: universe_locomotion loaded from settings: %s", universeLocomotion ? "true" : "false");
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool publisherThread = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_publisher_thread, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_publisherThread.store(publisherThread);
+            Log("treadmill: publisher_thread loaded from settings: %s", publisherThread ? "true" : "false");
+        }
+        
+        se = vr::VRSettingsError_None;
+        int32_t publisherRate = vr::VRSettings()->GetInt32(my_tracker_main_settings_section, my_tracker_settings_key_publisher_rate_hz, &se);
+        if (se == vr::VRSettingsError_None && publisherRate >= 30 && publisherRate <= 1000) {
+            g_publisherRateHz.store(publisherRate);
+            Log("treadmill: publisher_rate_hz loaded from settings: %d", publisherRate);
+        }
+        
+        se = vr::VRSettingsError_None;
+        bool footTrackers = vr::VRSettings()->GetBool(my_tracker_main_settings_section, my_tracker_settings_key_foot_trackers, &se);
+        if (se == vr::VRSettingsError_None) {
+            g_footTrackers.store(footTrackers);
+            Log("treadmill: foot_trackers loaded from settings: %s", footTrackers ? "true" : "false");
+        }
+        
+        se = vr::VRSettingsError_None;
+        float footStride = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_foot_stride_m, &se);
+        if (se == vr::VRSettingsError_None && footStride >= 0.2f && footStride <= 1.5f) {
+            g_footStrideM.store(footStride);
+            Log("treadmill: foot_stride_m loaded from settings: %.2f", footStride);
+        }
+        
+        se = vr::VRSettingsError_None;
+        float footEyeHeight = vr::VRSettings()->GetFloat(my_tracker_main_settings_section, my_tracker_settings_key_foot_eye_height_m, &se);
+        if (se == vr::VRSettingsError_None && footEyeHeight >= 1.0f && footEyeHeight <= 2.2f) {
+            g_footEyeHeightM.store(footEyeHeight);
+            Log("treadmill: foot_eye_height_m loaded from settings: %.2f", footEyeHeight);
+        }
     }
 }
 
 void TreadmillDevice::UpdateInputs() {
     if (!is_active_) return;
+    TreadmillCallTimer timer(g_profileUpdateInputs);
+    TREADMILL_ZONE("UpdateInputs");
     float x, y, yawDeg;
     uint64_t logCounter;
+    int64_t sampleTimeUs, stepTimeUs;
     { 
-        std::lock_guard<std::mutex> lock(g_state.mtx); 
-        x = g_state.x_smoothed; 
-        y = g_state.y_smoothed; 
+        TreadmillTimedLock lock(g_state.mtx, g_profileStateLock); 
+        x = g_state.x_smoothed * g_state.speedScale; 
+        y = g_state.y_smoothed * g_state.speedScale; 
         yawDeg = g_state.yaw_smoothed;
         logCounter = g_state.logCounter;
+        sampleTimeUs = g_state.lastSampleTimeUs;
+        stepTimeUs = g_state.pendingStepTimeUs;
+        g_state.pendingStepTimeUs = 0;
     }
+    
+    // Events carry their own time: negative offsets = that long ago
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    auto offsetOf = [nowUs](int64_t timeUs) {
+        return timeUs > 0 ? std::min(0.0, (timeUs - nowUs) * 1e-6) : 0.0;
+    };
 
     // CORRECTION: Joystick values are NOT rotated!
     // Rotation happens through the controller's pose rotation
@@ -142,6 +593,12 @@ void TreadmillDevice::UpdateInputs() {
     float factor = g_speedFactor.load();
     float sx = std::clamp(x * factor, -1.0f, 1.0f);
     float sy = std::clamp(y * factor, -1.0f, 1.0f);
+    float speed = std::min(1.0f, std::sqrt(sx * sx + sy * sy));
+    if (g_universeLocomotion.load()) {
+        sx = 0.0f;  // the universe moves instead
+        sy = 0.0f;
+    }
+    TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::InjectionsTotal, 1);
 
     if (input_handles_[MyComponent_joystick_x] != vr::k_ulInvalidInputComponentHandle) {
         auto e = vr::VRDriverInput()->UpdateScalarComponent(input_handles_[MyComponent_joystick_x], sx, 0.0);
@@ -151,9 +608,30 @@ void TreadmillDevice::UpdateInputs() {
         auto e = vr::VRDriverInput()->UpdateScalarComponent(input_handles_[MyComponent_joystick_y], sy, 0.0);
         if (e != vr::VRInputError_None) Log("treadmill: UpdateScalar Y failed %d", e);
     }
+    if (input_handles_[MyComponent_speed_value] != vr::k_ulInvalidInputComponentHandle) {
+        vr::VRDriverInput()->UpdateScalarComponent(input_handles_[MyComponent_speed_value], speed, offsetOf(sampleTimeUs));
+    }
+    if (input_handles_[MyComponent_step_click] != vr::k_ulInvalidInputComponentHandle) {
+        // Press at the footfall's time, release StepClickHoldUs later. A step
+        // that arrives while still held releases first, just before the new
+        // press, so back-to-back steps stay separate clicks.
+        if (stepTimeUs != 0) {
+            if (step_pressed_) {
+                int64_t releaseUs = std::max(step_press_time_us_,
+                    std::min(step_press_time_us_ + StepClickHoldUs, stepTimeUs - StepClickGapUs));
+                vr::VRDriverInput()->UpdateBooleanComponent(input_handles_[MyComponent_step_click], false, offsetOf(releaseUs));
+            }
+            vr::VRDriverInput()->UpdateBooleanComponent(input_handles_[MyComponent_step_click], true, offsetOf(stepTimeUs));
+            step_pressed_ = true;
+            step_press_time_us_ = stepTimeUs;
+        } else if (step_pressed_ && nowUs >= step_press_time_us_ + StepClickHoldUs) {
+            vr::VRDriverInput()->UpdateBooleanComponent(input_handles_[MyComponent_step_click], false, offsetOf(step_press_time_us_ + StepClickHoldUs));
+            step_pressed_ = false;
+        }
+    }
     
     // Unified logging every 50 frames
-    if (logCounter % 50 == 0) {
+    if (TREADMILL_EVERY_N("UpdateInputs calls", 50)) {
         // ANALYSIS: Is movement correct relative to rotation?
         // If yaw=0° and Y=1.0 (forward) -> should move north
         // If yaw=90° and Y=1.0 (forward) -> should move east
@@ -177,19 +655,26 @@ vr::EVRInitError TreadmillDevice::Activate(vr::TrackedDeviceIndex_t unObjectId)
     auto container = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
     Log("treadmill: Activate: property container=%llu", static_cast<unsigned long long>(container));
 
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_Controller);
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_ControllerType_String, "treadmill_controller");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_InputProfilePath_String, "{treadmill}/input/treadmill_profile.json");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_SerialNumber_String, "treadmill_xy");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_TrackingSystemName_String, "treadmill");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_ModelNumber_String, my_device_model_number_.c_str());
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_RenderModelName_String, "treadmill_controller");
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_Treadmill);
-
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_HasDisplayComponent_Bool, false);
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_HasCameraComponent_Bool, false);
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_HasDriverDirectModeComponent_Bool, false);
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_HasVirtualDisplayComponent_Bool, false);
+    // All properties in one IPC (TreadmillPropertyTable.h)
+    int64_t propsStartNs = TreadmillCallProfile::NowNs();
+    const TreadmillProperty props[] = {
+        TreadmillProperty::Int32(vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_Controller),
+        TreadmillProperty::String(vr::Prop_ControllerType_String, "treadmill_controller"),
+        TreadmillProperty::String(vr::Prop_InputProfilePath_String, "{treadmill}/input/treadmill_profile.json"),
+        TreadmillProperty::String(vr::Prop_SerialNumber_String, "treadmill_xy"),
+        TreadmillProperty::String(vr::Prop_TrackingSystemName_String, "treadmill"),
+        TreadmillProperty::String(vr::Prop_ModelNumber_String, my_device_model_number_.c_str()),
+        TreadmillProperty::String(vr::Prop_RenderModelName_String, "treadmill_controller"),
+        TreadmillProperty::Int32(vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_Treadmill),
+        
+        TreadmillProperty::Bool(vr::Prop_HasDisplayComponent_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_HasCameraComponent_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_HasDriverDirectModeComponent_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_HasVirtualDisplayComponent_Bool, false),
+    };
+    size_t propsFailed = WriteTreadmillProperties(container, props, std::size(props), "controller");
+    Log("treadmill: Activate: %zu properties in 1 batch (%zu failed) in %.3f ms", std::size(props), propsFailed,
+        (TreadmillCallProfile::NowNs() - propsStartNs) / 1e6);
 
     vr::EVRInputError err;
     err = vr::VRDriverInput()->CreateScalarComponent(container, "/input/joystick/x", &input_handles_[MyComponent_joystick_x], vr::VRScalarType_Relative, vr::VRScalarUnits_NormalizedTwoSided);
@@ -197,6 +682,12 @@ vr::EVRInitError TreadmillDevice::Activate(vr::TrackedDeviceIndex_t unObjectId)
 
     err = vr::VRDriverInput()->CreateScalarComponent(container, "/input/joystick/y", &input_handles_[MyComponent_joystick_y], vr::VRScalarType_Relative, vr::VRScalarUnits_NormalizedTwoSided);
     if (err != vr::VRInputError_None) Log("treadmill: CreateScalar Y failed %d", err);
+
+    err = vr::VRDriverInput()->CreateBooleanComponent(container, "/input/step/click", &input_handles_[MyComponent_step_click]);
+    if (err != vr::VRInputError_None) Log("treadmill: CreateBoolean step failed %d", err);
+
+    err = vr::VRDriverInput()->CreateScalarComponent(container, "/input/speed/value", &input_handles_[MyComponent_speed_value], vr::VRScalarType_Absolute, vr::VRScalarUnits_NormalizedOneSided);
+    if (err != vr::VRInputError_None) Log("treadmill: CreateScalar speed failed %d", err);
     
     m_pose = {};
     m_pose.poseTimeOffset = 0.0;
@@ -292,23 +783,361 @@ void TreadmillDevice::DebugRequest(const char* pchRequest, char* pchResponseBuff
         return;
     }
 
+    if (cmd == "filter") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        bool ok = false;
+        if (arg == "ema") {
+            g_oneEuro.store(false);
+            ok = true;
+        } else if (arg == "oneeuro") {
+            std::string minCutoffArg, betaArg;
+            iss >> minCutoffArg >> betaArg;
+            try {
+                float minCutoff = minCutoffArg.empty() ? g_oneEuroMinCutoff.load() : std::stof(minCutoffArg);
+                float beta = betaArg.empty() ? g_oneEuroBeta.load() : std::stof(betaArg);
+                if (minCutoff > 0.0f && beta >= 0.0f) {
+                    g_oneEuroMinCutoff.store(minCutoff);
+                    g_oneEuroBeta.store(beta);
+                    g_oneEuro.store(true);
+                    ok = true;
+                }
+            } catch (...) {}
+        }
+        if (ok) {
+            Log("treadmill: filter set via DebugRequest: %s (min_cutoff=%f beta=%f)",
+                g_oneEuro.load() ? "oneeuro" : "ema", g_oneEuroMinCutoff.load(), g_oneEuroBeta.load());
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[96];
+            if (!ok) {
+                snprintf(resp, sizeof(resp), "Invalid FILTER (ema | oneeuro <mincutoff> <beta>)");
+            } else if (g_oneEuro.load()) {
+                snprintf(resp, sizeof(resp), "FILTER=oneeuro MINCUTOFF=%g BETA=%g",
+                    static_cast<double>(g_oneEuroMinCutoff.load()), static_cast<double>(g_oneEuroBeta.load()));
+            } else {
+                snprintf(resp, sizeof(resp), "FILTER=ema SMOOTHING=%g", static_cast<double>(g_smoothingFactor.load()));
+            }
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "kalman") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "on" || arg == "true" || arg == "1") g_yawKalman.store(true);
+        else if (arg == "off" || arg == "false" || arg == "0") g_yawKalman.store(false);
+        
+        TreadmillYawKalman::State ks;
+        {
+            std::lock_guard<std::mutex> lock(g_state.mtx);
+            ks = g_state.yawKalman.GetState();
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[192];
+            snprintf(resp, sizeof(resp), "KALMAN=%s YAW=%.2f RATE=%.2f P=[%.4g %.4g %.4g]",
+                g_yawKalman.load() ? "on" : "off", ks.yaw, ks.yawRate, ks.pYaw, ks.pYawRate, ks.pRate);
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "judder") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "reset") g_frameJudder.Reset();
+        
+        TreadmillFrameJudder::Summary js = g_frameJudder.GetSummary();
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[160];
+            snprintf(resp, sizeof(resp), "FRAMES=%llu HELD_STDDEV=%.5f RESAMPLED_STDDEV=%.5f",
+                static_cast<unsigned long long>(js.frames), js.heldStdDev, js.resampledStdDev);
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "predictor") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "on" || arg == "true" || arg == "1") g_speedPrediction.store(true);
+        else if (arg == "off" || arg == "false" || arg == "0") g_speedPrediction.store(false);
+        
+        TreadmillSpeedPredictor::Stats ps;
+        {
+            std::lock_guard<std::mutex> lock(g_state.mtx);
+            ps = g_state.speedPredictor.GetStats();
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[192];
+            snprintf(resp, sizeof(resp), "PREDICTOR=%s HORIZON_MS=%.1f TRAINED=%llu RMSE=%.5f HOLD_RMSE=%.5f CONFIDENCE=%.2f",
+                g_speedPrediction.load() ? "on" : "off", g_speedPredictionHorizonUs.load() / 1000.0,
+                static_cast<unsigned long long>(ps.trained), ps.rmse, ps.holdRmse, ps.confidence);
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "calibrate") {
+        int mode;
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "reset") {
+            g_speedCalibrator.Reset();
+        } else if (arg == "save") {
+            // Persist the current speed_factor (e.g. after "calibrate apply")
+            vr::VRSettings()->SetFloat(my_tracker_main_settings_section, my_tracker_settings_key_speed_factor, g_speedFactor.load());
+            Log("treadmill: speed_factor saved via DebugRequest: %f", g_speedFactor.load());
+        } else if (!arg.empty() && ParseSpeedCalibration(arg, mode)) {
+            g_speedCalibration.store(mode);
+        }
+        
+        TreadmillSpeedCalibrator::Stats cs = g_speedCalibrator.GetStats();
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[224];
+            snprintf(resp, sizeof(resp), "CALIBRATION=%s GAIN=%.3f ACCEPTED=%llu REJECTED=%llu RESIDUAL=%.3f SUGGESTED_SPEED=%g SPEED=%g",
+                SpeedCalibrationName(g_speedCalibration.load()), cs.gain,
+                static_cast<unsigned long long>(cs.accepted), static_cast<unsigned long long>(cs.rejected), cs.residualStd,
+                static_cast<double>(g_speedCalibrator.SuggestSpeedFactor(g_calibrationTargetSpeed.load())),
+                static_cast<double>(g_speedFactor.load()));
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "yawoffset") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "on" || arg == "true" || arg == "1") {
+            g_yawCorrection.store(true);
+        } else if (arg == "off" || arg == "false" || arg == "0") {
+            g_yawCorrection.store(false);
+            g_yawOffset.store(0.0f);
+        } else if (arg == "reset") {
+            g_yawOffsetEstimator.Reset();
+            g_yawOffset.store(0.0f);
+        }
+        
+        TreadmillYawOffsetEstimator::Stats ys = g_yawOffsetEstimator.GetStats();
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char resp[256];
+            snprintf(resp, sizeof(resp), "YAWOFFSET=%s APPLIED=%.1f RESIDUAL=%.1f LOOPGAIN=%.2f CONCENTRATION=%.2f BATCHES=%llu ACCEPTED=%llu REJECTED=%llu",
+                g_yawCorrection.load() ? "on" : "off", static_cast<double>(g_yawOffset.load()), ys.residualDeg, ys.loopGain,
+                ys.concentration, static_cast<unsigned long long>(ys.batches),
+                static_cast<unsigned long long>(ys.accepted), static_cast<unsigned long long>(ys.rejected));
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "latency") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "reset") {
+            g_latencyPoll.Reset();
+            g_latencyHistory.Reset();
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            std::string resp = "{" + g_latencyPoll.ToJson("poll") + "," + g_latencyHistory.ToJson("history") + "}";
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "profile") {
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        TreadmillCallProfile* profiles[] = { &g_profileOmniSample, &g_profileUpdateInputs, &g_profileDevicePose, &g_profileTrackerPose, &g_profileStateLock };
+        if (arg == "on" || arg == "true" || arg == "1") {
+            TreadmillCallProfile::SetEnabled(true);
+        } else if (arg == "off" || arg == "false" || arg == "0") {
+            TreadmillCallProfile::SetEnabled(false);
+        } else if (arg == "reset") {
+            for (auto* p : profiles) p->Reset();
+        } else if (arg == "baseline") {
+            // Compare later results against the current numbers, then start a fresh run
+            for (auto* p : profiles) {
+                p->SetBaseline();
+                p->Reset();
+            }
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            // Logging costs show up in these numbers, so report whether it was on
+            std::string resp = std::string("{\"enabled\":") + (TreadmillCallProfile::IsEnabled() ? "true" : "false") +
+                ",\"debug\":" + (g_debug.load() ? "true" : "false") +
+                ",\"frame_sampling\":" + (g_frameSamplingActive.load() ? "true" : "false") + "," +
+                g_profileOmniSample.ToJson("omni_sample") + "," +
+                g_profileUpdateInputs.ToJson("update_inputs") + "," +
+                g_profileDevicePose.ToJson("device_pose") + "," +
+                g_profileTrackerPose.ToJson("tracker_pose") + "," +
+                g_profileStateLock.ToJson("state_lock_wait") + "}";
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "trace") {
+        // "trace <file>" -> write the instrumentation ring as a Chrome trace (Debug builds)
+        std::string resp;
+#ifdef TREADMILL_INSTRUMENTATION
+        std::string path, rest;
+        std::getline(iss, rest);
+        path = arg + rest;  // paths may contain spaces
+        trim(path);
+        if (path.empty()) {
+            resp = "Usage: trace <file>";
+        } else if (TreadmillInstrument::WriteChromeTrace(path, "vrserver (treadmill driver)")) {
+            resp = "Trace written to " + path;
+        } else {
+            resp = "Cannot write " + path;
+        }
+#else
+        resp = "Instrumentation not compiled in (build with TREADMILL_INSTRUMENTATION)";
+#endif
+        Log("treadmill: %s", resp.c_str());
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "record") {
+        // "record <file>" -> record the filter chain's input and output, "record stop"
+        std::string path, rest;
+        std::getline(iss, rest);
+        path = arg + rest;
+        trim(path);
+        std::string resp;
+        if (path.empty() || path == "stop") {
+            uint64_t events = g_recorder.Stop();
+            resp = "Recording stopped (" + std::to_string(events) + " events)";
+        } else {
+            // Restart the chain so a replay from a fresh one sees the same state
+            std::lock_guard<std::mutex> lock(g_state.mtx);
+            if (g_recorder.Start(path, PipelineSettings())) {
+                ResetFilterChain(g_state, g_state.x_smoothed, g_state.y_smoothed, g_state.yaw_smoothed);
+                TreadmillSessionEvent e;
+                e.type = TreadmillSessionEvent::Reset;
+                e.timeUs = TreadmillSampleHistory::NowUs();
+                e.outX = g_state.x_smoothed;
+                e.outY = g_state.y_smoothed;
+                e.outYaw = g_state.yaw_smoothed;
+                g_recorder.Write(e);
+                resp = "Recording to " + path;
+            } else {
+                resp = "Cannot write " + path;
+            }
+        }
+        Log("treadmill: %s", resp.c_str());
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "replay") {
+        // "replay <file>" -> JSON comparison of a recording against the current build and settings
+        std::string path, rest;
+        std::getline(iss, rest);
+        path = arg + rest;
+        trim(path);
+        std::string resp = path.empty() ? "Usage: replay <file>" : ReplaySession(path);
+        Log("treadmill: replay %s: %s", path.c_str(), resp.c_str());
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "budget") {
+        // "budget" -> per-phase RunFrame timings, "budget reset" -> clear them first
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "reset") {
+            g_frameBudget.Reset();
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            std::string resp = g_frameBudget.ToJson();
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, resp.c_str(), _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "connection") {
+        // "connection" -> OmniBridge connection state, age of the newest sample and link stats
+        int64_t lastUs = g_lastOmniSampleUs.load();
+        char buf[256];
+        snprintf(buf, sizeof(buf), "{\"state\":\"%s\",\"last_sample_ms\":%.1f,\"stalls\":%llu,\"reconnects\":%llu,\"last_reconnect_ms\":%lld}",
+            TreadmillConnectionStateName(g_connectionState.load()),
+            lastUs > 0 ? (TreadmillSampleHistory::NowUs() - lastUs) / 1000.0 : -1.0,
+            static_cast<unsigned long long>(g_linkStalls.load()), static_cast<unsigned long long>(g_linkReconnects.load()),
+            static_cast<long long>(g_linkLastReconnectMs.load()));
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, buf, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "locomotion") {
+        // "locomotion [on|off|reset]" -> universe_locomotion and the walked offset
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "on" || arg == "off") {
+            g_universeLocomotion.store(arg == "on");
+            Log("treadmill: universe_locomotion %s via DebugRequest", arg.c_str());
+        }
+        double x, z;
+        {
+            std::lock_guard<std::mutex> lock(g_state.mtx);
+            if (arg == "reset") g_state.locomotion.Reset();  // published with the next sample
+            x = g_state.locomotion.X();
+            z = g_state.locomotion.Z();
+        }
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char buf[128];
+            snprintf(buf, sizeof(buf), "{\"enabled\":%s,\"x\":%.4f,\"z\":%.4f}",
+                g_universeLocomotion.load() ? "true" : "false", x, z);
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, buf, _TRUNCATE);
+        }
+        return;
+    }
+
+    if (cmd == "feet") {
+        // "feet [reset]" -> foot tracker state; reset recaptures the flat-foot
+        // pose on the next pod sample while standing
+        for (auto &c : arg) c = static_cast<char>(std::tolower((unsigned char)c));
+        if (arg == "reset") {
+            g_footNeutralGeneration.fetch_add(1);
+            Log("treadmill: Foot neutral pose reset via DebugRequest");
+        }
+        int64_t lastUs = g_footLastPodUs.load();
+        if (pchResponseBuffer && unResponseBufferSize > 0) {
+            char buf[192];
+            snprintf(buf, sizeof(buf), "{\"enabled\":%s,\"pod_samples\":%llu,\"last_pod_ms\":%.1f,\"walking\":%s,\"stride\":%.3f}",
+                g_footTrackers.load() ? "true" : "false",
+                static_cast<unsigned long long>(g_footPodSamples.load()),
+                lastUs > 0 ? (TreadmillSampleHistory::NowUs() - lastUs) / 1000.0 : -1.0,
+                g_footWalking.load() ? "true" : "false", g_footStrideNow.load());
+            strncpy_s(pchResponseBuffer, unResponseBufferSize, buf, _TRUNCATE);
+        }
+        return;
+    }
+
     if (pchResponseBuffer && unResponseBufferSize > 0) {
         strncpy_s(pchResponseBuffer, unResponseBufferSize, "Unknown command", _TRUNCATE);
     }
 }
 
 vr::DriverPose_t TreadmillDevice::GetPose() {
+    TreadmillCallTimer timer(g_profileDevicePose);
+    TREADMILL_ZONE("TreadmillDevice::GetPose");
     float rawYaw;
     uint64_t dataId;
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
     
     {
-        std::lock_guard<std::mutex> lock(g_state.mtx);
-        rawYaw = g_state.yaw_smoothed;
+        TreadmillTimedLock lock(g_state.mtx, g_profileStateLock);
+        rawYaw = WrapYaw(g_state.yaw_smoothed + g_yawOffset.load());
         dataId = g_state.dataId;
         
-        m_pose.poseIsValid = true;
-        m_pose.deviceIsConnected = true;
-        m_pose.result = vr::TrackingResult_Running_OK;
+        // The yaw is as of the last sample; SteamVR extrapolates from there
+        // with vecAngularVelocity (0 with frame sampling - sampled at now).
+        // Capped so a stalled treadmill does not spin on a stale rate.
+        double ageS = g_state.lastSampleTimeUs > 0 ? (nowUs - g_state.lastSampleTimeUs) * 1e-6 : 0.0;
+        m_pose.poseTimeOffset = -std::clamp(ageS, 0.0, 0.05);
+        
+        ApplyConnectionState(m_pose);
 
         // Position remains at (0,0,0) - the controller does not move in space
         m_pose.vecPosition[0] = 0.0;
@@ -329,11 +1158,15 @@ vr::DriverPose_t TreadmillDevice::GetPose() {
         m_pose.qRotation.x = 0.0;
         m_pose.qRotation.y = -s;  // CHANGED: from s to -s
         m_pose.qRotation.z = 0.0;
+        
+        // Kalman yaw rate lets SteamVR predict the rotation (same negated Y axis)
+        m_pose.vecAngularVelocity[0] = 0.0;
+        m_pose.vecAngularVelocity[1] = -static_cast<double>(g_state.yawRate) * DEG2RAD;
+        m_pose.vecAngularVelocity[2] = 0.0;
     }
     
     // Debug logging AFTER lock
-    static int frameCount = 0;
-    if (++frameCount % 100 == 0) {
+    if (TREADMILL_EVERY_N("TreadmillDevice::GetPose calls", 100)) {
         Log("treadmill: [TreadmillDevice::GetPose ID=%llu] SMOOTHED yaw=%.2f° | CALC quat(w=%.4f, x=%.4f, y=%.4f, z=%.4f)",
             dataId, rawYaw, 
             m_pose.qRotation.w, m_pose.qRotation.x, m_pose.qRotation.y, m_pose.qRotation.z);
@@ -342,8 +1175,152 @@ vr::DriverPose_t TreadmillDevice::GetPose() {
     return m_pose;
 }
 
-void OnOmniData(float ringAngle, int gamePadX, int gamePadY)
+// EMA weight for a sample intervalUs after the previous one, such that
+// smoothing_factor per reference interval gives the same time constant at
+// any rate: alpha = 1 - (1 - s)^(dt / dtRef)
+static float EmaAlpha(float smoothing, int64_t intervalUs)
 {
+    constexpr double ReferenceIntervalUs = 1e6 / 60.0;
+    if (intervalUs <= 0 || smoothing <= 0.0f || smoothing >= 1.0f) return smoothing;
+    return static_cast<float>(1.0 - std::pow(1.0 - smoothing, intervalUs / ReferenceIntervalUs));
+}
+
+// The filter chain for one sample: normalize, EMA or One-Euro, speed
+// prediction, Kalman yaw. Shared by live input and DebugRequest "replay", so
+// it only touches the given state (caller holds its lock if needed).
+// Returns the filter's lag in microseconds, or -1 when unknown.
+static int64_t FilterSample(XYState& s, float ringAngle, float gamePadX, float gamePadY, int64_t timeUs)
+{
+    int64_t lagUs = -1;
+    
+    // X remains the same (left/right)
+    float raw_x = std::clamp((gamePadX - 127.0f) / 127.0f, -1.0f, 1.0f);
+    
+    // Y inverted (forward/backward)
+    float raw_y = std::clamp(-(gamePadY - 127.0f) / 127.0f, -1.0f, 1.0f);
+    
+    // Store raw values
+    s.x = raw_x;
+    s.y = raw_y;
+    s.yaw = ringAngle;
+    
+    if (g_oneEuro.load()) {
+        // One-Euro: low cutoff while steady, higher cutoff while changing
+        float minCutoff = g_oneEuroMinCutoff.load();
+        float beta = g_oneEuroBeta.load();
+        s.filterX.Configure(minCutoff, beta);
+        s.filterY.Configure(minCutoff, beta);
+        s.filterYaw.Configure(minCutoff, beta);
+        
+        s.x_smoothed = s.filterX.Filter(raw_x, timeUs);
+        s.y_smoothed = s.filterY.Filter(raw_y, timeUs);
+        s.yaw_smoothed = s.filterYaw.FilterAngle(ringAngle, timeUs);
+        
+        constexpr double TWO_PI = 2.0 * 3.14159265358979323846;
+        lagUs = static_cast<int64_t>(1e6 / (TWO_PI * s.filterX.Cutoff()));
+    } else {
+        // One-Euro restarts from the current value when switched on again
+        s.filterX.Reset();
+        s.filterY.Reset();
+        s.filterYaw.Reset();
+    
+        // Apply exponential moving average (EMA) smoothing. smoothing_factor
+        // is the weight per ~60 Hz treadmill packet; scaled by the actual
+        // interval so frame sampling at 90/120/144 Hz smooths the same
+        float alpha = EmaAlpha(g_smoothingFactor.load(), s.lastSampleTimeUs != 0 ? timeUs - s.lastSampleTimeUs : 0);
+    
+        // For movement (X, Y) - simple EMA
+        s.x_smoothed = alpha * raw_x + (1.0f - alpha) * s.x_smoothed;
+        s.y_smoothed = alpha * raw_y + (1.0f - alpha) * s.y_smoothed;
+    
+        // For rotation (Yaw) - handle angle wrapping (0-360 degrees)
+        float yaw_diff = ringAngle - s.yaw_smoothed;
+    
+        // Normalize angle difference to [-180, 180]
+        if (yaw_diff > 180.0f) yaw_diff -= 360.0f;
+        if (yaw_diff < -180.0f) yaw_diff += 360.0f;
+    
+        // Apply smoothing to the difference
+        s.yaw_smoothed += alpha * yaw_diff;
+    
+        // Normalize smoothed yaw to [0, 360]
+        if (s.yaw_smoothed < 0.0f) s.yaw_smoothed += 360.0f;
+        if (s.yaw_smoothed >= 360.0f) s.yaw_smoothed -= 360.0f;
+        
+        // An EMA lags (1 - alpha) / alpha sample intervals
+        if (s.lastSampleTimeUs != 0 && alpha > 0.0f && timeUs > s.lastSampleTimeUs) {
+            lagUs = static_cast<int64_t>((timeUs - s.lastSampleTimeUs) * (1.0f - alpha) / alpha);
+        }
+    }
+    s.lastSampleTimeUs = timeUs;
+    
+    if (g_speedPrediction.load()) {
+        s.speedPredictor.Configure(g_speedPredictionHorizonUs.load(), g_speedPredictionStepSize.load());
+        float speed = std::min(1.0f, std::sqrt(s.x_smoothed * s.x_smoothed + s.y_smoothed * s.y_smoothed));
+        float predicted = s.speedPredictor.Update(speed, s.cadence, timeUs);
+        
+        // Only the magnitude is predicted, the direction stays the filtered one
+        s.speedScale = speed > 0.001f ? predicted / speed : 1.0f;
+    } else {
+        s.speedPredictor.Reset();
+        s.speedScale = 1.0f;
+    }
+    
+    if (g_yawKalman.load()) {
+        TreadmillYawKalman::Params params;
+        params.processNoise = g_kalmanProcessNoise.load();
+        params.angleNoise = g_kalmanAngleNoise.load();
+        params.rateNoise = g_kalmanRateNoise.load();
+        s.yawKalman.Configure(params);
+        s.yawKalman.UpdateAngle(ringAngle, timeUs);
+        
+        TreadmillYawKalman::State ks = s.yawKalman.GetState();
+        s.yaw_smoothed = ks.yaw;
+        s.yawRate = ks.yawRate;
+    } else {
+        s.yawKalman.Reset();
+        s.yawRate = 0.0f;
+    }
+    return lagUs;
+}
+
+// Restart the stateful filters (One-Euro, Kalman, speed prediction); the
+// EMA continues from x/y/yaw. Recording starts with this so a replay from
+// a fresh chain sees the same state (recorded as an X row).
+static void ResetFilterChain(XYState& s, float x, float y, float yaw)
+{
+    s.x_smoothed = x;
+    s.y_smoothed = y;
+    s.yaw_smoothed = yaw;
+    s.filterX.Reset();
+    s.filterY.Reset();
+    s.filterYaw.Reset();
+    s.yawKalman.Reset();
+    s.yawRate = 0.0f;
+    s.speedPredictor.Reset();
+    s.speedScale = 1.0f;
+    s.lastSampleTimeUs = 0;
+}
+
+// Link stall: movement to zero, yaw kept (recorded as an L row)
+static void StallFilterChain(XYState& s)
+{
+    s.x = 0.0f;
+    s.y = 0.0f;
+    s.x_smoothed = 0.0f;
+    s.y_smoothed = 0.0f;
+    s.filterX.Reset();
+    s.filterY.Reset();
+    s.speedPredictor.Reset();
+    s.speedScale = 1.0f;
+    s.cadence = 0.0f;
+}
+
+static void ApplyOmniSample(float ringAngle, float gamePadX, float gamePadY, int64_t timeUs)
+{
+    TreadmillCallTimer timer(g_profileOmniSample);
+    TREADMILL_ZONE("ApplyOmniSample");
+    
     // Generate timestamp for tracing
     uint64_t timestamp = static_cast<uint64_t>(
         std::chrono::duration_cast<std::chrono::milliseconds>(
@@ -352,52 +1329,187 @@ void OnOmniData(float ringAngle, int gamePadX, int gamePadY)
     );
     
     {
-        std::lock_guard<std::mutex> lock(g_state.mtx);
-        
-        // X remains the same (left/right)
-        float raw_x = std::clamp((static_cast<float>(gamePadX) - 127.0f) / 127.0f, -1.0f, 1.0f);
-        
-        // Y inverted (forward/backward)
-        float raw_y = std::clamp(-(static_cast<float>(gamePadY) - 127.0f) / 127.0f, -1.0f, 1.0f);
+        TreadmillTimedLock lock(g_state.mtx, g_profileStateLock);
         
-        // Store raw values
-        g_state.x = raw_x;
-        g_state.y = raw_y;
-        g_state.yaw = ringAngle;
-        
-        // Apply exponential moving average (EMA) smoothing
-        float alpha = g_smoothingFactor.load();
-        
-        // For movement (X, Y) - simple EMA
-        g_state.x_smoothed = alpha * raw_x + (1.0f - alpha) * g_state.x_smoothed;
-        g_state.y_smoothed = alpha * raw_y + (1.0f - alpha) * g_state.y_smoothed;
-        
-        // For rotation (Yaw) - handle angle wrapping (0-360 degrees)
-        float yaw_diff = ringAngle - g_state.yaw_smoothed;
-        
-        // Normalize angle difference to [-180, 180]
-        if (yaw_diff > 180.0f) yaw_diff -= 360.0f;
-        if (yaw_diff < -180.0f) yaw_diff += 360.0f;
+        int64_t lagUs = FilterSample(g_state, ringAngle, gamePadX, gamePadY, timeUs);
+        if (lagUs >= 0) g_metrics.Set(TreadmillMetric::FilterLagUs, lagUs);
         
-        // Apply smoothing to the difference
-        g_state.yaw_smoothed += alpha * yaw_diff;
+        // Full sample rate, with the same stick and direction the joystick
+        // and controller pose would carry; full stick = calibration_target_speed
+        if (g_universeLocomotion.load(std::memory_order_relaxed)) {
+            float factor = g_speedFactor.load();
+            float sx = std::clamp(g_state.x_smoothed * g_state.speedScale * factor, -1.0f, 1.0f);
+            float sy = std::clamp(g_state.y_smoothed * g_state.speedScale * factor, -1.0f, 1.0f);
+            g_state.locomotion.Integrate(sx, sy, WrapYaw(g_state.yaw_smoothed + g_yawOffset.load()),
+                g_calibrationTargetSpeed.load(), timeUs);
+            g_metrics.Set(TreadmillMetric::LocomotionXUm, std::llround(g_state.locomotion.X() * 1e6));
+            g_metrics.Set(TreadmillMetric::LocomotionZUm, std::llround(g_state.locomotion.Z() * 1e6));
+        }
         
-        // Normalize smoothed yaw to [0, 360]
-        if (g_state.yaw_smoothed < 0.0f) g_state.yaw_smoothed += 360.0f;
-        if (g_state.yaw_smoothed >= 360.0f) g_state.yaw_smoothed -= 360.0f;
+        // Under the state lock, so rows are in the order the chain saw them
+        if (g_recorder.IsRecording()) {
+            g_recorder.Write({ TreadmillSessionEvent::Sample, timeUs, ringAngle, gamePadX, gamePadY, g_state.cadence,
+                g_state.x_smoothed * g_state.speedScale, g_state.y_smoothed * g_state.speedScale, g_state.yaw_smoothed });
+        }
         
         g_state.dataId = timestamp;
         g_state.logCounter++;
     }
     
     // Unified logging every 50 frames
-    if (g_state.logCounter % 50 == 0) {
-        Log("treadmill: [OnOmniData #%llu] RAW: angle=%.2f° X=%d Y=%d | SMOOTHED: angle=%.2f° X=%.3f Y=%.3f",
+    if (TREADMILL_EVERY_N("OnOmniData calls", 50)) {
+        Log("treadmill: [OnOmniData #%llu] RAW: angle=%.2f° X=%.1f Y=%.1f | SMOOTHED: angle=%.2f° X=%.3f Y=%.3f",
             g_state.logCounter, ringAngle, gamePadX, gamePadY,
             g_state.yaw_smoothed, g_state.x_smoothed, g_state.y_smoothed);
     }
 }
 
+// Runs a recording through a fresh filter chain with the current settings
+// and compares against the recorded output. Timestamps come from the file,
+// so the result does not depend on the machine's clock or load.
+static std::string ReplaySession(const std::string& path)
+{
+    std::vector<TreadmillSessionEvent> events;
+    std::string settings;
+    if (!TreadmillSessionRecorder::Load(path, events, settings)) return "Cannot read " + path;
+    
+    constexpr float Tolerance = 1e-4f;
+    auto replay = std::make_unique<XYState>();  // live g_state stays untouched
+    size_t samples = 0, mismatches = 0, firstMismatch = 0;
+    float maxDx = 0.0f, maxDy = 0.0f, maxDyaw = 0.0f;
+    
+    int64_t startNs = TreadmillCallProfile::NowNs();
+    for (const TreadmillSessionEvent& e : events) {
+        if (e.type == TreadmillSessionEvent::Rate) {
+            if (g_yawKalman.load()) replay->yawKalman.UpdateRate(e.ringAngle, e.timeUs);
+            continue;
+        }
+        if (e.type == TreadmillSessionEvent::Reset) {
+            ResetFilterChain(*replay, e.outX, e.outY, e.outYaw);
+            continue;
+        }
+        if (e.type == TreadmillSessionEvent::Stall) {
+            StallFilterChain(*replay);
+            continue;
+        }
+        replay->cadence = e.cadence;
+        FilterSample(*replay, e.ringAngle, e.gamePadX, e.gamePadY, e.timeUs);
+        samples++;
+        
+        float dx = std::fabs(replay->x_smoothed * replay->speedScale - e.outX);
+        float dy = std::fabs(replay->y_smoothed * replay->speedScale - e.outY);
+        float dyaw = std::fabs(WrapYaw(replay->yaw_smoothed - e.outYaw + 180.0f) - 180.0f);
+        maxDx = std::max(maxDx, dx);
+        maxDy = std::max(maxDy, dy);
+        maxDyaw = std::max(maxDyaw, dyaw);
+        if (dx > Tolerance || dy > Tolerance || dyaw > Tolerance * 360.0f) {
+            if (mismatches++ == 0) firstMismatch = samples;
+        }
+    }
+    int64_t elapsedNs = TreadmillCallProfile::NowNs() - startNs;
+    
+    char buf[512];
+    snprintf(buf, sizeof(buf),
+        "{\"samples\":%zu,\"mismatches\":%zu,\"first_mismatch\":%zu,\"max_dx\":%.6g,\"max_dy\":%.6g,\"max_dyaw\":%.6g,"
+        "\"settings_match\":%s,\"replay_ns\":%lld,\"ns_per_sample\":%.1f}",
+        samples, mismatches, firstMismatch, maxDx, maxDy, maxDyaw, settings == PipelineSettings() ? "true" : "false",
+        static_cast<long long>(elapsedNs), samples > 0 ? static_cast<double>(elapsedNs) / samples : 0.0);
+    return buf;
+}
+
+void OnOmniData(float ringAngle, int gamePadX, int gamePadY)
+{
+    TREADMILL_ZONE("OnOmniData");
+    TREADMILL_METRIC_ADD(g_metrics, TreadmillMetric::SamplesTotal, 1);
+    g_lastOmniSampleUs.store(TreadmillSampleHistory::NowUs(), std::memory_order_relaxed);
+    
+    // Frame sampling feeds g_state from RunFrame instead
+    if (g_frameSamplingActive.load()) return;
+    
+    // The callback carries no timestamp - arrival time is the best we have
+    ApplyOmniSample(ringAngle, static_cast<float>(gamePadX), static_cast<float>(gamePadY), TreadmillSampleHistory::NowUs());
+}
+
+void OnFrameSample(float ringAngle, float gamePadX, float gamePadY, int64_t timeUs)
+{
+    ApplyOmniSample(ringAngle, gamePadX, gamePadY, timeUs);
+}
+
+// RingDelta is taken as the signed ring movement in counts since the previous
+// packet (intervalUs ago); it only feeds the Kalman yaw as a rate measurement
+void OnRingDelta(int8_t ringDelta, int64_t timeUs, int64_t intervalUs)
+{
+    TREADMILL_ZONE("OnRingDelta");
+    float scale = g_ringDeltaScale.load();
+    if (!g_yawKalman.load() || scale <= 0.0f || intervalUs <= 0) return;
+    
+    float rate = static_cast<float>(ringDelta * scale / (intervalUs * 1e-6));
+    std::lock_guard<std::mutex> lock(g_state.mtx);
+    g_state.yawKalman.UpdateRate(rate, timeUs);
+    if (g_recorder.IsRecording()) {
+        TreadmillSessionEvent e;
+        e.type = TreadmillSessionEvent::Rate;
+        e.timeUs = timeUs;
+        e.ringAngle = rate;
+        g_recorder.Write(e);
+    }
+}
+
+// Step cadence for the speed predictor, from the treadmill's step counter
+void OnStepCount(uint32_t stepCount, int64_t timeUs)
+{
+    TREADMILL_ZONE("OnStepCount");
+    std::lock_guard<std::mutex> lock(g_state.mtx);
+    
+    if (g_state.lastStepTimeUs == 0 || stepCount < g_state.lastStepCount) {
+        g_state.lastStepCount = stepCount;
+        g_state.lastStepTimeUs = timeUs;
+        return;
+    }
+    
+    double elapsed = (timeUs - g_state.lastStepTimeUs) * 1e-6;
+    if (stepCount != g_state.lastStepCount && !g_state.stepTriggerSeen) {
+        g_state.pendingStepTimeUs = timeUs;
+        g_state.lastFootfallUs = timeUs;
+    }
+    if (stepCount != g_state.lastStepCount && elapsed > 0.0) {
+        float instant = static_cast<float>((stepCount - g_state.lastStepCount) / elapsed);
+        g_state.cadence += 0.3f * (instant - g_state.cadence);
+        g_state.lastStepCount = stepCount;
+        g_state.lastStepTimeUs = timeUs;
+    } else if (elapsed > 0.0) {
+        // No step for a while: the cadence can be at most one step per elapsed time
+        g_state.cadence = std::min(g_state.cadence, static_cast<float>(1.0 / elapsed));
+    }
+}
+
+// The link missed its sample deadline: stop walking instead of holding the
+// last stick value until samples (or a reconnect) bring new data
+void OnLinkStall()
+{
+    std::lock_guard<std::mutex> lock(g_state.mtx);
+    StallFilterChain(g_state);
+    g_state.pendingStepTimeUs = 0;
+    if (g_recorder.IsRecording()) {
+        TreadmillSessionEvent e;
+        e.type = TreadmillSessionEvent::Stall;
+        e.timeUs = TreadmillSampleHistory::NowUs();
+        g_recorder.Write(e);
+    }
+}
+
+// StepTrigger goes non-zero on a footfall; the rising edge is the step
+void OnStepTrigger(uint8_t stepTrigger, int64_t timeUs)
+{
+    TREADMILL_ZONE("OnStepTrigger");
+    std::lock_guard<std::mutex> lock(g_state.mtx);
+    g_state.stepTriggerSeen = true;
+    if (stepTrigger != 0 && g_state.lastStepTrigger == 0) {
+        g_state.pendingStepTimeUs = timeUs;
+        g_state.lastFootfallUs = timeUs;
+    }
+    g_state.lastStepTrigger = stepTrigger;
+}
 
 // NEW: Implementation of visualization tracker
 vr::EVRInitError TreadmillVisualTracker::Activate(vr::TrackedDeviceIndex_t unObjectId) {
@@ -411,42 +1523,48 @@ vr::EVRInitError TreadmillVisualTracker::Activate(vr::TrackedDeviceIndex_t unObj
 
     auto container = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
 
-    // Register as GenericTracker (visible!)
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_GenericTracker);
-    
-    // Base properties
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_TrackingSystemName_String, "treadmill");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_ModelNumber_String, "Treadmill_Orientation_Tracker");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_SerialNumber_String, "treadmill_visual_001");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_RenderModelName_String, "{htc}vr_tracker_vive_1_0");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_ManufacturerName_String, "Treadmill");
-    
-    // Icons for SteamVR (uses Vive Tracker icons)
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceOff_String, "{htc}/icons/tracker_status_off.png");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceSearching_String, "{htc}/icons/tracker_status_searching.gif");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceSearchingAlert_String, "{htc}/icons/tracker_status_searching_alert.gif");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceReady_String, "{htc}/icons/tracker_status_ready.png");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceReadyAlert_String, "{htc}/icons/tracker_status_ready_alert.png");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceNotReady_String, "{htc}/icons/tracker_status_error.png");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceStandby_String, "{htc}/icons/tracker_status_standby.png");
-    vr::VRProperties()->SetStringProperty(container, vr::Prop_NamedIconPathDeviceAlertLow_String, "{htc}/icons/tracker_status_ready_low.png");
-
-    // Tracker-specific properties
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_WillDriftInYaw_Bool, false);
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_DeviceIsWireless_Bool, false);
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_DeviceIsCharging_Bool, false);
-    vr::VRProperties()->SetFloatProperty(container, vr::Prop_DeviceBatteryPercentage_Float, 1.0f);
-    
-    // Tracking properties
-    vr::VRProperties()->SetBoolProperty(container, vr::Prop_Identifiable_Bool, true);
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_Axis0Type_Int32, vr::k_eControllerAxis_None);
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_Axis1Type_Int32, vr::k_eControllerAxis_None);
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_Axis2Type_Int32, vr::k_eControllerAxis_None);
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_Axis3Type_Int32, vr::k_eControllerAxis_None);
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_Axis4Type_Int32, vr::k_eControllerAxis_None);
-    
-    // Explicitly disable controller role
-    vr::VRProperties()->SetInt32Property(container, vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_Invalid);
+    int64_t propsStartNs = TreadmillCallProfile::NowNs();
+    const TreadmillProperty props[] = {
+        // Register as GenericTracker (visible!)
+        TreadmillProperty::Int32(vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_GenericTracker),
+        
+        // Base properties
+        TreadmillProperty::String(vr::Prop_TrackingSystemName_String, "treadmill"),
+        TreadmillProperty::String(vr::Prop_ModelNumber_String, "Treadmill_Orientation_Tracker"),
+        TreadmillProperty::String(vr::Prop_SerialNumber_String, "treadmill_visual_001"),
+        TreadmillProperty::String(vr::Prop_RenderModelName_String, "{htc}vr_tracker_vive_1_0"),
+        TreadmillProperty::String(vr::Prop_ManufacturerName_String, "Treadmill"),
+        
+        // Icons for SteamVR (uses Vive Tracker icons)
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceOff_String, "{htc}/icons/tracker_status_off.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceSearching_String, "{htc}/icons/tracker_status_searching.gif"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceSearchingAlert_String, "{htc}/icons/tracker_status_searching_alert.gif"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceReady_String, "{htc}/icons/tracker_status_ready.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceReadyAlert_String, "{htc}/icons/tracker_status_ready_alert.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceNotReady_String, "{htc}/icons/tracker_status_error.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceStandby_String, "{htc}/icons/tracker_status_standby.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceAlertLow_String, "{htc}/icons/tracker_status_ready_low.png"),
+        
+        // Tracker-specific properties
+        TreadmillProperty::Bool(vr::Prop_WillDriftInYaw_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_DeviceIsWireless_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_DeviceIsCharging_Bool, false),
+        TreadmillProperty::Float(vr::Prop_DeviceBatteryPercentage_Float, 1.0f),
+        
+        // Tracking properties
+        TreadmillProperty::Bool(vr::Prop_Identifiable_Bool, true),
+        TreadmillProperty::Int32(vr::Prop_Axis0Type_Int32, vr::k_eControllerAxis_None),
+        TreadmillProperty::Int32(vr::Prop_Axis1Type_Int32, vr::k_eControllerAxis_None),
+        TreadmillProperty::Int32(vr::Prop_Axis2Type_Int32, vr::k_eControllerAxis_None),
+        TreadmillProperty::Int32(vr::Prop_Axis3Type_Int32, vr::k_eControllerAxis_None),
+        TreadmillProperty::Int32(vr::Prop_Axis4Type_Int32, vr::k_eControllerAxis_None),
+        
+        // Explicitly disable controller role
+        TreadmillProperty::Int32(vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_Invalid),
+    };
+    size_t propsFailed = WriteTreadmillProperties(container, props, std::size(props), "VisualTracker");
+    Log("treadmill: VisualTracker: %zu properties in 1 batch (%zu failed) in %.3f ms", std::size(props), propsFailed,
+        (TreadmillCallProfile::NowNs() - propsStartNs) / 1e6);
 
     // Initialize pose
     m_pose = {};
@@ -483,37 +1601,118 @@ void TreadmillVisualTracker::DebugRequest(const char* pchRequest, char* pchRespo
     }
 }
 
+void TreadmillVisualTracker::UpdateCalibration(float hmdX, float hmdZ, float hmdForwardX, float hmdForwardZ,
+                                               float yawDeg, float joystickX, float joystickY) {
+    // What UpdateInputs sends to the game
+    float factor = g_speedFactor.load();
+    float sx = std::clamp(joystickX * factor, -1.0f, 1.0f);
+    float sy = std::clamp(joystickY * factor, -1.0f, 1.0f);
+    bool saturated = std::fabs(sx) >= 0.999f || std::fabs(sy) >= 0.999f;
+    float stick = std::min(1.0f, std::sqrt(sx * sx + sy * sy));
+    
+    // The direction the game was given: raw ring yaw plus the applied offset
+    // (speed only uses lengths)
+    constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+    float appliedOffset = g_yawOffset.load();
+    double appliedYaw = WrapYaw(yawDeg + appliedOffset);
+    double sinYaw = std::sin(appliedYaw * DEG2RAD);
+    double cosYaw = std::cos(appliedYaw * DEG2RAD);
+    float commandX = static_cast<float>(sx * cosYaw - sy * sinYaw);
+    float commandZ = static_cast<float>(sx * sinYaw + sy * cosYaw);
+    
+    // The direction the player meant: the same stick, turned by where they
+    // face. Looking straight up or down gives no heading.
+    float intendedX = 0.0f;
+    float intendedZ = 0.0f;
+    float forward = std::sqrt(hmdForwardX * hmdForwardX + hmdForwardZ * hmdForwardZ);
+    if (forward > 0.3f) {
+        float fx = hmdForwardX / forward;
+        float fz = hmdForwardZ / forward;
+        intendedX = sx * -fz + sy * fx;     // right = forward turned 90° clockwise
+        intendedZ = sx * fx + sy * fz;
+    }
+    
+    TreadmillMotionObservation obs;
+    if (!m_motionWindow.AddFrame(TreadmillSampleHistory::NowUs(), hmdX, hmdZ, commandX, commandZ, intendedX, intendedZ,
+                                 stick, saturated, obs)) return;
+    
+    // Yaw offset: the estimator measures how each step changed the residual
+    // and sizes the next one by it (closed loop, see TreadmillCalibration.h)
+    double step = 0.0;
+    TreadmillYawOffsetEstimator::Decision decision = g_yawCorrection.load()
+        ? g_yawOffsetEstimator.Add(obs, step) : TreadmillYawOffsetEstimator::Decision::None;
+    if (decision == TreadmillYawOffsetEstimator::Decision::Stop) {
+        TreadmillYawOffsetEstimator::Stats ys = g_yawOffsetEstimator.GetStats();
+        g_yawCorrection.store(false);
+        g_yawOffset.store(0.0f);
+        g_yawOffsetEstimator.Reset();
+        Log("treadmill: [Calibration] yaw offset does not steer the game (loop gain %.2f) - yaw_correction stopped", ys.loopGain);
+    } else if (decision == TreadmillYawOffsetEstimator::Decision::Step) {
+        TreadmillYawOffsetEstimator::Stats ys = g_yawOffsetEstimator.GetStats();
+        float next = static_cast<float>(std::remainder(appliedOffset + step, 360.0));
+        g_yawOffset.store(next);
+        Log("treadmill: [Calibration] yaw offset %.1f° -> %.1f° (residual %.1f°, loop gain %.2f, concentration %.2f)",
+            appliedOffset, next, ys.residualDeg, ys.loopGain, ys.concentration);
+    }
+    
+    if (g_speedCalibration.load() == SpeedCalibration_Off || !g_speedCalibrator.Add(obs)) return;
+    
+    float suggested = g_speedCalibrator.SuggestSpeedFactor(g_calibrationTargetSpeed.load());
+    if (suggested <= 0.0f) return;
+    
+    static int calibrationLogCounter = 0;
+    bool logNow = ++calibrationLogCounter % 20 == 0;
+    
+    if (g_speedCalibration.load() == SpeedCalibration_Apply && std::fabs(suggested - factor) > 0.02f * factor) {
+        // Move gradually so a bad window cannot yank the speed
+        float next = factor + 0.1f * (suggested - factor);
+        g_speedFactor.store(next);
+        if (logNow) Log("treadmill: [Calibration] speed_factor %.3f -> %.3f (target %.3f)", factor, next, suggested);
+    } else if (logNow) {
+        TreadmillSpeedCalibrator::Stats cs = g_speedCalibrator.GetStats();
+        Log("treadmill: [Calibration] game gain=%.3f m/s per unit | suggested speed_factor=%.3f (current %.3f) | accepted=%llu rejected=%llu",
+            cs.gain, suggested, factor,
+            static_cast<unsigned long long>(cs.accepted), static_cast<unsigned long long>(cs.rejected));
+    }
+}
+
 vr::DriverPose_t TreadmillVisualTracker::GetPose() {
+    TreadmillCallTimer timer(g_profileTrackerPose);
+    TREADMILL_ZONE("TreadmillVisualTracker::GetPose");
     float rawYaw;
     uint64_t dataId;
     uint64_t logCounter;
     float joystickX, joystickY;
+    float speedScale;
+    bool hmdValid = false;
+    float currentHmdX = 0.0f;
+    float currentHmdZ = 0.0f;
+    float hmdForwardX = 0.0f;
+    float hmdForwardZ = 0.0f;
+    bool logFrame = TREADMILL_EVERY_N("TreadmillVisualTracker::GetPose calls", 50);
     
     {
-        std::lock_guard<std::mutex> lock(g_state.mtx);
+        TreadmillTimedLock lock(g_state.mtx, g_profileStateLock);
         rawYaw = g_state.yaw_smoothed;
         dataId = g_state.dataId;
         logCounter = g_state.logCounter;
         joystickX = g_state.x_smoothed;
         joystickY = g_state.y_smoothed;
+        speedScale = g_state.speedScale;
         
-        m_pose.poseIsValid = true;
-        m_pose.deviceIsConnected = true;
-        m_pose.result = vr::TrackingResult_Running_OK;
+        ApplyConnectionState(m_pose);
 
         // Tracker positions itself relative to HMD
         vr::TrackedDevicePose_t hmdPose;
         vr::VRServerDriverHost()->GetRawTrackedDevicePoses(0.0f, &hmdPose, 1);
         
-        float currentHmdX = 0.0f;
-        float currentHmdZ = 0.0f;
-        bool hmdValid = false;
-        
         if (hmdPose.bPoseIsValid) {
             vr::HmdMatrix34_t hmdMatrix = hmdPose.mDeviceToAbsoluteTracking;
             
             currentHmdX = hmdMatrix.m[0][3];
             currentHmdZ = hmdMatrix.m[2][3];
+            hmdForwardX = -hmdMatrix.m[0][2];   // -Z axis, for the yaw estimator
+            hmdForwardZ = -hmdMatrix.m[2][2];
             hmdValid = true;
             
             // Position: Follows HMD position, but NOT HMD rotation
@@ -528,7 +1727,7 @@ vr::DriverPose_t TreadmillVisualTracker::GetPose() {
         }
 
         // MOVEMENT ANALYSIS: Actual vs Expected direction
-        if (hmdValid && g_state.hmdInitialized && (logCounter % 50 == 0)) {
+        if (hmdValid && g_state.hmdInitialized && logFrame) {
             // Calculate actual movement (in world coordinates)
             float actualDeltaX = currentHmdX - g_state.lastHmdX;
             float actualDeltaZ = currentHmdZ - g_state.lastHmdZ;
@@ -585,9 +1784,10 @@ vr::DriverPose_t TreadmillVisualTracker::GetPose() {
             g_state.hmdInitialized = true;
         }
 
-        // Tracker rotation based ONLY on treadmill yaw (NOT HMD rotation!)
+        // Tracker rotation based ONLY on treadmill yaw (NOT HMD rotation!), with
+        // the learned world offset. The analysis above stays on the raw yaw.
         constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
-        double theta = static_cast<double>(rawYaw) * DEG2RAD;
+        double theta = static_cast<double>(WrapYaw(rawYaw + g_yawOffset.load())) * DEG2RAD;
         
         // Calculate quaternion
         double half = theta * 0.5;
@@ -614,9 +1814,16 @@ vr::DriverPose_t TreadmillVisualTracker::GetPose() {
             m_pose.qRotation.z /= qLength;
         }
     }
+    
+    // Calibration works on this frame's copies, outside g_state.mtx
+    if (hmdValid && (g_speedCalibration.load() != SpeedCalibration_Off || g_yawCorrection.load())) {
+        UpdateCalibration(currentHmdX, currentHmdZ, hmdForwardX, hmdForwardZ, rawYaw, joystickX * speedScale, joystickY * speedScale);
+    } else {
+        m_motionWindow.Reset();
+    }
 
     // Unified logging every 50 frames
-    if (logCounter % 50 == 0) {
+    if (logFrame) {
         double expectedWorldX = std::sin(rawYaw * 3.14159265358979323846 / 180.0);
         double expectedWorldZ = -std::cos(rawYaw * 3.14159265358979323846 / 180.0);
         
@@ -630,6 +1837,181 @@ vr::DriverPose_t TreadmillVisualTracker::GetPose() {
     return m_pose;
 }
 
+void AdvanceFootGait(int64_t timeUs) {
+    float x, y, yaw, cadence;
+    int64_t lastFootfallUs;
+    {
+        TreadmillTimedLock lock(g_state.mtx, g_profileStateLock);
+        x = g_state.x_smoothed * g_state.speedScale;
+        y = g_state.y_smoothed * g_state.speedScale;
+        yaw = g_state.yaw_smoothed;
+        cadence = g_state.cadence;
+        lastFootfallUs = g_state.lastFootfallUs;
+    }
+    g_footFrame.headingDeg = WrapYaw(yaw + g_yawOffset.load());
+    
+    // Feet below the HMD; without a valid HMD pose they keep the last place
+    vr::TrackedDevicePose_t hmdPose;
+    vr::VRServerDriverHost()->GetRawTrackedDevicePoses(0.0f, &hmdPose, 1);
+    if (hmdPose.bPoseIsValid) {
+        g_footFrame.baseX = hmdPose.mDeviceToAbsoluteTracking.m[0][3];
+        g_footFrame.floorY = hmdPose.mDeviceToAbsoluteTracking.m[1][3] - g_footEyeHeightM.load();
+        g_footFrame.baseZ = hmdPose.mDeviceToAbsoluteTracking.m[2][3];
+    }
+    
+    double speed = std::min(1.0, std::sqrt(static_cast<double>(x) * x + static_cast<double>(y) * y));
+    g_footGait.Advance(speed, cadence, lastFootfallUs, g_footStrideM.load(), timeUs);
+    g_footStrideNow.store(static_cast<float>(g_footGait.Stride()), std::memory_order_relaxed);
+    g_footWalking.store(g_footGait.Walking(), std::memory_order_relaxed);
+}
+
+TreadmillFootTracker::TreadmillFootTracker(int foot) : m_foot(foot) {}
+
+const char* TreadmillFootTracker::SerialNumber() const {
+    return m_foot == 0 ? "treadmill_foot_left" : "treadmill_foot_right";
+}
+
+vr::EVRInitError TreadmillFootTracker::Activate(vr::TrackedDeviceIndex_t unObjectId) {
+    m_unObjectId = unObjectId;
+    Log("treadmill: FootTracker %s Activate called, objectId=%d", SerialNumber(), static_cast<int>(unObjectId));
+    
+    if (!vr::VRProperties()) {
+        Log("treadmill: FootTracker: VRProperties() is null");
+        return vr::VRInitError_Driver_Failed;
+    }
+    
+    auto container = vr::VRProperties()->TrackedDeviceToPropertyContainer(m_unObjectId);
+    
+    int64_t propsStartNs = TreadmillCallProfile::NowNs();
+    const TreadmillProperty props[] = {
+        TreadmillProperty::Int32(vr::Prop_DeviceClass_Int32, vr::TrackedDeviceClass_GenericTracker),
+        TreadmillProperty::String(vr::Prop_TrackingSystemName_String, "treadmill"),
+        TreadmillProperty::String(vr::Prop_ModelNumber_String, "Treadmill_Foot_Tracker"),
+        TreadmillProperty::String(vr::Prop_SerialNumber_String, SerialNumber()),
+        TreadmillProperty::String(vr::Prop_RenderModelName_String, "{htc}vr_tracker_vive_1_0"),
+        TreadmillProperty::String(vr::Prop_ManufacturerName_String, "Treadmill"),
+        // Suggests the foot role in SteamVR's tracker management
+        TreadmillProperty::String(vr::Prop_ControllerType_String, m_foot == 0 ? "vive_tracker_left_foot" : "vive_tracker_right_foot"),
+        
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceOff_String, "{htc}/icons/tracker_status_off.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceSearching_String, "{htc}/icons/tracker_status_searching.gif"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceSearchingAlert_String, "{htc}/icons/tracker_status_searching_alert.gif"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceReady_String, "{htc}/icons/tracker_status_ready.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceReadyAlert_String, "{htc}/icons/tracker_status_ready_alert.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceNotReady_String, "{htc}/icons/tracker_status_error.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceStandby_String, "{htc}/icons/tracker_status_standby.png"),
+        TreadmillProperty::String(vr::Prop_NamedIconPathDeviceAlertLow_String, "{htc}/icons/tracker_status_ready_low.png"),
+        
+        TreadmillProperty::Bool(vr::Prop_WillDriftInYaw_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_DeviceIsWireless_Bool, true),
+        TreadmillProperty::Bool(vr::Prop_DeviceIsCharging_Bool, false),
+        TreadmillProperty::Bool(vr::Prop_Identifiable_Bool, false),
+        TreadmillProperty::Int32(vr::Prop_ControllerRoleHint_Int32, vr::TrackedControllerRole_Invalid),
+    };
+    size_t propsFailed = WriteTreadmillProperties(container, props, std::size(props), SerialNumber());
+    Log("treadmill: FootTracker: %zu properties in 1 batch (%zu failed) in %.3f ms", std::size(props), propsFailed,
+        (TreadmillCallProfile::NowNs() - propsStartNs) / 1e6);
+    
+    // Not valid until the first pod sample
+    m_pose = {};
+    m_pose.qWorldFromDriverRotation = { 1,0,0,0 };
+    m_pose.qDriverFromHeadRotation = { 1,0,0,0 };
+    m_pose.qRotation = { 1.0, 0.0, 0.0, 0.0 };
+    m_pose.poseIsValid = false;
+    m_pose.deviceIsConnected = true;
+    m_pose.result = vr::TrackingResult_Running_OutOfRange;
+    
+    Log("treadmill: FootTracker %s activated successfully", SerialNumber());
+    return vr::VRInitError_None;
+}
+
+void TreadmillFootTracker::Deactivate() {
+    Log("treadmill: FootTracker %s Deactivate called", SerialNumber());
+    m_unObjectId = vr::k_unTrackedDeviceIndexInvalid;
+}
+
+void TreadmillFootTracker::EnterStandby() {}
+
+void* TreadmillFootTracker::GetComponent(const char* pchComponentNameAndVersion) {
+    return nullptr;
+}
+
+void TreadmillFootTracker::DebugRequest(const char* pchRequest, char* pchResponseBuffer, uint32_t unResponseBufferSize) {
+    if (pchResponseBuffer && unResponseBufferSize > 0) {
+        strncpy_s(pchResponseBuffer, unResponseBufferSize, SerialNumber(), _TRUNCATE);
+    }
+}
+
+void TreadmillFootTracker::OnPodSample(const float wxyz[4], int64_t timeUs) {
+    uint32_t generation = g_footNeutralGeneration.load(std::memory_order_relaxed);
+    if (generation != m_neutralGeneration) {
+        m_neutralGeneration = generation;
+        m_orientation.ResetNeutral();
+    }
+    
+    m_orientation.Update(wxyz);
+    // The flat-foot reference is the first sample taken while standing
+    if (!m_orientation.HasNeutral() && !g_footGait.Walking()) {
+        m_orientation.CaptureNeutral();
+        Log("treadmill: FootTracker %s neutral pose captured", SerialNumber());
+    }
+    
+    TreadmillQuaternion rotation = m_orientation.Orientation(g_footFrame.headingDeg);
+    double dtS = m_lastPodUs != 0 ? (timeUs - m_lastPodUs) * 1e-6 : 0.0;
+    if (dtS > 0.0 && dtS < 0.1) {
+        QuatAngularVelocity(m_rotation, rotation, dtS, m_angularVelocity);
+    } else {
+        m_angularVelocity[0] = m_angularVelocity[1] = m_angularVelocity[2] = 0.0;  // first sample or after a gap
+    }
+    m_rotation = rotation;
+    m_lastPodUs = timeUs;
+    
+    g_footPodSamples.fetch_add(1, std::memory_order_relaxed);
+    g_footLastPodUs.store(timeUs, std::memory_order_relaxed);
+}
+
+vr::DriverPose_t TreadmillFootTracker::GetPose() {
+    TREADMILL_ZONE("TreadmillFootTracker::GetPose");
+    ApplyConnectionState(m_pose);
+    if (!m_orientation.HasSample()) {
+        // No pod data (consumer, older OmniBridge): nothing to show
+        m_pose.poseIsValid = false;
+        m_pose.result = vr::TrackingResult_Running_OutOfRange;
+        return m_pose;
+    }
+    
+    // Heading as of now, the pod's tilt as of its last sample, carried
+    // forward by the pod's angular velocity (at most 50 ms)
+    int64_t nowUs = TreadmillSampleHistory::NowUs();
+    double ageS = std::clamp((nowUs - m_lastPodUs) * 1e-6, 0.0, 0.05);
+    TreadmillQuaternion rotation = QuatNormalize(QuatMultiply(
+        QuatFromAngularVelocity(m_angularVelocity, ageS), m_orientation.Orientation(g_footFrame.headingDeg)));
+    m_pose.qRotation = { rotation.w, rotation.x, rotation.y, rotation.z };
+    
+    // Position from the gait model along the heading (forward = (sin, 0, -cos))
+    constexpr double DEG2RAD = 3.14159265358979323846 / 180.0;
+    double theta = g_footFrame.headingDeg * DEG2RAD;
+    double forwardX = std::sin(theta), forwardZ = -std::cos(theta);
+    double rightX = std::cos(theta), rightZ = std::sin(theta);
+    double side = (m_foot == 0 ? -0.5 : 0.5) * TreadmillGaitModel::FootSpacingMeters;
+    TreadmillGaitModel::Foot foot = g_footGait.Get(m_foot);
+    
+    m_pose.vecPosition[0] = g_footFrame.baseX + rightX * side + forwardX * foot.forward;
+    m_pose.vecPosition[1] = g_footFrame.floorY + TreadmillGaitModel::FootHeightMeters + foot.lift;
+    m_pose.vecPosition[2] = g_footFrame.baseZ + rightZ * side + forwardZ * foot.forward;
+    
+    // SteamVR predicts to photon time from these
+    m_pose.vecVelocity[0] = forwardX * foot.forwardVelocity;
+    m_pose.vecVelocity[1] = foot.liftVelocity;
+    m_pose.vecVelocity[2] = forwardZ * foot.forwardVelocity;
+    m_pose.vecAngularVelocity[0] = m_angularVelocity[0];
+    m_pose.vecAngularVelocity[1] = m_angularVelocity[1];
+    m_pose.vecAngularVelocity[2] = m_angularVelocity[2];
+    m_pose.poseTimeOffset = 0.0;
+    
+    return m_pose;
+}
+
 extern "C" __declspec(dllexport) void* HmdDriverFactory(const char* pInterfaceName, int* pReturnCode) {
     try {
         if (pReturnCode) *pReturnCode = vr::VRInitError_Init_InterfaceNotFound;